@@ -724,6 +724,16 @@ AC_DEFUN([CS_ENABLE_LOCK_DEBUG], [
 	AC_MSG_RESULT([--enable-lock-debug: ${ac_cv_lock_debug}])
 ])
 
+AC_DEFUN([CS_ENABLE_LOCK_PROFILE], [
+	AC_ARG_ENABLE(lock_profile, 
+		[AC_HELP_STRING([--enable-lock-profile], [enable lock contention profiling, see 'sccp show lockstats' (developer only)])], 
+		[ac_cv_lock_profile=$enableval], 
+		[ac_cv_lock_profile=no]
+	)
+	AS_IF([test "_${ac_cv_lock_profile}" == "_yes"], [AC_DEFINE(CS_LOCK_PROFILE, 1, [lock profiling enabled])])
+	AC_MSG_RESULT([--enable-lock-profile: ${ac_cv_lock_profile}])
+])
+
 
 AC_DEFUN([CS_ENABLE_STRIP], [
 	AC_ARG_ENABLE(strip, 
@@ -1007,6 +1017,7 @@ AC_DEFUN([CS_PARSE_WITH_AND_ENABLE], [
 	CS_ENABLE_GCOV
 	CS_ENABLE_REFCOUNT_DEBUG
 	CS_ENABLE_LOCK_DEBUG
+	CS_ENABLE_LOCK_PROFILE
 	CS_ENABLE_STRIP
 	CS_DISABLE_PICKUP
 	CS_DISABLE_PARK
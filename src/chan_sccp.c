@@ -33,6 +33,13 @@
 #include "sccp_devstate.h"
 #endif
 #include "sccp_management.h"	// use __constructor__ to remove this entry
+#include "sccp_realtime.h"
+#include "sccp_regcontext.h"
+#include "sccp_pcap.h"
+#include "sccp_stats.h"
+#include "sccp_metrics.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_provision.h"
 #include <signal.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -64,7 +71,7 @@ int load_config(void)
 #else
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "Platform byte order   : BIG ENDIAN\n");
 #endif
-	if (sccp_config_getConfig(TRUE) > CONFIG_STATUS_FILE_OK) {
+	if (!sccp_config_readSnapshot() && sccp_config_getConfig(TRUE) > CONFIG_STATUS_FILE_OK) {
 		pbx_log(LOG_ERROR, "Error loading configfile !\n");
 		return FALSE;
 	}
@@ -73,7 +80,10 @@ int load_config(void)
 		pbx_log(LOG_ERROR, "Error parsing configfile !\n");
 		return FALSE;
 	}
-	sccp_config_readDevicesLines(SCCP_CONFIG_READINITIAL);
+	if (sccp_config_readDevicesLines(SCCP_CONFIG_READINITIAL)) {
+		sccp_config_writeSnapshot();
+	}
+	sccp_mwi_primeCache();
 	return TRUE;
 }
 
@@ -122,6 +132,15 @@ boolean_t sccp_prePBXLoad(void)
 #ifdef CS_SCCP_CONFERENCE
 	sccp_conference_module_start();
 #endif
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_start();
+#endif
+	sccp_regcontext_module_start();
+	sccp_buttontemplate_module_start();
+	sccp_provision_module_start();
+	sccp_pcap_module_start();
+	sccp_stats_module_start();
+	sccp_metrics_module_start();
 	sccp_event_subscribe(SCCP_EVENT_FEATURE_CHANGED, sccp_device_featureChangedDisplay, TRUE);
 	sccp_event_subscribe(SCCP_EVENT_FEATURE_CHANGED, sccp_util_featureStorageBackend, TRUE);
 
@@ -272,19 +291,29 @@ int sccp_preUnload(void)
 	usleep(100);												// wait for events to finalize
 
 	/* stop services */
+	sccp_regcontext_module_stop();
 	sccp_session_terminateAll();
+	sccp_buttontemplate_module_stop();
+	sccp_provision_module_stop();
+	sccp_pcap_module_stop();
+	sccp_stats_module_stop();
+	sccp_metrics_module_stop();
 	sccp_manager_module_stop();
 #ifdef CS_DEVSTATE_FEATURE	
 	sccp_devstate_module_stop();
 #endif
 #ifdef CS_SCCP_CONFERENCE
 	sccp_conference_module_stop();
+#endif
+#ifdef CS_SCCP_REALTIME
+	sccp_realtime_module_stop();
 #endif
 	sccp_softkey_clear();
 	sccp_hint_module_stop();
 	sccp_event_module_stop();
 	sccp_threadpool_destroy(GLOB(general_threadpool));
 	sccp_refcount_destroy();
+	sccp_log_async_module_stop();
 
 	/* free resources */
 	if (GLOB(config_file_name)) {
@@ -300,6 +329,8 @@ int sccp_preUnload(void)
 		sccp_free_ha(GLOB(localaddr));
 	}
 	sccp_config_cleanup_dynamically_allocated_memory(sccp_globals, SCCP_CONFIG_GLOBAL_SEGMENT);
+	sccp_config_cleanupReloadReport();
+	sccp_config_cleanupMetadata();
 	/* */
 
 	/* destroy locks */
@@ -347,6 +378,7 @@ int sccp_reload(void)
 				returnval = 3;
 				break;
 			}
+			sccp_config_writeSnapshot();
 			returnval = sccp_session_bind_and_listen( &GLOB(bindaddr) ) ? 0 : 3;
 			break;
 		case CONFIG_STATUS_FILE_OLD:
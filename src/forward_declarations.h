@@ -41,6 +41,8 @@ typedef struct sccp_ast_channel_name sccp_ast_channel_name_t;							/*!< SCCP As
 typedef struct sccp_buttonconfig sccp_buttonconfig_t;								/*!< SCCP Button Config Structure */
 typedef struct sccp_hotline sccp_hotline_t;									/*!< SCCP Hotline Structure */
 typedef struct sccp_callinfo sccp_callinfo_t;									/*!< SCCP Call Information Structure */
+typedef struct sccp_callinfo_snapshot sccp_callinfo_snapshot_t;							/*!< SCCP Call Information Snapshot (immutable) */
+typedef struct sccp_buttontemplate sccp_buttontemplate_t;							/*!< SCCP Cached Button Template (immutable) */
 typedef struct sccp_call_statistics sccp_call_statistics_t;							/*!< SCCP Call Statistic Structure */
 typedef struct softKeySetConfiguration sccp_softKeySetConfiguration_t;						/*!< SoftKeySet configuration */
 typedef struct sccp_mailbox sccp_mailbox_t;									/*!< SCCP Mailbox Type Definition */
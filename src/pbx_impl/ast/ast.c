@@ -321,6 +321,24 @@ struct ast_context *pbx_context_find_or_create(struct ast_context **extcontexts,
 #endif														// ASTERISK_VERSION_NUMBER
 }
 
+/*
+ * \brief Add an extension to a context that is already write locked by the caller
+ * \note replacement for ast_add_extension2_nolock
+ *
+ * Used to add many extensions to one context while taking the context lock only once.
+ *
+ * \retval 0 on success
+ * \retval -1 on failure (errno is EEXIST when the extension/priority already exists)
+ */
+int pbx_add_extension2_nolock(struct ast_context *con, int replace, const char *extension, int priority, const char *label, const char *callerid, const char *application, void *data, void (*datad) (void *), const char *registrar)
+{
+#if ASTERISK_VERSION_GROUP >= 112
+	return ast_add_extension2_nolock(con, replace, extension, priority, label, callerid, application, data, datad, registrar, NULL, 0);
+#else
+	return ast_add_extension2_nolock(con, replace, extension, priority, label, callerid, application, data, datad, registrar);
+#endif														// ASTERISK_VERSION_GROUP
+}
+
 /*!
  * \brief Load a config file
  *
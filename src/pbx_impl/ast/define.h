@@ -214,6 +214,7 @@ typedef struct ast_event pbx_event_t;
 #define pbx_io_wait ast_io_wait
 #define pbx_jb_read_conf ast_jb_read_conf
 #define pbx_load_realtime ast_load_realtime
+#define pbx_load_realtime_multientry ast_load_realtime_multientry
 #define pbx_log ast_log
 #define pbx_malloc ast_malloc
 #define pbx_manager_register_xml ast_manager_register_xml
@@ -231,7 +232,21 @@ typedef struct ast_event pbx_event_t;
 #define pbx_rwlock_init(x) ast_rwlock_init((ast_rwlock_t *)x)
 #define pbx_rwlock_init_notracking(x) ast_rwlock_init_notracking((ast_rwlock_t *)x)
 
-#if CS_LOCK_DEBUG
+#if CS_LOCK_PROFILE
+/* contention profiling, see sccp_lockstats.c: every call site (file:line) becomes a lock class */
+SCCP_API int SCCP_CALL sccp_lockstats_mutex_lock(ast_mutex_t * lock, int trylock, const char *name, const char *file, int line);
+SCCP_API int SCCP_CALL sccp_lockstats_mutex_unlock(ast_mutex_t * lock);
+SCCP_API int SCCP_CALL sccp_lockstats_rwlock_lock(ast_rwlock_t * lock, int write, int trylock, const char *name, const char *file, int line);
+SCCP_API int SCCP_CALL sccp_lockstats_rwlock_unlock(ast_rwlock_t * lock);
+#define pbx_mutex_lock(x) ({sccp_lockstats_mutex_lock((ast_mutex_t *)x, 0, #x, __FILE__, __LINE__);})
+#define pbx_mutex_trylock(x) ({sccp_lockstats_mutex_lock((ast_mutex_t *)x, 1, #x, __FILE__, __LINE__);})
+#define pbx_mutex_unlock(x) ({sccp_lockstats_mutex_unlock((ast_mutex_t *)x);})
+#define pbx_rwlock_rdlock(x) ({sccp_lockstats_rwlock_lock((ast_rwlock_t *)x, 0, 0, #x, __FILE__, __LINE__);})
+#define pbx_rwlock_wrlock(x) ({sccp_lockstats_rwlock_lock((ast_rwlock_t *)x, 1, 0, #x, __FILE__, __LINE__);})
+#define pbx_rwlock_tryrdlock(x) ({sccp_lockstats_rwlock_lock((ast_rwlock_t *)x, 0, 1, #x, __FILE__, __LINE__);})
+#define pbx_rwlock_trywrlock(x) ({sccp_lockstats_rwlock_lock((ast_rwlock_t *)x, 1, 1, #x, __FILE__, __LINE__);})
+#define pbx_rwlock_unlock(x) ({sccp_lockstats_rwlock_unlock((ast_rwlock_t *)x);})
+#elif CS_LOCK_DEBUG
 #define pbx_mutex_lock(x) {ast_debug(4, "[%d] %s:%d (%s) MUTEX_LOCK: " #x ": %p\n", (unsigned int) pthread_self(), __FILE__, __LINE__, __PRETTY_FUNCTION__, x); ast_mutex_lock((ast_mutex_t *)x);}
 #define pbx_mutex_trylock(x) {ast_debug(4, "[%d] %s:%d (%s) MUTEX_TRYLOCK: " #x ": %p\n", (unsigned int) pthread_self(), __FILE__, __LINE__, __PRETTY_FUNCTION__, x); ast_mutex_trylock((ast_mutex_t *)x);}
 #define pbx_mutex_unlock(x) {ast_mutex_unlock((ast_mutex_t *)x); ast_debug(4, "[%d] %s:%d (%s) MUTEX_UNLOCK: " #x ": %p\n", (unsigned int) pthread_self(), __FILE__, __LINE__, __PRETTY_FUNCTION__, x);}
@@ -313,6 +328,7 @@ typedef struct ast_event pbx_event_t;
 #define pbx_str_create ast_str_create
 #define pbx_str_alloca ast_str_alloca
 #define pbx_str_append ast_str_append
+#define pbx_str_append_va ast_str_append_va
 #define pbx_str_reset ast_str_reset
 #define pbx_str_strlen ast_str_strlen
 #define pbx_str_thread_get ast_str_thread_get
@@ -344,6 +360,7 @@ typedef struct ast_event pbx_event_t;
 #define pbx_variable_new ast_variable_new
 #define pbx_variable_retrieve ast_variable_retrieve
 #define pbx_variables_destroy ast_variables_destroy
+#define pbx_variables_dup ast_variables_dup
 #define pbx_strlen_zero ast_strlen_zero
 #if defined( CS_AST_HAS_STASIS )
 #define pbx_event_sub stasis_subscription
@@ -351,6 +368,11 @@ typedef struct ast_event pbx_event_t;
 #define pbx_event_sub ast_event_sub
 #endif
 #define pbx_context_find ast_context_find
+#define pbx_context_remove_extension_callerid2 ast_context_remove_extension_callerid2
+#define pbx_wrlock_contexts ast_wrlock_contexts
+#define pbx_unlock_contexts ast_unlock_contexts
+#define pbx_wrlock_context ast_wrlock_context
+#define pbx_unlock_context ast_unlock_context
 #define pbx_hangup ast_hangup
 #define pbx_atomic_fetchadd_int ast_atomic_fetchadd_int
 #define pbx_clear_flag ast_clear_flag
@@ -29,6 +29,8 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_line.h"
 #include "sccp_labels.h"
 #include "sccp_featureParkingLot.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_stats.h"
 
 /*!
  * \remarks
@@ -117,7 +119,7 @@ gcc_inline static sccp_device_t * const check_session_message_device(constSessio
 		errors++;
 	}
 
-	if (msg && (GLOB(debug) & (DEBUGCAT_MESSAGE)) != 0) {
+	if (msg && sccp_debug_enabled(DEBUGCAT_MESSAGE)) {
 		uint32_t mid = letohl(msg->header.lel_messageId);
 		pbx_log(LOG_NOTICE, "%s: SCCP Handle Message: %s(0x%04X) %d bytes length\n", sccp_session_getDesignator(s), msgtype2str(mid), mid, msg->header.length);
 		sccp_dump_msg(msg);
@@ -212,6 +214,7 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 {
 	const struct messageMap_cb *messageMap_cb = NULL;
 	uint32_t mid = 0;
+	struct timeval start = pbx_tvnow();
 	AUTO_RELEASE(sccp_device_t, device , NULL);
 
 	if (!s) {
@@ -235,6 +238,7 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 	} else {
 		pbx_log(LOG_WARNING, "SCCP: Unknown Message %x. Don't know how to handle it. Skipping.\n", mid);
 		handle_unknown_message(s, device, msg);
+		sccp_stats_message(SCCP_STATS_INBOUND, mid, &start);
 		return 0;
 	}
 	sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Got message %s (0x%X)\n", sccp_session_getDesignator(s), msgtype2str(mid), mid);
@@ -248,6 +252,7 @@ int sccp_handle_message(constMessagePtr msg, constSessionPtr s)
 	if (messageMap_cb->messageHandler_cb) {
 		messageMap_cb->messageHandler_cb(s, device, msg);
 	}
+	sccp_stats_message(SCCP_STATS_INBOUND, mid, &start);
 
 	if (device && sccp_device_getRegistrationState(device) == SKINNY_DEVICE_RS_PROGRESS && mid == device->protocol->registrationFinishedMessageId) {
 		sccp_dev_set_registered(device, SKINNY_DEVICE_RS_OK);
@@ -322,7 +327,7 @@ void handle_unknown_message(constSessionPtr no_s, devicePtr no_d, constMessagePt
 {
 	uint32_t mid = letohl(msg_in->header.lel_messageId);
 
-	if ((GLOB(debug) & DEBUGCAT_MESSAGE) != 0) {								// only show when debugging messages
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {								// only show when debugging messages
 		pbx_log(LOG_WARNING, "Unhandled SCCP Message: %s(0x%04X) %d bytes length\n", msgtype2str(mid), mid, msg_in->header.length);
 		sccp_dump_msg(msg_in);
 	}
@@ -445,7 +450,7 @@ void handle_XMLAlarmMessage(constSessionPtr s, devicePtr no_d, constMessagePtr m
 		   }
 		 */
 	}
-	if ((GLOB(debug) & DEBUGCAT_MESSAGE) != 0) {								// only show when debugging messages
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {								// only show when debugging messages
 		pbx_log(LOG_WARNING, "SCCP XMLAlarm Message: %s(0x%04X) %d bytes length\n", msgtype2str(mid), mid, msg_in->header.length);
 		sccp_dump_msg(msg_in);
 	}
@@ -462,7 +467,7 @@ void handle_LocationInfoMessage(constSessionPtr s, devicePtr d, constMessagePtr
 	char *xmldata = pbx_strdupa(msg_in->data.LocationInfoMessage.xmldata);
 	sccp_log(DEBUGCAT_DEVICE)(VERBOSE_PREFIX_2 "SCCP: LocationInfo (WIFI) Message: %s\n", xmldata);
 	
-	if ((GLOB(debug) & DEBUGCAT_MESSAGE) != 0) {								// only show when debugging messages
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {								// only show when debugging messages
 		sccp_dump_msg(msg_in);
         }
 }
@@ -1394,9 +1399,12 @@ void handle_unregister(constSessionPtr s, devicePtr device, constMessagePtr msg_
  */
 void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessagePtr none)
 {
-	btnlist *btn;
+	btnlist *btn = NULL;
 	int i;
 	uint8_t buttonCount = 0, lastUsedButtonPosition = 0;
+	uint64_t templateKey = 0;
+	boolean_t cacheable = FALSE;
+	sccp_buttontemplate_t *template = NULL;
 
 	sccp_msg_t *msg_out = NULL;
 
@@ -1411,7 +1419,18 @@ void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessag
 	if (d->buttonTemplate) {
 		sccp_free(d->buttonTemplate);
 	}
-	btn = d->buttonTemplate = sccp_make_button_template(d);
+	sccp_buttontemplate_setDeviceTemplate(d, NULL);
+
+	/* identical phones share the same layout, reuse it when all of its lines can be resolved for this device */
+	if ((cacheable = sccp_buttontemplate_key(d, &templateKey)) && (template = sccp_buttontemplate_find(templateKey))) {
+		if (!(btn = sccp_buttontemplate_apply(template, d))) {
+			sccp_buttontemplate_release(&template);
+		}
+	}
+	if (!btn) {
+		btn = sccp_make_button_template(d);
+	}
+	d->buttonTemplate = btn;
 
 	/* update lineButtons array */
 	sccp_line_createLineButtonsArray(d);
@@ -1423,6 +1442,18 @@ void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessag
 	}
 
 	REQ(msg_out, ButtonTemplateMessage);
+	if (template) {
+		uint32_t cachedButtonCount = 0, cachedTotalButtonCount = 0;
+
+		sccp_buttontemplate_getDefinition(template, msg_out->data.ButtonTemplateMessage.definition, &cachedButtonCount, &cachedTotalButtonCount);
+		msg_out->data.ButtonTemplateMessage.lel_buttonOffset = 0;
+		msg_out->data.ButtonTemplateMessage.lel_buttonCount = htolel(cachedButtonCount);
+		msg_out->data.ButtonTemplateMessage.lel_totalButtonCount = htolel(cachedTotalButtonCount);
+		sccp_buttontemplate_setDeviceTemplate(d, template);					/* instances were restored by sccp_buttontemplate_apply */
+		sccp_dev_createButtonInstancesArray(d);
+		sccp_dev_send(d, msg_out);
+		return;
+	}
 	for (i = 0; i < StationMaxButtonTemplateSize; i++) {
 		msg_out->data.ButtonTemplateMessage.definition[i].instanceNumber = btn[i].instance;
 
@@ -1496,6 +1527,10 @@ void sccp_handle_button_template_req(constSessionPtr s, devicePtr d, constMessag
 	}
 	/* done */
 
+	sccp_dev_createButtonInstancesArray(d);
+	if (cacheable) {
+		sccp_buttontemplate_setDeviceTemplate(d, sccp_buttontemplate_store(d, templateKey, btn, msg_out->data.ButtonTemplateMessage.definition, buttonCount, lastUsedButtonPosition + 1));
+	}
 	sccp_dev_send(d, msg_out);
 }
 
@@ -1510,13 +1545,16 @@ void handle_line_number(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	sccp_speed_t k;
 	sccp_buttonconfig_t *config;
 	uint8_t lineNumber = letohl(msg_in->data.LineStatReqMessage.lel_lineNumber);
+	sccp_buttontemplate_t *template = sccp_buttontemplate_getDeviceTemplate(d);
 	sccp_log((DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: Configuring line number %d\n", d->id, lineNumber);
 
-	/* if we find no regular line - it can be a speeddial with hint */
-	AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byid(d, lineNumber));
-	if (!l) {
+	memset(&k, 0, sizeof(k));
+	/* if we find no regular line - it can be a speeddial with hint, the cached template tells which one it is without walking the buttonconfig */
+	AUTO_RELEASE(sccp_line_t, l , (!template || sccp_buttontemplate_getLineInstance(template, lineNumber) == SCCP_BUTTONTEMPLATE_INSTANCE_LINE) ? sccp_line_find_byid(d, lineNumber) : NULL);
+	if (!l && (!template || sccp_buttontemplate_getSpeeddialInstance(template, lineNumber) != SCCP_BUTTONTEMPLATE_INSTANCE_NONE)) {
 		sccp_dev_speed_find_byindex(d, lineNumber, TRUE, &k);
 	}
+	sccp_buttontemplate_release(&template);
 
 	if (!l && !k.valid) {
 		pbx_log(LOG_ERROR, "%s: requested a line configuration for unknown line/speeddial %d\n", sccp_session_getDesignator(s), lineNumber);
@@ -1531,18 +1569,15 @@ void handle_line_number(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	char displayName[SCCP_MAX_LABEL + 1];
 	if (l) {
 		SCCP_LIST_LOCK(&d->buttonconfig);
-		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-			if (config->type == LINE && config->instance == lineNumber) {
-				if (config->button.line.subscriptionId && !sccp_strlen_zero(config->button.line.subscriptionId->label)) {
-					if (config->button.line.subscriptionId->replaceCid) {
-						snprintf(displayName, SCCP_MAX_LABEL, "%s", config->button.line.subscriptionId->label);
-					} else {
-						snprintf(displayName, SCCP_MAX_LABEL, "%s%s", l->label, config->button.line.subscriptionId->label);
-					}
+		if ((config = sccp_dev_buttonconfig_find_byinstance(d, LINE, lineNumber))) {
+			if (config->button.line.subscriptionId && !sccp_strlen_zero(config->button.line.subscriptionId->label)) {
+				if (config->button.line.subscriptionId->replaceCid) {
+					snprintf(displayName, SCCP_MAX_LABEL, "%s", config->button.line.subscriptionId->label);
 				} else {
-					snprintf(displayName, SCCP_MAX_LABEL, "%s", l->label);
+					snprintf(displayName, SCCP_MAX_LABEL, "%s%s", l->label, config->button.line.subscriptionId->label);
 				}
-				break;
+			} else {
+				snprintf(displayName, SCCP_MAX_LABEL, "%s", l->label);
 			}
 		}
 		SCCP_LIST_UNLOCK(&d->buttonconfig);
@@ -1555,13 +1590,10 @@ void handle_line_number(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 	if (l) {
 		/* set default line on device if based on "default" config option */
 		SCCP_LIST_LOCK(&d->buttonconfig);
-		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-			if (config->type == LINE && config->instance == lineNumber) {
-				if (config->button.line.options && strcasestr(config->button.line.options, "default")) {
-					d->defaultLineInstance = lineNumber;
-					sccp_log((DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "set defaultLineInstance to: %u\n", lineNumber);
-				}
-				break;
+		if ((config = sccp_dev_buttonconfig_find_byinstance(d, LINE, lineNumber))) {
+			if (config->button.line.options && strcasestr(config->button.line.options, "default")) {
+				d->defaultLineInstance = lineNumber;
+				sccp_log((DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "set defaultLineInstance to: %u\n", lineNumber);
 			}
 		}
 		SCCP_LIST_UNLOCK(&d->buttonconfig);
@@ -1578,6 +1610,7 @@ void handle_speed_dial_stat_req(constSessionPtr s, devicePtr d, constMessagePtr
 {
 	sccp_speed_t k;
 	sccp_msg_t *msg_out = NULL;
+	sccp_buttontemplate_t *template = NULL;
 
 	int wanted = letohl(msg_in->data.SpeedDialStatReqMessage.lel_speedDialNumber);
 
@@ -1586,7 +1619,12 @@ void handle_speed_dial_stat_req(constSessionPtr s, devicePtr d, constMessagePtr
 	REQ(msg_out, SpeedDialStatMessage);
 	msg_out->data.SpeedDialStatMessage.lel_speedDialNumber = htolel(wanted);
 
-	sccp_dev_speed_find_byindex(d, wanted, FALSE, &k);
+	memset(&k, 0, sizeof(k));
+	template = sccp_buttontemplate_getDeviceTemplate(d);
+	if (!template || sccp_buttontemplate_getSpeeddialInstance(template, wanted) != SCCP_BUTTONTEMPLATE_INSTANCE_NONE) {
+		sccp_dev_speed_find_byindex(d, wanted, FALSE, &k);
+	}
+	sccp_buttontemplate_release(&template);
 	if (k.valid) {
 		d->copyStr2Locale(d, msg_out->data.SpeedDialStatMessage.speedDialDirNumber, k.ext, sizeof(msg_out->data.SpeedDialStatMessage.speedDialDirNumber));
 		d->copyStr2Locale(d, msg_out->data.SpeedDialStatMessage.speedDialDisplayName, k.name, sizeof(msg_out->data.SpeedDialStatMessage.speedDialDisplayName));
@@ -2114,15 +2152,9 @@ static void handle_feature_action(constDevicePtr d, const int instance, const bo
 
 	sccp_log((DEBUGCAT_FEATURE_BUTTON + DEBUGCAT_FEATURE)) (VERBOSE_PREFIX_3 "%s: instance: %d, toggle: %s\n", d->id, instance, (toggleState) ? "yes" : "no");
 
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		if (config->instance == instance && config->type == FEATURE) {
-			// sccp_log((DEBUGCAT_FEATURE_BUTTON + DEBUGCAT_FEATURE)) (VERBOSE_PREFIX_3 "%s: toggle status from %d\n", d->id, config->button.feature.status);
-			// config->button.feature.status = (config->button.feature.status == 0) ? 1 : 0;
-			// sccp_log((DEBUGCAT_FEATURE_BUTTON + DEBUGCAT_FEATURE)) (VERBOSE_PREFIX_3 " to %d\n", config->button.feature.status);
-			break;
-		}
-
-	}
+	SCCP_LIST_LOCK(&((devicePtr)d)->buttonconfig);
+	config = sccp_dev_buttonconfig_find_byinstance(d, FEATURE, instance);
+	SCCP_LIST_UNLOCK(&((devicePtr)d)->buttonconfig);
 
 	if (!config || !config->type || config->type != FEATURE) {
 		pbx_log(LOG_WARNING, "%s: Couldn find feature with ID = %d \n", d->id, instance);
@@ -2478,6 +2510,7 @@ void handle_offhook(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 			//sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: Using line %s\n", d->id, l->name);
 			AUTO_RELEASE(sccp_channel_t, new_channel , NULL);
 			new_channel = sccp_channel_newcall(l, d, (!sccp_strlen_zero(l->adhocNumber) ? l->adhocNumber : NULL), SKINNY_CALLTYPE_OUTBOUND, NULL, NULL);
+			sccp_channel_markCallSpan(new_channel, SCCP_CALLSPAN_OFFHOOK);
 		}
 	}
 }
@@ -3123,6 +3156,7 @@ void handle_keypad_button(constSessionPtr s, devicePtr d, constMessagePtr msg_in
 		return;
 	}
 
+	sccp_channel_markCallSpan(channel, SCCP_CALLSPAN_FIRSTDIGIT);
 	len = sccp_strlen(channel->dialedNumber);
 	if (len + 1 >= (SCCP_MAX_EXTENSION)) {
 		/*! \todo Shouldn't we only skip displaying the number to the phone (Maybe even showing '...' at the end), but still dial it ? */
@@ -4051,10 +4085,11 @@ void handle_feature_stat_req(constSessionPtr s, devicePtr d, constMessagePtr msg
 	}
 #endif
 
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		if (config->instance == featureIndex && config->type == FEATURE) {
-			sccp_feat_changed(d, NULL, config->button.feature.id);
-		}
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	config = sccp_dev_buttonconfig_find_byinstance(d, FEATURE, featureIndex);
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+	if (config) {
+		sccp_feat_changed(d, NULL, config->button.feature.id);
 	}
 }
 
@@ -4642,7 +4677,7 @@ void handle_device_to_user(constSessionPtr s, devicePtr d, constMessagePtr msg_i
  */
 void handle_device_to_user_response(constSessionPtr s, devicePtr d, constMessagePtr msg_in)
 {
-	if ((GLOB(debug) & DEBUGCAT_MESSAGE) != 0) {
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {
 		uint32_t appID;
 		uint32_t lineInstance;
 		uint32_t callReference;
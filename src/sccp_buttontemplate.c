@@ -0,0 +1,548 @@
+/*!
+ * \file        sccp_buttontemplate.c
+ * \brief       SCCP Button Template Cache
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Laying out the button template walks the buttonconfig list against every free button position, which is repeated for every
+ * registration of every phone. The layout only depends on the device type, addons, protocol version, config_type and the shape of the
+ * buttonconfig (types, which labels/hints are set, feature ids), not on line names or speeddial numbers. Identical phones therefore share one
+ * resolved template:
+ * - the cache key is a hash over exactly those inputs, lines are resolved by name per device when the template is applied
+ * - a template is only stored when every configured line could be resolved, and is only applied when all its lines can be resolved again
+ * - the rendered ButtonTemplateMessage definitions are kept as well, and the per instance maps let the LineStatReq / SpeedDialStatReq
+ *   handlers answer unknown instances without walking the buttonconfig
+ * - entries are immutable and refcounted, a device keeps the template it registered with, reload drops the ones no device uses anymore
+ * - the template of a device is swapped on (re)registration while the session thread may be answering stat requests, it is only accessed
+ *   through sccp_buttontemplate_getDeviceTemplate / sccp_buttontemplate_setDeviceTemplate
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_atomic.h"
+#include "sccp_device.h"
+#include "sccp_line.h"
+#include "sccp_utils.h"
+#include "sccp_featureParkingLot.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_BUTTONTEMPLATE_HASH_OFFSET 14695981039346656037ULL
+#define SCCP_BUTTONTEMPLATE_HASH_PRIME 1099511628211ULL
+
+/*!
+ * \brief Resolved state of one buttonconfig entry, in buttonconfig list order
+ */
+typedef struct sccp_buttontemplate_config {
+	uint8_t instance;
+	uint8_t button;												/*!< template position + 1 of a line button, 0 otherwise */
+	boolean_t setFeatureStatus;
+	uint32_t featureStatus;
+} sccp_buttontemplate_config_t;
+
+struct sccp_buttontemplate {
+	SCCP_LIST_ENTRY (sccp_buttontemplate_t) list;
+	volatile int refcount;
+	uint64_t key;
+	btnlist btn[StationMaxButtonTemplateSize];								/*!< resolved layout, ptr is always NULL */
+	StationButtonDefinition definition[StationMaxButtonTemplateSize];					/*!< rendered ButtonTemplateMessage definitions */
+	uint32_t buttonCount;
+	uint32_t totalButtonCount;
+	uint8_t lineInstances[StationMaxButtonTemplateSize + 1];						/*!< sccp_buttontemplate_instance_t by line instance */
+	uint8_t speeddialInstances[StationMaxButtonTemplateSize + 1];						/*!< sccp_buttontemplate_instance_t by speeddial instance */
+	uint16_t numConfigs;
+	sccp_buttontemplate_config_t configs[0];
+};
+
+SCCP_LIST_HEAD (sccp_buttontemplate_list, sccp_buttontemplate_t);
+
+static struct {
+	struct sccp_buttontemplate_list templates;
+	sccp_buttontemplate_stats_t stats;
+} sccp_buttontemplate_cache;
+AST_MUTEX_DEFINE_STATIC(buttontemplate_refcount_lock);								/* only used by platforms without atomic operations */
+AST_MUTEX_DEFINE_STATIC(buttontemplate_device_lock);								/* protects sccp_device_t->buttonTemplateCache */
+
+static uint64_t sccp_buttontemplate_hash(uint64_t hash, const void *buffer, size_t len)
+{
+	const unsigned char *c = (const unsigned char *) buffer;
+	const unsigned char *end = c + len;
+
+	for (; c < end; c++) {
+		hash = (hash ^ *c) * SCCP_BUTTONTEMPLATE_HASH_PRIME;
+	}
+	return hash;
+}
+
+#define SCCP_BUTTONTEMPLATE_HASH_VALUE(_hash, _value) ({ __typeof__(_value) _v = (_value); sccp_buttontemplate_hash(_hash, &_v, sizeof(_v)); })
+
+/*!
+ * \brief Compute the cache key for the button template of a device
+ * \return FALSE when the template of this device cannot be cached (anonymous/hotline, or buttons that already have an instance)
+ */
+boolean_t sccp_buttontemplate_key(devicePtr d, uint64_t * key)
+{
+	sccp_buttonconfig_t *config = NULL;
+	uint64_t hash = SCCP_BUTTONTEMPLATE_HASH_OFFSET;
+	boolean_t res = TRUE;
+
+	if (!d || d->isAnonymous) {
+		return FALSE;
+	}
+	hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint32_t) d->skinny_type);
+	hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (int32_t) sccp_addons_taps(d));
+	hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint32_t) d->inuseprotocolversion);
+	hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint8_t) (iParkingLot.attachObserver ? 1 : 0));
+	hash = sccp_buttontemplate_hash(hash, d->config_type, sccp_strlen(d->config_type) + 1);
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		if (config->instance > 0) {
+			res = FALSE;
+			break;
+		}
+		hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint32_t) config->type);
+		hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint8_t) sccp_strlen_zero(config->label));
+		switch (config->type) {
+			case LINE:
+				hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint8_t) sccp_strlen_zero(config->button.line.name));
+				break;
+			case SPEEDDIAL:
+				hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint8_t) sccp_strlen_zero(config->button.speeddial.hint));
+				break;
+			case FEATURE:
+				hash = SCCP_BUTTONTEMPLATE_HASH_VALUE(hash, (uint32_t) config->button.feature.id);
+				break;
+			default:
+				break;
+		}
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+	*key = hash;
+	return res;
+}
+
+static sccp_buttontemplate_t *sccp_buttontemplate_retain(sccp_buttontemplate_t * tpl)
+{
+	(void) ATOMIC_INCR(&tpl->refcount, 1, &buttontemplate_refcount_lock);
+	return tpl;
+}
+
+void sccp_buttontemplate_release(sccp_buttontemplate_t ** tpl)
+{
+	if (*tpl && ATOMIC_DECR(&(*tpl)->refcount, 1, &buttontemplate_refcount_lock) == 1) {
+		sccp_free(*tpl);
+	}
+	*tpl = NULL;
+}
+
+/*!
+ * \brief Get the template a device registered with
+ * \return retained template or NULL
+ */
+sccp_buttontemplate_t *sccp_buttontemplate_getDeviceTemplate(constDevicePtr d)
+{
+	sccp_buttontemplate_t *tpl = NULL;
+
+	pbx_mutex_lock(&buttontemplate_device_lock);
+	if (d->buttonTemplateCache) {
+		tpl = sccp_buttontemplate_retain(d->buttonTemplateCache);
+	}
+	pbx_mutex_unlock(&buttontemplate_device_lock);
+	return tpl;
+}
+
+/*!
+ * \brief Replace the template a device registered with, takes over the reference to tpl (may be NULL)
+ */
+void sccp_buttontemplate_setDeviceTemplate(devicePtr d, sccp_buttontemplate_t * tpl)
+{
+	sccp_buttontemplate_t *old = NULL;
+
+	pbx_mutex_lock(&buttontemplate_device_lock);
+	old = d->buttonTemplateCache;
+	d->buttonTemplateCache = tpl;
+	pbx_mutex_unlock(&buttontemplate_device_lock);
+	sccp_buttontemplate_release(&old);
+}
+
+/*!
+ * \brief Find a cached template
+ * \return retained template or NULL
+ */
+sccp_buttontemplate_t *sccp_buttontemplate_find(const uint64_t key)
+{
+	sccp_buttontemplate_t *tpl = NULL;
+
+	SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+	SCCP_LIST_TRAVERSE(&sccp_buttontemplate_cache.templates, tpl, list) {
+		if (tpl->key == key) {
+			sccp_buttontemplate_retain(tpl);
+			sccp_buttontemplate_cache.stats.hits++;
+			break;
+		}
+	}
+	if (!tpl) {
+		sccp_buttontemplate_cache.stats.misses++;
+	}
+	SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+	return tpl;
+}
+
+/*!
+ * \brief Store the freshly built template of a device
+ * \note called after the template was built and all instances were assigned, d->buttonconfig reflects the result
+ * \return retained template, or NULL when it cannot be cached (a configured line could not be resolved)
+ */
+sccp_buttontemplate_t *sccp_buttontemplate_store(devicePtr d, const uint64_t key, const btnlist * btn, const StationButtonDefinition * definition, const uint32_t buttonCount, const uint32_t totalButtonCount)
+{
+	sccp_buttontemplate_t *tpl = NULL, *existing = NULL;
+	sccp_buttonconfig_t *config = NULL;
+	uint16_t numConfigs = 0, ordinal = 0;
+	uint8_t i = 0;
+	boolean_t resolved = TRUE;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	numConfigs = SCCP_LIST_GETSIZE(&d->buttonconfig);
+	if (!(tpl = sccp_calloc(sizeof *tpl + numConfigs * sizeof(sccp_buttontemplate_config_t), 1))) {
+		SCCP_LIST_UNLOCK(&d->buttonconfig);
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, DEV_ID_LOG(d));
+		return NULL;
+	}
+	tpl->refcount = 1;
+	tpl->key = key;
+	tpl->numConfigs = numConfigs;
+	for (i = 0; i < StationMaxButtonTemplateSize; i++) {
+		tpl->btn[i].type = btn[i].type;
+		tpl->btn[i].instance = btn[i].instance;
+	}
+	memcpy(tpl->definition, definition, sizeof(tpl->definition));
+	tpl->buttonCount = buttonCount;
+	tpl->totalButtonCount = totalButtonCount;
+
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		sccp_buttontemplate_config_t *cached = &tpl->configs[ordinal++];
+
+		cached->instance = config->instance;
+		if (config->instance > StationMaxButtonTemplateSize) {
+			resolved = FALSE;									/* outside of the instance maps */
+			break;
+		}
+		if (config->type == LINE && !sccp_strlen_zero(config->button.line.name)) {
+			if (!config->instance) {
+				resolved = FALSE;								/* line did not resolve, the layout is not reusable */
+				break;
+			}
+			for (i = 0; i < StationMaxButtonTemplateSize; i++) {
+				if (btn[i].type == SKINNY_BUTTONTYPE_LINE && btn[i].ptr && btn[i].instance == config->instance) {
+					cached->button = i + 1;
+					break;
+				}
+			}
+			tpl->lineInstances[config->instance] = SCCP_BUTTONTEMPLATE_INSTANCE_LINE;
+		} else if (config->type == SPEEDDIAL && config->instance) {
+			tpl->speeddialInstances[config->instance] = sccp_strlen_zero(config->button.speeddial.hint) ? SCCP_BUTTONTEMPLATE_INSTANCE_SPEEDDIAL : SCCP_BUTTONTEMPLATE_INSTANCE_HINTSPEEDDIAL;
+		} else if (config->type == FEATURE && config->button.feature.id == SCCP_FEATURE_PARKINGLOT) {
+			cached->setFeatureStatus = TRUE;
+			cached->featureStatus = config->button.feature.status;
+		}
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+	if (!resolved) {
+		sccp_free(tpl);
+		SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+		sccp_buttontemplate_cache.stats.uncacheable++;
+		SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+		return NULL;
+	}
+
+	SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+	SCCP_LIST_TRAVERSE(&sccp_buttontemplate_cache.templates, existing, list) {
+		if (existing->key == key) {
+			break;
+		}
+	}
+	if (existing) {												/* stored concurrently by an identical phone */
+		sccp_free(tpl);
+		tpl = sccp_buttontemplate_retain(existing);
+	} else {
+		SCCP_LIST_INSERT_HEAD(&sccp_buttontemplate_cache.templates, sccp_buttontemplate_retain(tpl), list);
+		sccp_buttontemplate_cache.stats.entries = SCCP_LIST_GETSIZE(&sccp_buttontemplate_cache.templates);
+	}
+	SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+	sccp_log((DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: Stored button template %016" PRIx64 " (%d buttons)\n", DEV_ID_LOG(d), key, buttonCount);
+	return tpl;
+}
+
+/*!
+ * \brief Apply a cached template to a device: assign the instances, resolve and attach the lines
+ * \return new button list (to be stored in d->buttonTemplate), or NULL when the template does not fit (anymore) and must be built
+ */
+btnlist *sccp_buttontemplate_apply(const sccp_buttontemplate_t * tpl, devicePtr d)
+{
+	btnlist *btn = NULL;
+	sccp_buttonconfig_t *config = NULL;
+	uint16_t ordinal = 0;
+	uint8_t i = 0;
+	boolean_t defaultLineSet = FALSE;
+	boolean_t fits = TRUE;
+
+	if (!(btn = sccp_calloc(sizeof *btn, StationMaxButtonTemplateSize))) {
+		return NULL;
+	}
+	sccp_dev_build_buttontemplate(d, btn);									/* device type specific setup (callbacks, capabilities) */
+	for (i = 0; i < StationMaxButtonTemplateSize; i++) {
+		btn[i].type = tpl->btn[i].type;
+		btn[i].instance = tpl->btn[i].instance;
+		btn[i].ptr = NULL;
+	}
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	if (SCCP_LIST_GETSIZE(&d->buttonconfig) != tpl->numConfigs) {
+		fits = FALSE;
+	}
+	/* resolve all lines first, so that nothing is attached when one of them is missing */
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		const sccp_buttontemplate_config_t *cached = &tpl->configs[ordinal++];
+
+		if (!fits || config->instance > 0) {
+			fits = FALSE;
+			break;
+		}
+		if (cached->button && config->type == LINE) {
+			if (!(btn[cached->button - 1].ptr = sccp_line_find_byname(config->button.line.name, TRUE))) {
+				fits = FALSE;
+				break;
+			}
+		}
+	}
+	if (fits) {
+		ordinal = 0;
+		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+			const sccp_buttontemplate_config_t *cached = &tpl->configs[ordinal++];
+
+			config->instance = cached->instance;
+			if (cached->button && config->type == LINE) {
+				sccp_line_addDevice((sccp_line_t *) btn[cached->button - 1].ptr, d, config->instance, config->button.line.subscriptionId);
+				if (FALSE == defaultLineSet && !d->defaultLineInstance) {
+					d->defaultLineInstance = config->instance;
+					defaultLineSet = TRUE;
+				}
+			} else if (cached->setFeatureStatus) {
+				config->button.feature.status = cached->featureStatus;
+			}
+		}
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+
+	if (!fits) {
+		for (i = 0; i < StationMaxButtonTemplateSize; i++) {
+			if (btn[i].ptr) {
+				sccp_line_t *line = btn[i].ptr;
+
+				sccp_line_release(&line);							/* explicit release of the line found above */
+			}
+		}
+		sccp_free(btn);
+		sccp_log((DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: Cached button template %016" PRIx64 " does not fit, building\n", DEV_ID_LOG(d), tpl->key);
+		return NULL;
+	}
+	sccp_log((DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: Using cached button template %016" PRIx64 "\n", DEV_ID_LOG(d), tpl->key);
+	return btn;
+}
+
+void sccp_buttontemplate_getDefinition(const sccp_buttontemplate_t * tpl, StationButtonDefinition * definition, uint32_t * buttonCount, uint32_t * totalButtonCount)
+{
+	memcpy(definition, tpl->definition, sizeof(tpl->definition));
+	*buttonCount = tpl->buttonCount;
+	*totalButtonCount = tpl->totalButtonCount;
+}
+
+sccp_buttontemplate_instance_t sccp_buttontemplate_getLineInstance(const sccp_buttontemplate_t * tpl, const uint16_t instance)
+{
+	return instance <= StationMaxButtonTemplateSize ? (sccp_buttontemplate_instance_t) tpl->lineInstances[instance] : SCCP_BUTTONTEMPLATE_INSTANCE_NONE;
+}
+
+sccp_buttontemplate_instance_t sccp_buttontemplate_getSpeeddialInstance(const sccp_buttontemplate_t * tpl, const uint16_t instance)
+{
+	return instance <= StationMaxButtonTemplateSize ? (sccp_buttontemplate_instance_t) tpl->speeddialInstances[instance] : SCCP_BUTTONTEMPLATE_INSTANCE_NONE;
+}
+
+/*!
+ * \brief Drop the templates no registered device uses anymore (called after reload)
+ * \note templates in use stay valid: a device whose buttons changed during reload is restarted and will look up its new key
+ */
+void sccp_buttontemplate_purge(void)
+{
+	sccp_buttontemplate_t *tpl = NULL;
+	uint32_t purged = 0;
+
+	SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_buttontemplate_cache.templates, tpl, list) {
+		if (tpl->refcount == 1) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			sccp_buttontemplate_release(&tpl);
+			purged++;
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	sccp_buttontemplate_cache.stats.purged += purged;
+	sccp_buttontemplate_cache.stats.entries = SCCP_LIST_GETSIZE(&sccp_buttontemplate_cache.templates);
+	SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+	sccp_log((DEBUGCAT_CONFIG + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "SCCP: Purged %d unused button templates\n", purged);
+}
+
+void sccp_buttontemplate_getStats(sccp_buttontemplate_stats_t * stats)
+{
+	SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+	*stats = sccp_buttontemplate_cache.stats;
+	SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+}
+
+void sccp_buttontemplate_module_start(void)
+{
+	SCCP_LIST_HEAD_INIT(&sccp_buttontemplate_cache.templates);
+	memset(&sccp_buttontemplate_cache.stats, 0, sizeof(sccp_buttontemplate_cache.stats));
+}
+
+void sccp_buttontemplate_module_stop(void)
+{
+	sccp_buttontemplate_t *tpl = NULL;
+
+	SCCP_LIST_LOCK(&sccp_buttontemplate_cache.templates);
+	while ((tpl = SCCP_LIST_REMOVE_HEAD(&sccp_buttontemplate_cache.templates, list))) {
+		sccp_buttontemplate_release(&tpl);
+	}
+	SCCP_LIST_UNLOCK(&sccp_buttontemplate_cache.templates);
+	SCCP_LIST_HEAD_DESTROY(&sccp_buttontemplate_cache.templates);
+}
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+static sccp_buttonconfig_t *sccp_buttontemplate_testButton(sccp_device_t * d, sccp_config_buttontype_t type, char *label, char *name, char *hint)
+{
+	sccp_buttonconfig_t *config = sccp_calloc(sizeof *config, 1);
+
+	config->type = type;
+	config->label = label;
+	if (type == LINE) {
+		config->button.line.name = name;
+	} else if (type == SPEEDDIAL) {
+		config->button.speeddial.ext = name;
+		config->button.speeddial.hint = hint;
+	}
+	SCCP_LIST_INSERT_TAIL(&d->buttonconfig, config, list);
+	return config;
+}
+
+static void sccp_buttontemplate_testDevice(sccp_device_t * d, char *line)
+{
+	memset(d, 0, sizeof *d);
+	d->skinny_type = SKINNY_DEVICETYPE_CISCO7942;
+	d->inuseprotocolversion = 17;
+	sccp_copy_string(d->config_type, "7942", sizeof(d->config_type));
+	SCCP_LIST_HEAD_INIT(&d->addons);
+	SCCP_LIST_HEAD_INIT(&d->buttonconfig);
+	sccp_buttontemplate_testButton(d, LINE, "", line, NULL);
+	sccp_buttontemplate_testButton(d, SPEEDDIAL, "Voicemail", "*97", "");
+	sccp_buttontemplate_testButton(d, SPEEDDIAL, "Reception", "100", "100@hints");
+}
+
+static void sccp_buttontemplate_testDeviceClean(sccp_device_t * d)
+{
+	sccp_buttonconfig_t *config = NULL;
+
+	while ((config = SCCP_LIST_REMOVE_HEAD(&d->buttonconfig, list))) {
+		sccp_free(config);
+	}
+	SCCP_LIST_HEAD_DESTROY(&d->buttonconfig);
+	SCCP_LIST_HEAD_DESTROY(&d->addons);
+}
+
+AST_TEST_DEFINE(sccp_buttontemplate_cache_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "cache";
+			info->category = "/channels/chan_sccp/buttontemplate/";
+			info->summary = "chan-sccp-b button template cache test";
+			info->description = "verify that identical phones share a cached button template and that its instance maps are correct";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	sccp_device_t d1, d2;
+	sccp_buttonconfig_t *config = NULL;
+	btnlist btn[StationMaxButtonTemplateSize];
+	StationButtonDefinition definition[StationMaxButtonTemplateSize];
+	uint64_t key1 = 0, key2 = 0;
+	uint8_t i = 0;
+
+	sccp_buttontemplate_testDevice(&d1, "100");
+	sccp_buttontemplate_testDevice(&d2, "200");
+
+	pbx_test_status_update(test, "Key...\n");
+	pbx_test_validate(test, sccp_buttontemplate_key(&d1, &key1) && sccp_buttontemplate_key(&d2, &key2));
+	pbx_test_validate(test, key1 == key2);									/* line names do not matter */
+	config = sccp_buttontemplate_testButton(&d2, FEATURE, "Park", NULL, NULL);
+	config->button.feature.id = SCCP_FEATURE_PARKINGLOT;
+	pbx_test_validate(test, sccp_buttontemplate_key(&d2, &key2) && key1 != key2);
+	d2.inuseprotocolversion = 11;
+	pbx_test_validate(test, sccp_buttontemplate_key(&d2, &key1) && key1 != key2);
+	d2.isAnonymous = TRUE;
+	pbx_test_validate(test, !sccp_buttontemplate_key(&d2, &key2));
+	pbx_test_validate(test, sccp_buttontemplate_key(&d1, &key1));
+
+	pbx_test_status_update(test, "Store...\n");
+	memset(btn, 0, sizeof(btn));
+	memset(definition, 0, sizeof(definition));
+	i = 1;
+	SCCP_LIST_TRAVERSE(&d1.buttonconfig, config, list) {
+		config->instance = i;
+		btn[i - 1].instance = i;
+		btn[i - 1].type = config->type == LINE ? SKINNY_BUTTONTYPE_LINE : SKINNY_BUTTONTYPE_SPEEDDIAL;
+		btn[i - 1].ptr = config->type == LINE ? (void *) config : NULL;					/* stand in for the resolved line */
+		i++;
+	}
+	sccp_buttontemplate_t *tpl = sccp_buttontemplate_store(&d1, key1, btn, definition, 3, 3);
+	pbx_test_validate(test, tpl != NULL);
+	if (tpl) {
+		pbx_test_validate(test, sccp_buttontemplate_getLineInstance(tpl, 1) == SCCP_BUTTONTEMPLATE_INSTANCE_LINE);
+		pbx_test_validate(test, sccp_buttontemplate_getLineInstance(tpl, 2) == SCCP_BUTTONTEMPLATE_INSTANCE_NONE);
+		pbx_test_validate(test, sccp_buttontemplate_getSpeeddialInstance(tpl, 2) == SCCP_BUTTONTEMPLATE_INSTANCE_SPEEDDIAL);
+		pbx_test_validate(test, sccp_buttontemplate_getSpeeddialInstance(tpl, 3) == SCCP_BUTTONTEMPLATE_INSTANCE_HINTSPEEDDIAL);
+		pbx_test_validate(test, sccp_buttontemplate_getSpeeddialInstance(tpl, 4) == SCCP_BUTTONTEMPLATE_INSTANCE_NONE);
+		pbx_test_validate(test, sccp_buttontemplate_getSpeeddialInstance(tpl, 300) == SCCP_BUTTONTEMPLATE_INSTANCE_NONE);
+
+		sccp_buttontemplate_t *found = sccp_buttontemplate_find(key1);
+		pbx_test_validate(test, found == tpl);
+		sccp_buttontemplate_release(&found);
+		sccp_buttontemplate_release(&tpl);
+	}
+
+	pbx_test_status_update(test, "Unresolved line is not cached...\n");
+	SCCP_LIST_FIRST(&d1.buttonconfig)->instance = 0;
+	pbx_test_validate(test, sccp_buttontemplate_store(&d1, key1 + 1, btn, definition, 3, 3) == NULL);
+
+	sccp_buttontemplate_purge();
+	pbx_test_validate(test, (tpl = sccp_buttontemplate_find(key1)) == NULL);
+	sccp_buttontemplate_release(&tpl);
+
+	sccp_buttontemplate_testDeviceClean(&d1);
+	sccp_buttontemplate_testDeviceClean(&d2);
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_buttontemplate_cache_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_buttontemplate_cache_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
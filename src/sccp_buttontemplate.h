@@ -0,0 +1,47 @@
+/*!
+ * \file        sccp_buttontemplate.h
+ * \brief       SCCP Button Template Cache Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief What a button instance resolves to in a cached button template
+ */
+typedef enum {
+	SCCP_BUTTONTEMPLATE_INSTANCE_NONE = 0,
+	SCCP_BUTTONTEMPLATE_INSTANCE_LINE,
+	SCCP_BUTTONTEMPLATE_INSTANCE_SPEEDDIAL,
+	SCCP_BUTTONTEMPLATE_INSTANCE_HINTSPEEDDIAL,
+} sccp_buttontemplate_instance_t;
+
+/*!
+ * \brief Button Template Cache Statistics
+ */
+typedef struct sccp_buttontemplate_stats {
+	uint32_t entries;
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t uncacheable;
+	uint32_t purged;
+} sccp_buttontemplate_stats_t;
+
+SCCP_API void SCCP_CALL sccp_buttontemplate_module_start(void);
+SCCP_API void SCCP_CALL sccp_buttontemplate_module_stop(void);
+SCCP_API boolean_t SCCP_CALL sccp_buttontemplate_key(devicePtr d, uint64_t * key);
+SCCP_API sccp_buttontemplate_t * SCCP_CALL sccp_buttontemplate_find(const uint64_t key);
+SCCP_API sccp_buttontemplate_t * SCCP_CALL sccp_buttontemplate_store(devicePtr d, const uint64_t key, const btnlist * btn, const StationButtonDefinition * definition, const uint32_t buttonCount, const uint32_t totalButtonCount);
+SCCP_API btnlist * SCCP_CALL sccp_buttontemplate_apply(const sccp_buttontemplate_t * tpl, devicePtr d);
+SCCP_API void SCCP_CALL sccp_buttontemplate_getDefinition(const sccp_buttontemplate_t * tpl, StationButtonDefinition * definition, uint32_t * buttonCount, uint32_t * totalButtonCount);
+SCCP_API sccp_buttontemplate_instance_t SCCP_CALL sccp_buttontemplate_getLineInstance(const sccp_buttontemplate_t * tpl, const uint16_t instance);
+SCCP_API sccp_buttontemplate_instance_t SCCP_CALL sccp_buttontemplate_getSpeeddialInstance(const sccp_buttontemplate_t * tpl, const uint16_t instance);
+SCCP_API void SCCP_CALL sccp_buttontemplate_release(sccp_buttontemplate_t ** tpl);
+SCCP_API sccp_buttontemplate_t * SCCP_CALL sccp_buttontemplate_getDeviceTemplate(constDevicePtr d);
+SCCP_API void SCCP_CALL sccp_buttontemplate_setDeviceTemplate(devicePtr d, sccp_buttontemplate_t * tpl);
+SCCP_API void SCCP_CALL sccp_buttontemplate_purge(void);
+SCCP_API void SCCP_CALL sccp_buttontemplate_getStats(sccp_buttontemplate_stats_t * stats);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -45,24 +45,49 @@ enum callinfo_types {
 	VOICEMAILBOX,
 };
 
+/*!
+ * \brief Expanded (mutable) CallInfo Content, only used by writers to build the next snapshot
+ */
+struct ci_content {
+	callinfo_entry_t entries[HUNT_PILOT + 1];
+	uint32_t originalCdpnRedirectReason;									/*!< Original Called Party Redirect Reason */
+	uint32_t lastRedirectingReason;										/*!< Last Redirecting Reason */
+	sccp_callerid_presentation_t presentation;								/*!< Should this callerinfo be shown (privacy) */
+	uint8_t callInstance;
+};
+
+/*!
+ * \brief Immutable CallInfo Snapshot
+ *
+ * Never modified after it has been published. All strings live in one pool, identical strings are stored only once
+ * and the empty string is always at offset 0.
+ */
+struct sccp_callinfo_snapshot {
+	volatile int refcount;
+	uint32_t version;											/*!< incremented on every published change */
+	uint16_t str[HUNT_PILOT + 1][VOICEMAILBOX + 1];								/*!< offsets into pool */
+	uint16_t valid;												/*!< NumberValid / VoiceMailboxValid bits, see CALLINFO_VALID_BIT */
+	uint32_t originalCdpnRedirectReason;									/*!< Original Called Party Redirect Reason */
+	uint32_t lastRedirectingReason;										/*!< Last Redirecting Reason */
+	sccp_callerid_presentation_t presentation;								/*!< Should this callerinfo be shown (privacy) */
+	uint8_t callInstance;
+	uint16_t poolsize;
+	char pool[];
+};
+#define CALLINFO_VALID_BIT(_group, _type) (1 << ((_group) * 2 + ((_type) == VOICEMAILBOX ? 1 : 0)))
+#define CALLINFO_POOL_MAX (1 + (HUNT_PILOT + 1) * (StationMaxNameSize + 2 * StationMaxDirnumSize))
+
 /*!
  * \brief SCCP CallInfo Structure
  */
 struct sccp_callinfo {
-	pbx_rwlock_t lock;
-	struct ci_content {
-		callinfo_entry_t entries[HUNT_PILOT + 1];
-		uint32_t originalCdpnRedirectReason;								/*!< Original Called Party Redirect Reason */
-		uint32_t lastRedirectingReason;									/*!< Last Redirecting Reason */
-		sccp_callerid_presentation_t presentation;							/*!< Should this callerinfo be shown (privacy) */
-		boolean_t changed;										/*! Changes since last send */
-		uint8_t callInstance;
-	} content;
+	sccp_mutex_t lock;											/*!< only protects swapping / retaining the snapshot pointer */
+	sccp_mutex_t writelock;											/*!< serializes writers (expand, modify, publish) */
+	struct sccp_callinfo_snapshot *snapshot;								/*!< current content, never NULL */
+	uint32_t sentVersion;											/*!< snapshot version last sent to the device */
 };														/*!< SCCP CallInfo Structure */
 
-#define sccp_callinfo_wrlock(x) pbx_rwlock_wrlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
-#define sccp_callinfo_rdlock(x) pbx_rwlock_rdlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
-#define sccp_callinfo_unlock(x) pbx_rwlock_unlock(&((sccp_callinfo_t * const)(x))->lock)				/* discard const */
+AST_MUTEX_DEFINE_STATIC(callinfo_refcount_lock);									/* only used by platforms without atomic operations */
 
 struct callinfo_lookup {
 	const enum callinfo_groups group;
@@ -88,20 +113,166 @@ struct callinfo_lookup {
 	/* *INDENT-ON* */
 };
 
+/* =================================================================================================================== Snapshot */
+static gcc_inline const char *callinfo_snapshot_str(const struct sccp_callinfo_snapshot * const snapshot, enum callinfo_groups group, enum callinfo_types type)
+{
+	return &snapshot->pool[snapshot->str[group][type]];
+}
+
+static gcc_inline boolean_t callinfo_snapshot_valid(const struct sccp_callinfo_snapshot * const snapshot, enum callinfo_groups group, enum callinfo_types type)
+{
+	return (type == NAME || (snapshot->valid & CALLINFO_VALID_BIT(group, type))) ? TRUE : FALSE;
+}
+
+/*!
+ * \brief Intern str into pool, returning the offset of an identical string already in the pool when there is one
+ */
+static uint16_t callinfo_snapshot_intern(char *pool, uint16_t *poolsize, const char *str)
+{
+	uint16_t offset = 1;
+	size_t len = 0;
+
+	if (sccp_strlen_zero(str)) {
+		return 0;
+	}
+	while (offset < *poolsize) {
+		if (!strcmp(&pool[offset], str)) {
+			return offset;
+		}
+		offset += strlen(&pool[offset]) + 1;
+	}
+	len = strlen(str) + 1;
+	memcpy(&pool[*poolsize], str, len);
+	*poolsize += len;
+	return offset;
+}
+
+/*!
+ * \brief Build a new immutable snapshot from expanded content
+ */
+static struct sccp_callinfo_snapshot *callinfo_snapshot_create(const struct ci_content * const content, uint32_t version)
+{
+	struct sccp_callinfo_snapshot *snapshot = NULL;
+	char pool[CALLINFO_POOL_MAX];
+	uint16_t str[HUNT_PILOT + 1][VOICEMAILBOX + 1];
+	uint16_t poolsize = 1;
+	uint16_t valid = 0;
+	int group = 0;
+
+	pool[0] = '\0';
+	for (group = CALLED_PARTY; group <= HUNT_PILOT; group++) {
+		const callinfo_entry_t *entry = &content->entries[group];
+		str[group][NAME] = callinfo_snapshot_intern(pool, &poolsize, entry->Name);
+		str[group][NUMBER] = callinfo_snapshot_intern(pool, &poolsize, entry->Number);
+		str[group][VOICEMAILBOX] = callinfo_snapshot_intern(pool, &poolsize, entry->VoiceMailbox);
+		valid |= entry->NumberValid ? CALLINFO_VALID_BIT(group, NUMBER) : 0;
+		valid |= entry->VoiceMailboxValid ? CALLINFO_VALID_BIT(group, VOICEMAILBOX) : 0;
+	}
+
+	snapshot = sccp_calloc(sizeof *snapshot + poolsize, 1);
+	if (!snapshot) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return NULL;
+	}
+	snapshot->refcount = 1;
+	snapshot->version = version;
+	memcpy(snapshot->str, str, sizeof(snapshot->str));
+	snapshot->valid = valid;
+	snapshot->originalCdpnRedirectReason = content->originalCdpnRedirectReason;
+	snapshot->lastRedirectingReason = content->lastRedirectingReason;
+	snapshot->presentation = content->presentation;
+	snapshot->callInstance = content->callInstance;
+	snapshot->poolsize = poolsize;
+	memcpy(snapshot->pool, pool, poolsize);
+	return snapshot;
+}
+
+/*!
+ * \brief Expand a snapshot into mutable content
+ */
+static void callinfo_snapshot_expand(const struct sccp_callinfo_snapshot * const snapshot, struct ci_content * const content)
+{
+	int group = 0;
+
+	memset(content, 0, sizeof(struct ci_content));
+	for (group = CALLED_PARTY; group <= HUNT_PILOT; group++) {
+		callinfo_entry_t *entry = &content->entries[group];
+		sccp_copy_string(entry->Name, callinfo_snapshot_str(snapshot, group, NAME), sizeof(entry->Name));
+		sccp_copy_string(entry->Number, callinfo_snapshot_str(snapshot, group, NUMBER), sizeof(entry->Number));
+		sccp_copy_string(entry->VoiceMailbox, callinfo_snapshot_str(snapshot, group, VOICEMAILBOX), sizeof(entry->VoiceMailbox));
+		entry->NumberValid = (snapshot->valid & CALLINFO_VALID_BIT(group, NUMBER)) ? 1 : 0;
+		entry->VoiceMailboxValid = (snapshot->valid & CALLINFO_VALID_BIT(group, VOICEMAILBOX)) ? 1 : 0;
+	}
+	content->originalCdpnRedirectReason = snapshot->originalCdpnRedirectReason;
+	content->lastRedirectingReason = snapshot->lastRedirectingReason;
+	content->presentation = snapshot->presentation;
+	content->callInstance = snapshot->callInstance;
+}
+
+/*!
+ * \brief Retain the current snapshot of ci. Only the pointer swap is protected, the snapshot itself can be read without locking.
+ */
+static struct sccp_callinfo_snapshot *callinfo_snapshot_get(const sccp_callinfo_t * const ci)
+{
+	sccp_callinfo_t * const ci_rw = (sccp_callinfo_t * const) ci;					/* discard const */
+	struct sccp_callinfo_snapshot *snapshot = NULL;
+
+	pbx_mutex_lock(&ci_rw->lock);
+	snapshot = ci_rw->snapshot;
+	(void) ATOMIC_INCR(&snapshot->refcount, 1, &callinfo_refcount_lock);
+	pbx_mutex_unlock(&ci_rw->lock);
+	return snapshot;
+}
+
+static void callinfo_snapshot_release(struct sccp_callinfo_snapshot ** const snapshot)
+{
+	if (*snapshot && ATOMIC_DECR(&(*snapshot)->refcount, 1, &callinfo_refcount_lock) == 1) {
+		sccp_free(*snapshot);
+	}
+	*snapshot = NULL;
+}
+
+/*!
+ * \brief Publish content as the next snapshot version of ci
+ * \note ci->writelock needs to be held by the caller
+ */
+static boolean_t callinfo_snapshot_publish(sccp_callinfo_t * const ci, const struct ci_content * const content)
+{
+	struct sccp_callinfo_snapshot *snapshot = callinfo_snapshot_create(content, ci->snapshot->version + 1);
+	struct sccp_callinfo_snapshot *old_snapshot = NULL;
+
+	if (!snapshot) {
+		return FALSE;
+	}
+	pbx_mutex_lock(&ci->lock);
+	old_snapshot = ci->snapshot;
+	ci->snapshot = snapshot;
+	pbx_mutex_unlock(&ci->lock);
+	callinfo_snapshot_release(&old_snapshot);
+	return TRUE;
+}
+
+/* =================================================================================================================== CallInfo */
 static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 {
 	sccp_callinfo_t *const ci = sccp_calloc(sizeof *ci, 1);
+	struct ci_content content;
 
 	if (!ci) {
 		pbx_log(LOG_ERROR, "SCCP: No memory to allocate callinfo object. Failing\n");
 		return NULL;
 	}
-	pbx_rwlock_init(&ci->lock);
 
 	/* by default we allow callerid presentation */
-	ci->content.presentation = CALLERID_PRESENTATION_ALLOWED;
-	ci->content.changed = TRUE;
-	ci->content.callInstance = callInstance;
+	memset(&content, 0, sizeof(struct ci_content));
+	content.presentation = CALLERID_PRESENTATION_ALLOWED;
+	content.callInstance = callInstance;
+	if (!(ci->snapshot = callinfo_snapshot_create(&content, 1))) {				/* sentVersion 0: changed since last send */
+		sccp_free(ci);
+		return NULL;
+	}
+	pbx_mutex_init(&ci->lock);
+	pbx_mutex_init(&ci->writelock);
 
 	sccp_log(DEBUGCAT_CALLINFO) (VERBOSE_PREFIX_1 "SCCP: callinfo constructor: %p\n", ci);
 	return ci;
@@ -110,9 +281,9 @@ static sccp_callinfo_t * const callinfo_Constructor(uint8_t callInstance)
 static sccp_callinfo_t * const callinfo_Destructor(sccp_callinfo_t * * const ci)
 {
 	pbx_assert(ci != NULL && *ci != NULL);
-	//sccp_callinfo_wrlock(ci);
-	//sccp_callinfo_unlock(ci);
-	pbx_rwlock_destroy(&(*ci)->lock);
+	callinfo_snapshot_release(&(*ci)->snapshot);
+	pbx_mutex_destroy(&(*ci)->writelock);
+	pbx_mutex_destroy(&(*ci)->lock);
 	sccp_free(*ci);
 	*ci = NULL;
 	sccp_log(DEBUGCAT_CALLINFO) (VERBOSE_PREFIX_2 "SCCP: callinfo destructor\n");
@@ -121,16 +292,15 @@ static sccp_callinfo_t * const callinfo_Destructor(sccp_callinfo_t * * const ci)
 
 static sccp_callinfo_t * callinfo_CopyConstructor(const sccp_callinfo_t * const src_ci)
 {
-	/* observing locking order. not locking both callinfo objects at the same time, using a tmp as go between */
+	/* snapshots are immutable, so the copy can share the current snapshot of src_ci (copy on write) */
 	if (src_ci) {
 		sccp_callinfo_t *tmp_ci = iCallInfo.Constructor(0);
 		if (!tmp_ci) {
 			return NULL;
 		}
-		sccp_callinfo_rdlock(src_ci);
-		memcpy(&tmp_ci->content, &src_ci->content, sizeof(struct ci_content));
-		tmp_ci->content.changed = TRUE;
-		sccp_callinfo_unlock(src_ci);
+		callinfo_snapshot_release(&tmp_ci->snapshot);
+		tmp_ci->snapshot = callinfo_snapshot_get(src_ci);
+		tmp_ci->sentVersion = 0;								/* changed since last send */
 
 		return tmp_ci;
 	}
@@ -143,16 +313,13 @@ static boolean_t callinfo_Copy(const sccp_callinfo_t * const src_ci, sccp_callin
 	/* observing locking order. not locking both callinfo objects at the same time, using a tmp as go between */
 	if (src_ci && dst_ci) {
 		struct ci_content tmp_ci_content;
-		memset(&tmp_ci_content, 0, sizeof(struct ci_content));
-
-		sccp_callinfo_rdlock(src_ci);
-		memcpy(&tmp_ci_content, &src_ci->content, sizeof(struct ci_content));
-		sccp_callinfo_unlock(src_ci);
+		struct sccp_callinfo_snapshot *src_snapshot = callinfo_snapshot_get(src_ci);
+		callinfo_snapshot_expand(src_snapshot, &tmp_ci_content);
+		callinfo_snapshot_release(&src_snapshot);
 
-		sccp_callinfo_wrlock(dst_ci);
-		memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-		dst_ci->content.changed = TRUE;
-		sccp_callinfo_unlock(dst_ci);
+		pbx_mutex_lock(&dst_ci->writelock);
+		callinfo_snapshot_publish(dst_ci, &tmp_ci_content);
+		pbx_mutex_unlock(&dst_ci->writelock);
 
 		return TRUE;
 	}
@@ -167,6 +334,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 	pbx_assert(ci != NULL);
 
 	sccp_callinfo_key_t curkey = SCCP_CALLINFO_NONE;
+	struct ci_content content;
 	int changes = 0;
 
 	/*
@@ -178,7 +346,9 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 	}
 	*/
 	
-	sccp_callinfo_wrlock(ci);
+	/* copy on write: expand the current snapshot, modify the copy and publish it as the next version */
+	pbx_mutex_lock(&ci->writelock);
+	callinfo_snapshot_expand(ci->snapshot, &content);
 	va_list ap;
 	va_start(ap, key);
 	for (curkey = key; curkey > SCCP_CALLINFO_NONE && curkey < SCCP_CALLINFO_KEY_SENTINEL; curkey = va_arg(ap, sccp_callinfo_key_t)) {
@@ -187,8 +357,8 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
 			{
 				uint new_value = va_arg(ap, uint);
-				if (new_value != ci->content.originalCdpnRedirectReason) {
-					ci->content.originalCdpnRedirectReason = new_value;
+				if (new_value != content.originalCdpnRedirectReason) {
+					content.originalCdpnRedirectReason = new_value;
 					changes++;
 				}
 			}
@@ -196,8 +366,8 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
 			{
 				uint new_value = va_arg(ap, uint);
-				if (new_value != ci->content.lastRedirectingReason) {
-					ci->content.lastRedirectingReason = new_value;
+				if (new_value != content.lastRedirectingReason) {
+					content.lastRedirectingReason = new_value;
 					changes++;
 				}
 			}
@@ -205,8 +375,8 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 		case SCCP_CALLINFO_PRESENTATION:
 			{
 				sccp_callerid_presentation_t new_value = va_arg(ap, sccp_callerid_presentation_t);
-				if (new_value != ci->content.presentation) {
-					ci->content.presentation = new_value;
+				if (new_value != content.presentation) {
+					content.presentation = new_value;
 					changes++;
 				}
 			}
@@ -219,7 +389,7 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 					char *dstPtr = NULL;
 					uint16_t *validPtr = NULL;
 					struct callinfo_lookup entry = callinfo_lookup[curkey];
-					callinfo_entry_t *callinfo = &ci->content.entries[entry.group];
+					callinfo_entry_t *callinfo = &content.entries[entry.group];
 
 					switch(entry.type) {
 						case NAME:
@@ -255,9 +425,9 @@ static int callinfo_Setter(sccp_callinfo_t * const ci, int key, ...)							// ke
 
 	va_end(ap);
 	if (changes) {
-		ci->content.changed = TRUE;
+		callinfo_snapshot_publish(ci, &content);
 	}
-	sccp_callinfo_unlock(ci);
+	pbx_mutex_unlock(&ci->writelock);
 
 	if ((GLOB(debug) & (DEBUGCAT_CALLINFO)) != 0) {
 		iCallInfo.Print2log(ci, "SCCP: (sccp_callinfo_setter) after:");
@@ -274,6 +444,7 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 {
 	pbx_assert(src_ci != NULL && dst_ci != NULL);
 	struct ci_content tmp_ci_content;
+	struct ci_content src_ci_content;
 	memset(&tmp_ci_content, 0, sizeof(struct ci_content));
 	
 	sccp_callinfo_key_t srckey = SCCP_CALLINFO_NONE;
@@ -287,7 +458,9 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 		iCallInfo.Print2log(dst_ci, "SCCP: (sccp_callinfo_copyByKey) orig dst_ci");
 	}
 	*/
-	sccp_callinfo_rdlock(src_ci);
+	struct sccp_callinfo_snapshot *src_snapshot = callinfo_snapshot_get(src_ci);
+	callinfo_snapshot_expand(src_snapshot, &src_ci_content);
+	callinfo_snapshot_release(&src_snapshot);
 	va_list ap;
 	va_start(ap, key);
 	dstkey=va_arg(ap, sccp_callinfo_key_t);
@@ -300,8 +473,8 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
 			{
 				if (srckey == dstkey) {
-					if (tmp_ci_content.originalCdpnRedirectReason != src_ci->content.originalCdpnRedirectReason) {
-						tmp_ci_content.originalCdpnRedirectReason = src_ci->content.originalCdpnRedirectReason;
+					if (tmp_ci_content.originalCdpnRedirectReason != src_ci_content.originalCdpnRedirectReason) {
+						tmp_ci_content.originalCdpnRedirectReason = src_ci_content.originalCdpnRedirectReason;
 						changes++;
 					}
 				} else {
@@ -312,8 +485,8 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
 			{
 				if (srckey == dstkey) {
-					if (tmp_ci_content.lastRedirectingReason != src_ci->content.lastRedirectingReason) {
-						tmp_ci_content.lastRedirectingReason = src_ci->content.lastRedirectingReason;
+					if (tmp_ci_content.lastRedirectingReason != src_ci_content.lastRedirectingReason) {
+						tmp_ci_content.lastRedirectingReason = src_ci_content.lastRedirectingReason;
 						changes++;
 					}
 				} else {
@@ -324,8 +497,8 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 		case SCCP_CALLINFO_PRESENTATION:
 			{
 				if (srckey == dstkey) {
-					if (tmp_ci_content.presentation != src_ci->content.presentation) {
-						tmp_ci_content.presentation = src_ci->content.presentation;
+					if (tmp_ci_content.presentation != src_ci_content.presentation) {
+						tmp_ci_content.presentation = src_ci_content.presentation;
 						changes++;
 					}
 				} else {
@@ -337,7 +510,7 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 			{
 				struct callinfo_lookup src_entry = callinfo_lookup[srckey];
 				struct callinfo_lookup tmp_entry = callinfo_lookup[dstkey];
-				callinfo_entry_t *src_callinfo = (callinfo_entry_t *const) &src_ci->content.entries[src_entry.group];
+				callinfo_entry_t *src_callinfo = &src_ci_content.entries[src_entry.group];
 				callinfo_entry_t *tmp_callinfo = &tmp_ci_content.entries[tmp_entry.group];
 				
 				char *srcPtr = NULL;
@@ -397,12 +570,10 @@ static int callinfo_CopyByKey(const sccp_callinfo_t * const src_ci, sccp_callinf
 		}
 	}
 	va_end(ap);
-	sccp_callinfo_unlock(src_ci);
 	
-	sccp_callinfo_wrlock(dst_ci);
-	memcpy(&dst_ci->content, &tmp_ci_content, sizeof(struct ci_content));
-	dst_ci->content.changed = TRUE;
-	sccp_callinfo_unlock(dst_ci);
+	pbx_mutex_lock(&dst_ci->writelock);
+	callinfo_snapshot_publish(dst_ci, &tmp_ci_content);
+	pbx_mutex_unlock(&dst_ci->writelock);
 	
 	if ((GLOB(debug) & (DEBUGCAT_CALLINFO)) != 0) {
 		iCallInfo.Print2log(dst_ci, "SCCP: (sccp_callinfo_copyByKey) new dst_ci");
@@ -421,7 +592,7 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 	sccp_callinfo_key_t curkey = SCCP_CALLINFO_NONE;
 	int entries = 0;
 
-	sccp_callinfo_rdlock(ci);
+	struct sccp_callinfo_snapshot *snapshot = callinfo_snapshot_get(ci);
 	va_list ap;
 	va_start(ap, key);
 
@@ -431,8 +602,8 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
 			{
 				uint *dstPtr = va_arg(ap, uint *);
-				if (*dstPtr != ci->content.originalCdpnRedirectReason) {
-					*dstPtr = ci->content.originalCdpnRedirectReason;
+				if (*dstPtr != snapshot->originalCdpnRedirectReason) {
+					*dstPtr = snapshot->originalCdpnRedirectReason;
 					entries++;
 				}
 			}
@@ -440,8 +611,8 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
 			{
 				uint *dstPtr = va_arg(ap, uint *);
-				if (*dstPtr != ci->content.lastRedirectingReason) {
-					*dstPtr = ci->content.lastRedirectingReason;
+				if (*dstPtr != snapshot->lastRedirectingReason) {
+					*dstPtr = snapshot->lastRedirectingReason;
 					entries++;
 				}
 			}
@@ -449,8 +620,8 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 		case SCCP_CALLINFO_PRESENTATION:
 			{
 				sccp_callerid_presentation_t *dstPtr = va_arg(ap, sccp_callerid_presentation_t *);
-				if (*dstPtr != ci->content.presentation) {
-					*dstPtr = ci->content.presentation;
+				if (*dstPtr != snapshot->presentation) {
+					*dstPtr = snapshot->presentation;
 					entries++;
 				}
 			}
@@ -459,38 +630,17 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 			{
 				char *dstPtr = va_arg(ap, char *);
 				if (dstPtr) {
-					size_t size = 0;
-					char *srcPtr = NULL;
-					uint16_t *validPtr = NULL;
 					struct callinfo_lookup entry = callinfo_lookup[curkey];
-					callinfo_entry_t *callinfo = (callinfo_entry_t *const) &(ci->content.entries[entry.group]);
+					size_t size = (entry.type == NAME) ? StationMaxNameSize : StationMaxDirnumSize;
 
-					switch(entry.type) {
-						case NAME:
-							size = StationMaxNameSize;
-							srcPtr = callinfo->Name;
-							validPtr = NULL;
-							break;
-						case NUMBER:
-							size = StationMaxDirnumSize;
-							srcPtr = callinfo->Number;
-							validPtr = &callinfo->NumberValid;
-							break;
-						case VOICEMAILBOX:
-							size = StationMaxDirnumSize;
-							srcPtr = callinfo->VoiceMailbox;
-							validPtr = &callinfo->VoiceMailboxValid;
-							break;
-					}
-					if (validPtr) {
-						if (!*validPtr) {
-							if (dstPtr[0] != '\0') {
-								dstPtr[0] = '\0';
-								entries++;
-							}
-							break;
+					if (!callinfo_snapshot_valid(snapshot, entry.group, entry.type)) {
+						if (dstPtr[0] != '\0') {
+							dstPtr[0] = '\0';
+							entries++;
 						}
+						break;
 					}
+					const char *srcPtr = callinfo_snapshot_str(snapshot, entry.group, entry.type);
 					if (!sccp_strequals(dstPtr, srcPtr)) {
 						entries++;
 						sccp_copy_string(dstPtr, srcPtr, size);
@@ -504,7 +654,7 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 	}
 
 	va_end(ap);
-	sccp_callinfo_unlock(ci);
+	callinfo_snapshot_release(&snapshot);
 
 	if ((GLOB(debug) & (DEBUGCAT_CALLINFO)) != 0) {
 		//#ifdef DEBUG
@@ -516,25 +666,79 @@ static int callinfo_Getter(const sccp_callinfo_t * const ci, int key, ...)
 	return entries;
 }
 
+static const sccp_callinfo_snapshot_t * callinfo_GetSnapshot(const sccp_callinfo_t * const ci)
+{
+	pbx_assert(ci != NULL);
+	return callinfo_snapshot_get(ci);
+}
+
+static void callinfo_ReleaseSnapshot(const sccp_callinfo_snapshot_t ** const snapshot)
+{
+	pbx_assert(snapshot != NULL);
+	struct sccp_callinfo_snapshot *tmp_snapshot = (struct sccp_callinfo_snapshot *) *snapshot;	/* discard const */
+	callinfo_snapshot_release(&tmp_snapshot);
+	*snapshot = NULL;
+}
+
+static const char * callinfo_SnapshotString(const sccp_callinfo_snapshot_t * const snapshot, int key)
+{
+	pbx_assert(snapshot != NULL);
+	if (key >= SCCP_CALLINFO_CALLEDPARTY_NAME && key <= SCCP_CALLINFO_HUNT_PILOT_NUMBER) {
+		struct callinfo_lookup entry = callinfo_lookup[key];
+		if (callinfo_snapshot_valid(snapshot, entry.group, entry.type)) {
+			return callinfo_snapshot_str(snapshot, entry.group, entry.type);
+		}
+	}
+	return "";
+}
+
+static uint32_t callinfo_SnapshotValue(const sccp_callinfo_snapshot_t * const snapshot, int key)
+{
+	pbx_assert(snapshot != NULL);
+	switch (key) {
+		case SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON:
+			return snapshot->originalCdpnRedirectReason;
+		case SCCP_CALLINFO_LAST_REDIRECT_REASON:
+			return snapshot->lastRedirectingReason;
+		case SCCP_CALLINFO_PRESENTATION:
+			return snapshot->presentation;
+		default:
+			return 0;
+	}
+}
+
+static uint32_t callinfo_GetVersion(const sccp_callinfo_t * const ci)
+{
+	pbx_assert(ci != NULL);
+	struct sccp_callinfo_snapshot *snapshot = callinfo_snapshot_get(ci);
+	uint32_t version = snapshot->version;
+	callinfo_snapshot_release(&snapshot);
+	return version;
+}
+
 static int callinfo_Send(sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const sccp_device_t * const device, boolean_t force)
 {
-	if (ci->content.changed || force) {
+	struct sccp_callinfo_snapshot *snapshot = callinfo_snapshot_get(ci);
+	int res = 0;
+
+	if (snapshot->version != ci->sentVersion || force) {
 		/* dependency on sccp_device.h should be fixed */
 		if (device && device->protocol && device->protocol->sendCallInfo) {
 			// using for to set the callsecuritystate is a temporary solution
 			// when indicating ringout the security state should be SKINNY_CALLSECURITYSTATE_UNKNOWN
 			// when indicating connected it should change to SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED
-			device->protocol->sendCallInfo(ci, callid, calltype, lineInstance, ci->content.callInstance, force ? SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED : SKINNY_CALLSECURITYSTATE_UNKNOWN, device);
-			sccp_callinfo_wrlock(ci);
-			ci->content.changed = FALSE;
-			sccp_callinfo_unlock(ci);
-			return 1;
+			device->protocol->sendCallInfo(snapshot, callid, calltype, lineInstance, snapshot->callInstance, force ? SKINNY_CALLSECURITYSTATE_NOTAUTHENTICATED : SKINNY_CALLSECURITYSTATE_UNKNOWN, device);
+			pbx_mutex_lock(&ci->lock);
+			ci->sentVersion = snapshot->version;
+			pbx_mutex_unlock(&ci->lock);
+			res = 1;
 		}
 	} else {
 		sccp_log(DEBUGCAT_CALLINFO) ("%p: (sccp_callinfo_send) ci has not changed since last send. Skipped sending\n", ci);
 	}
+	callinfo_snapshot_release(&snapshot);
 	
-	return 0;
+	return res;
 }
 
 
@@ -571,38 +775,38 @@ static int callinfo_SetLastRedirectingParty(sccp_callinfo_t * const ci, const ch
 static gcc_inline boolean_t __GetCallInfoStr(const sccp_callinfo_t * const ci, pbx_str_t ** const buf)
 {
 	pbx_assert(ci != NULL);
-	sccp_callinfo_rdlock(ci);
-	pbx_str_append(buf, 0, "%p: (getCallInfoStr):\n", ci);
-	if (ci->content.entries[CALLED_PARTY].NumberValid || ci->content.entries[CALLED_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - calledParty: %s <%s>%s%s%s\n", ci->content.entries[CALLED_PARTY].Name, ci->content.entries[CALLED_PARTY].Number, 
-			(ci->content.entries[CALLED_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[CALLED_PARTY].VoiceMailbox, 
-			(ci->content.entries[CALLED_PARTY].NumberValid) ? ", valid" : ", invalid");
-	}
-	if (ci->content.entries[CALLING_PARTY].NumberValid || ci->content.entries[CALLING_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - callingParty: %s <%s>%s%s%s\n", ci->content.entries[CALLING_PARTY].Name, ci->content.entries[CALLING_PARTY].Number, 
-			(ci->content.entries[CALLING_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[CALLING_PARTY].VoiceMailbox, 
-			(ci->content.entries[CALLING_PARTY].NumberValid) ? ", valid" : ", invalid");
-	}
-	if (ci->content.entries[ORIG_CALLED_PARTY].NumberValid || ci->content.entries[ORIG_CALLED_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - originalCalledParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[ORIG_CALLED_PARTY].Name, ci->content.entries[ORIG_CALLED_PARTY].Number, 
-			(ci->content.entries[ORIG_CALLED_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[ORIG_CALLED_PARTY].VoiceMailbox, 
-			(ci->content.entries[ORIG_CALLED_PARTY].NumberValid) ? ", valid" : ", invalid",
-			ci->content.originalCdpnRedirectReason);
-	}
-	if (ci->content.entries[ORIG_CALLING_PARTY].NumberValid) {
-		pbx_str_append(buf, 0, " - originalCallingParty: %s <%s>, valid\n", ci->content.entries[ORIG_CALLING_PARTY].Name, ci->content.entries[ORIG_CALLING_PARTY].Number);
-	}
-	if (ci->content.entries[LAST_REDIRECTING_PARTY].NumberValid || ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailboxValid) {
-		pbx_str_append(buf, 0, " - lastRedirectingParty: %s <%s>%s%s%s, reason: %d\n", ci->content.entries[LAST_REDIRECTING_PARTY].Name, ci->content.entries[LAST_REDIRECTING_PARTY].Number, 
-			(ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailboxValid) ? " voicemail: " : "", ci->content.entries[LAST_REDIRECTING_PARTY].VoiceMailbox, 
-			(ci->content.entries[LAST_REDIRECTING_PARTY].NumberValid) ? ", valid" : ", invalid",
-			ci->content.lastRedirectingReason);
-	}
-	if (ci->content.entries[HUNT_PILOT].NumberValid) {
-		pbx_str_append(buf, 0, " - huntPilot: %s <%s>, valid\n", ci->content.entries[HUNT_PILOT].Name, ci->content.entries[HUNT_PILOT].Number);
-	}
-	pbx_str_append(buf, 0, " - presentation: %s\n\n", sccp_callerid_presentation2str(ci->content.presentation));
-	sccp_callinfo_unlock(ci);
+	struct sccp_callinfo_snapshot *snapshot = callinfo_snapshot_get(ci);
+	pbx_str_append(buf, 0, "%p: (getCallInfoStr): version:%u\n", ci, snapshot->version);
+	if (callinfo_snapshot_valid(snapshot, CALLED_PARTY, NUMBER) || callinfo_snapshot_valid(snapshot, CALLED_PARTY, VOICEMAILBOX)) {
+		pbx_str_append(buf, 0, " - calledParty: %s <%s>%s%s%s\n", callinfo_snapshot_str(snapshot, CALLED_PARTY, NAME), callinfo_snapshot_str(snapshot, CALLED_PARTY, NUMBER), 
+			(callinfo_snapshot_valid(snapshot, CALLED_PARTY, VOICEMAILBOX)) ? " voicemail: " : "", callinfo_snapshot_str(snapshot, CALLED_PARTY, VOICEMAILBOX), 
+			(callinfo_snapshot_valid(snapshot, CALLED_PARTY, NUMBER)) ? ", valid" : ", invalid");
+	}
+	if (callinfo_snapshot_valid(snapshot, CALLING_PARTY, NUMBER) || callinfo_snapshot_valid(snapshot, CALLING_PARTY, VOICEMAILBOX)) {
+		pbx_str_append(buf, 0, " - callingParty: %s <%s>%s%s%s\n", callinfo_snapshot_str(snapshot, CALLING_PARTY, NAME), callinfo_snapshot_str(snapshot, CALLING_PARTY, NUMBER), 
+			(callinfo_snapshot_valid(snapshot, CALLING_PARTY, VOICEMAILBOX)) ? " voicemail: " : "", callinfo_snapshot_str(snapshot, CALLING_PARTY, VOICEMAILBOX), 
+			(callinfo_snapshot_valid(snapshot, CALLING_PARTY, NUMBER)) ? ", valid" : ", invalid");
+	}
+	if (callinfo_snapshot_valid(snapshot, ORIG_CALLED_PARTY, NUMBER) || callinfo_snapshot_valid(snapshot, ORIG_CALLED_PARTY, VOICEMAILBOX)) {
+		pbx_str_append(buf, 0, " - originalCalledParty: %s <%s>%s%s%s, reason: %d\n", callinfo_snapshot_str(snapshot, ORIG_CALLED_PARTY, NAME), callinfo_snapshot_str(snapshot, ORIG_CALLED_PARTY, NUMBER), 
+			(callinfo_snapshot_valid(snapshot, ORIG_CALLED_PARTY, VOICEMAILBOX)) ? " voicemail: " : "", callinfo_snapshot_str(snapshot, ORIG_CALLED_PARTY, VOICEMAILBOX), 
+			(callinfo_snapshot_valid(snapshot, ORIG_CALLED_PARTY, NUMBER)) ? ", valid" : ", invalid",
+			snapshot->originalCdpnRedirectReason);
+	}
+	if (callinfo_snapshot_valid(snapshot, ORIG_CALLING_PARTY, NUMBER)) {
+		pbx_str_append(buf, 0, " - originalCallingParty: %s <%s>, valid\n", callinfo_snapshot_str(snapshot, ORIG_CALLING_PARTY, NAME), callinfo_snapshot_str(snapshot, ORIG_CALLING_PARTY, NUMBER));
+	}
+	if (callinfo_snapshot_valid(snapshot, LAST_REDIRECTING_PARTY, NUMBER) || callinfo_snapshot_valid(snapshot, LAST_REDIRECTING_PARTY, VOICEMAILBOX)) {
+		pbx_str_append(buf, 0, " - lastRedirectingParty: %s <%s>%s%s%s, reason: %d\n", callinfo_snapshot_str(snapshot, LAST_REDIRECTING_PARTY, NAME), callinfo_snapshot_str(snapshot, LAST_REDIRECTING_PARTY, NUMBER), 
+			(callinfo_snapshot_valid(snapshot, LAST_REDIRECTING_PARTY, VOICEMAILBOX)) ? " voicemail: " : "", callinfo_snapshot_str(snapshot, LAST_REDIRECTING_PARTY, VOICEMAILBOX), 
+			(callinfo_snapshot_valid(snapshot, LAST_REDIRECTING_PARTY, NUMBER)) ? ", valid" : ", invalid",
+			snapshot->lastRedirectingReason);
+	}
+	if (callinfo_snapshot_valid(snapshot, HUNT_PILOT, NUMBER)) {
+		pbx_str_append(buf, 0, " - huntPilot: %s <%s>, valid\n", callinfo_snapshot_str(snapshot, HUNT_PILOT, NAME), callinfo_snapshot_str(snapshot, HUNT_PILOT, NUMBER));
+	}
+	pbx_str_append(buf, 0, " - presentation: %s\n\n", sccp_callerid_presentation2str(snapshot->presentation));
+	callinfo_snapshot_release(&snapshot);
 	return TRUE;
 }
 
@@ -627,6 +831,11 @@ const CallInfoInterface iCallInfo = {
 	callinfo_CopyByKey,
 	callinfo_Send,
 	callinfo_Getter,
+	callinfo_GetSnapshot,
+	callinfo_ReleaseSnapshot,
+	callinfo_SnapshotString,
+	callinfo_SnapshotValue,
+	callinfo_GetVersion,
 	callinfo_SetCalledParty,
 	callinfo_SetCallingParty,
 	callinfo_SetOrigCalledParty,
@@ -778,14 +987,99 @@ AST_TEST_DEFINE(sccp_callinfo_tests)
 	return AST_TEST_PASS;
 }
 
+AST_TEST_DEFINE(sccp_callinfo_benchmark)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "callinfo_benchmark";
+			info->category = "/channels/chan_sccp/";
+			info->summary = "chan-sccp-b callinfo microbenchmark";
+			info->description = "compare reading callinfo via the variadic Getter with reading it via a snapshot";
+			return AST_TEST_NOT_RUN;
+	        case TEST_EXECUTE:
+	        	break;
+	}
+
+	const int iterations = 100000;
+	int iteration = 0;
+	size_t total = 0;
+	struct timeval start;
+	int64_t getter_us = 0, snapshot_us = 0, setter_us = 0;
+	char data[12][StationMaxNameSize];
+	int originalCdpnRedirectReason = 0, lastRedirectingReason = 0;
+	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
+
+	sccp_callinfo_t *ci = iCallInfo.Constructor(1);
+	pbx_test_validate(test, ci != NULL);
+	iCallInfo.SetCalledParty(ci, "Called Name", "1000", "1000");
+	iCallInfo.SetCallingParty(ci, "Calling Name", "2000", "2000");
+	iCallInfo.SetOrigCalledParty(ci, "Called Name", "1000", "1000", 4);
+	iCallInfo.SetLastRedirectingParty(ci, "Redirecting Name", "3000", "3000", 2);
+
+	pbx_test_status_update(test, "Getter: %d iterations reading 12 strings and 3 values (sendCallInfo)...\n", iterations);
+	start = pbx_tvnow();
+	for (iteration = 0; iteration < iterations; iteration++) {
+		memset(data, 0, sizeof(data));
+		iCallInfo.Getter(ci,
+			SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0], SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[1],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[2], SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[3],
+			SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[4], SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[5],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[6], SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[7],
+			SCCP_CALLINFO_CALLINGPARTY_NAME, &data[8], SCCP_CALLINFO_CALLEDPARTY_NAME, &data[9],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[10], SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[11],
+			SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
+			SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
+			SCCP_CALLINFO_PRESENTATION, &presentation,
+			SCCP_CALLINFO_KEY_SENTINEL);
+		total += strlen(data[8]);
+	}
+	getter_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Snapshot: %d iterations reading the same fields...\n", iterations);
+	start = pbx_tvnow();
+	for (iteration = 0; iteration < iterations; iteration++) {
+		const sccp_callinfo_snapshot_t *snapshot = iCallInfo.GetSnapshot(ci);
+		const char *strings[12] = {
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NUMBER), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NUMBER),
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER),
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL),
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL),
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NAME), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NAME),
+			iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME), iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME),
+		};
+		originalCdpnRedirectReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON);
+		lastRedirectingReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_LAST_REDIRECT_REASON);
+		presentation = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_PRESENTATION);
+		total += strlen(strings[8]);
+		iCallInfo.ReleaseSnapshot(&snapshot);
+	}
+	snapshot_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Setter: %d iterations setting an unchanged party...\n", iterations);
+	start = pbx_tvnow();
+	for (iteration = 0; iteration < iterations; iteration++) {
+		total += iCallInfo.SetCallingParty(ci, "Calling Name", "2000", "2000");
+	}
+	setter_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Results (%zu): Getter:%" PRId64 "us, Snapshot:%" PRId64 "us, Setter(unchanged):%" PRId64 "us\n", total, getter_us, snapshot_us, setter_us);
+	pbx_test_validate(test, originalCdpnRedirectReason == 4 && lastRedirectingReason == 2);
+
+	ci = iCallInfo.Destructor(&ci);
+	pbx_test_validate(test, ci == NULL);
+	return AST_TEST_PASS;
+}
+
 static void __attribute__((constructor)) sccp_register_tests(void)
 {
         AST_TEST_REGISTER(sccp_callinfo_tests);
+        AST_TEST_REGISTER(sccp_callinfo_benchmark);
 }
 
 static void __attribute__((destructor)) sccp_unregister_tests(void)
 {
         AST_TEST_UNREGISTER(sccp_callinfo_tests);
+        AST_TEST_UNREGISTER(sccp_callinfo_benchmark);
 }
 #endif
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -54,6 +54,19 @@ typedef struct tagCallInfo {
 	 */
 	int (*Getter)(const sccp_callinfo_t * const ci, int key, ...);						// key is a va_arg of type sccp_callinfo_key_t
 
+	/*
+	 * \brief lock free read access to the current (immutable) callinfo content
+	 * const sccp_callinfo_snapshot_t *snapshot = iCallInfo.GetSnapshot(ci);
+	 * const char *number = iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NUMBER);
+	 * iCallInfo.ReleaseSnapshot(&snapshot);
+	 * strings are "" when not set / not valid and remain valid until the snapshot is released
+	 */
+	const sccp_callinfo_snapshot_t * (*GetSnapshot)(const sccp_callinfo_t * const ci);
+	void (*ReleaseSnapshot)(const sccp_callinfo_snapshot_t ** const snapshot);
+	const char * (*SnapshotString)(const sccp_callinfo_snapshot_t * const snapshot, int key);		// key is of type sccp_callinfo_key_t
+	uint32_t (*SnapshotValue)(const sccp_callinfo_snapshot_t * const snapshot, int key);			// reasons / presentation, key is of type sccp_callinfo_key_t
+	uint32_t (*GetVersion)(const sccp_callinfo_t * const ci);						// incremented on every change
+
 	/* helpers */
 	int (*SetCalledParty)(sccp_callinfo_t * const ci, const char name[StationMaxDirnumSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize]);
 	int (*SetCallingParty)(sccp_callinfo_t * const ci, const char name[StationMaxDirnumSize], const char number[StationMaxDirnumSize], const char voicemail[StationMaxDirnumSize]);
@@ -36,6 +36,7 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include <asterisk/pbx.h>			// AST_EXTENSION_NOT_INUSE
 
 static uint32_t callCount = 1;
+static uint32_t allocatedCount = 0;									/* never wraps back like callCount (metrics) */
 void __sccp_channel_destroy(sccp_channel_t * channel);
 
 AST_MUTEX_DEFINE_STATIC(callCountLock);
@@ -48,6 +49,7 @@ struct sccp_private_channel_data {
 	sccp_linedevices_t *linedevice;
 	sccp_callinfo_t * callInfo;
 	boolean_t microphone;											/*!< Flag to mute the microphone when calling a baby phone */
+	sccp_callspan_t callspan;										/*!< Call setup milestones */
 };
 
 /*!
@@ -125,6 +127,7 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 		callCount = 1;
 		callid = callCount;
 	}
+	allocatedCount++;
 	snprintf(designator, 32, "SCCP/%s-%08X", refLine->name, callid);
 	uint8_t callInstance = refLine->statistic.numberOfActiveChannels + refLine->statistic.numberOfHeldChannels + 1;
 	sccp_mutex_unlock(&callCountLock);
@@ -147,6 +150,7 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 		/* assign private_data default values */
 		private_data->microphone = TRUE;
 		private_data->device = NULL;
+		sccp_callspan_start(&private_data->callspan);
 		private_data->callInfo = iCallInfo.Constructor(callInstance);
 		if (!private_data->callInfo) {
 			break;
@@ -219,6 +223,19 @@ channelPtr sccp_channel_allocate(constLinePtr l, constDevicePtr device)
 	return NULL;
 }
 
+/*!
+ * \brief Number of channels allocated since module load
+ */
+uint32_t sccp_channel_getAllocatedCount(void)
+{
+	uint32_t count = 0;
+
+	sccp_mutex_lock(&callCountLock);
+	count = allocatedCount;
+	sccp_mutex_unlock(&callCountLock);
+	return count;
+}
+
 /*!
  * \brief Retrieve Device from Channels->Private Channel Data
  * \param channel SCCP Channel
@@ -368,6 +385,16 @@ sccp_callinfo_t * const __PURE__ sccp_channel_getCallInfo(const sccp_channel_t *
 	return (sccp_callinfo_t * const) channel->privateData->callInfo;			/* discard const because callinfo has a private implementation anyway */
 }
 
+/*!
+ * \brief Stamp a call setup milestone (first occurrence only)
+ */
+void sccp_channel_markCallSpan(const sccp_channel_t *const channel, sccp_callspan_milestone_t milestone)
+{
+	if (channel && channel->privateData) {
+		sccp_callspan_mark(&channel->privateData->callspan, milestone);
+	}
+}
+
 /*!
  * \brief Send Call Information to Device/Channel
  *
@@ -562,6 +589,8 @@ void sccp_channel_openReceiveChannel(constChannelPtr channel)
 	}
 	pbx_assert(channel->line != NULL);									/* should not be possible, but received a backtrace / report */
 
+	sccp_channel_markCallSpan(channel, SCCP_CALLSPAN_OPENRECEIVE);
+
 	/* Mute mic feature: If previously set, mute the microphone prior receiving media is already open. */
 	/* This must be done in this exact order to work on popular phones like the 7975. It must also be done in other places for other phones. */
 	if (!channel->isMicrophoneEnabled()) {
@@ -727,6 +756,7 @@ void sccp_channel_startMediaTransmission(constChannelPtr channel)
 		sccp_log((DEBUGCAT_RTP)) (VERBOSE_PREFIX_3 "%s: can't start rtp media transmission, maybe channel is down %s\n", channel->currentDeviceId, channel->designator);
 		return;
 	}
+	sccp_channel_markCallSpan(channel, SCCP_CALLSPAN_STARTMEDIA);
 
 	sccp_log((DEBUGCAT_RTP)) (VERBOSE_PREFIX_3 "%s: Starting Phone RTP/UDP Transmission (State: %s[%d])\n", d->id, sccp_channelstate2str(channel->state), channel->state);
 	/* Mute mic feature: If previously set, mute the microphone after receiving of media is already open, but before starting to send to rtp. */
@@ -1893,6 +1923,9 @@ void sccp_channel_clean(sccp_channel_t * channel)
 
 	// l = channel->line;
 	sccp_log((DEBUGCAT_CHANNEL)) (VERBOSE_PREFIX_3 "SCCP: Cleaning channel %s\n", channel->designator);
+	if (channel->privateData) {
+		sccp_callspan_finish(&channel->privateData->callspan, channel->designator, d ? skinny_devicetype2str(d->skinny_type) : NULL, channel->line ? channel->line->name : NULL);
+	}
 
 	if (ATOMIC_FETCH(&channel->scheduler.deny, &channel->scheduler.lock) == 0) {
 		sccp_channel_stop_and_deny_scheduled_tasks(channel);
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "sccp_device.h"
+#include "sccp_stats.h"
 
 #define sccp_channel_retain(_x)		sccp_refcount_retain_type(sccp_channel_t, _x)
 #define sccp_channel_release(_x)	sccp_refcount_release_type(sccp_channel_t, _x)
@@ -119,6 +120,7 @@ SCCP_API channelPtr SCCP_CALL sccp_channel_newcall(constLinePtr l, constDevicePt
 
 SCCP_API void SCCP_CALL sccp_channel_updateChannelCapability(sccp_channel_t * channel);
 SCCP_API sccp_callinfo_t * const SCCP_CALL sccp_channel_getCallInfo(const sccp_channel_t *const channel);
+SCCP_API void SCCP_CALL sccp_channel_markCallSpan(const sccp_channel_t *const channel, sccp_callspan_milestone_t milestone);
 SCCP_API void SCCP_CALL sccp_channel_send_callinfo(const sccp_device_t * device, const sccp_channel_t * channel);
 SCCP_API void SCCP_CALL sccp_channel_send_callinfo2(sccp_channel_t * channel);
 SCCP_API void SCCP_CALL sccp_channel_setChannelstate(channelPtr channel, sccp_channelstate_t state);
@@ -204,5 +206,6 @@ SCCP_API sccp_channel_t * SCCP_CALL sccp_find_channel_by_buttonIndex_and_callid(
 SCCP_API sccp_channel_t * SCCP_CALL sccp_channel_find_on_device_bypassthrupartyid(constDevicePtr d, uint32_t passthrupartyid);
 SCCP_API sccp_selectedchannel_t * SCCP_CALL sccp_device_find_selectedchannel(constDevicePtr d, constChannelPtr channel);
 SCCP_API uint8_t SCCP_CALL sccp_device_selectedchannels_count(constDevicePtr device);
+SCCP_API uint32_t SCCP_CALL sccp_channel_getAllocatedCount(void);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -61,9 +61,16 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_mwi.h"
 #include "sccp_hint.h"
 #include "sccp_labels.h"
+#include "sccp_realtime.h"
+#include "sccp_pcap.h"
+#include "sccp_stats.h"
+#include "sccp_lockstats.h"
+#include "sccp_metrics.h"
+#include "sccp_management.h"
 #include "sys/stat.h"
 #include <asterisk/cli.h>
 #include <asterisk/paths.h>
+#include <math.h>
 
 typedef enum sccp_cli_completer {
 	SCCP_CLI_NULL_COMPLETER,
@@ -447,6 +454,177 @@ static char *sccp_exec_completer(sccp_cli_completer_t completer, OLDCONST char *
 }
 
 /* --- Support Functions ---------------------------------------------------------------------------------------------- */
+/* --------------------------------------------------------------------------------------------------------JSON WRITER- */
+/*!
+ * \brief Streaming JSON writer, used by the AMI table actions when called with "Format: json"
+ *
+ * Instead of one event per row, the whole table is returned as a single JSON document in the "JSON" header of one
+ * SCCPTable event. The document is written to a small buffer, which is handed to the manager session every
+ * SCCP_CLI_JSON_FLUSH bytes, so the table never has to be kept in memory as a whole.
+ * An optional "Columns" header (comma separated, case insensitive) limits the fields written per entry.
+ */
+static void sccp_cli_json_flush(sccp_cli_json_t * json, size_t threshold)
+{
+	if (pbx_str_strlen(json->buf) >= threshold) {
+		astman_append(json->s, "%s", pbx_str_buffer(json->buf));
+		pbx_str_reset(json->buf);
+	}
+}
+
+/* append str as a quoted json string, copying runs of characters that do not need escaping in one go */
+static void sccp_cli_json_string(pbx_str_t ** buf, const char *str)
+{
+	const char *run = str;
+
+	pbx_str_append(buf, 0, "\"");
+	for (; str && *str; str++) {
+		if (*str != '"' && *str != '\\' && (unsigned char) *str >= 0x20) {
+			continue;
+		}
+		pbx_str_append(buf, 0, "%.*s", (int) (str - run), run);
+		switch (*str) {
+			case '"':
+				pbx_str_append(buf, 0, "\\\"");
+				break;
+			case '\\':
+				pbx_str_append(buf, 0, "\\\\");
+				break;
+			case '\n':
+				pbx_str_append(buf, 0, "\\n");
+				break;
+			case '\r':
+				pbx_str_append(buf, 0, "\\r");
+				break;
+			case '\t':
+				pbx_str_append(buf, 0, "\\t");
+				break;
+			default:
+				pbx_str_append(buf, 0, "\\u%04x", (unsigned char) *str);
+				break;
+		}
+		run = str + 1;
+	}
+	if (run) {
+		pbx_str_append(buf, 0, "%s", run);
+	}
+	pbx_str_append(buf, 0, "\"");
+}
+
+/* is the (camelcased) column name part of the comma separated column list */
+static boolean_t sccp_cli_json_columnRequested(const char *columns, const char *name)
+{
+	size_t len = strlen(name);
+	const char *token = columns;
+
+	while (token && *token) {
+		token = pbx_skip_blanks(token);
+		if (!strncasecmp(token, name, len) && (token[len] == ',' || token[len] == ' ' || token[len] == '\0')) {
+			return TRUE;
+		}
+		if ((token = strchr(token, ','))) {
+			token++;
+		}
+	}
+	return FALSE;
+}
+
+boolean_t sccp_cli_json_start(sccp_cli_json_t * json, struct mansession *s, const struct message *m, const char *tablename)
+{
+	const char *actionid = NULL;
+	const char *columns = NULL;
+
+	memset(json, 0, sizeof(sccp_cli_json_t));
+	if (!s || !m || !sccp_strcaseequals(astman_get_header(m, "Format"), "json")) {
+		return FALSE;
+	}
+	if (!(json->buf = pbx_str_create(SCCP_CLI_JSON_FLUSH + DEFAULT_PBX_STR_BUFFERSIZE))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return FALSE;
+	}
+	json->s = s;
+	columns = astman_get_header(m, "Columns");
+	json->columns = !sccp_strlen_zero(columns) ? columns : NULL;
+
+	pbx_str_append(&json->buf, 0, "Event: SCCPTable\r\nTableName: %s\r\n", tablename);
+	actionid = astman_get_header(m, "ActionID");
+	if (!sccp_strlen_zero(actionid)) {
+		pbx_str_append(&json->buf, 0, "ActionID: %s\r\n", actionid);
+	}
+	pbx_str_append(&json->buf, 0, "Format: json\r\nJSON: {\"TableName\":");
+	sccp_cli_json_string(&json->buf, tablename);
+	pbx_str_append(&json->buf, 0, ",\"Entries\":[");
+	return TRUE;
+}
+
+void sccp_cli_json_startEntry(sccp_cli_json_t * json)
+{
+	pbx_str_append(&json->buf, 0, json->entries ? ",{" : "{");
+	json->field = 0;
+	json->fields = 0;
+}
+
+void sccp_cli_json_field(sccp_cli_json_t * json, const char *name, const char *conv, const char *fmt, ...)
+{
+	va_list ap;
+	char *camelName = NULL;
+	int field = json->field++;
+
+	/* the column filter is evaluated during the first entry and remembered per field position, fields beyond the bitmap are matched by name every time */
+	if (json->columns && field < 64 && json->entries && !(json->included & ((uint64_t) 1 << field))) {
+		return;
+	}
+	camelName = pbx_strdupa(name);
+	CLI_AMI_CAMEL_PARAM(camelName, camelName);
+	if (json->columns && (field >= 64 || !json->entries)) {
+		if (!sccp_cli_json_columnRequested(json->columns, camelName)) {
+			return;
+		}
+		if (field < 64) {
+			json->included |= (uint64_t) 1 << field;
+		}
+	}
+	pbx_str_append(&json->buf, 0, "%s\"%s\":", json->fields++ ? "," : "", camelName);
+	va_start(ap, fmt);
+	if (sccp_strequals(conv, "s")) {
+		sccp_cli_json_string(&json->buf, va_arg(ap, const char *));
+	} else if (sccp_strequals(conv, "p") || sccp_strequals(conv, "c")) {				/* not a json number */
+		char value[64];
+
+		vsnprintf(value, sizeof(value), fmt, ap);
+		sccp_cli_json_string(&json->buf, value);
+	} else if (conv[0] && strchr("eEfFgG", conv[0])) {
+		va_list aq;
+		double value;
+
+		va_copy(aq, ap);
+		value = va_arg(aq, double);
+		va_end(aq);
+		if (isfinite(value)) {
+			pbx_str_append_va(&json->buf, 0, fmt, ap);
+		} else {
+			pbx_str_append(&json->buf, 0, "null");						/* json has no nan/inf */
+		}
+	} else {
+		pbx_str_append_va(&json->buf, 0, fmt, ap);
+	}
+	va_end(ap);
+}
+
+void sccp_cli_json_endEntry(sccp_cli_json_t * json)
+{
+	pbx_str_append(&json->buf, 0, "}");
+	json->entries++;
+	sccp_cli_json_flush(json, SCCP_CLI_JSON_FLUSH);
+}
+
+int sccp_cli_json_end(sccp_cli_json_t * json)
+{
+	pbx_str_append(&json->buf, 0, "],\"TableEntries\":%d}\r\n\r\n", json->entries);
+	sccp_cli_json_flush(json, 0);
+	sccp_free(json->buf);
+	return json->entries;
+}
+
 /* -------------------------------------------------------------------------------------------------------SHOW GLOBALS- */
 
 /*!
@@ -518,6 +696,12 @@ static int sccp_show_globals(int fd, sccp_cli_totals_t *totals, struct mansessio
 	CLI_AMI_OUTPUT_PARAM("Nat", CLI_AMI_LIST_WIDTH, "%s", sccp_nat2str(GLOB(nat)));
 	CLI_AMI_OUTPUT_PARAM("Keepalive", CLI_AMI_LIST_WIDTH, "%d", GLOB(keepalive));
 	CLI_AMI_OUTPUT_PARAM("Debug", CLI_AMI_LIST_WIDTH, "(%d) %s", GLOB(debug), debugcategories);
+	if (GLOB(debug_async)) {
+		sccp_log_async_stats_t async_stats;
+
+		sccp_log_async_getStats(&async_stats);
+		CLI_AMI_OUTPUT_PARAM("Debug Async", CLI_AMI_LIST_WIDTH, "%d buffers, %d/%d KB, written:%d, dropped:%d, truncated:%d, synchronous:%d", async_stats.rings, async_stats.memory / 1024, GLOB(debug_async_memory), async_stats.written, async_stats.dropped, async_stats.truncated, async_stats.synchronous);
+	}
 	CLI_AMI_OUTPUT_PARAM("Date format", CLI_AMI_LIST_WIDTH, "%s", GLOB(dateformat));
 	CLI_AMI_OUTPUT_PARAM("First digit timeout", CLI_AMI_LIST_WIDTH, "%d", GLOB(firstdigittimeout));
 	CLI_AMI_OUTPUT_PARAM("Digit timeout", CLI_AMI_LIST_WIDTH, "%d", GLOB(digittimeout));
@@ -624,7 +808,202 @@ CLI_AMI_ENTRY(show_globals, sccp_show_globals, "List defined SCCP global setting
 #undef AMI_COMMAND
 #undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ------------------------------------------------------------------------------------------------------LISTING WINDOW- */
+/*!
+ * \brief Filter and Pagination Window used by the snapshot based listings (show devices / lines / channels)
+ *
+ * These listings only hold a list lock long enough to retain its members. The displayed fields are then copied into a private
+ * row array, and the table is streamed out row by row from that array, outside of all locks. A slow cli/ami consumer therefore
+ * never blocks registrations or reloads.
+ */
+typedef struct sccp_cli_window {
+	const char *filter;											/*!< case insensitive substring, NULL matches everything */
+	int offset;												/*!< number of matching entries to skip */
+	int limit;												/*!< maximum number of entries to return (0 = unlimited) */
+	int matched;												/*!< number of matching entries seen */
+	int returned;												/*!< number of matching entries inside the window */
+} sccp_cli_window_t;
+
+/* strict non negative integer, the whole string has to be digits ("10abc", "-1", " 5" and overflows are rejected) */
+static boolean_t sccp_cli_parseCount(const char *str, int *value)
+{
+	char *end = NULL;
+	long res = 0;
+
+	if (!isdigit((unsigned char) str[0])) {
+		return FALSE;
+	}
+	errno = 0;
+	res = strtol(str, &end, 10);
+	if (errno || *end != '\0' || res > INT_MAX) {
+		return FALSE;
+	}
+	*value = (int) res;
+	return TRUE;
+}
+
+/*!
+ * \brief Parse the optional [filter] [offset] [limit] arguments (argv[3] onwards)
+ * \note "*" or an empty filter matches everything, so that offset and limit can be passed without filtering
+ */
+static int sccp_cli_parseWindow(sccp_cli_window_t * window, int argc, char *argv[])
+{
+	memset(window, 0, sizeof(sccp_cli_window_t));
+	if (argc > 3 && !sccp_strlen_zero(argv[3]) && !sccp_strequals(argv[3], "*")) {
+		window->filter = argv[3];
+	}
+	if (argc > 4 && !sccp_strlen_zero(argv[4]) && !sccp_cli_parseCount(argv[4], &window->offset)) {
+		return RESULT_SHOWUSAGE;
+	}
+	if (argc > 5 && !sccp_strlen_zero(argv[5]) && !sccp_cli_parseCount(argv[5], &window->limit)) {
+		return RESULT_SHOWUSAGE;
+	}
+	return RESULT_SUCCESS;
+}
+
+/* returns TRUE if one of the fields matches the filter and the entry falls inside the requested offset/limit */
+static boolean_t sccp_cli_inWindow(sccp_cli_window_t * window, const char *field1, const char *field2, const char *field3)
+{
+	int position = 0;
+
+	if (window->filter && !(field1 && strcasestr(field1, window->filter)) && !(field2 && strcasestr(field2, window->filter)) && !(field3 && strcasestr(field3, window->filter))) {
+		return FALSE;
+	}
+	position = window->matched++;
+	if (position < window->offset || (window->limit && position >= window->offset + window->limit)) {
+		return FALSE;
+	}
+	window->returned++;
+	return TRUE;
+}
+
+static void sccp_cli_printWindow(int fd, struct mansession *s, sccp_cli_window_t * window)
+{
+	if (!s && (window->filter || window->offset || window->limit)) {
+		pbx_cli(fd, "Showing %d of %d matching entries (filter: '%s', offset: %d, limit: %d)\n", window->returned, window->matched, window->filter ? window->filter : "*", window->offset, window->limit);
+	}
+}
+
+/* grow a row array on demand, returns a pointer to a zeroed new row or NULL when out of memory */
+static void *sccp_cli_addRow(void **rows, int *nrows, int *size, size_t rowsize)
+{
+	void *newrows = NULL;
+	int newsize = 0;
+
+	if (*nrows == *size) {
+		newsize = *size ? *size * 2 : 64;
+		if (!(newrows = sccp_realloc(*rows, newsize * rowsize))) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+			return NULL;
+		}
+		*rows = newrows;
+		*size = newsize;
+	}
+	newrows = (char *) *rows + (*nrows)++ * rowsize;
+	memset(newrows, 0, rowsize);
+	return newrows;
+}
+
+/* retain all lines, only holding the list lock while doing so, returns the number of retained lines */
+static int sccp_cli_retainLines(sccp_line_t *** lines)
+{
+	sccp_line_t *list_line = NULL;
+	int nlines = 0;
+
+	*lines = NULL;
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	if (SCCP_RWLIST_GETSIZE(&GLOB(lines)) && (*lines = sccp_calloc(SCCP_RWLIST_GETSIZE(&GLOB(lines)), sizeof(sccp_line_t *)))) {
+		SCCP_RWLIST_TRAVERSE(&GLOB(lines), list_line, list) {
+			if (((*lines)[nlines] = sccp_line_retain(list_line))) {
+				nlines++;
+			}
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	return nlines;
+}
+
+static void sccp_cli_releaseLines(sccp_line_t ** lines, int nlines)
+{
+	int idx = 0;
+
+	for (idx = 0; idx < nlines; idx++) {
+		sccp_line_release(&lines[idx]);								/* explicit release */
+	}
+	if (lines) {
+		sccp_free(lines);
+	}
+}
+
     /* --------------------------------------------------------------------------------------------------------SHOW DEVICES- */
+typedef struct sccp_cli_device_row {
+	char description[StationMaxNameSize * 2];
+	char address[INET6_ADDRSTRLEN];
+	char id[StationMaxDeviceNameSize];
+	char regtime[25];
+	skinny_registrationstate_t regState;
+	sccp_tokenstate_t token;
+	boolean_t active;
+	uint8_t numberOfLines;
+	sccp_nat_t nat;
+} sccp_cli_device_row_t;
+
+/* copy the displayed fields of the devices inside the window, returns the number of rows */
+static int sccp_cli_collectDevices(sccp_cli_window_t * window, sccp_cli_device_row_t ** rows)
+{
+	sccp_device_t **devices = NULL;
+	sccp_device_t *list_dev = NULL;
+	sccp_cli_device_row_t *row = NULL;
+	struct sockaddr_storage sas = { 0 };
+	struct tm tm = { 0 };
+	int ndevices = 0;
+	int nrows = 0;
+	int idx = 0;
+
+	*rows = NULL;
+	SCCP_RWLIST_RDLOCK(&GLOB(devices));
+	if (SCCP_RWLIST_GETSIZE(&GLOB(devices)) && (devices = sccp_calloc(SCCP_RWLIST_GETSIZE(&GLOB(devices)), sizeof(sccp_device_t *)))) {
+		SCCP_RWLIST_TRAVERSE(&GLOB(devices), list_dev, list) {
+			if ((devices[ndevices] = sccp_device_retain(list_dev))) {
+				ndevices++;
+			}
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+
+	if (ndevices && (*rows = sccp_calloc(ndevices, sizeof(sccp_cli_device_row_t)))) {
+		for (idx = 0; idx < ndevices; idx++) {
+			sccp_device_t *d = devices[idx];
+
+			if (!sccp_cli_inWindow(window, d->id, d->description, NULL)) {
+				continue;
+			}
+			row = &(*rows)[nrows++];
+			sccp_copy_string(row->description, d->description ? d->description : "<not set>", sizeof(row->description));
+			sccp_copy_string(row->id, d->id, sizeof(row->id));
+			if (d->session) {
+				sccp_session_getSas(d->session, &sas);
+				sccp_copy_string(row->address, sccp_netsock_stringify(&sas), sizeof(row->address));
+				strftime(row->regtime, sizeof(row->regtime), "%c ", localtime_r(&d->registrationTime, &tm));
+			} else {
+				sccp_copy_string(row->address, "--", sizeof(row->address));
+			}
+			row->regState = sccp_device_getRegistrationState(d);
+			row->token = d->status.token;
+			row->active = d->active_channel ? TRUE : FALSE;
+			row->numberOfLines = d->configurationStatistic.numberOfLines;
+			row->nat = d->nat;
+		}
+	}
+	for (idx = 0; idx < ndevices; idx++) {
+		sccp_device_release(&devices[idx]);								/* explicit release */
+	}
+	if (devices) {
+		sccp_free(devices);
+	}
+	return nrows;
+}
+
     /*!
      * \brief Show Devices
      * \param fd Fd as int
@@ -641,50 +1020,42 @@ CLI_AMI_ENTRY(show_globals, sccp_show_globals, "List defined SCCP global setting
     //static int sccp_show_devices(int fd, int argc, char *argv[])
 static int sccp_show_devices(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
 {
-	struct tm *timeinfo;
-	char regtime[25];
 	int local_line_total = 0;
-	char addrStr[INET6_ADDRSTRLEN];
+	sccp_cli_window_t window;
+	sccp_cli_device_row_t *rows = NULL;
+	sccp_cli_device_row_t *row = NULL;
+	int nrows = 0;
+	int idx = 0;
+
+	if (sccp_cli_parseWindow(&window, argc, argv) != RESULT_SUCCESS) {
+		return RESULT_SHOWUSAGE;
+	}
+	nrows = sccp_cli_collectDevices(&window, &rows);
 
 	// table definition
 #define CLI_AMI_TABLE_NAME Devices
 #define CLI_AMI_TABLE_PER_ENTRY_NAME Device
-
-#define CLI_AMI_TABLE_LIST_ITER_TYPE sccp_device_t
-#define CLI_AMI_TABLE_LIST_ITER_HEAD &GLOB(devices)
-#define CLI_AMI_TABLE_LIST_ITER_VAR list_dev
-#define CLI_AMI_TABLE_LIST_LOCK SCCP_RWLIST_RDLOCK
-#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_RWLIST_TRAVERSE
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
 #define CLI_AMI_TABLE_BEFORE_ITERATION 																\
-	{																			\
-		AUTO_RELEASE(sccp_device_t, d , sccp_device_retain(list_dev));											\
-		if (d) {																	\
-			if(d->session) {															\
-				struct sockaddr_storage sas = { 0 };												\
-				timeinfo = localtime(&d->registrationTime); 											\
-				strftime(regtime, sizeof(regtime), "%c ", timeinfo);										\
-				sccp_session_getSas(d->session, &sas);											 	\
-				sccp_copy_string(addrStr,sccp_netsock_stringify(&sas),sizeof(addrStr));								\
- 			} else {addrStr[0] = '-'; addrStr[1] = '-';addrStr[2] = '\0';regtime[0] = '\0';}
-
-#define CLI_AMI_TABLE_AFTER_ITERATION 																\
-		}																		\
-	}
-#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_RWLIST_UNLOCK
+		row = &rows[idx];
 
 #define CLI_AMI_TABLE_FIELDS 																	\
-		CLI_AMI_TABLE_FIELD(Descr,		"-25.25",	s,	25,	d->description ? d->description : "<not set>")				\
-		CLI_AMI_TABLE_FIELD(Address,		"44.44",	s,	44,	addrStr)								\
-		CLI_AMI_TABLE_FIELD(Mac,		"-16.16",	s,	16,	d->id)									\
-		CLI_AMI_TABLE_FIELD(RegState,		"-10.10",	s,	10, 	skinny_registrationstate2str(sccp_device_getRegistrationState(d)))	\
-		CLI_AMI_TABLE_FIELD(Token,		"-5.5",		s,	5,	sccp_tokenstate2str(d->status.token)) 					\
-		CLI_AMI_TABLE_FIELD(RegTime,		"25.25",	s,	25, 	regtime[0] ? regtime : "None")						\
-		CLI_AMI_TABLE_FIELD(Act,		"3.3",		s,	3, 	(d->active_channel) ? "Yes" : "No")					\
-		CLI_AMI_TABLE_FIELD(Lines, 		"-5",		d,	5, 	d->configurationStatistic.numberOfLines)				\
-		CLI_AMI_TABLE_FIELD(Nat,		"9.9",		s, 	9,	sccp_nat2str(d->nat))
+		CLI_AMI_TABLE_FIELD(Descr,		"-25.25",	s,	25,	row->description)							\
+		CLI_AMI_TABLE_FIELD(Address,		"44.44",	s,	44,	row->address)								\
+		CLI_AMI_TABLE_FIELD(Mac,		"-16.16",	s,	16,	row->id)								\
+		CLI_AMI_TABLE_FIELD(RegState,		"-10.10",	s,	10, 	skinny_registrationstate2str(row->regState))				\
+		CLI_AMI_TABLE_FIELD(Token,		"-5.5",		s,	5,	sccp_tokenstate2str(row->token)) 					\
+		CLI_AMI_TABLE_FIELD(RegTime,		"25.25",	s,	25, 	row->regtime[0] ? row->regtime : "None")				\
+		CLI_AMI_TABLE_FIELD(Act,		"3.3",		s,	3, 	row->active ? "Yes" : "No")						\
+		CLI_AMI_TABLE_FIELD(Lines, 		"-5",		d,	5, 	row->numberOfLines)							\
+		CLI_AMI_TABLE_FIELD(Nat,		"9.9",		s, 	9,	sccp_nat2str(row->nat))
 #include "sccp_cli_table.h"
 
 	// end of table definition
+	if (rows) {
+		sccp_free(rows);
+	}
+	sccp_cli_printWindow(fd, s, &window);
 	if (s) {
 		totals->lines = local_line_total;
 		totals->tables = 1;
@@ -692,14 +1063,14 @@ static int sccp_show_devices(int fd, sccp_cli_totals_t *totals, struct mansessio
 	return RESULT_SUCCESS;
 }
 
-static char cli_devices_usage[] = "Usage: sccp show devices\n" "       Lists defined SCCP devices.\n";
-static char ami_devices_usage[] = "Usage: SCCPShowDevices\n" "Lists defined SCCP devices.\n\n" "PARAMS: None\n";
+static char cli_devices_usage[] = "Usage: sccp show devices [<filter> [<offset> [<limit>]]]\n" "       Lists defined SCCP devices.\n" "       Only devices whose id or description contain <filter> ('*' matches all) are shown, skipping <offset> and returning at most <limit> entries.\n";
+static char ami_devices_usage[] = "Usage: SCCPShowDevices\n" "Lists defined SCCP devices.\n\n" "Optional PARAMS: Filter, Offset, Limit, Format (json), Columns\n";
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 #define CLI_COMMAND "sccp", "show", "devices"
 #define AMI_COMMAND "SCCPShowDevices"
 #define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
-#define CLI_AMI_PARAMS ""
+#define CLI_AMI_PARAMS "Filter", "Offset", "Limit"
 CLI_AMI_ENTRY(show_devices, sccp_show_devices, "List defined SCCP devices", cli_devices_usage, FALSE, TRUE)
 #undef CLI_AMI_PARAMS
 #undef CLI_COMPLETE
@@ -1070,6 +1441,119 @@ CLI_AMI_ENTRY(show_device, sccp_show_device, "Lists device settings", cli_device
 #undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
     /* ---------------------------------------------------------------------------------------------------------SHOW LINES- */
+typedef enum {
+	SCCP_CLI_LINEROW_DEVICE,
+	SCCP_CLI_LINEROW_NODEVICE,
+	SCCP_CLI_LINEROW_VARIABLE,
+	SCCP_CLI_LINEROW_SUBSCRIPTIONID,
+} sccp_cli_linerow_type_t;
+
+typedef struct sccp_cli_line_row {
+	sccp_cli_linerow_type_t type;
+	boolean_t first;											/* first row of a line */
+	boolean_t replaceCid;
+	boolean_t mwi;
+	int channels;
+	sccp_channelstate_t state;
+	skinny_calltype_t calltype;
+	char name[StationMaxNameSize];										/* line name / variable name */
+	char number[SCCP_MAX_EXTENSION];
+	char label[SCCP_MAX_LABEL];
+	char description[128];											/* line description / variable value / subscription name */
+	char device[StationMaxDeviceNameSize];
+	char partyName[StationMaxNameSize];
+	char capabilities[128];
+} sccp_cli_line_row_t;
+
+/* copy the displayed fields of the lines inside the window (one row per linedevice plus variables), returns the number of rows */
+static int sccp_cli_collectLines(sccp_cli_window_t * window, sccp_cli_line_row_t ** rows)
+{
+	sccp_line_t **lines = NULL;
+	sccp_linedevices_t *linedevice = NULL;
+	sccp_channel_t *channel = NULL;
+	sccp_cli_line_row_t *row = NULL;
+	PBX_VARIABLE_TYPE *v = NULL;
+	int nlines = sccp_cli_retainLines(&lines);
+	int nrows = 0;
+	int size = 0;
+	int idx = 0;
+	int lineStart = 0;
+	boolean_t first = TRUE;
+
+	*rows = NULL;
+	for (idx = 0; idx < nlines; idx++) {
+		sccp_line_t *l = lines[idx];
+
+		if (!sccp_cli_inWindow(window, l->name, l->label, l->description)) {
+			continue;
+		}
+		first = TRUE;
+		lineStart = nrows;
+		SCCP_LIST_LOCK(&l->devices);
+		SCCP_LIST_TRAVERSE(&l->devices, linedevice, list) {
+			if (!linedevice->device || !(row = sccp_cli_addRow((void **) rows, &nrows, &size, sizeof(sccp_cli_line_row_t)))) {
+				continue;
+			}
+			row->type = SCCP_CLI_LINEROW_DEVICE;
+			row->first = first;
+			row->replaceCid = linedevice->subscriptionId.replaceCid;
+			sccp_copy_string(row->number, linedevice->subscriptionId.number, sizeof(row->number));
+			sccp_copy_string(row->label, !sccp_strlen_zero(linedevice->subscriptionId.label) ? linedevice->subscriptionId.label : (l->label ? l->label : ""), sizeof(row->label));
+			sccp_copy_string(row->device, linedevice->device->id, sizeof(row->device));
+			row->state = SCCP_CHANNELSTATE_SENTINEL;
+			row->calltype = SKINNY_CALLTYPE_SENTINEL;
+
+			SCCP_LIST_LOCK(&l->channels);
+			SCCP_LIST_TRAVERSE(&l->channels, channel, list) {
+				if (channel->state == SCCP_CHANNELSTATE_HOLD || sccp_strequals(channel->currentDeviceId, row->device)) {
+					if (channel->owner) {
+						pbx_getformatname_multiple(row->capabilities, sizeof(row->capabilities), pbx_channel_nativeformats(channel->owner));
+					}
+					iCallInfo.Getter(sccp_channel_getCallInfo(channel), 
+						channel->calltype == SKINNY_CALLTYPE_OUTBOUND ? SCCP_CALLINFO_CALLEDPARTY_NAME : SCCP_CALLINFO_CALLINGPARTY_NAME, &row->partyName,
+						SCCP_CALLINFO_KEY_SENTINEL);
+					row->calltype = channel->calltype;
+					row->state = channel->state;
+					break;
+				}
+			}
+			SCCP_LIST_UNLOCK(&l->channels);
+			first = FALSE;
+		}
+		SCCP_LIST_UNLOCK(&l->devices);
+
+		if (first && (row = sccp_cli_addRow((void **) rows, &nrows, &size, sizeof(sccp_cli_line_row_t)))) {
+			row->type = SCCP_CLI_LINEROW_NODEVICE;
+			row->first = TRUE;
+			sccp_copy_string(row->label, l->label ? l->label : "", sizeof(row->label));
+			row->state = SCCP_CHANNELSTATE_SENTINEL;
+			row->calltype = SKINNY_CALLTYPE_SENTINEL;
+		}
+		/* fill in the line fields shared by all rows of this line */
+		for (row = *rows + lineStart; row < *rows + nrows; row++) {
+			sccp_copy_string(row->name, l->name, sizeof(row->name));
+			sccp_copy_string(row->description, l->description ? l->description : "", sizeof(row->description));
+			row->mwi = l->voicemailStatistic.newmsgs ? TRUE : FALSE;
+			row->channels = SCCP_LIST_GETSIZE(&l->channels);
+		}
+
+		for (v = l->variables; v; v = v->next) {
+			if ((row = sccp_cli_addRow((void **) rows, &nrows, &size, sizeof(sccp_cli_line_row_t)))) {
+				row->type = SCCP_CLI_LINEROW_VARIABLE;
+				sccp_copy_string(row->name, v->name, sizeof(row->name));
+				sccp_copy_string(row->description, v->value, sizeof(row->description));
+			}
+		}
+		if ((!sccp_strlen_zero(l->defaultSubscriptionId.number) || !sccp_strlen_zero(l->defaultSubscriptionId.name)) && (row = sccp_cli_addRow((void **) rows, &nrows, &size, sizeof(sccp_cli_line_row_t)))) {
+			row->type = SCCP_CLI_LINEROW_SUBSCRIPTIONID;
+			sccp_copy_string(row->number, l->defaultSubscriptionId.number, sizeof(row->number));
+			sccp_copy_string(row->description, l->defaultSubscriptionId.name, sizeof(row->description));
+		}
+	}
+	sccp_cli_releaseLines(lines, nlines);
+	return nrows;
+}
+
     /*!
      * \brief Show Lines
      * \param fd Fd as int
@@ -1086,20 +1570,27 @@ CLI_AMI_ENTRY(show_device, sccp_show_device, "Lists device settings", cli_device
     //static int sccp_show_lines(int fd, int argc, char *argv[])
 static int sccp_show_lines(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
 {
-	sccp_line_t *l = NULL;
-	boolean_t found_linedevice;
-	sccp_linedevices_t *linedevice = NULL;
-	sccp_channel_t *channel = NULL;
-	char cap_buf[512] = {0};
-	PBX_VARIABLE_TYPE *v = NULL;
+	sccp_cli_window_t window;
+	sccp_cli_line_row_t *rows = NULL;
+	sccp_cli_line_row_t *row = NULL;
+	int nrows = 0;
+	int idx = 0;
 	int local_line_total = 0;
 	const char *actionid = "";
+	sccp_cli_json_t json;
+	boolean_t isjson = FALSE;
+
+	if (sccp_cli_parseWindow(&window, argc, argv) != RESULT_SUCCESS) {
+		return RESULT_SHOWUSAGE;
+	}
+	nrows = sccp_cli_collectLines(&window, &rows);
+	isjson = sccp_cli_json_start(&json, s, m, "Lines");
 
 	if (!s) {
 		pbx_cli(fd, "\n+--- Lines ------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
 		pbx_cli(fd, "| %-13s %-9s %-30s %-16s %-16s %-4s %-4s %-59s |\n", "Ext", "Suffix", "Label", "Description", "Device", "MWI", "Chs", "Active Channel");
 		pbx_cli(fd, "+ ============= ========= ============================== ================ ================ ==== ==== =========================================================== +\n");
-	} else {
+	} else if (!isjson) {
 		astman_append(s, "Event: TableStart\r\n");
 		local_line_total++;
 		astman_append(s, "TableName: Lines\r\n");
@@ -1111,116 +1602,85 @@ static int sccp_show_lines(int fd, sccp_cli_totals_t *totals, struct mansession
 		astman_append(s, "\r\n");
 		local_line_total++;
 	}
-	SCCP_RWLIST_RDLOCK(&GLOB(lines));
-	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
-		found_linedevice = 0;
-		channel = NULL;
-		SCCP_LIST_LOCK(&l->devices);
-		SCCP_LIST_TRAVERSE(&l->devices, linedevice, list) {
-			AUTO_RELEASE(sccp_device_t, d , sccp_device_retain(linedevice->device));
-			if (d) {
-				memset(&cap_buf, 0, sizeof(cap_buf));
-				char cid_name[StationMaxNameSize] = {0};
-				skinny_calltype_t calltype = SKINNY_CALLTYPE_SENTINEL;
-				sccp_channelstate_t state = SCCP_CHANNELSTATE_SENTINEL;
-				
-				SCCP_LIST_LOCK(&l->channels);
-				SCCP_LIST_TRAVERSE(&l->channels, channel, list) {
-					//if (channel && (channel->state != SCCP_CHANNELSTATE_CONNECTED || sccp_strequals(channel->currentDeviceId, d->id))) {
-					if (channel && (channel->state == SCCP_CHANNELSTATE_HOLD || sccp_strequals(channel->currentDeviceId, d->id))) {
-						if (channel->owner) {
-							pbx_getformatname_multiple(cap_buf, sizeof(cap_buf), pbx_channel_nativeformats(channel->owner));
-						}
-						if (channel->calltype == SKINNY_CALLTYPE_OUTBOUND) {
-							iCallInfo.Getter(sccp_channel_getCallInfo(channel), 
-								SCCP_CALLINFO_CALLEDPARTY_NAME, &cid_name,
-								SCCP_CALLINFO_KEY_SENTINEL);
-						} else {
-							iCallInfo.Getter(sccp_channel_getCallInfo(channel), 
-								SCCP_CALLINFO_CALLINGPARTY_NAME, &cid_name,
-								SCCP_CALLINFO_KEY_SENTINEL);
-						}
-						calltype = channel->calltype;
-						state = channel->state;
-						break;
-					}
-				}
-				SCCP_LIST_UNLOCK(&l->channels);
-				if (!s) {
-					pbx_cli(fd, "| %-13s %-3s%-6s %-30s %-16s %-16s %-4s %-4d %-10s %-10s %-26.26s %-10s |\n",
-						!found_linedevice ? l->name : " +--", 
-						linedevice->subscriptionId.replaceCid ? "(=)" : "(+)", linedevice->subscriptionId.number, 
-						sccp_strlen_zero(linedevice->subscriptionId.label) ? (l->label ? l->label : "--") : linedevice->subscriptionId.label,
-						l->description ? l->description : "--",
-						d->id, 
-						(l->voicemailStatistic.newmsgs) ? "ON" : "OFF", 
-						SCCP_RWLIST_GETSIZE(&l->channels), 
-						(state != SCCP_CHANNELSTATE_SENTINEL) ? sccp_channelstate2str(state) : "--",
-						(calltype != SKINNY_CALLTYPE_SENTINEL) ? skinny_calltype2str(calltype) : "--",
-						cid_name,
-						cap_buf);
-				} else {
-					astman_append(s, "Event: SCCPLineEntry\r\n");
-					astman_append(s, "ChannelType: SCCP\r\n");
-					astman_append(s, "ChannelObjectType: Line\r\n");
-					astman_append(s, "ActionId: %s\r\n", actionid);
-					astman_append(s, "Exten: %s\r\n", l->name);
-					astman_append(s, "SubscriptionNumber: %s\r\n", linedevice->subscriptionId.number);
-					astman_append(s, "Label: %s\r\n", sccp_strlen_zero(linedevice->subscriptionId.label) ? l->label : linedevice->subscriptionId.label);
-					astman_append(s, "Description: %s\r\n", l->description ? l->description : "<not set>");
-					astman_append(s, "Device: %s\r\n", d->id);
-					astman_append(s, "MWI: %s\r\n", (l->voicemailStatistic.newmsgs) ? "ON" : "OFF");
-					astman_append(s, "ActiveChannels: %d\r\n", SCCP_LIST_GETSIZE(&l->channels));
-					astman_append(s, "ChannelState: %s\r\n", (state != SCCP_CHANNELSTATE_SENTINEL) ? sccp_channelstate2str(state) : "--");
-					astman_append(s, "CallType: %s\r\n", (calltype != SKINNY_CALLTYPE_SENTINEL) ? skinny_calltype2str(calltype) : "--");
-					astman_append(s, "PartyName: %s\r\n", cid_name);
-					astman_append(s, "Capabilities: %s\r\n", cap_buf);
-					astman_append(s, "\r\n");
-				}
-				found_linedevice = 1;
-			}
-		}
-		SCCP_LIST_UNLOCK(&l->devices);
-
-		if (found_linedevice == 0) {
-			char cid_name[StationMaxNameSize] = {0};
-			if (!s) {
-				pbx_cli(fd, "| %-13s %-3s%-6s %-30s %-16s %-16s %-4s %-4d %-10s %-10s %-26.26s %-10s |\n", 
-					l->name, 
-					"", "",
-					l->label, 
-					l->description,
-					"--", 
-					(l->voicemailStatistic.newmsgs) ? "ON" : "OFF", 
-					SCCP_LIST_GETSIZE(&l->channels),
-					"--", 
-					"--", 
-					cid_name,
-					cap_buf);
-			} else {
-				astman_append(s, "Event: SCCPLineEntry\r\n");
-				astman_append(s, "ChannelType: SCCP\r\n");
-				astman_append(s, "ChannelObjectType: Line\r\n");
-				astman_append(s, "ActionId: %s\r\n", actionid);
-				astman_append(s, "Exten: %s\r\n", l->name);
-				astman_append(s, "Label: %s\r\n", l->label ? l->label : "<not set>");
-				astman_append(s, "Description: %s\r\n", l->description ? l->description : "<not set>");
-				astman_append(s, "Device: %s\r\n", "(null)");
-				astman_append(s, "MWI: %s\r\n", (l->voicemailStatistic.newmsgs) ? "ON" : "OFF");
-				astman_append(s, "\r\n");
-			}
-		}
+	for (idx = 0; idx < nrows; idx++) {
+		row = &rows[idx];
 		if (!s) {
-			for (v = l->variables; v; v = v->next) {
-				pbx_cli(fd, "| %-13s %-9s %-30s = %-101.101s |\n", "", "Variable:", v->name, v->value);
-			}
-			if (!sccp_strlen_zero(l->defaultSubscriptionId.number) || !sccp_strlen_zero(l->defaultSubscriptionId.name)) {
-				pbx_cli(fd, "| %-13s %-9s %-30s %-103.103s |\n", "", "SubscrId:", l->defaultSubscriptionId.number, l->defaultSubscriptionId.name);
+			switch (row->type) {
+				case SCCP_CLI_LINEROW_DEVICE:
+				case SCCP_CLI_LINEROW_NODEVICE:
+					pbx_cli(fd, "| %-13s %-3s%-6s %-30s %-16s %-16s %-4s %-4d %-10s %-10s %-26.26s %-10s |\n",
+						row->first ? row->name : " +--", 
+						row->type == SCCP_CLI_LINEROW_NODEVICE ? "" : (row->replaceCid ? "(=)" : "(+)"), row->number,
+						!sccp_strlen_zero(row->label) ? row->label : "--",
+						!sccp_strlen_zero(row->description) ? row->description : "--",
+						row->type == SCCP_CLI_LINEROW_NODEVICE ? "--" : row->device,
+						row->mwi ? "ON" : "OFF", 
+						row->channels,
+						(row->state != SCCP_CHANNELSTATE_SENTINEL) ? sccp_channelstate2str(row->state) : "--",
+						(row->calltype != SKINNY_CALLTYPE_SENTINEL) ? skinny_calltype2str(row->calltype) : "--",
+						row->partyName,
+						row->capabilities);
+					break;
+				case SCCP_CLI_LINEROW_VARIABLE:
+					pbx_cli(fd, "| %-13s %-9s %-30s = %-101.101s |\n", "", "Variable:", row->name, row->description);
+					break;
+				case SCCP_CLI_LINEROW_SUBSCRIPTIONID:
+					pbx_cli(fd, "| %-13s %-9s %-30s %-103.103s |\n", "", "SubscrId:", row->number, row->description);
+					break;
 			}
+		} else if (isjson && (row->type == SCCP_CLI_LINEROW_DEVICE || row->type == SCCP_CLI_LINEROW_NODEVICE)) {
+			sccp_cli_json_startEntry(&json);
+			sccp_cli_json_field(&json, "Exten", "s", "%s", row->name);
+			sccp_cli_json_field(&json, "SubscriptionNumber", "s", "%s", row->number);
+			sccp_cli_json_field(&json, "Label", "s", "%s", row->label);
+			sccp_cli_json_field(&json, "Description", "s", "%s", row->description);
+			sccp_cli_json_field(&json, "Device", "s", "%s", row->type == SCCP_CLI_LINEROW_DEVICE ? row->device : "");
+			sccp_cli_json_field(&json, "MWI", "s", "%s", row->mwi ? "ON" : "OFF");
+			sccp_cli_json_field(&json, "ActiveChannels", "d", "%d", row->channels);
+			sccp_cli_json_field(&json, "ChannelState", "s", "%s", (row->state != SCCP_CHANNELSTATE_SENTINEL) ? sccp_channelstate2str(row->state) : "--");
+			sccp_cli_json_field(&json, "CallType", "s", "%s", (row->calltype != SKINNY_CALLTYPE_SENTINEL) ? skinny_calltype2str(row->calltype) : "--");
+			sccp_cli_json_field(&json, "PartyName", "s", "%s", row->partyName);
+			sccp_cli_json_field(&json, "Capabilities", "s", "%s", row->capabilities);
+			sccp_cli_json_endEntry(&json);
+		} else if (!isjson && row->type == SCCP_CLI_LINEROW_DEVICE) {
+			astman_append(s, "Event: SCCPLineEntry\r\n");
+			astman_append(s, "ChannelType: SCCP\r\n");
+			astman_append(s, "ChannelObjectType: Line\r\n");
+			astman_append(s, "ActionId: %s\r\n", actionid);
+			astman_append(s, "Exten: %s\r\n", row->name);
+			astman_append(s, "SubscriptionNumber: %s\r\n", row->number);
+			astman_append(s, "Label: %s\r\n", row->label);
+			astman_append(s, "Description: %s\r\n", !sccp_strlen_zero(row->description) ? row->description : "<not set>");
+			astman_append(s, "Device: %s\r\n", row->device);
+			astman_append(s, "MWI: %s\r\n", row->mwi ? "ON" : "OFF");
+			astman_append(s, "ActiveChannels: %d\r\n", row->channels);
+			astman_append(s, "ChannelState: %s\r\n", (row->state != SCCP_CHANNELSTATE_SENTINEL) ? sccp_channelstate2str(row->state) : "--");
+			astman_append(s, "CallType: %s\r\n", (row->calltype != SKINNY_CALLTYPE_SENTINEL) ? skinny_calltype2str(row->calltype) : "--");
+			astman_append(s, "PartyName: %s\r\n", row->partyName);
+			astman_append(s, "Capabilities: %s\r\n", row->capabilities);
+			astman_append(s, "\r\n");
+		} else if (!isjson && row->type == SCCP_CLI_LINEROW_NODEVICE) {
+			astman_append(s, "Event: SCCPLineEntry\r\n");
+			astman_append(s, "ChannelType: SCCP\r\n");
+			astman_append(s, "ChannelObjectType: Line\r\n");
+			astman_append(s, "ActionId: %s\r\n", actionid);
+			astman_append(s, "Exten: %s\r\n", row->name);
+			astman_append(s, "Label: %s\r\n", !sccp_strlen_zero(row->label) ? row->label : "<not set>");
+			astman_append(s, "Description: %s\r\n", !sccp_strlen_zero(row->description) ? row->description : "<not set>");
+			astman_append(s, "Device: %s\r\n", "(null)");
+			astman_append(s, "MWI: %s\r\n", row->mwi ? "ON" : "OFF");
+			astman_append(s, "\r\n");
 		}
 	}
+	if (rows) {
+		sccp_free(rows);
+	}
 	if (!s) {
 		pbx_cli(fd, "+----------------------------------------------------------------------------------------------------------------------------------------------------------------+\n");
+		sccp_cli_printWindow(fd, s, &window);
+	} else if (isjson) {
+		sccp_cli_json_end(&json);
+		local_line_total++;
 	} else {
 		astman_append(s, "Event: TableEnd\r\n");
 		local_line_total++;
@@ -1233,7 +1693,6 @@ static int sccp_show_lines(int fd, sccp_cli_totals_t *totals, struct mansession
 		}
 		local_line_total++;
 	}
-	SCCP_RWLIST_UNLOCK(&GLOB(lines));
 	if (s) {
 		totals->lines = local_line_total;
 		totals->tables = 1;
@@ -1243,14 +1702,14 @@ static int sccp_show_lines(int fd, sccp_cli_totals_t *totals, struct mansession
 	return RESULT_SUCCESS;
 }
 
-static char cli_lines_usage[] = "Usage: sccp show lines\n" "       Lists all lines known to the SCCP subsystem.\n";
-static char ami_lines_usage[] = "Usage: SCCPShowLines\n" "Lists all lines known to the SCCP subsystem\n" "PARAMS: None\n";
+static char cli_lines_usage[] = "Usage: sccp show lines [<filter> [<offset> [<limit>]]]\n" "       Lists all lines known to the SCCP subsystem.\n" "       Only lines whose name, label or description contain <filter> ('*' matches all) are shown, skipping <offset> and returning at most <limit> lines.\n";
+static char ami_lines_usage[] = "Usage: SCCPShowLines\n" "Lists all lines known to the SCCP subsystem\n" "Optional PARAMS: Filter, Offset, Limit, Format (json), Columns\n";
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 #define CLI_COMMAND "sccp", "show", "lines"
 #define AMI_COMMAND "SCCPShowLines"
 #define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
-#define CLI_AMI_PARAMS ""
+#define CLI_AMI_PARAMS "Filter", "Offset", "Limit"
 CLI_AMI_ENTRY(show_lines, sccp_show_lines, "List defined SCCP Lines", cli_lines_usage, FALSE, TRUE)
 #undef CLI_AMI_PARAMS
 #undef CLI_COMPLETE
@@ -1436,6 +1895,66 @@ CLI_AMI_ENTRY(show_line, sccp_show_line, "List defined SCCP line settings", cli_
 #undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
     /* --------------------------------------------------------------------------------------------------------SHOW CHANNELS- */
+typedef struct sccp_cli_channel_row {
+	uint32_t callid;
+	char name[25];
+	char line[StationMaxNameSize];
+	char device[StationMaxDeviceNameSize];
+	char dialedNumber[SCCP_MAX_EXTENSION];
+	char pbxState[20];
+	sccp_channelstate_t state;
+	skinny_codec_t readFormat;
+	skinny_codec_t writeFormat;
+	char rtpPeer[INET6_ADDRSTRLEN];
+	boolean_t directMedia;
+	sccp_dtmfmode_t dtmfmode;
+} sccp_cli_channel_row_t;
+
+/* copy the displayed fields of the channels inside the window, returns the number of rows */
+static int sccp_cli_collectChannels(sccp_cli_window_t * window, sccp_cli_channel_row_t ** rows)
+{
+	sccp_line_t **lines = NULL;
+	sccp_channel_t *channel = NULL;
+	sccp_cli_channel_row_t *row = NULL;
+	char name[25];
+	int nlines = sccp_cli_retainLines(&lines);
+	int nrows = 0;
+	int size = 0;
+	int idx = 0;
+
+	*rows = NULL;
+	for (idx = 0; idx < nlines; idx++) {
+		sccp_line_t *l = lines[idx];
+
+		SCCP_LIST_LOCK(&l->channels);
+		SCCP_LIST_TRAVERSE(&l->channels, channel, list) {
+			if (channel->conference_id) {
+				snprintf(name, sizeof(name), "SCCPCONF/%03d/%03d", channel->conference_id, channel->conference_participant_id);
+			} else {
+				snprintf(name, sizeof(name), "%s", channel->designator);
+			}
+			if (!sccp_cli_inWindow(window, name, l->name, channel->currentDeviceId) || !(row = sccp_cli_addRow((void **) rows, &nrows, &size, sizeof(sccp_cli_channel_row_t)))) {
+				continue;
+			}
+			row->callid = channel->callid;
+			sccp_copy_string(row->name, name, sizeof(row->name));
+			sccp_copy_string(row->line, l->name, sizeof(row->line));
+			sccp_copy_string(row->device, channel->currentDeviceId, sizeof(row->device));
+			sccp_copy_string(row->dialedNumber, channel->dialedNumber, sizeof(row->dialedNumber));
+			sccp_copy_string(row->pbxState, channel->owner ? pbx_state2str(iPbx.getChannelState(channel)) : "(none)", sizeof(row->pbxState));
+			row->state = channel->state;
+			row->readFormat = channel->rtp.audio.readFormat;
+			row->writeFormat = channel->rtp.audio.writeFormat;
+			sccp_copy_string(row->rtpPeer, sccp_netsock_stringify(&channel->rtp.audio.phone), sizeof(row->rtpPeer));
+			row->directMedia = channel->rtp.audio.directMedia;
+			row->dtmfmode = channel->dtmfmode;
+		}
+		SCCP_LIST_UNLOCK(&l->channels);
+	}
+	sccp_cli_releaseLines(lines, nlines);
+	return nrows;
+}
+
     /*!
      * \brief Show Channels
      * \param fd Fd as int
@@ -1452,51 +1971,43 @@ CLI_AMI_ENTRY(show_line, sccp_show_line, "List defined SCCP line settings", cli_
     //static int sccp_show_channels(int fd, int argc, char *argv[])
 static int sccp_show_channels(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
 {
-	sccp_channel_t *channel = NULL;
-	sccp_line_t *line = NULL;
 	int local_line_total = 0;
-	char tmpname[25];
-	char addrStr[INET6_ADDRSTRLEN] = "";
+	sccp_cli_window_t window;
+	sccp_cli_channel_row_t *rows = NULL;
+	sccp_cli_channel_row_t *row = NULL;
+	int nrows = 0;
+	int idx = 0;
+
+	if (sccp_cli_parseWindow(&window, argc, argv) != RESULT_SUCCESS) {
+		return RESULT_SHOWUSAGE;
+	}
+	nrows = sccp_cli_collectChannels(&window, &rows);
 
 #define CLI_AMI_TABLE_NAME Channels
 #define CLI_AMI_TABLE_PER_ENTRY_NAME Channel
-#define CLI_AMI_TABLE_LIST_ITER_HEAD &GLOB(lines)
-#define CLI_AMI_TABLE_LIST_ITER_VAR line
-#define CLI_AMI_TABLE_LIST_LOCK SCCP_RWLIST_RDLOCK
-#define CLI_AMI_TABLE_LIST_ITERATOR SCCP_RWLIST_TRAVERSE
-#define CLI_AMI_TABLE_LIST_UNLOCK SCCP_RWLIST_UNLOCK
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
 #define CLI_AMI_TABLE_BEFORE_ITERATION 												\
-		AUTO_RELEASE(sccp_line_t, l , sccp_line_retain(line));								\
-		SCCP_LIST_LOCK(&l->channels);											\
-		SCCP_LIST_TRAVERSE(&l->channels, channel, list) {								\
-			if (channel->conference_id) {										\
-				snprintf(tmpname, sizeof(tmpname), "SCCPCONF/%03d/%03d", channel->conference_id, channel->conference_participant_id);	\
-			} else {												\
-				snprintf(tmpname, sizeof(tmpname), "%s", channel->designator);					\
-			}													\
-			if (&channel->rtp) {											\
-				sccp_copy_string(addrStr,sccp_netsock_stringify(&channel->rtp.audio.phone), sizeof(addrStr));	\
-			}
-
-#define CLI_AMI_TABLE_AFTER_ITERATION 												\
-		}														\
-		SCCP_LIST_UNLOCK(&l->channels);											\
+		row = &rows[idx];
 
 #define CLI_AMI_TABLE_FIELDS 															\
-		CLI_AMI_TABLE_FIELD(ID,			"-5",		d,	5,	channel->callid)					\
-		CLI_AMI_TABLE_FIELD(Name,		"-25.25",	s,	25,	pbx_strdupa(tmpname))					\
-		CLI_AMI_TABLE_FIELD(LineName,		"-10.10",	s,	10,	channel->line->name)					\
-		CLI_AMI_TABLE_FIELD(DeviceName,		"-16",		s,	16,	channel->currentDeviceId)				\
-		CLI_AMI_TABLE_FIELD(NumCalled,		"-10.10",	s,	10,	channel->dialedNumber)					\
-		CLI_AMI_TABLE_FIELD(PBX State,		"-10.10",	s,	10,	(channel->owner) ? pbx_state2str(iPbx.getChannelState(channel)) : "(none)")	\
-		CLI_AMI_TABLE_FIELD(SCCP State,		"-10.10",	s,	10,	sccp_channelstate2str(channel->state))			\
-		CLI_AMI_TABLE_FIELD(ReadCodec,		"-10.10",	s,	10,	codec2name(channel->rtp.audio.readFormat))		\
-		CLI_AMI_TABLE_FIELD(WriteCodec,		"-10.10",	s,	10,	codec2name(channel->rtp.audio.writeFormat))		\
-		CLI_AMI_TABLE_FIELD(RTPPeer,		"22.22",	s,	22,	addrStr)						\
-		CLI_AMI_TABLE_FIELD(Direct,		"-6.6",		s,	6,	channel->rtp.audio.directMedia ? "yes" : "no")		\
-		CLI_AMI_TABLE_FIELD(DTMFmode,		"-8.8",		s,	8,	sccp_dtmfmode2str(channel->dtmfmode))
+		CLI_AMI_TABLE_FIELD(ID,			"-5",		d,	5,	row->callid)						\
+		CLI_AMI_TABLE_FIELD(Name,		"-25.25",	s,	25,	row->name)						\
+		CLI_AMI_TABLE_FIELD(LineName,		"-10.10",	s,	10,	row->line)						\
+		CLI_AMI_TABLE_FIELD(DeviceName,		"-16",		s,	16,	row->device)						\
+		CLI_AMI_TABLE_FIELD(NumCalled,		"-10.10",	s,	10,	row->dialedNumber)					\
+		CLI_AMI_TABLE_FIELD(PBX State,		"-10.10",	s,	10,	row->pbxState)						\
+		CLI_AMI_TABLE_FIELD(SCCP State,		"-10.10",	s,	10,	sccp_channelstate2str(row->state))			\
+		CLI_AMI_TABLE_FIELD(ReadCodec,		"-10.10",	s,	10,	codec2name(row->readFormat))				\
+		CLI_AMI_TABLE_FIELD(WriteCodec,		"-10.10",	s,	10,	codec2name(row->writeFormat))				\
+		CLI_AMI_TABLE_FIELD(RTPPeer,		"22.22",	s,	22,	row->rtpPeer)						\
+		CLI_AMI_TABLE_FIELD(Direct,		"-6.6",		s,	6,	row->directMedia ? "yes" : "no")			\
+		CLI_AMI_TABLE_FIELD(DTMFmode,		"-8.8",		s,	8,	sccp_dtmfmode2str(row->dtmfmode))
 #include "sccp_cli_table.h"
 
+	if (rows) {
+		sccp_free(rows);
+	}
+	sccp_cli_printWindow(fd, s, &window);
 	if (s) {
 		totals->lines = local_line_total;
 		totals->tables = 1;
@@ -1504,14 +2015,14 @@ static int sccp_show_channels(int fd, sccp_cli_totals_t *totals, struct mansessi
 	return RESULT_SUCCESS;
 }
 
-static char cli_channels_usage[] = "Usage: sccp show channels\n" "       Lists active channels for the SCCP subsystem.\n";
-static char ami_channels_usage[] = "Usage: SCCPShowChannels\n" "Lists active channels for the SCCP subsystem.\n\n" "PARAMS: None\n";
+static char cli_channels_usage[] = "Usage: sccp show channels [<filter> [<offset> [<limit>]]]\n" "       Lists active channels for the SCCP subsystem.\n" "       Only channels whose name, line or device contain <filter> ('*' matches all) are shown, skipping <offset> and returning at most <limit> entries.\n";
+static char ami_channels_usage[] = "Usage: SCCPShowChannels\n" "Lists active channels for the SCCP subsystem.\n\n" "Optional PARAMS: Filter, Offset, Limit, Format (json), Columns\n";
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 #define CLI_COMMAND "sccp", "show", "channels"
 #define AMI_COMMAND "SCCPShowChannels"
 #define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
-#define CLI_AMI_PARAMS ""
+#define CLI_AMI_PARAMS "Filter", "Offset", "Limit"
 CLI_AMI_ENTRY(show_channels, sccp_show_channels, "Lists active SCCP channels", cli_channels_usage, FALSE, TRUE)
 #undef CLI_AMI_PARAMS
 #undef CLI_COMPLETE
@@ -2441,6 +2952,12 @@ static int sccp_do_debug(int fd, int argc, char *argv[])
 		pbx_cli(fd, "SCCP debug status: (%d) %s\n", GLOB(debug), debugcategories);
 	}
 	sccp_free(debugcategories);
+	if (GLOB(debug_async)) {
+		sccp_log_async_stats_t async_stats;
+
+		sccp_log_async_getStats(&async_stats);
+		pbx_cli(fd, "SCCP async debug: %d buffers (%d/%d KB), written:%d, dropped:%d, truncated:%d, synchronous:%d\n", async_stats.rings, async_stats.memory / 1024, GLOB(debug_async_memory), async_stats.written, async_stats.dropped, async_stats.truncated, async_stats.synchronous);
+	}
 
 	GLOB(debug) = new_debug;
 	return RESULT_SUCCESS;
@@ -2483,6 +3000,133 @@ static char no_debug_usage[] = "Usage: SCCP no debug\n" "       Disables dumping
 CLI_ENTRY(cli_no_debug, sccp_no_debug, "Set SCCP Debugging Types", no_debug_usage, FALSE)
 #undef CLI_COMMAND
 #undef CLI_COMPLETE
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* --------------------------------------------------------------------------------------------------------DEBUG FILTER- */
+    /*!
+     * \brief Scoped Debug Filter
+     * \param fd Fd as int
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     * 
+     * \called_from_asterisk
+     */
+static int sccp_debug_filter(int fd, int argc, char *argv[])
+{
+	int type = 0;
+	int32_t old_debug = 0;
+	int32_t new_debug = 0;
+
+	if (argc == 3) {
+		pbx_cli(fd, "SCCP scoped debug filters:\n");
+		if (!sccp_debug_filter_print(fd)) {
+			pbx_cli(fd, "  none\n");
+		}
+		return RESULT_SUCCESS;
+	}
+	if (argc < 6 || (type = sccp_debug_str2scope(argv[3])) < 0) {
+		return RESULT_SHOWUSAGE;
+	}
+	old_debug = sccp_debug_filter_get(type, argv[4]);
+	new_debug = sccp_parse_debugline(argv, 5, argc, old_debug);
+
+	if (sccp_debug_filter_set(type, argv[4], new_debug)) {
+		sccp_session_refreshScopes();
+	}
+	char *debugcategories = sccp_get_debugcategories(new_debug);
+
+	pbx_cli(fd, "SCCP debug filter %s '%s': (%d -> %d) %s\n", sccp_debug_scope2str(type), argv[4], old_debug, new_debug, debugcategories ? debugcategories : "none");
+	sccp_free(debugcategories);
+	return RESULT_SUCCESS;
+}
+
+static char debug_filter_usage[] = "Usage: SCCP debug filter [device|line|ip <name> [no] <level or categories>]\n" "       Enable debug categories for a single device, line or remote ip-address only, on top of the global 'sccp debug' level.\n" "       'none' removes the filter, without arguments the current filters are listed.\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "debug", "filter"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+CLI_ENTRY(cli_debug_filter, sccp_debug_filter, "Set Scoped SCCP Debugging", debug_filter_usage, FALSE)
+#undef CLI_COMMAND
+#undef CLI_COMPLETE
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* -------------------------------------------------------------------------------------------------------------CAPTURE- */
+    /*!
+     * \brief Start / Stop capturing the skinny messages of a device into pcap_file
+     * \param fd Fd as int
+     * \param totals Total number of lines as int
+     * \param s AMI Session
+     * \param m Message
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     *
+     * \called_from_asterisk
+     */
+static int sccp_capture(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	const char *actionid = "";
+	sccp_pcap_stats_t stats;
+	pbx_str_t *devices = NULL;
+
+	if (!(devices = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		CLI_AMI_RETURN_ERROR(fd, s, m, "%s: Memory Allocation Error.\n", "SCCP");		/* explicit return */
+	}
+	if (argc > 2 && !sccp_strlen_zero(argv[2])) {
+		boolean_t enable = TRUE;
+
+		if (argc > 3 && !sccp_strlen_zero(argv[3])) {
+			if (sccp_strcaseequals(argv[3], "off")) {
+				enable = FALSE;
+			} else if (!sccp_strcaseequals(argv[3], "on")) {
+				sccp_free(devices);
+				return RESULT_SHOWUSAGE;
+			}
+		}
+		if (sccp_pcap_set(argv[2], enable)) {
+			sccp_session_refreshScopes();
+		}
+	}
+	sccp_pcap_getStats(&stats, &devices);
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPCapture\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	CLI_AMI_OUTPUT_PARAM("Devices", CLI_AMI_LIST_WIDTH, "%s", pbx_str_strlen(devices) ? pbx_str_buffer(devices) : "none");
+	CLI_AMI_OUTPUT_PARAM("File", CLI_AMI_LIST_WIDTH, "%s", stats.filename);
+	CLI_AMI_OUTPUT_PARAM("File Size", CLI_AMI_LIST_WIDTH, "%ld", stats.filesize);
+	CLI_AMI_OUTPUT_PARAM("Captured", CLI_AMI_LIST_WIDTH, "%d", stats.captured);
+	CLI_AMI_OUTPUT_PARAM("Written", CLI_AMI_LIST_WIDTH, "%d", stats.written);
+	CLI_AMI_OUTPUT_PARAM("Dropped", CLI_AMI_LIST_WIDTH, "%d", stats.dropped);
+	CLI_AMI_OUTPUT_PARAM("Rotations", CLI_AMI_LIST_WIDTH, "%d", stats.rotations);
+	sccp_free(devices);
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
+static char cli_capture_usage[] = "Usage: sccp capture [<deviceId> [on|off]]\n" "	Start / Stop writing the skinny messages of a device to pcap_file (wireshark), without arguments show the capture status.\n";
+static char ami_capture_usage[] = "Usage: SCCPCapture\n" "Start / Stop writing the skinny messages of a device to pcap_file and show the capture status.\n\n" "PARAMS: DeviceName (optional), State (on/off, optional)\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "capture"
+#define AMI_COMMAND "SCCPCapture"
+#define CLI_COMPLETE SCCP_CLI_DEVICE_COMPLETER
+#define CLI_AMI_PARAMS "DeviceName", "State"
+CLI_AMI_ENTRY(capture, sccp_capture, "Capture the skinny messages of a device", cli_capture_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
 /* --------------------------------------------------------------------------------------------------------------RELOAD- */
 /*!
@@ -2541,7 +3185,8 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 				}
 #ifdef CS_SCCP_REALTIME
 				if (device->realtime) {
-					v = pbx_load_realtime(GLOB(realtimedevicetable), "name", argv[3], NULL);
+					sccp_realtime_invalidate(GLOB(realtimedevicetable), argv[3]);
+					v = sccp_realtime_load(GLOB(realtimedevicetable), argv[3]);
 				} else
 #endif
 				{
@@ -2605,7 +3250,8 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 				}
 #ifdef CS_SCCP_REALTIME
 				if (line->realtime) {
-					v = pbx_load_realtime(GLOB(realtimelinetable), "name", argv[3], NULL);
+					sccp_realtime_invalidate(GLOB(realtimelinetable), argv[3]);
+					v = sccp_realtime_load(GLOB(realtimelinetable), argv[3]);
 				} else
 #endif
 				{
@@ -2632,7 +3278,7 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 								SCCP_LIST_UNLOCK(&device->buttonconfig);
 #ifdef CS_SCCP_REALTIME
 								if (device->realtime) {
-									if ((dv = pbx_load_realtime(GLOB(realtimedevicetable), "name", argv[3], NULL))) {
+									if ((dv = sccp_realtime_load(GLOB(realtimedevicetable), device->id))) {
 										change |= sccp_config_applyDeviceConfiguration(device, dv);
 									}
 								} else
@@ -2726,6 +3372,7 @@ static int sccp_cli_reload(int fd, int argc, char *argv[])
 					pbx_cli(fd, "Unable to reload configuration.\n");
 					goto EXIT;
 				}
+				sccp_config_writeSnapshot();
 				returnval = sccp_session_bind_and_listen( &GLOB(bindaddr) ) ? RESULT_SUCCESS : RESULT_FAILURE;
 			}
 			break;
@@ -2753,7 +3400,7 @@ EXIT:
 	return returnval;
 }
 
-static char reload_usage[] = "Usage: SCCP reload [force|file filename|device devicename|line linename]\n" "       Reloads SCCP configuration from sccp.conf or filename [force|file filename|device devicename|line linename]\n" "       (It will send a reset to all device which have changed (when they have an active channel reset will be postponed until device goes onhook))\n";
+static char reload_usage[] = "Usage: SCCP reload [force|file filename|device devicename|line linename]\n" "       Reloads SCCP configuration from sccp.conf or filename [force|file filename|device devicename|line linename]\n" "       (It will send a reset to all device which have changed (when they have an active channel reset will be postponed until device goes onhook))\n" "       With reload_incremental=yes only changed devices/lines are re-applied, 'force' re-applies everything. See 'sccp show reload' for the result.\n";
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 #define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
@@ -2778,6 +3425,185 @@ CLI_ENTRY(cli_reload_file, sccp_cli_reload, "Reload the SCCP configuration", rel
 #undef CLI_COMMAND
 #undef CLI_COMPLETE
 #endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ---------------------------------------------------------------------------------------------------------SHOW_RELOAD- */
+    // sccp_config_show_reload implementation lives in sccp_config.c, because of access to the private reload report
+static char cli_show_reload_usage[] = "Usage: sccp show reload\n" "	Show what the last reload did: mode, duration and the devices/lines that were added, removed or modified.\n";
+static char ami_show_reload_usage[] = "Usage: SCCPShowReload\n" "Show what the last reload did: mode, duration and the devices/lines that were added, removed or modified.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "reload"
+#define AMI_COMMAND "SCCPShowReload"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_reload, sccp_config_show_reload, "Show the result of the last SCCP reload", cli_show_reload_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* --------------------------------------------------------------------------------------------------SHOW_STATS_MESSAGES- */
+    // sccp_stats_show_messages implementation lives in sccp_stats.c, next to the per thread tables it merges
+static char cli_show_stats_messages_usage[] = "Usage: sccp show stats messages [<limit>]\n" "	Show count, rate and latency (avg/p50/p99/max in microseconds) per message type, for the inbound handlers and outbound sends.\n" "	Sorted by total time spent, so the worst offenders come first.\n";
+static char ami_show_stats_messages_usage[] = "Usage: SCCPShowStatsMessages\n" "Show count, rate and latency per message type, worst total time first.\n\n" "PARAMS: Limit (optional)\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "stats", "messages"
+#define AMI_COMMAND "SCCPShowStatsMessages"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Limit"
+CLI_AMI_ENTRY(show_stats_messages, sccp_stats_show_messages, "Show SCCP message statistics", cli_show_stats_messages_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* -----------------------------------------------------------------------------------------------------SHOW_STATS_CALLS- */
+    // sccp_stats_show_callspans implementation lives in sccp_stats.c
+static char cli_show_stats_calls_usage[] = "Usage: sccp show stats calls [devicetype|line]\n" "	Show the call setup milestones (milliseconds after channel allocation) per device type and per line: count, avg, p50, p99 and max.\n";
+static char ami_show_stats_calls_usage[] = "Usage: SCCPShowStatsCalls\n" "Show the call setup milestones per device type and per line.\n\n" "PARAMS: Type (devicetype/line, optional)\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "stats", "calls"
+#define AMI_COMMAND "SCCPShowStatsCalls"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Type"
+CLI_AMI_ENTRY(show_stats_calls, sccp_stats_show_callspans, "Show SCCP call setup statistics", cli_show_stats_calls_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* ------------------------------------------------------------------------------------------------------SHOW_LOCKSTATS- */
+    // sccp_lockstats_show implementation lives in sccp_lockstats.c, only collects when configured with --enable-lock-profile
+static char cli_show_lockstats_usage[] = "Usage: sccp show lockstats [reset]\n" "	Show acquisitions, contended acquisitions, total/max wait time and max hold time (microseconds) per lock call site, worst total wait first.\n" "	'reset' zeroes the counters after showing them.\n";
+static char ami_show_lockstats_usage[] = "Usage: SCCPShowLockStats\n" "Show the lock contention statistics per lock call site, worst total wait first.\n\n" "PARAMS: Reset (yes/no, optional)\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "lockstats"
+#define AMI_COMMAND "SCCPShowLockStats"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Reset"
+CLI_AMI_ENTRY(show_lockstats, sccp_lockstats_show, "Show SCCP lock contention statistics", cli_show_lockstats_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+    /* --------------------------------------------------------------------------------------------------------SHOW_METRICS- */
+    // sccp_metrics_show implementation lives in sccp_metrics.c, next to the metrics registry
+static char cli_show_metrics_usage[] = "Usage: sccp show metrics\n" "	Show the metrics (sessions, devices, messages, channels, threadpool, events, refcounted objects) in prometheus text format,\n" "	as written to metrics_file every metrics_interval seconds.\n";
+static char ami_show_metrics_usage[] = "Usage: SCCPShowMetrics\n" "Show the metrics samples (name, type, suffix, labels, value), the same data as written to metrics_file.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "metrics"
+#define AMI_COMMAND "SCCPShowMetrics"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_metrics, sccp_metrics_show, "Show SCCP metrics", cli_show_metrics_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#ifdef CS_SCCP_MANAGER
+    /* -------------------------------------------------------------------------------------------------SHOW_MANAGER_EVENTS- */
+    // sccp_manager_show_events implementation lives in sccp_management.c, next to the event batching
+static char cli_show_manager_events_usage[] = "Usage: sccp show manager events\n" "	Show the manager events received, emitted, coalesced and summarized per event type (see manager_event_batching).\n";
+static char ami_show_manager_events_usage[] = "Usage: SCCPShowManagerEvents\n" "Show the manager events received, emitted, coalesced and summarized per event type.\n\n" "PARAMS: None\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "show", "manager", "events"
+#define AMI_COMMAND "SCCPShowManagerEvents"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS ""
+CLI_AMI_ENTRY(show_manager_events, sccp_manager_show_events, "Show SCCP manager event counters", cli_show_manager_events_usage, FALSE, TRUE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#endif
+#ifdef CS_SCCP_REALTIME
+    /* ---------------------------------------------------------------------------------------------------REALTIME_INVALIDATE- */
+    /*!
+     * \brief Drop entries from the realtime lookup cache
+     * \param fd Fd as int
+     * \param totals Total number of lines as int
+     * \param s AMI Session
+     * \param m Message
+     * \param argc Argc as int
+     * \param argv[] Argv[] as char
+     * \return Result as int
+     *
+     * \called_from_asterisk
+     */
+static int sccp_realtime_invalidate_cmd(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	const char *table = NULL;
+	const char *name = NULL;
+	const char *actionid = "";
+	sccp_realtime_stats_t stats;
+	int dropped = 0;
+
+	if (argc > 3 && !sccp_strlen_zero(argv[3])) {
+		if (sccp_strcaseequals(argv[3], "device")) {
+			table = GLOB(realtimedevicetable);
+		} else if (sccp_strcaseequals(argv[3], "line")) {
+			table = GLOB(realtimelinetable);
+		} else if (argc > 4) {
+			return RESULT_SHOWUSAGE;
+		} else {
+			name = argv[3];
+		}
+	}
+	if (argc > 4 && !sccp_strlen_zero(argv[4])) {
+		name = argv[4];
+	}
+	dropped = sccp_realtime_invalidate(table, name);
+	sccp_realtime_getStats(&stats);
+
+	if (s) {
+		astman_append(s, "Response: Success\r\n");
+		astman_append(s, "Message: SCCPRealtimeInvalidate\r\n");
+		actionid = astman_get_header(m, "ActionID");
+		if (!pbx_strlen_zero(actionid)) {
+			astman_append(s, "ActionID: %s\r\n", actionid);
+		}
+		local_line_total++;
+	}
+	CLI_AMI_OUTPUT_PARAM("Dropped", CLI_AMI_LIST_WIDTH, "%d", dropped);
+	CLI_AMI_OUTPUT_PARAM("Entries", CLI_AMI_LIST_WIDTH, "%d", stats.entries);
+	CLI_AMI_OUTPUT_PARAM("Negative Entries", CLI_AMI_LIST_WIDTH, "%d", stats.negative);
+	CLI_AMI_OUTPUT_PARAM("Hits", CLI_AMI_LIST_WIDTH, "%d", stats.hits);
+	CLI_AMI_OUTPUT_PARAM("Negative Hits", CLI_AMI_LIST_WIDTH, "%d", stats.negative_hits);
+	CLI_AMI_OUTPUT_PARAM("Misses", CLI_AMI_LIST_WIDTH, "%d", stats.misses);
+	CLI_AMI_OUTPUT_PARAM("Coalesced", CLI_AMI_LIST_WIDTH, "%d", stats.coalesced);
+	CLI_AMI_OUTPUT_PARAM("Queries", CLI_AMI_LIST_WIDTH, "%d", stats.queries);
+	CLI_AMI_OUTPUT_PARAM("Prefetched", CLI_AMI_LIST_WIDTH, "%d", stats.prefetched);
+	CLI_AMI_OUTPUT_PARAM("Evicted", CLI_AMI_LIST_WIDTH, "%d", stats.evicted);
+
+	if (s) {
+		totals->lines = local_line_total;
+	}
+	return RESULT_SUCCESS;
+}
+
+static char cli_realtime_invalidate_usage[] = "Usage: sccp realtime invalidate [device|line] [name]\n" "	Drop cached realtime lookups (all, of one table and/or for one name) and show the cache statistics.\n";
+static char ami_realtime_invalidate_usage[] = "Usage: SCCPRealtimeInvalidate\n" "Drop cached realtime lookups and show the cache statistics.\n\n" "PARAMS: Type (device/line, optional), Name (optional)\n";
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+#define CLI_COMMAND "sccp", "realtime", "invalidate"
+#define AMI_COMMAND "SCCPRealtimeInvalidate"
+#define CLI_COMPLETE SCCP_CLI_NULL_COMPLETER
+#define CLI_AMI_PARAMS "Type", "Name"
+CLI_AMI_ENTRY(realtime_invalidate, sccp_realtime_invalidate_cmd, "Drop cached realtime lookups", cli_realtime_invalidate_usage, FALSE, FALSE)
+#undef CLI_AMI_PARAMS
+#undef CLI_COMPLETE
+#undef AMI_COMMAND
+#undef CLI_COMMAND
+#endif														/* DOXYGEN_SHOULD_SKIP_THIS */
+#endif
     /*!
      * \brief Generare sccp.conf
      * \param fd Fd as int
@@ -3462,12 +4288,25 @@ static struct pbx_cli_entry cli_entries[] = {
 	AST_CLI_DEFINE(cli_dnd_device, "Set DND on a device"),
 	AST_CLI_DEFINE(cli_do_debug, "Enable SCCP debugging."),
 	AST_CLI_DEFINE(cli_no_debug, "Disable SCCP debugging."),
+	AST_CLI_DEFINE(cli_debug_filter, "Set scoped SCCP debugging."),
+	AST_CLI_DEFINE(cli_capture, "Capture the skinny messages of a device."),
 	AST_CLI_DEFINE(cli_config_generate, "SCCP generate config file."),
 	AST_CLI_DEFINE(cli_reload, "SCCP module reload."),
 	AST_CLI_DEFINE(cli_reload_file, "SCCP module reload file."),
 	AST_CLI_DEFINE(cli_reload_force, "SCCP module reload force."),
 	AST_CLI_DEFINE(cli_reload_device, "SCCP module reload device."),
 	AST_CLI_DEFINE(cli_reload_line, "SCCP module reload line."),
+	AST_CLI_DEFINE(cli_show_reload, "Show the result of the last SCCP reload."),
+	AST_CLI_DEFINE(cli_show_stats_messages, "Show SCCP message statistics."),
+	AST_CLI_DEFINE(cli_show_stats_calls, "Show SCCP call setup statistics."),
+	AST_CLI_DEFINE(cli_show_lockstats, "Show SCCP lock contention statistics."),
+	AST_CLI_DEFINE(cli_show_metrics, "Show SCCP metrics."),
+#ifdef CS_SCCP_MANAGER
+	AST_CLI_DEFINE(cli_show_manager_events, "Show SCCP manager event counters."),
+#endif
+#ifdef CS_SCCP_REALTIME
+	AST_CLI_DEFINE(cli_realtime_invalidate, "Drop cached realtime lookups."),
+#endif
 	AST_CLI_DEFINE(cli_restart, "Restart an SCCP device"),
 	AST_CLI_DEFINE(cli_reset, "Reset an SCCP Device"),
 	AST_CLI_DEFINE(cli_applyconfig, "Force device to reload it's cnf.xml"),
@@ -3517,6 +4356,18 @@ int sccp_register_cli(void)
 	res |= pbx_manager_register("SCCPShowSessions", _MAN_REP_FLAGS, manager_show_sessions, "show sessions", ami_sessions_usage);
 	res |= pbx_manager_register("SCCPShowMWISubscriptions", _MAN_REP_FLAGS, manager_show_mwi_subscriptions, "show mwi subscriptions", ami_mwi_subscriptions_usage);
 	res |= pbx_manager_register("SCCPShowSoftkeySets", _MAN_REP_FLAGS, manager_show_softkeysets, "show softkey sets", ami_show_softkeysets_usage);
+	res |= pbx_manager_register("SCCPShowReload", _MAN_REP_FLAGS, manager_show_reload, "show last reload result", ami_show_reload_usage);
+	res |= pbx_manager_register("SCCPShowStatsMessages", _MAN_REP_FLAGS, manager_show_stats_messages, "show message statistics", ami_show_stats_messages_usage);
+	res |= pbx_manager_register("SCCPShowStatsCalls", _MAN_REP_FLAGS, manager_show_stats_calls, "show call setup statistics", ami_show_stats_calls_usage);
+	res |= pbx_manager_register("SCCPShowLockStats", _MAN_REP_FLAGS, manager_show_lockstats, "show lock contention statistics", ami_show_lockstats_usage);
+	res |= pbx_manager_register("SCCPShowMetrics", _MAN_REP_FLAGS, manager_show_metrics, "show metrics", ami_show_metrics_usage);
+#ifdef CS_SCCP_MANAGER
+	res |= pbx_manager_register("SCCPShowManagerEvents", _MAN_REP_FLAGS, manager_show_manager_events, "show manager event counters", ami_show_manager_events_usage);
+#endif
+	res |= pbx_manager_register("SCCPCapture", _MAN_REP_FLAGS, manager_capture, "capture device messages", ami_capture_usage);
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_register("SCCPRealtimeInvalidate", _MAN_REP_FLAGS, manager_realtime_invalidate, "drop cached realtime lookups", ami_realtime_invalidate_usage);
+#endif
 	res |= pbx_manager_register("SCCPMessageDevices", _MAN_REP_FLAGS, manager_message_devices, "message devices", ami_message_devices_usage);
 	res |= pbx_manager_register("SCCPMessageDevice", _MAN_REP_FLAGS, manager_message_device, "message device", ami_message_device_usage);
 	res |= pbx_manager_register("SCCPSystemMessage", _MAN_REP_FLAGS, manager_system_message, "system message", ami_system_message_usage);
@@ -3556,6 +4407,18 @@ int sccp_unregister_cli(void)
 	res |= pbx_manager_unregister("SCCPShowSessions");
 	res |= pbx_manager_unregister("SCCPShowMWISubscriptions");
 	res |= pbx_manager_unregister("SCCPShowSoftkeySets");
+	res |= pbx_manager_unregister("SCCPShowReload");
+	res |= pbx_manager_unregister("SCCPShowStatsMessages");
+	res |= pbx_manager_unregister("SCCPShowStatsCalls");
+	res |= pbx_manager_unregister("SCCPShowLockStats");
+	res |= pbx_manager_unregister("SCCPShowMetrics");
+#ifdef CS_SCCP_MANAGER
+	res |= pbx_manager_unregister("SCCPShowManagerEvents");
+#endif
+	res |= pbx_manager_unregister("SCCPCapture");
+#ifdef CS_SCCP_REALTIME
+	res |= pbx_manager_unregister("SCCPRealtimeInvalidate");
+#endif
 	res |= pbx_manager_unregister("SCCPMessageDevices");
 	res |= pbx_manager_unregister("SCCPMessageDevice");
 	res |= pbx_manager_unregister("SCCPSystemMessage");
@@ -3574,4 +4437,200 @@ int sccp_unregister_cli(void)
 	return res;
 }
 
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_cli_json_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "json";
+			info->category = "/channels/chan_sccp/cli/";
+			info->summary = "chan-sccp-b json table writer";
+			info->description = "verify escaping, non numeric conversions and the column filter of the json writer and compare its size and speed to the event per row output";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const int count = 1000;
+	sccp_cli_json_t json;
+	pbx_str_t *events = NULL;
+	struct timeval start;
+	int64_t jsonTime = 0, eventsTime = 0;
+	size_t jsonSize = 0, eventsSize = 0;
+	char name[StationMaxDeviceNameSize];
+	int n = 0;
+
+	memset(&json, 0, sizeof(json));
+	if (!(json.buf = pbx_str_create(SCCP_CLI_JSON_FLUSH + DEFAULT_PBX_STR_BUFFERSIZE))) {
+		return AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Escaping and conversions...\n");
+	sccp_cli_json_startEntry(&json);
+	sccp_cli_json_field(&json, "Name", "s", "%s", "a \"quoted\"\\path\n\x01");
+	sccp_cli_json_field(&json, "Count", "d", "%d", 42);
+	sccp_cli_json_field(&json, "Address", "p", "%p", (void *) 0x10);
+	sccp_cli_json_field(&json, "Ratio", "f", "%.2f", 0.5);
+	sccp_cli_json_field(&json, "Load", "f", "%f", NAN);
+	sccp_cli_json_field(&json, "Peak", "g", "%g", INFINITY);
+	sccp_cli_json_endEntry(&json);
+	pbx_test_status_update(test, "%s\n", pbx_str_buffer(json.buf));
+	if (!sccp_strequals(pbx_str_buffer(json.buf), "{\"Name\":\"a \\\"quoted\\\"\\\\path\\n\\u0001\",\"Count\":42,\"Address\":\"0x10\",\"Ratio\":0.50,\"Load\":null,\"Peak\":null}")) {
+		sccp_free(json.buf);
+		return AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Column filter...\n");
+	pbx_str_reset(json.buf);
+	json.entries = 0;
+	json.included = 0;
+	json.columns = "count, RATIO";
+	for (n = 0; n < 2; n++) {
+		sccp_cli_json_startEntry(&json);
+		sccp_cli_json_field(&json, "Name", "s", "%s", "x");
+		sccp_cli_json_field(&json, "Count", "d", "%d", n);
+		sccp_cli_json_field(&json, "Ratio", "f", "%.1f", 1.0);
+		sccp_cli_json_endEntry(&json);
+	}
+	pbx_test_status_update(test, "%s\n", pbx_str_buffer(json.buf));
+	if (!sccp_strequals(pbx_str_buffer(json.buf), "{\"Count\":0,\"Ratio\":1.0},{\"Count\":1,\"Ratio\":1.0}")) {
+		sccp_free(json.buf);
+		return AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Column filter beyond 64 fields...\n");
+	pbx_str_reset(json.buf);
+	json.entries = 0;
+	json.included = 0;
+	json.columns = "Tail";
+	for (n = 0; n < 2; n++) {
+		int field = 0;
+
+		sccp_cli_json_startEntry(&json);
+		for (field = 0; field < 64; field++) {
+			sccp_cli_json_field(&json, "Pad", "d", "%d", field);
+		}
+		sccp_cli_json_field(&json, "Tail", "d", "%d", n);
+		sccp_cli_json_field(&json, "Other", "d", "%d", n);
+		sccp_cli_json_endEntry(&json);
+	}
+	pbx_test_status_update(test, "%s\n", pbx_str_buffer(json.buf));
+	if (!sccp_strequals(pbx_str_buffer(json.buf), "{\"Tail\":0},{\"Tail\":1}")) {
+		sccp_free(json.buf);
+		return AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Compare %d json entries with %d events...\n", count, count);
+	if (!(events = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE))) {
+		sccp_free(json.buf);
+		return AST_TEST_FAIL;
+	}
+	pbx_str_reset(json.buf);
+	json.entries = 0;
+	json.columns = NULL;
+	start = ast_tvnow();
+	for (n = 0; n < count; n++) {										/* flushing needs a session, keep the whole document */
+		snprintf(name, sizeof(name), "SEP%012X", n);
+		sccp_cli_json_startEntry(&json);
+		sccp_cli_json_field(&json, "Name", "s", "%s", name);
+		sccp_cli_json_field(&json, "Address", "s", "%s", "10.0.0.1:2000");
+		sccp_cli_json_field(&json, "Status", "s", "%s", "OK");
+		sccp_cli_json_field(&json, "Active", "d", "%d", n % 3);
+		pbx_str_append(&json.buf, 0, "}");
+		json.entries++;
+	}
+	jsonTime = ast_tvdiff_us(ast_tvnow(), start);
+	jsonSize = pbx_str_strlen(json.buf);
+	start = ast_tvnow();
+	for (n = 0; n < count; n++) {										/* as written by sccp_cli_table.h */
+		pbx_str_append(&events, 0, "Event: DeviceEntry\r\nChannelType: SCCP\r\nChannelObjectType: Device\r\nActionID: 1\r\n");
+		snprintf(name, sizeof(name), "SEP%012X", n);
+		pbx_str_append(&events, 0, "Name: %s\r\nAddress: %s\r\nStatus: %s\r\nActive: %d\r\n\r\n", name, "10.0.0.1:2000", "OK", n % 3);
+	}
+	eventsTime = ast_tvdiff_us(ast_tvnow(), start);
+	eventsSize = pbx_str_strlen(events);
+	pbx_test_status_update(test, "json: %zu bytes in %" PRId64 "us, events: %zu bytes in %" PRId64 "us\n", jsonSize, jsonTime, eventsSize, eventsTime);
+	sccp_free(events);
+	sccp_free(json.buf);
+	pbx_test_validate(test, jsonSize < eventsSize);
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_cli_window_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "window";
+			info->category = "/channels/chan_sccp/cli/";
+			info->summary = "chan-sccp-b listing filter and pagination";
+			info->description = "verify argument parsing and the filter, offset, limit and counters of the window used by show devices / lines / channels";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	static const char *const names[] = { "SEP0001", "SEP0002", "SEP0003", "ATA0001", "SEP0004" };
+	sccp_cli_window_t window;
+	char filter[16] = "";
+	char offset[16] = "";
+	char limit[16] = "";
+	char *argv[] = { (char *) "sccp", (char *) "show", (char *) "devices", filter, offset, limit };
+	char returned[64] = "";
+	uint idx = 0;
+
+	pbx_test_status_update(test, "argument parsing...\n");
+	sccp_copy_string(filter, "*", sizeof(filter));
+	sccp_copy_string(offset, "1", sizeof(offset));
+	sccp_copy_string(limit, "2", sizeof(limit));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SUCCESS && !window.filter && window.offset == 1 && window.limit == 2);
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 3, argv) == RESULT_SUCCESS && !window.filter && window.offset == 0 && window.limit == 0);
+	sccp_copy_string(offset, "10abc", sizeof(offset));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SHOWUSAGE);
+	sccp_copy_string(offset, "-1", sizeof(offset));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SHOWUSAGE);
+	sccp_copy_string(offset, "99999999999", sizeof(offset));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SHOWUSAGE);
+	sccp_copy_string(offset, "0", sizeof(offset));
+	sccp_copy_string(limit, " 5", sizeof(limit));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SHOWUSAGE);
+
+	pbx_test_status_update(test, "filter, offset and limit...\n");
+	sccp_copy_string(filter, "sep", sizeof(filter));
+	sccp_copy_string(offset, "1", sizeof(offset));
+	sccp_copy_string(limit, "2", sizeof(limit));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SUCCESS && sccp_strequals(window.filter, "sep"));
+	for (idx = 0; idx < ARRAY_LEN(names); idx++) {
+		if (sccp_cli_inWindow(&window, names[idx], NULL, NULL)) {
+			snprintf(returned + strlen(returned), sizeof(returned) - strlen(returned), "%s ", names[idx]);
+		}
+	}
+	pbx_test_status_update(test, "returned: %s\n", returned);
+	pbx_test_validate(test, sccp_strequals(returned, "SEP0002 SEP0003 "));
+	pbx_test_validate(test, window.matched == 4 && window.returned == 2);
+
+	pbx_test_status_update(test, "offset without limit, filter on the other fields...\n");
+	sccp_copy_string(filter, "reception", sizeof(filter));
+	sccp_copy_string(limit, "0", sizeof(limit));
+	pbx_test_validate(test, sccp_cli_parseWindow(&window, 6, argv) == RESULT_SUCCESS);
+	pbx_test_validate(test, !sccp_cli_inWindow(&window, "SEP0001", "Reception", NULL));		/* matches, skipped by the offset */
+	pbx_test_validate(test, !sccp_cli_inWindow(&window, "SEP0002", "Office", "Lobby"));
+	pbx_test_validate(test, sccp_cli_inWindow(&window, "SEP0003", NULL, "Reception Desk"));
+	pbx_test_validate(test, sccp_cli_inWindow(&window, "SEP0004", "reception", NULL));
+	pbx_test_validate(test, window.matched == 3 && window.returned == 2);
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_cli_json_tests);
+	AST_TEST_REGISTER(sccp_cli_window_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_cli_json_tests);
+	AST_TEST_UNREGISTER(sccp_cli_window_tests);
+}
+#endif
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
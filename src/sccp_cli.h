@@ -16,7 +16,22 @@ typedef struct sccp_cli_totals {
 	int lines;
 	int tables;
 } sccp_cli_totals_t;
+#define SCCP_CLI_JSON_FLUSH 8192										/* hand the json buffer to the manager session at this size */
+typedef struct sccp_cli_json {
+	struct mansession *s;
+	pbx_str_t *buf;
+	const char *columns;											/*!< comma separated column filter, NULL for all columns */
+	uint64_t included;											/*!< requested columns by field position, set during the first entry */
+	int field;												/*!< field position inside the current entry */
+	int fields;												/*!< fields written for the current entry */
+	int entries;
+} sccp_cli_json_t;
 SCCP_API int SCCP_CALL sccp_register_cli(void);
 SCCP_API int SCCP_CALL sccp_unregister_cli(void);
+SCCP_API boolean_t SCCP_CALL sccp_cli_json_start(sccp_cli_json_t * json, struct mansession *s, const struct message *m, const char *tablename);
+SCCP_API void SCCP_CALL sccp_cli_json_startEntry(sccp_cli_json_t * json);
+SCCP_API void SCCP_CALL sccp_cli_json_field(sccp_cli_json_t * json, const char *name, const char *conv, const char *fmt, ...) __attribute__ ((format(printf, 4, 5)));
+SCCP_API void SCCP_CALL sccp_cli_json_endEntry(sccp_cli_json_t * json);
+SCCP_API int SCCP_CALL sccp_cli_json_end(sccp_cli_json_t * json);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -44,6 +44,8 @@ int UNIQUE_VAR(table_width_, CLI_AMI_TABLE_NAME) = 0;
 int UNIQUE_VAR(table_entries_, CLI_AMI_TABLE_NAME) = 0;
 const char *UNIQUE_VAR(id, CLI_AMI_TABLE_NAME);
 char UNIQUE_VAR(idtext, CLI_AMI_TABLE_NAME)[256] = "";
+sccp_cli_json_t UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME);
+boolean_t UNIQUE_VAR(isjson_, CLI_AMI_TABLE_NAME) = sccp_cli_json_start(&UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME), s, m, STRINGIFY(CLI_AMI_TABLE_NAME));
 
 #define CLI_AMI_TABLE_FIELD(_a,_b,_c,_d,_e) UNIQUE_VAR(table_width_,CLI_AMI_TABLE_NAME)=UNIQUE_VAR(table_width_,CLI_AMI_TABLE_NAME) + _d+ 1;
 CLI_AMI_TABLE_FIELDS
@@ -63,7 +65,7 @@ pbx_cli(fd, "+ ");
 CLI_AMI_TABLE_FIELDS
 #undef CLI_AMI_TABLE_FIELD
     pbx_cli(fd, "+\n");
-} else {
+} else if (!UNIQUE_VAR(isjson_, CLI_AMI_TABLE_NAME)) {
 	astman_append(s, "Event: TableStart\r\n");
 	local_line_total++;
 	astman_append(s, "TableName: %s\r\n", STRINGIFY(CLI_AMI_TABLE_NAME));
@@ -95,6 +97,22 @@ if (!s) {
 	_CLI_AMI_TABLE_LIST_UNLOCK(CLI_AMI_TABLE_LIST_ITER_HEAD);
 #endif
 #undef CLI_AMI_TABLE_FIELD
+} else if (UNIQUE_VAR(isjson_, CLI_AMI_TABLE_NAME)) {
+#define CLI_AMI_TABLE_FIELD(_a,_b,_c,_d,_e) sccp_cli_json_field(&UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME), #_a, #_c, "%" #_c, _e);
+#ifdef CLI_AMI_TABLE_LIST_ITERATOR
+	_CLI_AMI_TABLE_LIST_LOCK(CLI_AMI_TABLE_LIST_ITER_HEAD);
+	_CLI_AMI_TABLE_LIST_ITERATOR(CLI_AMI_TABLE_LIST_ITER_HEAD, CLI_AMI_TABLE_LIST_ITER_VAR, list) {
+#else
+	CLI_AMI_TABLE_ITERATOR {
+#endif
+		CLI_AMI_TABLE_BEFORE_ITERATION sccp_cli_json_startEntry(&UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME));
+		CLI_AMI_TABLE_FIELDS
+		sccp_cli_json_endEntry(&UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME));
+	CLI_AMI_TABLE_AFTER_ITERATION}
+#ifdef CLI_AMI_TABLE_LIST_ITERATOR
+	_CLI_AMI_TABLE_LIST_UNLOCK(CLI_AMI_TABLE_LIST_ITER_HEAD);
+#endif
+#undef CLI_AMI_TABLE_FIELD
 } else {
 //#define CLI_AMI_TABLE_FIELD(_a,_b,_c,_d,_e) CLI_AMI_OUTPUT_PARAM(#_a, 0, "%" #_c, _e);
 #define CLI_AMI_TABLE_FIELD(_a,_b,_c,_d,_e) AMI_OUTPUT_PARAM(#_a, 0, "%" #_c, _e);
@@ -129,6 +147,9 @@ if (!s) {
 if (!s) {
 	pbx_cli(fd, "+%.*s+\n", UNIQUE_VAR(table_width_, CLI_AMI_TABLE_NAME) + 1, "------------------------------------------------------------------------------------------------------------------------------------------------------------------");
 
+} else if (UNIQUE_VAR(isjson_, CLI_AMI_TABLE_NAME)) {
+	sccp_cli_json_end(&UNIQUE_VAR(json_, CLI_AMI_TABLE_NAME));
+	local_line_total++;
 } else {
 	astman_append(s, "Event: TableEnd\r\n");
 	local_line_total++;
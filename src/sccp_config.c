@@ -36,6 +36,7 @@
  *    .
  *  - calls sccp_config_buildDevice as usual
  *    - calls sccp_config_buildDevice as usual
+ *      - skips devices/lines whose section content hash did not change (reload_incremental=yes, [general] unchanged, no force)
  *      - find device
  *      - or create new device
  *      - parses sccp.conf for device
@@ -49,6 +50,7 @@
  *      - set defaults for line if necessary using the default from globals using the same parameter name
  *      - set pendingUpdate on line for parameters marked with SCCP_CONFIG_NEEDDEVICERESET (remove pendingDelete)
  *      .
+ *    - device and line sections are queued in file order, built in parallel on the general threadpool when there are many, then committed in file order
  *    - calls sccp_config_softKeySet as usual ***
  *      - find softKeySet
  *      - or create new softKeySet
@@ -93,11 +95,18 @@
 #include "sccp_utils.h"
 #include "sccp_devstate.h"
 #include "sccp_labels.h"
+#include "sccp_vector.h"
+#include "sccp_realtime.h"
+#include "sccp_regcontext.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_provision.h"
 #include "revision.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
 #include <asterisk/paths.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #if defined(CS_AST_HAS_EVENT) && defined(HAVE_PBX_EVENT_H) && (defined(CS_DEVICESTATE) || defined(CS_CACHEABLE_DEVICESTATE))	// ast_event_subscribe
 #  include <asterisk/event.h>
 #endif
@@ -117,6 +126,13 @@ SCCP_FILE_VERSION(__FILE__, "");
 #define L_OBJ_REF(x) offsize(struct sccp_line,x), offsetof(struct sccp_line,x)
 #define S_OBJ_REF(x) offsize(struct softKeySetConfiguration,x), offsetof(struct softKeySetConfiguration,x)
 #define H_OBJ_REF(x) offsize(struct sccp_hotline,x), offsetof(struct sccp_hotline,x)
+
+/* warnings raised while building a device / line section are buffered per section and logged when it is committed (see sccp_config_log) */
+static void __attribute__ ((format(printf, 5, 6))) sccp_config_log(int level, const char *file, int line, const char *function, const char *fmt, ...);
+#undef pbx_log
+#define pbx_log sccp_config_log
+
+static sccp_configurationchange_t sccp_config_applyLineSettings(sccp_line_t * l, PBX_VARIABLE_TYPE * v);
 //#define BITMASK(b) (1 << ((b) % CHAR_BIT))
 //#define BITSLOT(b) ((b) / CHAR_BIT)
 //#define BITSET(a, b) ((a)[BITSLOT(b)] |= BITMASK(b))
@@ -244,34 +260,109 @@ static const SCCPConfigSegment *sccp_find_segment(const sccp_config_segment_t se
 }
 
 /*!
- * \brief Find of SCCP Config Options
+ * \brief SCCP Config Option Index Entry
+ *
+ * Every option name is indexed once per alias ("disallow|allow" yields "disallow", "allow" and "disallow|allow"), the name
+ * points into the static option table, so the index never needs to allocate or tokenize while parsing.
  */
-static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+typedef struct SCCPConfigOptionIndex {
+	const char *name;
+	size_t len;
+	const SCCPConfigOption *option;
+} SCCPConfigOptionIndex;
+
+#define SCCP_CONFIG_INDEX_SIZE ((ARRAY_LEN(sccpGlobalConfigOptions) + ARRAY_LEN(sccpDeviceConfigOptions) + ARRAY_LEN(sccpLineConfigOptions) + ARRAY_LEN(sccpSoftKeyConfigOptions)) * 3)
+static SCCPConfigOptionIndex sccpConfigOptionIndex[SCCP_CONFIG_INDEX_SIZE];
+static struct {
+	const SCCPConfigOptionIndex *entries;
+	size_t size;
+} sccpConfigSegmentIndex[ARRAY_LEN(sccpConfigSegments)];
+
+static int sccp_config_index_compare(const void *a, const void *b)
+{
+	const SCCPConfigOptionIndex *ia = (const SCCPConfigOptionIndex *) a;
+	const SCCPConfigOptionIndex *ib = (const SCCPConfigOptionIndex *) b;
+	int res = strncasecmp(ia->name, ib->name, ia->len < ib->len ? ia->len : ib->len);
+
+	if (!res && ia->len != ib->len) {
+		res = ia->len < ib->len ? -1 : 1;
+	}
+	if (!res && ia->option != ib->option) {							/* keep table order for duplicate names, first entry wins */
+		res = ia->option < ib->option ? -1 : 1;
+	}
+	return res;
+}
+
+/*!
+ * \brief Build the sorted (alias expanded) option name index for every config segment
+ * \note runs once at module load, the option tables are static so the index never changes afterwards
+ */
+static void __attribute__((constructor)) sccp_config_buildOptionIndex(void)
 {
+	uint8_t segment = 0;
 	long unsigned int i = 0;
-	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
-	const SCCPConfigOption *config = sccpConfigSegment->config;
+	size_t used = 0;
 
-	char delims[] = "|";
-	char *token = NULL;
-	char *config_name = NULL;
+	for (segment = 0; segment < ARRAY_LEN(sccpConfigSegments); segment++) {
+		const SCCPConfigOption *config = sccpConfigSegments[segment].config;
+		SCCPConfigOptionIndex *entries = &sccpConfigOptionIndex[used];
+		size_t size = 0;
 
-	for (i = 0; i < sccpConfigSegment->config_size; i++) {
-		if (strstr(config[i].name, delims) != NULL) {
-			config_name = pbx_strdupa(config[i].name);
-			token = strtok(config_name, delims);
-			while (token != NULL) {
-				if (!strcasecmp(token, name)) {
-					return &config[i];
-				}
-				token = strtok(NULL, delims);
+		for (i = 0; i < sccpConfigSegments[segment].config_size && used + size < SCCP_CONFIG_INDEX_SIZE; i++) {
+			const char *name = config[i].name;
+			const char *delim = NULL;
+
+			entries[size++] = (SCCPConfigOptionIndex) {name, strlen(name), &config[i]};
+			if (!strchr(name, '|')) {
+				continue;
+			}
+			while ((delim = strchr(name, '|')) && used + size < SCCP_CONFIG_INDEX_SIZE) {
+				entries[size++] = (SCCPConfigOptionIndex) {name, delim - name, &config[i]};
+				name = delim + 1;
+			}
+			if (used + size < SCCP_CONFIG_INDEX_SIZE) {
+				entries[size++] = (SCCPConfigOptionIndex) {name, strlen(name), &config[i]};
 			}
 		}
-		if (!strcasecmp(config[i].name, name)) {
-			return &config[i];
-		}
+		qsort(entries, size, sizeof(SCCPConfigOptionIndex), sccp_config_index_compare);
+		sccpConfigSegmentIndex[segment].entries = entries;
+		sccpConfigSegmentIndex[segment].size = size;
+		used += size;
 	}
+}
+
+/*!
+ * \brief Find of SCCP Config Options
+ */
+static const SCCPConfigOption *sccp_find_config(const sccp_config_segment_t segment, const char *name)
+{
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigOptionIndex *entries = NULL;
+	size_t low = 0, high = 0, mid = 0;
+	int res = 0;
 
+	if (!sccpConfigSegment || !name) {
+		return NULL;
+	}
+	entries = sccpConfigSegmentIndex[sccpConfigSegment - sccpConfigSegments].entries;
+	high = sccpConfigSegmentIndex[sccpConfigSegment - sccpConfigSegments].size;
+
+	/* lower bound binary search, so that the first of any duplicate names is returned */
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		res = strncasecmp(entries[mid].name, name, entries[mid].len);
+		if (!res && name[entries[mid].len] != '\0') {
+			res = -1;									/* entry is a prefix of name, so it sorts before name */
+		}
+		if (res < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (low < sccpConfigSegmentIndex[sccpConfigSegment - sccpConfigSegments].size && !strncasecmp(entries[low].name, name, entries[low].len) && name[entries[low].len] == '\0') {
+		return entries[low].option;
+	}
 	return NULL;
 }
 
@@ -283,9 +374,10 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 	char delims[] = "|";
 	char option_name[strlen(configOptionName) + 2];
 	char *token = NULL;
+	char *saveptr = NULL;
 	
 	snprintf(option_name, sizeof(option_name), "%s%s", configOptionName, delims);
-	token = strtok(option_name, delims);
+	token = strtok_r(option_name, delims, &saveptr);
 	while (token != NULL) {
 		sccp_log_and((DEBUGCAT_CONFIG + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_4 "Token %s/%s\n", option_name, token);
 		for (v = cat_root; v; v = v->next) {
@@ -308,7 +400,7 @@ static PBX_VARIABLE_TYPE *createVariableSetForMultiEntryParameters(PBX_VARIABLE_
 				}
 			}
 		}
-		token = strtok(NULL, delims);
+		token = strtok_r(NULL, delims, &saveptr);
 	}
 EXIT:
 	return out;
@@ -2158,7 +2250,7 @@ sccp_value_changed_t sccp_config_addButton(sccp_buttonconfig_list_t *buttonconfi
  */
 static void sccp_config_buildLine(sccp_line_t * l, PBX_VARIABLE_TYPE * v, const char *lineName, boolean_t isRealtime)
 {
-	sccp_configurationchange_t res = sccp_config_applyLineConfiguration(l, v);
+	sccp_configurationchange_t res = sccp_config_applyLineSettings(l, v);				/* the id of a line without one is assigned on commit */
 
 #ifdef CS_SCCP_REALTIME
 	l->realtime = isRealtime;
@@ -2287,6 +2379,498 @@ static void sccp_config_add_default_softkeyset(void)
 	pbx_variables_destroy(softkeyset_root);
 }
 
+/* ======================================================================================================== Incremental Reload */
+/*!
+ * \brief Kind of change a reload made to a device or line
+ */
+typedef enum {
+	SCCP_CONFIG_RELOAD_ADDED,
+	SCCP_CONFIG_RELOAD_REMOVED,
+	SCCP_CONFIG_RELOAD_MODIFIED,
+	SCCP_CONFIG_RELOAD_UNCHANGED,										/* only counted, not kept in the change set */
+} sccp_config_reloadchange_t;
+
+static const char *const sccp_config_reloadchange_str[] = {"Added", "Removed", "Modified", "Unchanged"};
+
+/*!
+ * \brief Change Set Entry, one per added, removed or modified device/line
+ */
+typedef struct sccp_config_reloadchange_entry {
+	char name[StationMaxNameSize];
+	sccp_config_segment_t segment;
+	sccp_config_reloadchange_t change;
+} sccp_config_reloadchange_entry_t;
+
+/*!
+ * \brief Report of the last reload, protected by sccp_config_reloadReportLock
+ */
+static struct {
+	boolean_t valid;
+	boolean_t incremental;
+	boolean_t generalChanged;
+	time_t started;
+	int64_t duration;											/* ms */
+	uint32_t counts[SCCP_CONFIG_SOFTKEY_SEGMENT + 1][SCCP_CONFIG_RELOAD_UNCHANGED + 1];
+	sccp_regcontext_summary_t regcontext;
+	SCCP_VECTOR(, sccp_config_reloadchange_entry_t) changes;
+} sccp_config_reloadReport;
+AST_MUTEX_DEFINE_STATIC(sccp_config_reloadReportLock);
+
+static uint64_t sccp_config_generalHash;									/* content hash of the [general] section at the last (re)load */
+static boolean_t sccp_config_generalChanged;									/* [general] changed during the current reload */
+static boolean_t sccp_config_reloadForced;									/* the current config was loaded using force */
+
+#define SCCP_CONFIG_HASH_OFFSET 14695981039346656037ULL
+#define SCCP_CONFIG_HASH_PRIME 1099511628211ULL
+
+static uint64_t sccp_config_hashString(uint64_t hash, const char *str, const char terminator)
+{
+	const unsigned char *c = (const unsigned char *) str;
+
+	for (; c && *c; c++) {
+		hash = (hash ^ *c) * SCCP_CONFIG_HASH_PRIME;
+	}
+	return (hash ^ (unsigned char) terminator) * SCCP_CONFIG_HASH_PRIME;
+}
+
+/*!
+ * \brief Content hash (FNV-1a) over all name/value pairs of a category, in file order
+ * \note templates have already been merged into the variable list by the pbx config parser, so template changes are covered as well
+ */
+static uint64_t sccp_config_hashCategory(PBX_VARIABLE_TYPE * v)
+{
+	uint64_t hash = SCCP_CONFIG_HASH_OFFSET;
+
+	for (; v; v = v->next) {
+		hash = sccp_config_hashString(hash, v->name, '=');
+		hash = sccp_config_hashString(hash, v->value, '\n');
+	}
+	return hash;
+}
+
+static void sccp_config_reloadReportBegin(boolean_t incremental)
+{
+	pbx_mutex_lock(&sccp_config_reloadReportLock);
+	if (!sccp_config_reloadReport.changes.elems) {
+		SCCP_VECTOR_INIT(&sccp_config_reloadReport.changes, 32);
+	}
+	SCCP_VECTOR_RESET(&sccp_config_reloadReport.changes, SCCP_VECTOR_ELEM_CLEANUP_NOOP);
+	memset(sccp_config_reloadReport.counts, 0, sizeof(sccp_config_reloadReport.counts));
+	memset(&sccp_config_reloadReport.regcontext, 0, sizeof(sccp_config_reloadReport.regcontext));
+	sccp_config_reloadReport.valid = FALSE;
+	sccp_config_reloadReport.incremental = incremental;
+	sccp_config_reloadReport.generalChanged = sccp_config_generalChanged;
+	sccp_config_reloadReport.started = time(NULL);
+	sccp_config_reloadReport.duration = 0;
+	pbx_mutex_unlock(&sccp_config_reloadReportLock);
+}
+
+static void sccp_config_reloadReportAdd(const sccp_config_segment_t segment, const char *name, const sccp_config_reloadchange_t change)
+{
+	pbx_mutex_lock(&sccp_config_reloadReportLock);
+	sccp_config_reloadReport.counts[segment][change]++;
+	if (change != SCCP_CONFIG_RELOAD_UNCHANGED) {
+		sccp_config_reloadchange_entry_t entry = {.segment = segment, .change = change };
+
+		sccp_copy_string(entry.name, name, sizeof(entry.name));
+		if (SCCP_VECTOR_APPEND(&sccp_config_reloadReport.changes, entry)) {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		}
+	}
+	pbx_mutex_unlock(&sccp_config_reloadReportLock);
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: %s %s during reload\n", name, sccp_find_segment(segment)->name, sccp_config_reloadchange_str[change]);
+}
+
+static void sccp_config_reloadReportEnd(const struct timeval start, const sccp_regcontext_summary_t * regcontext)
+{
+	pbx_mutex_lock(&sccp_config_reloadReportLock);
+	sccp_config_reloadReport.duration = ast_tvdiff_ms(pbx_tvnow(), start);
+	sccp_config_reloadReport.regcontext = *regcontext;
+	sccp_config_reloadReport.valid = TRUE;
+	pbx_log(LOG_NOTICE, "SCCP: %s reload took %" PRId64 "ms, devices: %d added, %d removed, %d modified, %d unchanged, lines: %d added, %d removed, %d modified, %d unchanged, regcontext: %d added, %d removed\n",
+		sccp_config_reloadReport.incremental ? "Incremental" : "Full", sccp_config_reloadReport.duration,
+		sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_ADDED], sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_REMOVED],
+		sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_MODIFIED], sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_UNCHANGED],
+		sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_ADDED], sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_REMOVED],
+		sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_MODIFIED], sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_UNCHANGED],
+		regcontext->added, regcontext->removed);
+	pbx_mutex_unlock(&sccp_config_reloadReportLock);
+}
+
+/*!
+ * \brief Free the change set of the last reload (module unload)
+ */
+void sccp_config_cleanupReloadReport(void)
+{
+	pbx_mutex_lock(&sccp_config_reloadReportLock);
+	SCCP_VECTOR_FREE(&sccp_config_reloadReport.changes);
+	sccp_config_reloadReport.valid = FALSE;
+	pbx_mutex_unlock(&sccp_config_reloadReportLock);
+}
+
+/*!
+ * \brief Undo the pre_reload markings on a device whose section did not change, so that it is neither touched nor restarted
+ */
+static void sccp_config_keepDevice(sccp_device_t * d)
+{
+	sccp_buttonconfig_t *config = NULL;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		config->pendingDelete = 0;
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+	d->pendingUpdate = 0;
+	d->pendingDelete = 0;
+}
+
+/*!
+ * \brief Undo the pre_reload markings on a line whose section did not change
+ */
+static void sccp_config_keepLine(sccp_line_t * l)
+{
+	l->pendingUpdate = 0;
+	l->pendingDelete = 0;
+}
+
+/*!
+ * \brief Staged device / line build
+ *
+ * sccp_config_readDevicesLines scans sccp.conf in file order and queues a build job per device / line section. The build
+ * only touches the job's own object and reads GLOB(cfg), so large configurations are built in chunks on the general
+ * threadpool. Afterwards the jobs are committed in file order, so ids, logging and astdb restore stay identical to a
+ * sequential load.
+ */
+#define SCCP_CONFIG_BUILD_PARALLEL_MIN 64									/* below this number of sections, build sequentially */
+#define SCCP_CONFIG_BUILD_CHUNKS_PER_THREAD 4
+
+typedef struct sccp_config_diagnostic sccp_config_diagnostic_t;
+
+typedef struct sccp_config_buildjob {
+	sccp_config_segment_t segment;
+	const char *name;
+	PBX_VARIABLE_TYPE *v;
+	uint64_t hash;
+	int count;												/* device / line counter, for logging */
+	boolean_t created;											/* line is new and still has to be added to GLOB(lines) */
+	boolean_t autoId;											/* line section without an id, number it on commit */
+	sccp_nat_t nat;												/* nat status saved from the previous load */
+	sccp_device_t *device;
+	sccp_line_t *line;
+	sccp_config_diagnostic_t *diagnostics;									/* warnings raised during the build, logged on commit */
+} sccp_config_buildjob_t;
+
+SCCP_VECTOR(sccp_config_buildjobs, sccp_config_buildjob_t);
+
+/*!
+ * \brief Diagnostics of a device / line section logged during its build
+ *
+ * Sections are built concurrently, so their warnings would interleave. Instead they are kept with the job and logged when
+ * the job is committed, in file order, exactly like a sequential load would have logged them.
+ */
+struct sccp_config_diagnostic {
+	sccp_config_diagnostic_t *next;
+	int level;
+	const char *file;
+	int line;
+	const char *function;
+	char message[];
+};
+
+static pthread_key_t sccp_config_diagnostics_key;
+static pthread_once_t sccp_config_diagnostics_once = PTHREAD_ONCE_INIT;
+
+static void sccp_config_diagnostics_init(void)
+{
+	pthread_key_create(&sccp_config_diagnostics_key, NULL);
+}
+
+/* start (slot != NULL) or stop buffering the diagnostics of the calling thread, slot is where the next diagnostic is linked */
+static void sccp_config_captureDiagnostics(sccp_config_diagnostic_t ** slot)
+{
+	pthread_once(&sccp_config_diagnostics_once, sccp_config_diagnostics_init);
+	pthread_setspecific(sccp_config_diagnostics_key, slot);
+}
+
+/*!
+ * \brief pbx_log replacement for this file, buffers the message while the calling thread captures diagnostics
+ */
+static void sccp_config_log(int level, const char *file, int line, const char *function, const char *fmt, ...)
+{
+	sccp_config_diagnostic_t **slot = NULL;
+	sccp_config_diagnostic_t *diagnostic = NULL;
+	char message[1024];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(message, sizeof(message), fmt, ap);
+	va_end(ap);
+
+	pthread_once(&sccp_config_diagnostics_once, sccp_config_diagnostics_init);
+	if ((slot = pthread_getspecific(sccp_config_diagnostics_key)) && (diagnostic = sccp_calloc(1, sizeof *diagnostic + strlen(message) + 1))) {
+		diagnostic->level = level;
+		diagnostic->file = file;
+		diagnostic->line = line;
+		diagnostic->function = function;
+		strcpy(diagnostic->message, message);
+		*slot = diagnostic;
+		pthread_setspecific(sccp_config_diagnostics_key, &diagnostic->next);
+		return;
+	}
+	ast_log(level, file, line, function, "%s", message);
+}
+
+static void sccp_config_flushDiagnostics(sccp_config_diagnostic_t ** diagnostics)
+{
+	sccp_config_diagnostic_t *diagnostic = NULL;
+
+	while ((diagnostic = *diagnostics)) {
+		*diagnostics = diagnostic->next;
+		ast_log(diagnostic->level, diagnostic->file, diagnostic->line, diagnostic->function, "%s", diagnostic->message);
+		sccp_free(diagnostic);
+	}
+}
+
+typedef struct sccp_config_buildbatch {
+	sccp_mutex_t lock;
+	pbx_cond_t done;
+	sccp_config_buildjob_t *jobs;
+	size_t count;
+	size_t chunksize;
+	size_t next;												/* first job not claimed yet */
+	size_t built;
+	int users;												/* caller + scheduled workers, the last one frees the batch */
+} sccp_config_buildbatch_t;
+
+static void sccp_config_buildJob(sccp_config_buildjob_t * job)
+{
+	sccp_config_captureDiagnostics(&job->diagnostics);
+	if (job->segment == SCCP_CONFIG_DEVICE_SEGMENT) {
+		sccp_config_buildDevice(job->device, job->v, job->name, FALSE);
+	} else {
+		sccp_config_buildLine(job->line, job->v, job->name, FALSE);
+	}
+	sccp_config_captureDiagnostics(NULL);
+}
+
+/* number a line without an id, only called by the config thread (commit / realtime), never from a build worker, so numbering follows the file order */
+static void sccp_config_assignLineId(sccp_line_t * line)
+{
+	snprintf(line->id, sizeof(line->id), "%04d", SCCP_LIST_GETSIZE(&GLOB(lines)));
+}
+
+/*!
+ * \brief Finish a built job in file order: everything that depends on other objects, astdb or the global lists happens here
+ * \param job Build Job
+ * \param duplicates the config contains duplicate section names, new lines have to be checked against GLOB(lines) again
+ */
+static void sccp_config_commitJob(sccp_config_buildjob_t * job, boolean_t duplicates)
+{
+	sccp_config_flushDiagnostics(&job->diagnostics);
+	if (job->segment == SCCP_CONFIG_DEVICE_SEGMENT) {
+		sccp_device_t *device = job->device;
+
+		device->configHash = job->hash;
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found device %d: %s\n", job->count, job->name);
+		/* load saved settings from ast db */
+		sccp_config_restoreDeviceFeatureStatus(device);
+
+		/* restore current nat status, if device does not get restarted */
+		if (0 == device->pendingDelete && sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE) {
+			if (SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == job->nat || SCCP_NAT_AUTO_OFF == job->nat || SCCP_NAT_AUTO_ON == job->nat)) {
+				device->nat = job->nat;
+			}
+		}
+		sccp_device_release(&job->device);						/* explicit release */
+	} else {
+		sccp_line_t *line = job->line;
+
+		if (job->created) {
+			AUTO_RELEASE(sccp_line_t, existing, duplicates ? sccp_line_find_byname(job->name, FALSE) : NULL);
+
+			if (existing) {
+				/* an earlier section with the same name created this line already, apply this one on top, like a sequential load would */
+				sccp_config_buildLine(existing, job->v, job->name, FALSE);
+				if (sccp_strlen_zero(existing->id)) {
+					sccp_config_assignLineId(existing);
+				}
+				existing->configHash = job->hash;
+				sccp_line_release(&job->line);						/* explicit release, drops the unused line */
+				return;
+			}
+			if (job->autoId || sccp_strlen_zero(line->id)) {
+				sccp_config_assignLineId(line);
+			}
+			line->configHash = job->hash;
+			sccp_line_addToGlobals(line);						/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when l is released */
+		} else {
+			if (sccp_strlen_zero(line->id)) {
+				sccp_config_assignLineId(line);
+			}
+			line->configHash = job->hash;
+		}
+		sccp_line_release(&job->line);							/* explicit release */
+	}
+}
+
+/*!
+ * \brief Claim and build the next chunk of jobs
+ * \return FALSE when there was nothing left to claim
+ */
+static boolean_t sccp_config_buildNextChunk(sccp_config_buildbatch_t * batch)
+{
+	size_t first, last, cur;
+
+	sccp_mutex_lock(&batch->lock);
+	first = batch->next;
+	last = (first + batch->chunksize < batch->count) ? first + batch->chunksize : batch->count;
+	batch->next = last;
+	sccp_mutex_unlock(&batch->lock);
+
+	if (first >= last) {
+		return FALSE;
+	}
+	for (cur = first; cur < last; cur++) {
+		sccp_config_buildJob(&batch->jobs[cur]);
+	}
+
+	sccp_mutex_lock(&batch->lock);
+	batch->built += last - first;
+	if (batch->built == batch->count) {
+		pbx_cond_signal(&batch->done);
+	}
+	sccp_mutex_unlock(&batch->lock);
+	return TRUE;
+}
+
+static void sccp_config_releaseBatch(sccp_config_buildbatch_t * batch)
+{
+	int users;
+
+	sccp_mutex_lock(&batch->lock);
+	users = --batch->users;
+	sccp_mutex_unlock(&batch->lock);
+	if (!users) {
+		pbx_cond_destroy(&batch->done);
+		sccp_mutex_destroy(&batch->lock);
+		sccp_free(batch);
+	}
+}
+
+static void *sccp_config_buildWorker(void *data)
+{
+	sccp_config_buildbatch_t *batch = (sccp_config_buildbatch_t *) data;
+
+	while (sccp_config_buildNextChunk(batch)) {
+		/* keep claiming chunks */
+	}
+	sccp_config_releaseBatch(batch);
+	return NULL;
+}
+
+/*!
+ * \brief Build all queued jobs, in parallel on the general threadpool if there are enough of them
+ * \note the calling thread builds chunks as well and only waits for chunks already claimed by a worker, so a busy threadpool can not stall the load
+ */
+static void sccp_config_buildJobs(struct sccp_config_buildjobs *jobs, boolean_t parallel)
+{
+	size_t count = SCCP_VECTOR_SIZE(jobs);
+	size_t cur = 0;
+	int threads = GLOB(general_threadpool) ? sccp_threadpool_thread_count(GLOB(general_threadpool)) : 0;
+	int worker = 0;
+	sccp_config_buildbatch_t *batch = NULL;
+
+	if (!parallel || threads < 1 || count < SCCP_CONFIG_BUILD_PARALLEL_MIN || !(batch = sccp_calloc(1, sizeof *batch))) {
+		for (cur = 0; cur < count; cur++) {
+			sccp_config_buildJob(SCCP_VECTOR_GET_ADDR(jobs, cur));
+		}
+		return;
+	}
+	sccp_mutex_init(&batch->lock);
+	pbx_cond_init(&batch->done, NULL);
+	batch->jobs = jobs->elems;
+	batch->count = count;
+	batch->chunksize = count / ((threads + 1) * SCCP_CONFIG_BUILD_CHUNKS_PER_THREAD) + 1;
+	batch->users = 1;
+
+	for (worker = 0; worker < threads; worker++) {
+		sccp_mutex_lock(&batch->lock);
+		batch->users++;
+		sccp_mutex_unlock(&batch->lock);
+		if (!sccp_threadpool_add_work(GLOB(general_threadpool), sccp_config_buildWorker, batch)) {
+			sccp_config_releaseBatch(batch);
+			break;
+		}
+	}
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: (sccp_config_buildJobs) building %d sections using %d worker(s)\n", (int) count, worker);
+
+	while (sccp_config_buildNextChunk(batch)) {
+		/* help out until all chunks are claimed */
+	}
+	sccp_mutex_lock(&batch->lock);
+	while (batch->built < batch->count) {
+		pbx_cond_wait(&batch->done, &batch->lock);
+	}
+	sccp_mutex_unlock(&batch->lock);
+	sccp_config_releaseBatch(batch);
+}
+
+static int sccp_config_buildjob_compare(const void *a, const void *b)
+{
+	const sccp_config_buildjob_t *job_a = (const sccp_config_buildjob_t *) a;
+	const sccp_config_buildjob_t *job_b = (const sccp_config_buildjob_t *) b;
+
+	if (job_a->segment != job_b->segment) {
+		return job_a->segment < job_b->segment ? -1 : 1;
+	}
+	return strcasecmp(job_a->name, job_b->name);
+}
+
+/*!
+ * \brief Check that no device / line is queued twice (duplicate section names), those have to be built in file order
+ */
+static boolean_t sccp_config_buildJobsAreUnique(struct sccp_config_buildjobs *jobs)
+{
+	size_t count = SCCP_VECTOR_SIZE(jobs);
+	size_t cur = 0;
+	boolean_t unique = TRUE;
+	sccp_config_buildjob_t *sorted = NULL;
+
+	if (count < 2) {
+		return TRUE;
+	}
+	if (!(sorted = sccp_malloc(count * sizeof *sorted))) {
+		return FALSE;
+	}
+	memcpy(sorted, jobs->elems, count * sizeof *sorted);
+	qsort(sorted, count, sizeof *sorted, sccp_config_buildjob_compare);
+	for (cur = 1; cur < count && unique; cur++) {
+		if (!sccp_config_buildjob_compare(&sorted[cur - 1], &sorted[cur])) {
+			unique = FALSE;
+		}
+	}
+	sccp_free(sorted);
+	return unique;
+}
+
+/*!
+ * \brief Build and commit the queued jobs, releasing them
+ */
+static void sccp_config_runBuildJobs(struct sccp_config_buildjobs *jobs)
+{
+	size_t cur = 0;
+	boolean_t unique = sccp_config_buildJobsAreUnique(jobs);
+
+	if (!unique) {
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: (sccp_config_runBuildJobs) duplicate sections found, building sequentially\n");
+	}
+	sccp_config_buildJobs(jobs, unique);
+	for (cur = 0; cur < SCCP_VECTOR_SIZE(jobs); cur++) {
+		sccp_config_commitJob(SCCP_VECTOR_GET_ADDR(jobs, cur), !unique);
+	}
+	SCCP_VECTOR_RESET(jobs, SCCP_VECTOR_ELEM_CLEANUP_NOOP);
+}
+
 /*!
  * \brief Parse sccp.conf and Create General Configuration
  * \param readingtype SCCP Reading Type
@@ -2312,6 +2896,11 @@ boolean_t sccp_config_general(sccp_readingtype_t readingtype)
 	}
 	// sccp_config_set_defaults(sccp_globals, SCCP_CONFIG_GLOBAL_SEGMENT);
 
+	/* devices and lines inherit their defaults from [general], when it changes they all have to be re-applied */
+	uint64_t hash = sccp_config_hashCategory(v);
+	sccp_config_generalChanged = (readingtype == SCCP_CONFIG_READRELOAD && hash != sccp_config_generalHash);
+	sccp_config_generalHash = hash;
+
 	/* setup bindaddress */
 	if (!sccp_netsock_getPort(&GLOB(bindaddr))) {
 		struct sockaddr_in *in = (struct sockaddr_in *) &GLOB(bindaddr);
@@ -2358,6 +2947,7 @@ boolean_t sccp_config_general(sccp_readingtype_t readingtype)
 	if (GLOB(externhost)) {
 		sccp_netsock_flush_externhost();
 	}
+	sccp_log_async_configure(GLOB(debug_async), GLOB(debug_async_memory));
 	
 	return TRUE;
 }
@@ -2412,6 +3002,9 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 	uint8_t device_count = 0;
 	uint8_t line_count = 0;
 	sccp_device_t *d = NULL;
+	uint64_t hash = 0;
+	struct timeval start = pbx_tvnow();
+	boolean_t incremental = (readingtype == SCCP_CONFIG_READRELOAD && GLOB(reload_incremental) && !sccp_config_reloadForced && !sccp_config_generalChanged);
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Loading Devices and Lines from config\n");
 
@@ -2423,6 +3016,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		sccp_line_pre_reload();
 		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Softkey Pre Reload\n");
 		sccp_softkey_pre_reload();
+		sccp_config_reloadReportBegin(incremental);
 	}
 
 	if (!GLOB(cfg)) {
@@ -2430,6 +3024,12 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		return FALSE;
 	}
 
+	struct sccp_config_buildjobs jobs;
+	if (SCCP_VECTOR_INIT(&jobs, 64) != 0) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return FALSE;
+	}
+
 	while ((cat = pbx_category_browse(GLOB(cfg), cat))) {
 
 		const char *utype;
@@ -2451,36 +3051,46 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 				continue;
 			} else {
 				v = ast_variable_browse(GLOB(cfg), cat);
+				hash = sccp_config_hashCategory(v);
 
 				// Try to find out if we have the device already on file.
 				// However, do not look into realtime, since
 				// we might have been asked to create a device for realtime addition,
 				// thus causing an infinite loop / recursion.
 				AUTO_RELEASE(sccp_device_t, device, sccp_device_find_byid(cat, FALSE));
-				sccp_nat_t nat = SCCP_NAT_AUTO;
+				sccp_config_buildjob_t job = {.segment = SCCP_CONFIG_DEVICE_SEGMENT, .name = cat, .v = v, .hash = hash, .nat = SCCP_NAT_AUTO };
 
 				/* create new device with default values */
 				if (!device) {
-					device = sccp_device_create(cat);
+					if (!(device = sccp_device_create(cat))) {
+						continue;
+					}
 					// sccp_copy_string(d->id, cat, sizeof(d->id));         /* set device name */
 					sccp_device_addToGlobals(device);
 					device_count++;
+					if (readingtype == SCCP_CONFIG_READRELOAD) {
+						sccp_config_reloadReportAdd(SCCP_CONFIG_DEVICE_SEGMENT, cat, SCCP_CONFIG_RELOAD_ADDED);
+					}
 				} else {
+					if (incremental && device->configHash == hash) {
+						sccp_config_keepDevice(device);
+						sccp_config_reloadReportAdd(SCCP_CONFIG_DEVICE_SEGMENT, cat, SCCP_CONFIG_RELOAD_UNCHANGED);
+						continue;
+					}
+					if (readingtype == SCCP_CONFIG_READRELOAD) {
+						sccp_config_reloadReportAdd(SCCP_CONFIG_DEVICE_SEGMENT, cat, device->configHash == hash ? SCCP_CONFIG_RELOAD_UNCHANGED : SCCP_CONFIG_RELOAD_MODIFIED);
+					}
 					if (device->pendingDelete) {
-						nat = device->nat;
+						job.nat = device->nat;
 						device->pendingDelete = 0;
 					}
 				}
-				sccp_config_buildDevice(device, v, cat, FALSE);
-				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found device %d: %s\n", device_count, cat);
-				/* load saved settings from ast db */
-				sccp_config_restoreDeviceFeatureStatus(device);
-				
-				/* restore current nat status, if device does not get restarted */
-				if (0 == device->pendingDelete && sccp_device_getRegistrationState(device) != SKINNY_DEVICE_RS_NONE) {
-					if (SCCP_NAT_AUTO == device->nat && (SCCP_NAT_AUTO == nat || SCCP_NAT_AUTO_OFF == nat || SCCP_NAT_AUTO_ON == nat)) {
-						device->nat = nat;
-					}
+				job.count = device_count;
+				job.device = sccp_device_retain(device);
+				if (SCCP_VECTOR_APPEND(&jobs, job)) {
+					pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, cat);
+					sccp_config_buildJob(&job);
+					sccp_config_commitJob(&job, TRUE);
 				}
 			}
 		} else if (!strcasecmp(utype, "line")) {
@@ -2494,18 +3104,37 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			line_count++;
 
 			v = ast_variable_browse(GLOB(cfg), cat);
+			hash = sccp_config_hashCategory(v);
 			AUTO_RELEASE(sccp_line_t, l , sccp_line_find_byname(cat, FALSE));
 
+			sccp_config_buildjob_t job = {.segment = SCCP_CONFIG_LINE_SEGMENT, .name = cat, .v = v, .hash = hash, .count = line_count };
+
 			/* check if we have this line already */
-			//    SCCP_RWLIST_WRLOCK(&GLOB(lines));
-			if (l) {
+			if (l && incremental && l->configHash == hash) {
+				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found line %d: %s, unchanged\n", line_count, cat);
+				sccp_config_keepLine(l);
+				sccp_config_reloadReportAdd(SCCP_CONFIG_LINE_SEGMENT, cat, SCCP_CONFIG_RELOAD_UNCHANGED);
+				continue;
+			} else if (l) {
 				sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "found line %d: %s, do update\n", line_count, cat);
-				sccp_config_buildLine(l, v, cat, FALSE);
+				if (readingtype == SCCP_CONFIG_READRELOAD) {
+					sccp_config_reloadReportAdd(SCCP_CONFIG_LINE_SEGMENT, cat, l->configHash == hash ? SCCP_CONFIG_RELOAD_UNCHANGED : SCCP_CONFIG_RELOAD_MODIFIED);
+				}
 			} else if ((l = sccp_line_create(cat))) {
-				sccp_config_buildLine(l, v, cat, FALSE);
-				sccp_line_addToGlobals(l);						/* may find another line instance create by another thread, in that case the newly created line is going to be dropped when l is released */
+				if (readingtype == SCCP_CONFIG_READRELOAD) {
+					sccp_config_reloadReportAdd(SCCP_CONFIG_LINE_SEGMENT, cat, SCCP_CONFIG_RELOAD_ADDED);
+				}
+				job.created = TRUE;
+				job.autoId = sccp_strlen_zero(pbx_variable_retrieve(GLOB(cfg), cat, "id"));
+			} else {
+				continue;
+			}
+			job.line = sccp_line_retain(l);
+			if (SCCP_VECTOR_APPEND(&jobs, job)) {
+				pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, cat);
+				sccp_config_buildJob(&job);
+				sccp_config_commitJob(&job, TRUE);
 			}
-			//    SCCP_RWLIST_UNLOCK(&GLOB(lines));
 
 		} else if (!strcasecmp(utype, "softkeyset")) {
 			sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "parsing softkey [%s]\n", cat);
@@ -2519,9 +3148,19 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			pbx_log(LOG_WARNING, "SCCP: (sccp_config_readDevicesLines) UNKNOWN SECTION / UTYPE, type: %s\n", utype);
 		}
 	}
+	sccp_config_runBuildJobs(&jobs);
+	SCCP_VECTOR_FREE(&jobs);
 	sccp_config_add_default_softkeyset();
 
 #ifdef CS_SCCP_REALTIME
+	if (readingtype == SCCP_CONFIG_READRELOAD) {
+		sccp_realtime_invalidate(NULL, NULL);								/* the realtime tables may have changed as well */
+	}
+	if (GLOB(realtime_cache_prefetch)) {
+		sccp_realtime_prefetch(GLOB(realtimedevicetable));
+		sccp_realtime_prefetch(GLOB(realtimelinetable));
+	}
+
 	/* reload realtime lines */
 	sccp_configurationchange_t res = SCCP_CONFIG_NOUPDATENEEDED;
 	PBX_VARIABLE_TYPE *rv = NULL;
@@ -2534,7 +3173,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			do {
 				if (line->realtime == TRUE && line != GLOB(hotline)->line) {
 					sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: reload realtime line\n", line->name);
-					rv = pbx_load_realtime(GLOB(realtimelinetable), "name", line->name, NULL);
+					rv = sccp_realtime_load(GLOB(realtimelinetable), line->name);
 					/* we did not find this line, mark it for deletion */
 					if (!rv) {
 						sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: realtime line not found - set pendingDelete=1\n", line->name);
@@ -2565,7 +3204,7 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 			do {
 				if (device->realtime == TRUE) {
 					sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: reload realtime line\n", device->id);
-					rv = pbx_load_realtime(GLOB(realtimedevicetable), "name", device->id, NULL);
+					rv = sccp_realtime_load(GLOB(realtimedevicetable), device->id);
 					/* we did not find this line, mark it for deletion */
 					if (!rv) {
 						sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_3 "%s: realtime device not found - set pendingDelete=1\n", device->id);
@@ -2608,6 +3247,23 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 
 	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Checking Reading Type\n");
 	if (readingtype == SCCP_CONFIG_READRELOAD) {
+		/* whatever is still marked pendingDelete at this point, was not found in the new configuration */
+		SCCP_RWLIST_RDLOCK(&GLOB(devices));
+		SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+			if (d->pendingDelete) {
+				sccp_config_reloadReportAdd(SCCP_CONFIG_DEVICE_SEGMENT, d->id, SCCP_CONFIG_RELOAD_REMOVED);
+			}
+		}
+		SCCP_RWLIST_UNLOCK(&GLOB(devices));
+		sccp_line_t *line = NULL;
+		SCCP_RWLIST_RDLOCK(&GLOB(lines));
+		SCCP_RWLIST_TRAVERSE(&GLOB(lines), line, list) {
+			if (line->pendingDelete) {
+				sccp_config_reloadReportAdd(SCCP_CONFIG_LINE_SEGMENT, line->name, SCCP_CONFIG_RELOAD_REMOVED);
+			}
+		}
+		SCCP_RWLIST_UNLOCK(&GLOB(lines));
+
 		/* IMPORTANT: The line_post_reload function may change the pendingUpdate field of
 		 * devices, so it's really important to call it *before* calling device_post_real().
 		 */
@@ -2617,7 +3273,14 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
 		sccp_device_post_reload();
 		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "Softkey Post Reload\n");
 		sccp_softkey_post_reload();
+
+		/* regexten / regcontext changes are applied in one pass */
+		sccp_regcontext_summary_t regcontext = { 0 };
+		sccp_regcontext_sync(&regcontext);
+		sccp_buttontemplate_purge();
+		sccp_config_reloadReportEnd(start, &regcontext);
 	}
+	sccp_provision_sync(FALSE, NULL);
 	return TRUE;
 }
 
@@ -2633,6 +3296,21 @@ boolean_t sccp_config_readDevicesLines(sccp_readingtype_t readingtype)
  * 
  */
 sccp_configurationchange_t sccp_config_applyLineConfiguration(sccp_line_t * l, PBX_VARIABLE_TYPE * v)
+{
+	sccp_configurationchange_t res = sccp_config_applyLineSettings(l, v);
+
+	if (sccp_strlen_zero(l->id)) {
+		sccp_config_assignLineId(l);
+	}
+
+	return res;
+}
+
+/*!
+ * \brief Apply Line Configuration from Asterisk Variable, without numbering a line that has no id
+ * \note only touches the line itself, so it can be called for several lines in parallel
+ */
+static sccp_configurationchange_t sccp_config_applyLineSettings(sccp_line_t * l, PBX_VARIABLE_TYPE * v)
 {
 	sccp_configurationchange_t res = SCCP_CONFIG_NOUPDATENEEDED;
 	boolean_t SetEntries[ARRAY_LEN(sccpLineConfigOptions)] = { FALSE };
@@ -2643,11 +3321,6 @@ sccp_configurationchange_t sccp_config_applyLineConfiguration(sccp_line_t * l, P
 	}
 
 	sccp_config_set_defaults(l, SCCP_CONFIG_LINE_SEGMENT, SetEntries);
-
-	if (sccp_strlen_zero(l->id)) {
-		snprintf(l->id, sizeof(l->id), "%04d", SCCP_LIST_GETSIZE(&GLOB(lines)));
-	}
-
 	return res;
 }
 
@@ -2684,6 +3357,373 @@ sccp_configurationchange_t sccp_config_applyDeviceConfiguration(sccp_device_t *
 	return res;
 }
 
+/*!
+ * \brief Compiled Config Snapshot
+ *
+ * After a successful (re)load the validated configuration (the categories and variables that were applied, with templates already merged
+ * in by the pbx parser) is written to a flat, pointer-free image in the asterisk data directory. On the next start the image is memory-mapped and turned
+ * back into a config when the content hash of the source files (sccp.conf and its #include files) still matches, skipping the text parser.
+ * Only the parse step is replaced: the source files are still read to hash them, and the objects themselves (devices, lines, buttonconfigs,
+ * softkeysets, acls) hold pointers, refcounts and locks, so they are still built from this config by the normal build path. Any mismatch,
+ * #exec or wildcard include, or damaged image falls back to the parser.
+ *
+ * Layout: header | categories[] | variables[] | string area (NUL terminated, offsets are relative to the string area)
+ */
+#define SCCP_CONFIG_SNAPSHOT_MAGIC "SCCPSNAP"
+#define SCCP_CONFIG_SNAPSHOT_VERSION 1
+#define SCCP_CONFIG_SNAPSHOT_MAXDEPTH 8
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t categories;
+	uint32_t variables;
+	uint32_t strings;											/* size of the string area in bytes */
+	uint64_t sourceHash;											/* content hash of the source files */
+	uint64_t contentHash;											/* hash over the tables and string area, detects damaged images */
+} sccp_config_snapshot_header_t;
+
+typedef struct {
+	uint32_t name;
+	uint32_t first;
+	uint32_t count;
+	int32_t lineno;
+} sccp_config_snapshot_category_t;
+
+typedef struct {
+	uint32_t name;
+	uint32_t value;
+	int32_t lineno;
+	uint32_t reserved;
+} sccp_config_snapshot_variable_t;
+
+static uint64_t sccp_config_sourceHash;										/* content hash of the source files, taken just before they were parsed */
+static boolean_t sccp_config_sourceHashValid;									/* source files can be snapshotted (no #exec or wildcard includes) */
+static boolean_t sccp_config_sourceHashSkipped;									/* config_snapshot was off when the source files were parsed */
+static boolean_t sccp_config_fromSnapshot;									/* GLOB(cfg) was loaded from an unchanged snapshot */
+
+static uint64_t sccp_config_hashBuffer(uint64_t hash, const void *buffer, size_t len)
+{
+	const unsigned char *c = (const unsigned char *) buffer;
+	const unsigned char *end = c + len;
+
+	for (; c < end; c++) {
+		hash = (hash ^ *c) * SCCP_CONFIG_HASH_PRIME;
+	}
+	return hash;
+}
+
+/*!
+ * \brief Hash a config file and (recursively) the files it #includes
+ * \return FALSE when the file set cannot be snapshotted (unreadable, #exec, wildcard include or too deeply nested)
+ */
+static boolean_t sccp_config_hashSourceFile(const char *filename, uint64_t * hash, int depth)
+{
+	char path[PATH_MAX];
+	char line[PATH_MAX + 32];
+	FILE *fp = NULL;
+	boolean_t res = TRUE;
+
+	if (depth > SCCP_CONFIG_SNAPSHOT_MAXDEPTH) {
+		return FALSE;
+	}
+	if (filename[0] == '/') {
+		sccp_copy_string(path, filename, sizeof(path));
+	} else {
+		snprintf(path, sizeof(path), "%s/%s", ast_config_AST_CONFIG_DIR, filename);
+	}
+	if (!(fp = fopen(path, "r"))) {
+		return FALSE;
+	}
+	*hash = sccp_config_hashString(*hash, path, '\0');
+	while (res && fgets(line, sizeof(line), fp)) {
+		char *directive = line;
+
+		*hash = sccp_config_hashBuffer(*hash, line, strlen(line));
+		while (*directive == ' ' || *directive == '\t') {
+			directive++;
+		}
+		if (*directive != '#') {
+			continue;
+		}
+		if (!strncasecmp(directive, "#exec", 5)) {
+			res = FALSE;
+		} else if (!strncasecmp(directive, "#include", 8) || !strncasecmp(directive, "#tryinclude", 11)) {
+			boolean_t optional = (directive[1] == 't' || directive[1] == 'T');
+			char *include = directive + (optional ? 11 : 8);
+			char *end = NULL;
+
+			include = ast_skip_blanks(include);
+			if (*include == '"' || *include == '<') {
+				include++;
+			}
+			for (end = include; *end && *end != '"' && *end != '>' && *end != '\r' && *end != '\n'; end++);
+			*end = '\0';
+			ast_trim_blanks(include);
+			if (sccp_strlen_zero(include) || strpbrk(include, "*?[")) {
+				res = FALSE;
+			} else if (!sccp_config_hashSourceFile(include, hash, depth + 1)) {
+				if (!optional) {
+					res = FALSE;
+				}
+				*hash = sccp_config_hashString(*hash, include, '!');				/* missing optional include */
+			}
+		}
+	}
+	fclose(fp);
+	return res;
+}
+
+static void sccp_config_snapshotPath(char *path, size_t len)
+{
+	const char *filename = strrchr(GLOB(config_file_name), '/');
+
+	snprintf(path, len, "%s/%s.snapshot", ast_config_AST_DATA_DIR, filename ? filename + 1 : GLOB(config_file_name));
+}
+
+/*!
+ * \brief Write the categories and variables of cfg as a snapshot image to path (atomically, via a temporary file)
+ */
+static boolean_t sccp_config_writeSnapshotFile(struct ast_config *cfg, const char *path, uint64_t sourceHash)
+{
+	sccp_config_snapshot_header_t header = {.version = SCCP_CONFIG_SNAPSHOT_VERSION,.sourceHash = sourceHash };
+	sccp_config_snapshot_category_t *categories = NULL;
+	sccp_config_snapshot_variable_t *variables = NULL;
+	char *strings = NULL;
+	char *cat = NULL;
+	char tmppath[PATH_MAX];
+	PBX_VARIABLE_TYPE *v = NULL;
+	size_t stringsize = 0, offset = 0;
+	uint32_t c = 0, n = 0;
+	FILE *fp = NULL;
+	int fd = -1;
+	boolean_t res = FALSE;
+
+	memcpy(header.magic, SCCP_CONFIG_SNAPSHOT_MAGIC, sizeof(header.magic));
+	while ((cat = pbx_category_browse(cfg, cat))) {
+		header.categories++;
+		stringsize += strlen(cat) + 1;
+		for (v = ast_variable_browse(cfg, cat); v; v = v->next) {
+			header.variables++;
+			stringsize += strlen(v->name) + strlen(v->value) + 2;
+		}
+	}
+	if (stringsize > UINT32_MAX) {
+		return FALSE;
+	}
+	header.strings = (uint32_t) stringsize;
+	categories = sccp_calloc(header.categories ? header.categories : 1, sizeof *categories);
+	variables = sccp_calloc(header.variables ? header.variables : 1, sizeof *variables);
+	strings = sccp_calloc(header.strings ? header.strings : 1, 1);
+	if (!categories || !variables || !strings) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		goto EXIT;
+	}
+#define SCCP_CONFIG_SNAPSHOT_ADDSTRING(_str) ({ size_t _len = strlen(_str) + 1; uint32_t _off = (uint32_t) offset; memcpy(strings + offset, _str, _len); offset += _len; _off; })
+	cat = NULL;
+	while ((cat = pbx_category_browse(cfg, cat)) && c < header.categories) {
+		categories[c].name = SCCP_CONFIG_SNAPSHOT_ADDSTRING(cat);
+		categories[c].first = n;
+		categories[c].lineno = -1;
+		for (v = ast_variable_browse(cfg, cat); v && n < header.variables; v = v->next) {
+			variables[n].name = SCCP_CONFIG_SNAPSHOT_ADDSTRING(v->name);
+			variables[n].value = SCCP_CONFIG_SNAPSHOT_ADDSTRING(v->value);
+			variables[n].lineno = v->lineno;
+			if (categories[c].lineno < 0) {
+				categories[c].lineno = v->lineno;
+			}
+			n++;
+		}
+		categories[c].count = n - categories[c].first;
+		c++;
+	}
+#undef SCCP_CONFIG_SNAPSHOT_ADDSTRING
+	header.contentHash = sccp_config_hashBuffer(SCCP_CONFIG_HASH_OFFSET, categories, header.categories * sizeof *categories);
+	header.contentHash = sccp_config_hashBuffer(header.contentHash, variables, header.variables * sizeof *variables);
+	header.contentHash = sccp_config_hashBuffer(header.contentHash, strings, header.strings);
+
+	snprintf(tmppath, sizeof(tmppath), "%s.%d", path, (int) getpid());
+	unlink(tmppath);											/* left behind by a crash, never follow a link planted there */
+	if ((fd = open(tmppath, O_WRONLY | O_CREAT | O_EXCL, 0600)) < 0 || !(fp = fdopen(fd, "w"))) {
+		pbx_log(LOG_WARNING, "SCCP: Unable to write config snapshot '%s': %s\n", tmppath, strerror(errno));
+		if (fd >= 0) {
+			close(fd);
+			unlink(tmppath);
+		}
+		goto EXIT;
+	}
+	if (fwrite(&header, sizeof header, 1, fp) == 1 &&
+	    fwrite(categories, sizeof *categories, header.categories, fp) == header.categories &&
+	    fwrite(variables, sizeof *variables, header.variables, fp) == header.variables &&
+	    fwrite(strings, 1, header.strings, fp) == header.strings) {
+		res = TRUE;
+	}
+	if (fclose(fp) != 0) {
+		res = FALSE;
+	}
+	if (!res || rename(tmppath, path) != 0) {
+		pbx_log(LOG_WARNING, "SCCP: Unable to write config snapshot '%s': %s\n", path, strerror(errno));
+		unlink(tmppath);
+		res = FALSE;
+	}
+EXIT:
+	sccp_free(categories);
+	sccp_free(variables);
+	sccp_free(strings);
+	return res;
+}
+
+/*!
+ * \brief Map the snapshot image at path and turn it back into a config
+ * \return new config or NULL when the image is missing, damaged or was made from different source files
+ */
+static struct ast_config *sccp_config_readSnapshotFile(const char *path, uint64_t sourceHash)
+{
+	const sccp_config_snapshot_header_t *header = NULL;
+	const sccp_config_snapshot_category_t *categories = NULL;
+	const sccp_config_snapshot_variable_t *variables = NULL;
+	const char *strings = NULL;
+	struct ast_config *cfg = NULL;
+	struct stat st;
+	void *image = MAP_FAILED;
+	uint64_t contentHash = SCCP_CONFIG_HASH_OFFSET;
+	uint32_t c = 0, n = 0;
+	int fd = -1;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return NULL;
+	}
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof *header || (image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+		close(fd);
+		return NULL;
+	}
+	close(fd);
+
+	header = (const sccp_config_snapshot_header_t *) image;
+	if (memcmp(header->magic, SCCP_CONFIG_SNAPSHOT_MAGIC, sizeof(header->magic)) || header->version != SCCP_CONFIG_SNAPSHOT_VERSION || header->sourceHash != sourceHash) {
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config snapshot '%s' is outdated\n", path);
+		goto EXIT;
+	}
+	if ((uint64_t) st.st_size != sizeof *header + (uint64_t) header->categories * sizeof *categories + (uint64_t) header->variables * sizeof *variables + header->strings || !header->strings) {
+		goto DAMAGED;
+	}
+	categories = (const sccp_config_snapshot_category_t *) (header + 1);
+	variables = (const sccp_config_snapshot_variable_t *) (categories + header->categories);
+	strings = (const char *) (variables + header->variables);
+	contentHash = sccp_config_hashBuffer(contentHash, categories, header->categories * sizeof *categories);
+	contentHash = sccp_config_hashBuffer(contentHash, variables, header->variables * sizeof *variables);
+	contentHash = sccp_config_hashBuffer(contentHash, strings, header->strings);
+	if (contentHash != header->contentHash || strings[header->strings - 1] != '\0') {
+		goto DAMAGED;
+	}
+
+	if (!(cfg = ast_config_new())) {
+		goto EXIT;
+	}
+	for (c = 0; c < header->categories; c++) {
+		const sccp_config_snapshot_category_t *category = &categories[c];
+		struct ast_category *cat = NULL;
+
+		if (category->name >= header->strings || category->first > header->variables || category->count > header->variables - category->first) {
+			goto DAMAGED;
+		}
+		if (!(cat = ast_category_new(strings + category->name, GLOB(config_file_name), category->lineno))) {
+			goto DAMAGED;
+		}
+		ast_category_append(cfg, cat);
+		for (n = category->first; n < category->first + category->count; n++) {
+			PBX_VARIABLE_TYPE *v = NULL;
+
+			if (variables[n].name >= header->strings || variables[n].value >= header->strings) {
+				goto DAMAGED;
+			}
+			if (!(v = ast_variable_new(strings + variables[n].name, strings + variables[n].value, GLOB(config_file_name)))) {
+				goto DAMAGED;
+			}
+			v->lineno = variables[n].lineno;
+			ast_variable_append(cat, v);
+		}
+	}
+	goto EXIT;
+DAMAGED:
+	pbx_log(LOG_WARNING, "SCCP: Config snapshot '%s' is damaged, ignoring it\n", path);
+	if (cfg) {
+		pbx_config_destroy(cfg);
+		cfg = NULL;
+	}
+EXIT:
+	munmap(image, st.st_size);
+	return cfg;
+}
+
+/*!
+ * \brief Load GLOB(cfg) from the compiled config snapshot, when the source files did not change since it was written
+ * \return TRUE when GLOB(cfg) was loaded from the snapshot, FALSE to fall back to the config parser
+ */
+boolean_t sccp_config_readSnapshot(void)
+{
+	char path[PATH_MAX];
+	uint64_t hash = SCCP_CONFIG_HASH_OFFSET;
+	struct ast_config *cfg = NULL;
+	struct timeval start = pbx_tvnow();
+
+	if (sccp_strlen_zero(GLOB(config_file_name))) {
+		GLOB(config_file_name) = pbx_strdup("sccp.conf");
+	}
+	sccp_config_fromSnapshot = FALSE;
+	sccp_config_snapshotPath(path, sizeof(path));
+	if (access(path, R_OK) != 0 || !sccp_config_hashSourceFile(GLOB(config_file_name), &hash, 0)) {
+		return FALSE;
+	}
+	if (!(cfg = sccp_config_readSnapshotFile(path, hash))) {
+		return FALSE;
+	}
+	if (!ast_variable_browse(cfg, "general")) {
+		pbx_config_destroy(cfg);
+		return FALSE;
+	}
+	if (GLOB(cfg)) {
+		pbx_config_destroy(GLOB(cfg));
+	}
+	GLOB(cfg) = cfg;
+	sccp_config_reloadForced = TRUE;
+	sccp_config_sourceHash = hash;
+	sccp_config_sourceHashValid = TRUE;
+	sccp_config_sourceHashSkipped = FALSE;
+	sccp_config_fromSnapshot = TRUE;
+	pbx_log(LOG_NOTICE, "Config file '%s' loaded from snapshot '%s' (%d ms).\n", GLOB(config_file_name), path, (int) ast_tvdiff_ms(pbx_tvnow(), start));
+	return TRUE;
+}
+
+/*!
+ * \brief Write GLOB(cfg) to the compiled config snapshot after it was applied successfully (config_snapshot=yes), or remove a stale one
+ */
+void sccp_config_writeSnapshot(void)
+{
+	char path[PATH_MAX];
+
+	if (sccp_strlen_zero(GLOB(config_file_name))) {
+		return;
+	}
+	sccp_config_snapshotPath(path, sizeof(path));
+	if (GLOB(config_snapshot) && sccp_config_sourceHashSkipped) {
+		/* just switched on, hash now, a file changed since it was parsed only makes the snapshot outdated on the next start */
+		sccp_config_sourceHash = SCCP_CONFIG_HASH_OFFSET;
+		sccp_config_sourceHashValid = sccp_config_hashSourceFile(GLOB(config_file_name), &sccp_config_sourceHash, 0);
+		sccp_config_sourceHashSkipped = FALSE;
+	}
+	if (!GLOB(config_snapshot) || !sccp_config_sourceHashValid || !GLOB(cfg)) {
+		unlink(path);
+		return;
+	}
+	if (sccp_config_fromSnapshot) {
+		return;												/* image is still current */
+	}
+	if (sccp_config_writeSnapshotFile(GLOB(cfg), path, sccp_config_sourceHash)) {
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Config snapshot written to '%s'\n", path);
+	}
+}
+
 /*!
  * \brief Find the Correct Config File
  * \return Asterisk Config Object as ast_config
@@ -2693,6 +3733,7 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 	// struct ast_flags config_flags = { CONFIG_FLAG_WITHCOMMENTS & CONFIG_FLAG_FILEUNCHANGED };
 	int res = 0;
 	struct ast_flags config_flags = { CONFIG_FLAG_FILEUNCHANGED };
+	sccp_config_reloadForced = force;
 	if (force) {
 		if (GLOB(cfg)) {
 			pbx_config_destroy(GLOB(cfg));
@@ -2704,6 +3745,13 @@ sccp_config_file_status_t sccp_config_getConfig(boolean_t force)
 	if (sccp_strlen_zero(GLOB(config_file_name))) {
 		GLOB(config_file_name) = pbx_strdup("sccp.conf");
 	}
+	sccp_config_fromSnapshot = FALSE;
+	sccp_config_sourceHash = SCCP_CONFIG_HASH_OFFSET;
+	sccp_config_sourceHashValid = FALSE;
+	sccp_config_sourceHashSkipped = !GLOB(config_snapshot);						/* setting of the previous load, hashed after parsing if it gets switched on */
+	if (!sccp_config_sourceHashSkipped) {
+		sccp_config_sourceHashValid = sccp_config_hashSourceFile(GLOB(config_file_name), &sccp_config_sourceHash, 0);	/* hash before parsing, a file changed in between just makes the snapshot outdated */
+	}
 	GLOB(cfg) = pbx_config_load(GLOB(config_file_name), "chan_sccp", config_flags);
 	if (GLOB(cfg) == CONFIG_STATUS_FILEMISSING) {
 		pbx_log(LOG_ERROR, "Config file '%s' not found, aborting (re)load.\n", GLOB(config_file_name));
@@ -3050,289 +4098,449 @@ void sccp_config_restoreDeviceFeatureStatus(sccp_device_t * device)
 #endif
 }
 
+/*!
+ * \brief Show what the last reload changed (CLI/AMI)
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+#include <asterisk/cli.h>
+int sccp_config_show_reload(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int once = 0;
+	size_t idx = 0;
+	char started[25] = "";
+	struct tm tm;
+	const sccp_config_reloadchange_entry_t *entry = NULL;
+
+	pbx_mutex_lock(&sccp_config_reloadReportLock);
+	if (!sccp_config_reloadReport.valid) {
+		pbx_mutex_unlock(&sccp_config_reloadReportLock);
+		if (!s) {
+			pbx_cli(fd, "No reload has been performed since the module was loaded\n");
+		}
+		return RESULT_SUCCESS;
+	}
+	strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime_r(&sccp_config_reloadReport.started, &tm));
+
+#define CLI_AMI_TABLE_NAME ReloadSummary
+#define CLI_AMI_TABLE_PER_ENTRY_NAME Reload
+#define CLI_AMI_TABLE_ITERATOR for(once=0;once<1;once++)
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Started,		"-19.19",	s,	19,	started)							\
+ 		CLI_AMI_TABLE_FIELD(Mode,		"-11.11",	s,	11,	sccp_config_reloadReport.incremental ? "Incremental" : "Full")	\
+ 		CLI_AMI_TABLE_FIELD(General,		"-8.8",		s,	8,	sccp_config_reloadReport.generalChanged ? "Modified" : "Same")	\
+ 		CLI_AMI_TABLE_FIELD(DurationMs,	"10.10",	d,	10,	(int) sccp_config_reloadReport.duration)			\
+ 		CLI_AMI_TABLE_FIELD(DevAdd,		"6.6",		d,	6,	sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_ADDED])		\
+ 		CLI_AMI_TABLE_FIELD(DevDel,		"6.6",		d,	6,	sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_REMOVED])	\
+ 		CLI_AMI_TABLE_FIELD(DevMod,		"6.6",		d,	6,	sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_MODIFIED])	\
+ 		CLI_AMI_TABLE_FIELD(DevSame,		"7.7",		d,	7,	sccp_config_reloadReport.counts[SCCP_CONFIG_DEVICE_SEGMENT][SCCP_CONFIG_RELOAD_UNCHANGED])	\
+ 		CLI_AMI_TABLE_FIELD(LineAdd,		"7.7",		d,	7,	sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_ADDED])		\
+ 		CLI_AMI_TABLE_FIELD(LineDel,		"7.7",		d,	7,	sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_REMOVED])		\
+ 		CLI_AMI_TABLE_FIELD(LineMod,		"7.7",		d,	7,	sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_MODIFIED])		\
+ 		CLI_AMI_TABLE_FIELD(LineSame,		"8.8",		d,	8,	sccp_config_reloadReport.counts[SCCP_CONFIG_LINE_SEGMENT][SCCP_CONFIG_RELOAD_UNCHANGED])	\
+ 		CLI_AMI_TABLE_FIELD(RegAdd,		"6.6",		d,	6,	sccp_config_reloadReport.regcontext.added)			\
+ 		CLI_AMI_TABLE_FIELD(RegDel,		"6.6",		d,	6,	sccp_config_reloadReport.regcontext.removed)			\
+ 		CLI_AMI_TABLE_FIELD(RegTotal,		"8.8",		d,	8,	sccp_config_reloadReport.regcontext.registered)
+#include "sccp_cli_table.h"
+
+#define CLI_AMI_TABLE_NAME ReloadChanges
+#define CLI_AMI_TABLE_PER_ENTRY_NAME ReloadChange
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < SCCP_VECTOR_SIZE(&sccp_config_reloadReport.changes); idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		entry = SCCP_VECTOR_GET_ADDR(&sccp_config_reloadReport.changes, idx);
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Type,		"-7.7",		s,	7,	sccp_find_segment(entry->segment)->name)			\
+ 		CLI_AMI_TABLE_FIELD(Name,		"-40.40",	s,	40,	entry->name)							\
+ 		CLI_AMI_TABLE_FIELD(Change,		"-8.8",		s,	8,	sccp_config_reloadchange_str[entry->change])
+#include "sccp_cli_table.h"
+	pbx_mutex_unlock(&sccp_config_reloadReportLock);
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 2;
+	}
+	return RESULT_SUCCESS;
+}
+
 /* generate json output from now on */
-int sccp_manager_config_metadata(struct mansession *s, const struct message *m)
+/*!
+ * \brief Precomputed Config Metadata
+ * \note the option tables are fixed at build time, the json is rendered once on first use and shared (read only) by all requests
+ */
+static struct {
+	boolean_t valid;
+	char version[17];											/*!< content hash, used as etag */
+	char *overview;												/*!< all segments */
+	char *segments[ARRAY_LEN(sccpConfigSegments)];
+} sccp_config_metadata;
+
+AST_MUTEX_DEFINE_STATIC(sccp_config_metadataLock);
+
+static void sccp_config_metadataAppendEscaped(pbx_str_t **buf, const char *str)
 {
-	const SCCPConfigSegment *sccpConfigSegment = NULL;
-	int total = 0;
-	uint i;
-	const char *id = astman_get_header(m, "ActionID");
-	const char *req_segment = astman_get_header(m, "Segment");
-	const char *req_resultformat = astman_get_header(m, "ResultFormat");
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') {
+			pbx_str_append(buf, 0, "\\%c", *str);
+		} else if (*str == '\n') {
+			pbx_str_append(buf, 0, " ");							/* multi line descriptions are joined */
+		} else {
+			pbx_str_append(buf, 0, "%c", *str);
+		}
+	}
+}
+
+static void sccp_config_renderMetadataSegment(pbx_str_t **buf, const SCCPConfigSegment * sccpConfigSegment)
+{
+	const SCCPConfigOption *config = sccpConfigSegment->config;
+	uint8_t cur_elem = 0;
 	uint comma = 0;
 
-	if (sccp_strlen_zero(req_segment)) {										// return all segments
-		int sccp_config_revision = 0;
+	pbx_str_append(buf, 0, "{");
+	pbx_str_append(buf, 0, "\"Segment\":\"%s\",", sccpConfigSegment->name);
+	pbx_str_append(buf, 0, "\"Options\":[");
+	for (cur_elem = 0; cur_elem < sccpConfigSegment->config_size; cur_elem++) {
+		if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_IGNORE) == SCCP_CONFIG_FLAG_IGNORE) {
+			continue;
+		}
+		pbx_str_append(buf, 0, "%s{", comma ? "," : "");
+		pbx_str_append(buf, 0, "\"Name\":\"%s\",", config[cur_elem].name);
+
+		switch (config[cur_elem].type) {
+			case SCCP_CONFIG_DATATYPE_BOOLEAN:
+				pbx_str_append(buf, 0, "\"Type\":\"BOOLEAN\",");
+				pbx_str_append(buf, 0, "\"Size\":%d", (int) config[cur_elem].size - 1);
+				break;
+			case SCCP_CONFIG_DATATYPE_INT:
+				pbx_str_append(buf, 0, "\"Type\":\"INT\",");
+				pbx_str_append(buf, 0, "\"Size\":%d", (int) config[cur_elem].size - 1);
+				break;
+			case SCCP_CONFIG_DATATYPE_UINT:
+				pbx_str_append(buf, 0, "\"Type\":\"UNSIGNED INT\",");
+				pbx_str_append(buf, 0, "\"Size\":%d", (int) config[cur_elem].size - 1);
+				break;
+			case SCCP_CONFIG_DATATYPE_STRINGPTR:
+				pbx_str_append(buf, 0, "\"Type\":\" STRING\",");
+				pbx_str_append(buf, 0, "\"Size\":0");
+				break;
+			case SCCP_CONFIG_DATATYPE_STRING:
+				pbx_str_append(buf, 0, "\"Type\":\"STRING\",");
+				pbx_str_append(buf, 0, "\"Size\":%d", (int) config[cur_elem].size - 1);
+				break;
+			case SCCP_CONFIG_DATATYPE_PARSER:
+				pbx_str_append(buf, 0, "\"Type\":\"PARSER\",");
+				pbx_str_append(buf, 0, "\"Size\":0,");
+				pbx_str_append(buf, 0, "\"Parser\":\"%s\"", config[cur_elem].parsername);
+				break;
+			case SCCP_CONFIG_DATATYPE_CHAR:
+				pbx_str_append(buf, 0, "\"Type\":\"CHAR\",");
+				pbx_str_append(buf, 0, "\"Size\":1");
+				break;
+			case SCCP_CONFIG_DATATYPE_ENUM:
+				pbx_str_append(buf, 0, "\"Type\":\"ENUM\",");
+				pbx_str_append(buf, 0, "\"Size\":%d,", (int) config[cur_elem].size - 1);
+				char *all_entries = pbx_strdupa(config[cur_elem].all_entries());
+				char *possible_entry = "";
+
+				int subcomma = 0;
+				pbx_str_append(buf, 0, "\"Possible Values\": [");
+				while (all_entries && (possible_entry = strsep(&all_entries, ","))) {
+					pbx_str_append(buf, 0, "%s\"%s\"", subcomma ? "," : "", possible_entry);
+					subcomma = 1;
+				}
+				pbx_str_append(buf, 0, "]");
+				break;
+		}
+		pbx_str_append(buf, 0, ",");
 
-		sscanf(SCCP_CONFIG_REVISION, "$" "Revision: %i" "$", &sccp_config_revision);
+		if ((config[cur_elem].flags & (SCCP_CONFIG_FLAG_REQUIRED | SCCP_CONFIG_FLAG_DEPRECATED | SCCP_CONFIG_FLAG_OBSOLETE | SCCP_CONFIG_FLAG_MULTI_ENTRY)) > 0 || (config[cur_elem].change & SCCP_CONFIG_NEEDDEVICERESET) == SCCP_CONFIG_NEEDDEVICERESET) {
+			int comma1 = 0;
 
-		if (sccp_strcaseequals(req_resultformat, "list")) {
-			astman_send_listack(s, m, "SCCPConfigMetaData Follows", "Start");
-			astman_append(s, "Event: SCCPConfigMetaData\r\n");
-		} else if (sccp_strcaseequals(req_resultformat, "command")) {
-			astman_append(s, "Response: Follows\r\n");
-			astman_append(s, "Priviledge: Command\r\n");
-		} else {
-			astman_append(s, "Response: Success\r\n");
+			pbx_str_append(buf, 0, "\"Flags\":[");
+			if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_REQUIRED) == SCCP_CONFIG_FLAG_REQUIRED) {
+				pbx_str_append(buf, 0, "\"Required\"");
+				comma1 = 1;
+			}
+			if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_DEPRECATED) == SCCP_CONFIG_FLAG_DEPRECATED) {
+				pbx_str_append(buf, 0, "%s\"Deprecated\"", comma1 ? "," : "");
+				comma1 = 1;
+			}
+			if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_OBSOLETE) == SCCP_CONFIG_FLAG_OBSOLETE) {
+				pbx_str_append(buf, 0, "%s\"Obsolete\"", comma1 ? "," : "");
+				comma1 = 1;
+			}
+			if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_MULTI_ENTRY) == SCCP_CONFIG_FLAG_MULTI_ENTRY) {
+				pbx_str_append(buf, 0, "%s\"MultiEntry\"", comma1 ? "," : "");
+				comma1 = 1;
+			}
+			if ((config[cur_elem].change & SCCP_CONFIG_NEEDDEVICERESET) == SCCP_CONFIG_NEEDDEVICERESET) {
+				pbx_str_append(buf, 0, "%s\"RestartRequiredOnUpdate\"", comma1 ? "," : "");
+				comma1 = 1;
+			}
+			pbx_str_append(buf, 0, "],");
 		}
-		if (!ast_strlen_zero(id)) {
-			astman_append(s, "ActionID: %s\r\n", id);
+
+		pbx_str_append(buf, 0, "\"DefaultValue\":\"");
+		sccp_config_metadataAppendEscaped(buf, config[cur_elem].defaultValue ? config[cur_elem].defaultValue : "");
+		pbx_str_append(buf, 0, "\"");
+
+		if (!sccp_strlen_zero(config[cur_elem].description)) {
+			pbx_str_append(buf, 0, ",\"Description\":\"");
+			sccp_config_metadataAppendEscaped(buf, config[cur_elem].description);
+			pbx_str_append(buf, 0, "\"");
 		}
+		pbx_str_append(buf, 0, "}");
+		comma = 1;
+	}
+	pbx_str_append(buf, 0, "]}");
+}
 
-		astman_append(s, "JSON: {");
-		astman_append(s, "\"Name\":\"Chan-sccp-b\",");
-		astman_append(s, "\"Version\":\"%s\",", SCCP_VERSION);
+static void sccp_config_renderMetadataOverview(pbx_str_t **buf, const char *version)
+{
+	int sccp_config_revision = 0;
+	uint i = 0;
+	uint comma = 0;
+
+	sscanf(SCCP_CONFIG_REVISION, "$" "Revision: %i" "$", &sccp_config_revision);
+
+	pbx_str_append(buf, 0, "{");
+	pbx_str_append(buf, 0, "\"Name\":\"Chan-sccp-b\",");
+	pbx_str_append(buf, 0, "\"Version\":\"%s\",", SCCP_VERSION);
 #if defined(VCS_BRANCH) && defined(VCS_NUM) && defined(VCS_TAG) && defined(VCS_TAG) && defined(VCS_TYPE)
-		astman_append(s, "\"Branch\":\"%s\",", VCS_BRANCH);
-		astman_append(s, "\"RevisionHash\":\"%s\",", VCS_SHORT_HASH);
-		astman_append(s, "\"RevisionNum\":\"%d\",", VCS_NUM);
-		astman_append(s, "\"Tag\":\"%s\",", VCS_TAG);
-		astman_append(s, "\"VersioningType\":\"%s\",", VCS_TYPE);
+	pbx_str_append(buf, 0, "\"Branch\":\"%s\",", VCS_BRANCH);
+	pbx_str_append(buf, 0, "\"RevisionHash\":\"%s\",", VCS_SHORT_HASH);
+	pbx_str_append(buf, 0, "\"RevisionNum\":\"%d\",", VCS_NUM);
+	pbx_str_append(buf, 0, "\"Tag\":\"%s\",", VCS_TAG);
+	pbx_str_append(buf, 0, "\"VersioningType\":\"%s\",", VCS_TYPE);
 #else
-		astman_append(s, "\"Branch\":\"%s\",", SCCP_BRANCH);
-		astman_append(s, "\"RevisionHash\":\"%s\",", SCCP_REVISION);
-		astman_append(s, "\"RevisionNum\":\"%d\",", 0);
-		astman_append(s, "\"Tag\":\"%s\",", "");
-		astman_append(s, "\"VersioningType\":\"%s\",", "archive");
+	pbx_str_append(buf, 0, "\"Branch\":\"%s\",", SCCP_BRANCH);
+	pbx_str_append(buf, 0, "\"RevisionHash\":\"%s\",", SCCP_REVISION);
+	pbx_str_append(buf, 0, "\"RevisionNum\":\"%d\",", 0);
+	pbx_str_append(buf, 0, "\"Tag\":\"%s\",", "");
+	pbx_str_append(buf, 0, "\"VersioningType\":\"%s\",", "archive");
 #endif
-		astman_append(s, "\"ConfigRevision\":\"%d\",", sccp_config_revision);
-		char *conf_enabled_array[] = {
+	pbx_str_append(buf, 0, "\"ConfigRevision\":\"%d\",", sccp_config_revision);
+	if (version) {
+		pbx_str_append(buf, 0, "\"MetaDataVersion\":\"%s\",", version);
+	}
+	char *conf_enabled_array[] = {
 #ifdef CS_SCCP_PARK
-			"park",
+		"park",
 #endif
 #ifdef CS_SCCP_PICKUP
-			"pickup",
+		"pickup",
 #endif 
 #ifdef CS_SCCP_REALTIME
-			"realtime",
+		"realtime",
 #endif 
 #ifdef CS_SCCP_VIDEO
-			"video",
+		"video",
 #endif 
 #ifdef CS_SCCP_CONFERENCE
-			"conferenence",
+		"conferenence",
 #endif 
 #ifdef CS_SCCP_DIRTRFR
-			"dirtrfr",
+		"dirtrfr",
 #endif 
 #ifdef CS_SCCP_FEATURE_MONITOR
-			"feature_monitor",
+		"feature_monitor",
 #endif
 #ifdef CS_SCCP_FUNCTIONS
-			"functions",
+		"functions",
 #endif
 #ifdef CS_MANAGER_EVENTS
-			"manager_events",
+		"manager_events",
 #endif
 #ifdef CS_DEVICESTATE
-			"devicestate",
+		"devicestate",
 #endif
 #ifdef CS_DEVSTATE_FEATURE
-			"devstate_feature",
+		"devstate_feature",
 #endif
 #ifdef CS_DYNAMIC_SPEEDDIAL
-			"dynamic_speeddial",
+		"dynamic_speeddial",
 #endif
 #ifdef CS_DYNAMIC_SPEEDDIAL_CID
-			"dynamic_speeddial_cid",
+		"dynamic_speeddial_cid",
 #endif
 #ifdef CS_EXPERIMENTAL
-			"experimental",
+		"experimental",
 #endif
 #ifdef DEBUG
-			"debug",
+		"debug",
 #endif
-		};
-		comma = 0;
-		astman_append(s, "\"ConfigureEnabled\": [");
-		for (i = 0; i < ARRAY_LEN(conf_enabled_array); i++) {
-			astman_append(s, "%s\"%s\"", comma ? "," : "",conf_enabled_array[i]);
-			comma = 1;
-		}
-		astman_append(s, "],");
-		
-		comma = 0;
-		astman_append(s, "\"Segments\":[");
-		for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
-			astman_append(s, "%s", comma ? "," : "");
-			astman_append(s, "\"%s\"", sccpConfigSegments[i].name);
-			comma = 1;
-		}
-		astman_append(s, "]}\r\n");
-		total++;
-		if (sccp_strcaseequals(req_resultformat, "list")) {
-			astman_append(s,
-				"\r\nEvent: SCCPConfigMetaDataComplete\r\n"
-				"EventList: Complete\r\n"
-				"ListItems: %d\r\n\r\n", total);
-		} else if (sccp_strcaseequals(req_resultformat, "command")) {
-			astman_append(s, "--END COMMAND--\r\n");
-		}
-		astman_append(s, "\r\n");
-	} else {												// return metadata for option in segmnet
-		/*
-		   JSON:
-		   {
-		   "Segment": "general", 
-		   "Options": [
-		   {
-		   Option: config->name,
-		   Type: ....,
-		   Flags : [Required, Deprecated, Obsolete, MultiEntry, RestartRequiredOnUpdate],
-		   DefaultValue: ...,
-		   Description: ....
-		   },
-		   {
-		   ...
-		   }
-		   ] 
-
-		   }
-		 */
-		for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
-			if (sccp_strcaseequals(sccpConfigSegments[i].name, req_segment)) {
-				sccpConfigSegment = &sccpConfigSegments[i];
-				const SCCPConfigOption *config = sccpConfigSegment->config;
-
-				if (sccp_strcaseequals(req_resultformat, "list")) {
-					astman_send_listack(s, m, "SCCPConfigMetaData Follows", "Start");
-					astman_append(s, "Event: SCCPConfigMetaData\r\n");
-				} else if (sccp_strcaseequals(req_resultformat, "command")) {
-					astman_append(s, "Response: Follows\r\n");
-				} else {
-					astman_append(s, "Response: Success\r\n");
-				}
-				if (!ast_strlen_zero(id)) {
-					astman_append(s, "ActionID: %s\r\n", id);
-				}
-				astman_append(s, "JSON: {");
-				astman_append(s, "\"Segment\":\"%s\",", sccpConfigSegment->name);
-				astman_append(s, "\"Options\":[");
-				uint8_t cur_elem = 0;
-				comma = 0;
-
-				for (cur_elem = 0; cur_elem < sccpConfigSegment->config_size; cur_elem++) {
-					if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_IGNORE) != SCCP_CONFIG_FLAG_IGNORE) {
-						astman_append(s, "%s", comma ? "," : "");
-						astman_append(s, "{");
-
-						{
-							astman_append(s, "\"Name\":\"%s\",", config[cur_elem].name);
-
-							switch (config[cur_elem].type) {
-								case SCCP_CONFIG_DATATYPE_BOOLEAN:
-									astman_append(s, "\"Type\":\"BOOLEAN\",");
-									astman_append(s, "\"Size\":%d", (int) config[cur_elem].size - 1);
-									break;
-								case SCCP_CONFIG_DATATYPE_INT:
-									astman_append(s, "\"Type\":\"INT\",");
-									astman_append(s, "\"Size\":%d", (int) config[cur_elem].size - 1);
-									break;
-								case SCCP_CONFIG_DATATYPE_UINT:
-									astman_append(s, "\"Type\":\"UNSIGNED INT\",");
-									astman_append(s, "\"Size\":%d", (int) config[cur_elem].size - 1);
-									break;
-								case SCCP_CONFIG_DATATYPE_STRINGPTR:
-									astman_append(s, "\"Type\":\" STRING\",");
-									astman_append(s, "\"Size\":0");
-									break;
-								case SCCP_CONFIG_DATATYPE_STRING:
-									astman_append(s, "\"Type\":\"STRING\",");
-									astman_append(s, "\"Size\":%d", (int) config[cur_elem].size - 1);
-									break;
-								case SCCP_CONFIG_DATATYPE_PARSER:
-									astman_append(s, "\"Type\":\"PARSER\",");
-									astman_append(s, "\"Size\":0,");
-									astman_append(s, "\"Parser\":\"%s\"", config[cur_elem].parsername);
-									break;
-								case SCCP_CONFIG_DATATYPE_CHAR:
-									astman_append(s, "\"Type\":\"CHAR\",");
-									astman_append(s, "\"Size\":1");
-									break;
-								case SCCP_CONFIG_DATATYPE_ENUM:
-									astman_append(s, "\"Type\":\"ENUM\",");
-									astman_append(s, "\"Size\":%d,", (int) config[cur_elem].size - 1);
-									char *all_entries = pbx_strdupa(config[cur_elem].all_entries());
-									char *possible_entry = "";
+	};
+	comma = 0;
+	pbx_str_append(buf, 0, "\"ConfigureEnabled\": [");
+	for (i = 0; i < ARRAY_LEN(conf_enabled_array); i++) {
+		pbx_str_append(buf, 0, "%s\"%s\"", comma ? "," : "",conf_enabled_array[i]);
+		comma = 1;
+	}
+	pbx_str_append(buf, 0, "],");
 
-									int subcomma = 0;
-									astman_append(s, "\"Possible Values\": [");
-									while (all_entries && (possible_entry = strsep(&all_entries, ","))) {
-										astman_append(s, "%s\"%s\"", subcomma ? "," : "", possible_entry);
-										subcomma = 1;
-									}
-									astman_append(s, "]");
-									break;
-							}
-							astman_append(s, ",");
+	comma = 0;
+	pbx_str_append(buf, 0, "\"Segments\":[");
+	for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+		pbx_str_append(buf, 0, "%s\"%s\"", comma ? "," : "", sccpConfigSegments[i].name);
+		comma = 1;
+	}
+	pbx_str_append(buf, 0, "]}");
+}
 
-							if ((config[cur_elem].flags & (SCCP_CONFIG_FLAG_REQUIRED | SCCP_CONFIG_FLAG_DEPRECATED | SCCP_CONFIG_FLAG_OBSOLETE | SCCP_CONFIG_FLAG_MULTI_ENTRY)) > 0 || (config[cur_elem].change & SCCP_CONFIG_NEEDDEVICERESET) == SCCP_CONFIG_NEEDDEVICERESET) {
-								astman_append(s, "\"Flags\":[");
-								{
-									int comma1 = 0;
+/*!
+ * \brief Render the config metadata once, the version is a hash over the complete content
+ * \note call with sccp_config_metadataLock held
+ */
+static boolean_t sccp_config_buildMetadata(void)
+{
+	pbx_str_t *buf = NULL;
+	uint64_t hash = SCCP_CONFIG_HASH_OFFSET;
+	uint i = 0;
 
-									if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_REQUIRED) == SCCP_CONFIG_FLAG_REQUIRED) {
-										astman_append(s, "\"Required\"");
-										comma1 = 1;
-									}
-									if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_DEPRECATED) == SCCP_CONFIG_FLAG_DEPRECATED) {
-										astman_append(s, "%s", comma1 ? "," : "");
-										astman_append(s, "\"Deprecated\"");
-										comma1 = 1;
-									}
-									if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_OBSOLETE) == SCCP_CONFIG_FLAG_OBSOLETE) {
-										astman_append(s, "%s", comma1 ? "," : "");
-										astman_append(s, "\"Obsolete\"");
-										comma1 = 1;
-									}
-									if ((config[cur_elem].flags & SCCP_CONFIG_FLAG_MULTI_ENTRY) == SCCP_CONFIG_FLAG_MULTI_ENTRY) {
-										astman_append(s, "%s", comma1 ? "," : "");
-										astman_append(s, "\"MultiEntry\"");
-										comma1 = 1;
-									}
-									if ((config[cur_elem].change & SCCP_CONFIG_NEEDDEVICERESET) == SCCP_CONFIG_NEEDDEVICERESET) {
-										astman_append(s, "%s", comma1 ? "," : "");
-										astman_append(s, "\"RestartRequiredOnUpdate\"");
-										comma1 = 1;
-									}
-								}
-								astman_append(s, "],");
-							}
+	if (sccp_config_metadata.valid) {
+		return TRUE;
+	}
+	if (!(buf = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return FALSE;
+	}
+	for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+		pbx_str_reset(buf);
+		sccp_config_renderMetadataSegment(&buf, &sccpConfigSegments[i]);
+		hash = sccp_config_hashBuffer(hash, pbx_str_buffer(buf), pbx_str_strlen(buf));
+		sccp_config_metadata.segments[i] = pbx_strdup(pbx_str_buffer(buf));
+	}
+	pbx_str_reset(buf);
+	sccp_config_renderMetadataOverview(&buf, NULL);
+	hash = sccp_config_hashBuffer(hash, pbx_str_buffer(buf), pbx_str_strlen(buf));
+	snprintf(sccp_config_metadata.version, sizeof(sccp_config_metadata.version), "%016" PRIx64, hash);
 
-							astman_append(s, "\"DefaultValue\":\"%s\"", config[cur_elem].defaultValue);
+	pbx_str_reset(buf);
+	sccp_config_renderMetadataOverview(&buf, sccp_config_metadata.version);
+	sccp_config_metadata.overview = pbx_strdup(pbx_str_buffer(buf));
+	sccp_free(buf);
 
-							if (!sccp_strlen_zero(config[cur_elem].description)) {
-								char *description = pbx_strdupa(config[cur_elem].description);
-								char *description_part = "";
+	sccp_config_metadata.valid = (sccp_config_metadata.overview != NULL);
+	for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+		if (!sccp_config_metadata.segments[i]) {
+			sccp_config_metadata.valid = FALSE;
+		}
+	}
+	if (!sccp_config_metadata.valid) {
+		sccp_config_cleanupMetadata();
+	}
+	return sccp_config_metadata.valid;
+}
 
-								astman_append(s, ",\"Description\":\"");
-								while (description && (description_part = strsep(&description, "\n"))) {
-									astman_append(s, "%s ", description_part);
-								}
-								astman_append(s, "\"");
-							}
-						}
-						astman_append(s, "}");
-						comma = 1;
-					}
-				}
-				astman_append(s, "]}\r\n");
-				total++;
-				if (sccp_strcaseequals(req_resultformat, "list")) {
-					astman_append(s,
-						"\r\nEvent: SCCPConfigMetaDataComplete\r\n"
-						"EventList: Complete\r\n"
-						"ListItems: %d\r\n\r\n", total);
-				} else if (sccp_strcaseequals(req_resultformat, "command")) {
-					astman_append(s, "--END COMMAND--\r\n"
-							 "DataType: JSON\r\n"
-							 "Priviledge: Command\r\n"
-					);
+/*!
+ * \brief Free the precomputed config metadata (module unload)
+ */
+void sccp_config_cleanupMetadata(void)
+{
+	uint i = 0;
+
+	sccp_config_metadata.valid = FALSE;
+	if (sccp_config_metadata.overview) {
+		sccp_free(sccp_config_metadata.overview);
+	}
+	for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+		if (sccp_config_metadata.segments[i]) {
+			sccp_free(sccp_config_metadata.segments[i]);
+		}
+	}
+}
+
+/*!
+ * \brief AMI SCCPConfigMetaData
+ *
+ * Segment: empty for the overview, one or more (comma separated) segment names otherwise
+ * IfNoneMatch: MetaDataVersion the client already has, answered with "Message: Unchanged" and no JSON when it is still current
+ * ResultFormat: list / command / empty
+ */
+int sccp_manager_config_metadata(struct mansession *s, const struct message *m)
+{
+	const char *id = astman_get_header(m, "ActionID");
+	const char *req_segment = astman_get_header(m, "Segment");
+	const char *req_resultformat = astman_get_header(m, "ResultFormat");
+	const char *req_version = astman_get_header(m, "IfNoneMatch");
+	const char *blobs[ARRAY_LEN(sccpConfigSegments) + 1] = { NULL };
+	int total = 0;
+	uint i = 0;
+
+	pbx_mutex_lock(&sccp_config_metadataLock);
+	if (!sccp_config_buildMetadata()) {
+		pbx_mutex_unlock(&sccp_config_metadataLock);
+		astman_send_error(s, m, "Unable to generate config metadata");
+		return 0;
+	}
+	pbx_mutex_unlock(&sccp_config_metadataLock);
+	/* from here on the metadata is read only */
+
+	if (sccp_strlen_zero(req_segment)) {										// return all segments
+		blobs[total++] = sccp_config_metadata.overview;
+	} else {												// return metadata for option in segment(s)
+		char *segments = pbx_strdupa(req_segment);
+		char *segment = NULL;
+
+		while ((segment = strsep(&segments, ","))) {
+			segment = pbx_strip(segment);
+			for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+				if (sccp_strcaseequals(sccpConfigSegments[i].name, segment) && total < (int) ARRAY_LEN(blobs)) {
+					blobs[total++] = sccp_config_metadata.segments[i];
 				}
-				astman_append(s, "\r\n");
 			}
 		}
+		if (!total) {
+			astman_send_error(s, m, "Unknown Segment");
+			return 0;
+		}
 	}
+	if (!sccp_strlen_zero(req_version) && sccp_strcaseequals(req_version, sccp_config_metadata.version)) {
+		astman_append(s, "Response: Success\r\n");
+		if (!ast_strlen_zero(id)) {
+			astman_append(s, "ActionID: %s\r\n", id);
+		}
+		astman_append(s, "Message: Unchanged\r\n");
+		astman_append(s, "MetaDataVersion: %s\r\n\r\n", sccp_config_metadata.version);
+		return 0;
+	}
+
+	if (sccp_strcaseequals(req_resultformat, "list")) {
+		astman_send_listack(s, m, "SCCPConfigMetaData Follows", "Start");
+	} else if (sccp_strcaseequals(req_resultformat, "command")) {
+		astman_append(s, "Response: Follows\r\n");
+		astman_append(s, "Priviledge: Command\r\n");
+	} else {
+		astman_append(s, "Response: Success\r\n");
+	}
+	for (i = 0; i < (uint) total; i++) {
+		if (sccp_strcaseequals(req_resultformat, "list")) {
+			astman_append(s, "%sEvent: SCCPConfigMetaData\r\n", i ? "\r\n" : "");
+		}
+		if (!ast_strlen_zero(id) && (i == 0 || sccp_strcaseequals(req_resultformat, "list"))) {
+			astman_append(s, "ActionID: %s\r\n", id);
+		}
+		if (i == 0 || sccp_strcaseequals(req_resultformat, "list")) {
+			astman_append(s, "MetaDataVersion: %s\r\n", sccp_config_metadata.version);
+		}
+		astman_append(s, "JSON: %s\r\n", blobs[i]);
+	}
+	if (sccp_strcaseequals(req_resultformat, "list")) {
+		astman_append(s,
+			"\r\nEvent: SCCPConfigMetaDataComplete\r\n"
+			"EventList: Complete\r\n"
+			"ListItems: %d\r\n\r\n", total);
+	} else if (sccp_strcaseequals(req_resultformat, "command")) {
+		astman_append(s, "--END COMMAND--\r\n");
+	}
+	astman_append(s, "\r\n");
 	return 0;
 }
 
@@ -3530,6 +4738,401 @@ AST_TEST_DEFINE(sccp_config_base_functions)
 	return AST_TEST_PASS;
 }
 
+/* reference implementation: linear scan over the option table, used to verify and benchmark the option index */
+static const SCCPConfigOption *sccp_config_test_linear_find(const sccp_config_segment_t segment, const char *name)
+{
+	long unsigned int i = 0;
+	const SCCPConfigSegment *sccpConfigSegment = sccp_find_segment(segment);
+	const SCCPConfigOption *config = sccpConfigSegment->config;
+	char *token = NULL;
+	char *config_name = NULL;
+
+	for (i = 0; i < sccpConfigSegment->config_size; i++) {
+		if (strchr(config[i].name, '|')) {
+			config_name = pbx_strdupa(config[i].name);
+			for (token = strtok(config_name, "|"); token; token = strtok(NULL, "|")) {
+				if (!strcasecmp(token, name)) {
+					return &config[i];
+				}
+			}
+		}
+		if (!strcasecmp(config[i].name, name)) {
+			return &config[i];
+		}
+	}
+	return NULL;
+}
+
+AST_TEST_DEFINE(sccp_config_option_lookup)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "option_lookup";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config option index test";
+			info->description = "verify the option name index against a linear scan, and compare their speed";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const int iterations = 1000;
+	int iteration = 0;
+	uint8_t segment = 0;
+	size_t entry = 0;
+	size_t lookups = 0;
+	struct timeval start;
+	int64_t linear_us = 0, index_us = 0;
+	char name[80];
+
+	pbx_test_status_update(test, "Verify every option name and alias...\n");
+	for (segment = 0; segment < ARRAY_LEN(sccpConfigSegments); segment++) {
+		for (entry = 0; entry < sccpConfigSegmentIndex[segment].size; entry++) {
+			const SCCPConfigOptionIndex *index = &sccpConfigSegmentIndex[segment].entries[entry];
+			snprintf(name, sizeof(name), "%.*s", (int) index->len, index->name);
+			pbx_test_validate(test, sccp_find_config(sccpConfigSegments[segment].segment, name) == sccp_config_test_linear_find(sccpConfigSegments[segment].segment, name));
+		}
+	}
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "DISALLOW") == sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "allow"));
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "disallow|allow") == sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "allow"));
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "disallo") == NULL);
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "disallowed") == NULL);
+	pbx_test_validate(test, sccp_find_config(SCCP_CONFIG_GLOBAL_SEGMENT, "") == NULL);
+
+	pbx_test_status_update(test, "Benchmark %d passes over all option names...\n", iterations);
+	start = pbx_tvnow();
+	for (iteration = 0; iteration < iterations; iteration++) {
+		for (segment = 0; segment < ARRAY_LEN(sccpConfigSegments); segment++) {
+			for (entry = 0; entry < sccpConfigSegments[segment].config_size; entry++) {
+				lookups += sccp_config_test_linear_find(sccpConfigSegments[segment].segment, sccpConfigSegments[segment].config[entry].name) ? 1 : 0;
+			}
+		}
+	}
+	linear_us = ast_tvdiff_us(pbx_tvnow(), start);
+
+	start = pbx_tvnow();
+	for (iteration = 0; iteration < iterations; iteration++) {
+		for (segment = 0; segment < ARRAY_LEN(sccpConfigSegments); segment++) {
+			for (entry = 0; entry < sccpConfigSegments[segment].config_size; entry++) {
+				lookups += sccp_find_config(sccpConfigSegments[segment].segment, sccpConfigSegments[segment].config[entry].name) ? 1 : 0;
+			}
+		}
+	}
+	index_us = ast_tvdiff_us(pbx_tvnow(), start);
+	pbx_test_status_update(test, "Results (%zu lookups): linear scan:%" PRId64 "us, option index:%" PRId64 "us\n", lookups, linear_us, index_us);
+
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_config_category_hash)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "category_hash";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config test";
+			info->description = "content hash used by incremental reload";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	PBX_VARIABLE_TYPE *root = NULL, *other = NULL;
+	uint64_t hash = 0;
+
+	pbx_test_status_update(test, "sccp_config_hashCategory...\n");
+	root = ast_variable_new("type", "device", "");
+	root->next = ast_variable_new("button", "line, 100", "");
+	hash = sccp_config_hashCategory(root);
+	pbx_test_validate(test, hash == sccp_config_hashCategory(root));
+	pbx_test_validate(test, hash != sccp_config_hashCategory(NULL));
+
+	pbx_test_status_update(test, "changed value...\n");
+	other = ast_variable_new("type", "device", "");
+	other->next = ast_variable_new("button", "line, 101", "");
+	pbx_test_validate(test, hash != sccp_config_hashCategory(other));
+	pbx_variables_destroy(other);
+
+	pbx_test_status_update(test, "name/value boundary...\n");
+	other = ast_variable_new("type", "device", "");
+	other->next = ast_variable_new("buttonline", ", 100", "");
+	pbx_test_validate(test, hash != sccp_config_hashCategory(other));
+	pbx_variables_destroy(other);
+
+	pbx_test_status_update(test, "changed order...\n");
+	other = ast_variable_new("button", "line, 100", "");
+	other->next = ast_variable_new("type", "device", "");
+	pbx_test_validate(test, hash != sccp_config_hashCategory(other));
+	pbx_variables_destroy(other);
+
+	pbx_variables_destroy(root);
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_config_metadata_cache)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "metadata_cache";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config test";
+			info->description = "precomputed SCCPConfigMetaData blobs and version";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	char version[sizeof(sccp_config_metadata.version)] = "";
+	const char *overview = NULL;
+	uint i = 0;
+
+	pbx_test_status_update(test, "build...\n");
+	pbx_mutex_lock(&sccp_config_metadataLock);
+	pbx_test_validate(test, sccp_config_buildMetadata());
+	sccp_copy_string(version, sccp_config_metadata.version, sizeof(version));
+	overview = sccp_config_metadata.overview;
+	pbx_test_validate(test, strlen(version) == 16);
+	pbx_test_validate(test, overview && strstr(overview, version));
+	for (i = 0; i < ARRAY_LEN(sccpConfigSegments); i++) {
+		pbx_test_validate(test, sccp_config_metadata.segments[i] && strstr(sccp_config_metadata.segments[i], sccpConfigSegments[i].name));
+	}
+
+	pbx_test_status_update(test, "second request reuses the blobs...\n");
+	pbx_test_validate(test, sccp_config_buildMetadata());
+	pbx_test_validate(test, overview == sccp_config_metadata.overview);
+
+	pbx_test_status_update(test, "rebuild yields the same version...\n");
+	sccp_config_cleanupMetadata();
+	pbx_test_validate(test, !sccp_config_metadata.overview);
+	pbx_test_validate(test, sccp_config_buildMetadata());
+	pbx_test_validate(test, sccp_strequals(version, sccp_config_metadata.version));
+	pbx_mutex_unlock(&sccp_config_metadataLock);
+
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_config_parallel_build)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "parallel_build";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b config parallel build test";
+			info->description = "build 10000 device sections sequentially and on the threadpool, compare the results and their speed";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const int numDevices = 10000;
+	int cur = 0;
+	enum ast_test_result_state res = AST_TEST_PASS;
+	struct sccp_config_buildjobs sequential;
+	struct sccp_config_buildjobs parallel;
+	PBX_VARIABLE_TYPE **sections = NULL;
+	struct timeval start;
+	int64_t sequential_ms = 0, parallel_ms = 0;
+	char name[StationMaxDeviceNameSize];
+	char value[80];
+
+	if (!(sections = sccp_calloc(numDevices, sizeof *sections))) {
+		return AST_TEST_FAIL;
+	}
+	SCCP_VECTOR_INIT(&sequential, numDevices);
+	SCCP_VECTOR_INIT(&parallel, numDevices);
+
+	pbx_test_status_update(test, "Generate %d device sections...\n", numDevices);
+	for (cur = 0; cur < numDevices; cur++) {
+		PBX_VARIABLE_TYPE *v = NULL;
+
+		snprintf(name, sizeof(name), "SEPBENCH%06d", cur);
+		v = sections[cur] = ast_variable_new("type", "device", "");
+		v = v->next = ast_variable_new("devicetype", "7960", "");
+		snprintf(value, sizeof(value), "benchmark device %d", cur);
+		v = v->next = ast_variable_new("description", value, "");
+		snprintf(value, sizeof(value), "%d", 60 + cur % 60);
+		v = v->next = ast_variable_new("keepalive", value, "");
+		snprintf(value, sizeof(value), "line, %d", 10000 + cur);
+		v = v->next = ast_variable_new("button", value, "");
+		snprintf(value, sizeof(value), "speeddial, Bench %d, %d", cur, 20000 + cur);
+		v = v->next = ast_variable_new("button", value, "");
+
+		sccp_config_buildjob_t job = {.segment = SCCP_CONFIG_DEVICE_SEGMENT, .v = sections[cur], .nat = SCCP_NAT_AUTO };
+		if (!(job.device = sccp_device_create(name))) {
+			break;
+		}
+		job.name = job.device->id;
+		SCCP_VECTOR_APPEND(&sequential, job);
+		if (!(job.device = sccp_device_create(name))) {
+			break;
+		}
+		job.name = job.device->id;
+		SCCP_VECTOR_APPEND(&parallel, job);
+	}
+
+	pbx_test_status_update(test, "Build sequentially...\n");
+	start = pbx_tvnow();
+	sccp_config_buildJobs(&sequential, FALSE);
+	sequential_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Build on the threadpool...\n");
+	start = pbx_tvnow();
+	sccp_config_buildJobs(&parallel, TRUE);
+	parallel_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+
+	pbx_test_status_update(test, "Compare...\n");
+	pbx_test_validate(test, SCCP_VECTOR_SIZE(&sequential) == (size_t) numDevices && SCCP_VECTOR_SIZE(&parallel) == (size_t) numDevices);
+	for (cur = 0; cur < numDevices && res == AST_TEST_PASS; cur++) {
+		sccp_device_t *seq = SCCP_VECTOR_GET_ADDR(&sequential, cur)->device;
+		sccp_device_t *par = SCCP_VECTOR_GET_ADDR(&parallel, cur)->device;
+
+		if (!seq || !par || !sccp_strequals(seq->description, par->description) || seq->keepalive != par->keepalive || SCCP_LIST_GETSIZE(&seq->buttonconfig) != SCCP_LIST_GETSIZE(&par->buttonconfig) || seq->pendingUpdate != par->pendingUpdate) {
+			pbx_test_status_update(test, "device %d differs\n", cur);
+			res = AST_TEST_FAIL;
+		}
+	}
+	pbx_test_status_update(test, "%d devices: sequential %d ms, parallel %d ms using %d threads\n", numDevices, (int) sequential_ms, (int) parallel_ms, GLOB(general_threadpool) ? sccp_threadpool_thread_count(GLOB(general_threadpool)) : 0);
+
+	for (cur = 0; cur < (int) SCCP_VECTOR_SIZE(&sequential); cur++) {
+		sccp_device_release(&SCCP_VECTOR_GET_ADDR(&sequential, cur)->device);		/* explicit release */
+	}
+	for (cur = 0; cur < (int) SCCP_VECTOR_SIZE(&parallel); cur++) {
+		sccp_device_release(&SCCP_VECTOR_GET_ADDR(&parallel, cur)->device);		/* explicit release */
+	}
+	for (cur = 0; cur < numDevices; cur++) {
+		pbx_variables_destroy(sections[cur]);
+	}
+	SCCP_VECTOR_FREE(&sequential);
+	SCCP_VECTOR_FREE(&parallel);
+	sccp_free(sections);
+
+	return res;
+}
+
+AST_TEST_DEFINE(sccp_config_snapshot)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "snapshot";
+			info->category = "/channels/chan_sccp/config/";
+			info->summary = "chan-sccp-b compiled config snapshot test";
+			info->description = "write generated configs of increasing size, compare the time spent in the text parser against hashing the sources plus mapping their snapshot (the object build that follows either is not included), and verify that outdated or damaged snapshots are rejected";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const int sizes[] = { 100, 1000, 10000 };
+	struct ast_flags config_flags = { 0 };
+	enum ast_test_result_state res = AST_TEST_PASS;
+	char conffile[PATH_MAX], snapfile[PATH_MAX];
+	uint32_t s = 0;
+	int cur = 0;
+
+	snprintf(conffile, sizeof(conffile), "/tmp/sccp_snapshot_test_%d.conf", (int) getpid());
+	snprintf(snapfile, sizeof(snapfile), "%s.snapshot", conffile);
+	for (s = 0; s < ARRAY_LEN(sizes) && res == AST_TEST_PASS; s++) {
+		struct ast_config *parsed = NULL, *mapped = NULL;
+		struct timeval start;
+		int64_t parse_ms = 0, hash_ms = 0, write_ms = 0, read_ms = 0;
+		uint64_t hash = SCCP_CONFIG_HASH_OFFSET, parsedHash = SCCP_CONFIG_HASH_OFFSET, mappedHash = SCCP_CONFIG_HASH_OFFSET;
+		char *cat = NULL;
+		FILE *fp = NULL;
+
+		pbx_test_status_update(test, "Generate config with %d devices and lines...\n", sizes[s]);
+		if (!(fp = fopen(conffile, "w"))) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+		fprintf(fp, "[general]\nservername = snapshot\nkeepalive = 60\n\n[bench_device](!)\ntype = device\ndevicetype = 7960\n\n[bench_line](!)\ntype = line\ncontext = default\n\n");
+		for (cur = 0; cur < sizes[s]; cur++) {
+			fprintf(fp, "[SEPBENCH%06d](bench_device)\ndescription = benchmark device %d\nbutton = line, %d\nbutton = speeddial, Bench %d, %d\n\n", cur, cur, 10000 + cur, cur, 20000 + cur);
+			fprintf(fp, "[%d](bench_line)\nlabel = bench %d\ncid_num = %d\n\n", 10000 + cur, cur, 10000 + cur);
+		}
+		fclose(fp);
+
+		start = pbx_tvnow();
+		parsed = pbx_config_load(conffile, "chan_sccp", config_flags);
+		parse_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+		if (!parsed || parsed == CONFIG_STATUS_FILEMISSING || parsed == CONFIG_STATUS_FILEINVALID) {
+			pbx_test_status_update(test, "unable to parse '%s'\n", conffile);
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		start = pbx_tvnow();
+		if (!sccp_config_hashSourceFile(conffile, &hash, 0)) {
+			res = AST_TEST_FAIL;
+		}
+		hash_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+
+		start = pbx_tvnow();
+		if (res == AST_TEST_PASS && !sccp_config_writeSnapshotFile(parsed, snapfile, hash)) {
+			res = AST_TEST_FAIL;
+		}
+		write_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+
+		start = pbx_tvnow();
+		if (res == AST_TEST_PASS && !(mapped = sccp_config_readSnapshotFile(snapfile, hash))) {
+			res = AST_TEST_FAIL;
+		}
+		read_ms = ast_tvdiff_ms(pbx_tvnow(), start);
+
+		if (mapped) {
+			while ((cat = pbx_category_browse(parsed, cat))) {
+				parsedHash = sccp_config_hashString(parsedHash, cat, '[');
+				parsedHash = (parsedHash ^ sccp_config_hashCategory(ast_variable_browse(parsed, cat))) * SCCP_CONFIG_HASH_PRIME;
+			}
+			while ((cat = pbx_category_browse(mapped, cat))) {
+				mappedHash = sccp_config_hashString(mappedHash, cat, '[');
+				mappedHash = (mappedHash ^ sccp_config_hashCategory(ast_variable_browse(mapped, cat))) * SCCP_CONFIG_HASH_PRIME;
+			}
+			if (parsedHash != mappedHash || ast_variable_browse(mapped, "bench_device") != NULL) {			/* templates are not part of the snapshot */
+				pbx_test_status_update(test, "snapshot of '%s' does not match the parsed config\n", conffile);
+				res = AST_TEST_FAIL;
+			}
+			pbx_config_destroy(mapped);
+		}
+		/* only the parse step is replaced, the object build that follows is the same for both */
+		pbx_test_status_update(test, "%d devices/lines: text parser %d ms, snapshot: hash sources %d ms + map %d ms (written in %d ms)\n", sizes[s], (int) parse_ms, (int) hash_ms, (int) read_ms, (int) write_ms);
+		pbx_config_destroy(parsed);
+	}
+
+	if (res == AST_TEST_PASS) {
+		uint64_t hash = SCCP_CONFIG_HASH_OFFSET;
+		FILE *fp = NULL;
+
+		pbx_test_status_update(test, "Reject outdated snapshot...\n");
+		if (!sccp_config_hashSourceFile(conffile, &hash, 0) || sccp_config_readSnapshotFile(snapfile, hash + 1) != NULL) {
+			res = AST_TEST_FAIL;
+		}
+
+		pbx_test_status_update(test, "Reject damaged snapshot...\n");
+		if ((fp = fopen(snapfile, "r+"))) {
+			fseek(fp, -2, SEEK_END);
+			fputc('X', fp);
+			fclose(fp);
+		}
+		if (sccp_config_readSnapshotFile(snapfile, hash) != NULL) {
+			res = AST_TEST_FAIL;
+		}
+
+		pbx_test_status_update(test, "Refuse #exec...\n");
+		if ((fp = fopen(conffile, "a"))) {
+			fprintf(fp, "#exec /bin/true\n");
+			fclose(fp);
+		}
+		hash = SCCP_CONFIG_HASH_OFFSET;
+		if (sccp_config_hashSourceFile(conffile, &hash, 0)) {
+			res = AST_TEST_FAIL;
+		}
+	}
+	unlink(conffile);
+	unlink(snapfile);
+
+	return res;
+}
+
 AST_TEST_DEFINE(sccp_config_multientry)
 {
 	switch(cmd) {
@@ -3638,6 +5241,11 @@ AST_TEST_DEFINE(sccp_config_setDefault)
 static void __attribute__((constructor)) sccp_register_tests(void)
 {
 	AST_TEST_REGISTER(sccp_config_base_functions);
+	AST_TEST_REGISTER(sccp_config_option_lookup);
+	AST_TEST_REGISTER(sccp_config_category_hash);
+	AST_TEST_REGISTER(sccp_config_metadata_cache);
+	AST_TEST_REGISTER(sccp_config_parallel_build);
+	AST_TEST_REGISTER(sccp_config_snapshot);
 	AST_TEST_REGISTER(sccp_config_multientry);
 	AST_TEST_REGISTER(sccp_config_tokenized_default);
 	//AST_TEST_REGISTER(sccp_config_setValue);
@@ -3647,6 +5255,11 @@ static void __attribute__((constructor)) sccp_register_tests(void)
 static void __attribute__((destructor)) sccp_unregister_tests(void)
 {
 	AST_TEST_UNREGISTER(sccp_config_base_functions);
+	AST_TEST_UNREGISTER(sccp_config_option_lookup);
+	AST_TEST_UNREGISTER(sccp_config_category_hash);
+	AST_TEST_UNREGISTER(sccp_config_metadata_cache);
+	AST_TEST_UNREGISTER(sccp_config_parallel_build);
+	AST_TEST_UNREGISTER(sccp_config_snapshot);
 	AST_TEST_UNREGISTER(sccp_config_multientry);
 	AST_TEST_UNREGISTER(sccp_config_tokenized_default);
 	//AST_TEST_UNREGISTER(sccp_config_setValue);
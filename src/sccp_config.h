@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include "sccp_cli.h"
+
 __BEGIN_C_EXTERN__
 // sccp_buttonconfig_list_t externally declared in sccp_device.h, required by sccp_config_addButton
 extern struct sccp_buttonconfig_list sccp_buttonconfig_list;
@@ -58,6 +60,8 @@ typedef enum {
 } sccp_config_file_status_t;
 
 SCCP_API sccp_config_file_status_t SCCP_CALL sccp_config_getConfig(boolean_t force);
+SCCP_API boolean_t SCCP_CALL sccp_config_readSnapshot(void);
+SCCP_API void SCCP_CALL sccp_config_writeSnapshot(void);
 SCCP_API sccp_configurationchange_t SCCP_CALL sccp_config_applyGlobalConfiguration(PBX_VARIABLE_TYPE * v);
 SCCP_API sccp_configurationchange_t SCCP_CALL sccp_config_applyLineConfiguration(sccp_line_t * l, PBX_VARIABLE_TYPE * v);
 SCCP_API sccp_configurationchange_t SCCP_CALL sccp_config_applyDeviceConfiguration(sccp_device_t * d, PBX_VARIABLE_TYPE * v);
@@ -67,5 +71,8 @@ SCCP_API void SCCP_CALL sccp_config_softKeySet(PBX_VARIABLE_TYPE * variable, con
 SCCP_API void SCCP_CALL sccp_config_restoreDeviceFeatureStatus(sccp_device_t * device);
 
 SCCP_API int SCCP_CALL sccp_config_generate(char *filename, int configType);
+SCCP_API int SCCP_CALL sccp_config_show_reload(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API void SCCP_CALL sccp_config_cleanupReloadReport(void);
+SCCP_API void SCCP_CALL sccp_config_cleanupMetadata(void);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
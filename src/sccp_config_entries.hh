@@ -34,6 +34,18 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 																																					"possible categories:\n"
 																																					"core, hint, rtp, device, line, action, channel, cli, config, feature, feature_button, softkey, indicate, pbx\n"
 																																					"socket, mwi, event, adv_feature, conference, buttontemplate, speeddial, codec, realtime, lock, parkinglot, newcode, high, all, none\n"},
+	{"debug_async",			G_OBJ_REF(debug_async),			TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Hand debug output to a background thread instead of writing it to the asterisk logger from the calling (session) thread.\n"
+																																"Messages are formatted into a per-thread buffer and written out shortly afterwards. When a buffer overflows, messages are dropped and counted (see 'sccp debug').\n"},
+	{"debug_async_memory",		G_OBJ_REF(debug_async_memory),		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"2048",				"Memory budget in KB for the async debug buffers (debug_async). Threads that can not get a buffer within this budget log synchronously.\n"},
+	{"pcap_file",			G_OBJ_REF(pcap_file),			TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccp.pcap",			"File the skinny messages of devices selected with 'sccp capture' are written to (pcap format). A relative path is placed in the asterisk log directory.\n"},
+	{"pcap_filesize",		G_OBJ_REF(pcap_filesize),		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"10240",			"Rotate the capture file (pcap_file) once it grows beyond this size in KB.\n"},
+	{"pcap_files",			G_OBJ_REF(pcap_files),			TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"5",				"Number of rotated capture files to keep (pcap_file.1 ... pcap_file.<n>).\n"},
+	{"callspan_log",		G_OBJ_REF(callspan_log),		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Log the call setup milestones (offhook, first digit, softswitch, call, ring, answer, openreceivechannel, startmedia) of every call on hangup. Aggregates are always available through 'sccp show stats calls'.\n"},
+	{"metrics_file",		G_OBJ_REF(metrics_file),		TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"",				"Write the metrics in prometheus text format to this file every metrics_interval seconds (for the node_exporter textfile collector, use a name ending in .prom). A relative path is placed in the asterisk log directory. Empty disables the dump, 'sccp show metrics' and AMI SCCPShowMetrics always work.\n"},
+	{"metrics_interval",		G_OBJ_REF(metrics_interval),		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"15",				"Seconds between two writes of metrics_file.\n"},
+	{"manager_event_batching",	G_OBJ_REF(manager_event_batching),	TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Hold back the DeviceStatus, PeerStatus, DND and CallForward manager events for manager_event_window ms. Within that window only the last event per device (or device/line) is sent. Leave off if every single event is needed.\n"},
+	{"manager_event_window",	G_OBJ_REF(manager_event_window),	TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"250",				"Milliseconds manager events are held back when manager_event_batching is on.\n"},
+	{"manager_event_summary",	G_OBJ_REF(manager_event_summary),	TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"50",				"When batching, send a single SCCPEventSummary event (with a Count and the list of Objects) instead of the individual events, once an event type/status (for example DeviceStatus REGISTERED) occurs this many times within one window. 0 never summarizes.\n"},
 	{"servername", 			G_OBJ_REF(servername), 			TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_REQUIRED,					SCCP_CONFIG_NOUPDATENEEDED,		"Asterisk",			"show this name on the device registration\n"},
 	{"keepalive", 			G_OBJ_REF(keepalive), 			TYPE_UINT,									SCCP_CONFIG_FLAG_REQUIRED,					SCCP_CONFIG_NEEDDEVICERESET,		"60",				"Phone keep alive message every 60 secs. Used to check the voicemail and keep an open connection between server and phone (nat).\n"
 																										  											"Don't set any lower than 60 seconds.\n"},
@@ -120,6 +132,10 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 #ifdef CS_SCCP_REALTIME
 	{"devicetable", 		G_OBJ_REF(realtimedevicetable), 	TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpdevice",			"datebasetable for devices\n"},
 	{"linetable", 			G_OBJ_REF(realtimelinetable), 		TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"sccpline",			"datebasetable for lines\n"},
+	{"realtime_cache_ttl",		G_OBJ_REF(realtime_cache_ttl),		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"300",				"Seconds a device/line found in the realtime database is cached (0=off)\n"},
+	{"realtime_cache_negative_ttl",	G_OBJ_REF(realtime_cache_negative_ttl),	TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"30",				"Seconds a device/line NOT found in the realtime database is remembered, protects the database against unknown devices (0=off)\n"},
+	{"realtime_cache_size",		G_OBJ_REF(realtime_cache_size),		TYPE_UINT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"4096",				"Maximum number of realtime lookups kept in the cache, the least recently used entry is evicted first (0=no limit)\n"},
+	{"realtime_cache_prefetch",	G_OBJ_REF(realtime_cache_prefetch),	TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Load the complete device and line tables into the realtime cache with one query during (re)load\n"},
 #endif
 	{"meetme", 			G_OBJ_REF(meetme), 			TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"yes",				"enable/disable conferencing via meetme (on/off), make sure you have one of the meetme apps mentioned below activated in module.conf\n"
 																																	"when switching meetme=on it will search for the first of these three possible meetme applications and set these defaults\n"
@@ -162,6 +178,15 @@ static const SCCPConfigOption sccpGlobalConfigOptions[]={
 	{"backoff_time", 		G_OBJ_REF(token_backoff_time),		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"60",				"Time to wait before re-asking to fallback to primairy server (Token Reject Backoff Time)\n"},
 	{"server_priority", 		G_OBJ_REF(server_priority),		TYPE_INT,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"1",				"Server Priority for fallback: 1=Primairy, 2=Secundary, 3=Tertiary etc\n"
 																																					"For active-active (fallback=odd/even) use 1 for both\n"},
+	{"reload_incremental",		G_OBJ_REF(reload_incremental),		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"yes",				"Only re-apply the device and line sections that changed since the last (re)load. Unchanged devices and lines are skipped entirely.\n"
+																																					"Changes to the [general] section and 'sccp reload force' always re-apply everything. Use 'sccp show reload' to see what the last reload changed.\n"},
+	{"config_snapshot",		G_OBJ_REF(config_snapshot),		TYPE_BOOLEAN,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"no",				"Write a compiled snapshot of the validated configuration to the asterisk data directory after each successful (re)load.\n"
+																																					"The next start maps this snapshot instead of running the text parser on sccp.conf, as long as sccp.conf and its #include files did not change (they are still read to check that, not used with #exec).\n"
+																																					"Devices, lines and the other objects are still built from it as usual, so only the parse step is saved.\n"},
+	{"provision_dir",		G_OBJ_REF(provision_dir),		TYPE_STRINGPTR,									SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"",				"Dedicated directory to write the SEP<mac>.cnf.xml file of every configured device to after each (re)load. Only devices whose configuration changed are rewritten.\n"
+																																					"The files only carry the protocol, date format, callmanager address/port and firmware, so do not point this at a tftp root holding hand made files.\n"
+																																					"Files are replaced atomically, the files of devices that are removed from sccp.conf are deleted. Existing files that were not written by chan-sccp-b are never overwritten nor deleted.\n"
+																																					"Empty disables provisioning.\n"},
 //#if defined(CS_EXPERIMENTAL_XML)
 //	{"webdir",			G_OBJ_REF(webdir),			TYPE_PARSER(sccp_config_parse_webdir),						SCCP_CONFIG_FLAG_NONE,						SCCP_CONFIG_NOUPDATENEEDED,		"",				"Directory where xslt stylesheets can be found.\n"},
 //#endif
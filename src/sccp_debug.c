@@ -9,6 +9,7 @@
 #include "config.h"
 #include "common.h"
 #include "sccp_debug.h"
+#include <asterisk/threadstorage.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
 const char *SS_Memory_Allocation_Error = "%s: Memory Allocation Error.\n";
@@ -154,4 +155,670 @@ char *sccp_get_debugcategories(int32_t debugvalue)
 	return res;
 }
 
+/* ============================================================================================================ Scoped Debug == */
+/*!
+ * \brief Scoped Debug Filters
+ *
+ * Debug categories can be enabled for a single device, line or remote ip-address instead of globally. Each session caches the
+ * categories of all filters matching it (sccp_session_updateScope) and its thread publishes a pointer to that cached value
+ * as the current debug scope, which the sccp_log macros check next to GLOB(debug). As long as no filter is defined
+ * (sccp_debug_scoped == 0) sccp_log remains a single check of the global mask.
+ */
+typedef struct sccp_debug_filter sccp_debug_filter_t;
+struct sccp_debug_filter {
+	sccp_debug_scope_t type;
+	int32_t categories;
+	SCCP_LIST_ENTRY (sccp_debug_filter_t) list;
+	char key[INET6_ADDRSTRLEN];
+};
+static SCCP_LIST_HEAD (, sccp_debug_filter_t) sccp_debug_filters;
+AST_MUTEX_DEFINE_STATIC(sccp_debug_filter_lock);
+
+volatile int sccp_debug_scoped = 0;										/*!< number of scoped debug filters */
+static pthread_key_t sccp_debug_scope_key;
+static pthread_once_t sccp_debug_scope_once = PTHREAD_ONCE_INIT;
+
+static void sccp_debug_scope_init(void)
+{
+	pthread_key_create(&sccp_debug_scope_key, NULL);
+}
+
+/*!
+ * \brief Set the debug scope (cached filter categories) of the calling thread
+ * \return previous scope, to be restored by callers that only borrow a scope
+ */
+int32_t *sccp_debug_scope_set(int32_t * scope)
+{
+	int32_t *prev = NULL;
+
+	pthread_once(&sccp_debug_scope_once, sccp_debug_scope_init);
+	prev = pthread_getspecific(sccp_debug_scope_key);
+	pthread_setspecific(sccp_debug_scope_key, scope);
+	return prev;
+}
+
+/*!
+ * \brief Debug categories enabled for the scope of the calling thread
+ */
+int32_t sccp_debug_scope_current(void)
+{
+	int32_t *scope = NULL;
+
+	pthread_once(&sccp_debug_scope_once, sccp_debug_scope_init);
+	scope = pthread_getspecific(sccp_debug_scope_key);
+	return scope ? *scope : 0;
+}
+
+static const char *const sccp_debug_scope_names[] = { "device", "line", "ip" };
+
+const char *sccp_debug_scope2str(sccp_debug_scope_t type)
+{
+	return (uint) type < ARRAY_LEN(sccp_debug_scope_names) ? sccp_debug_scope_names[type] : "";
+}
+
+int sccp_debug_str2scope(const char *str)
+{
+	uint i = 0;
+
+	for (i = 0; str && i < ARRAY_LEN(sccp_debug_scope_names); i++) {
+		if (!strcasecmp(str, sccp_debug_scope_names[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*!
+ * \brief Add / Replace / Remove (categories == 0) a scoped debug filter
+ * \note callers refresh the cached session scopes afterwards (sccp_session_refreshScopes)
+ * \return TRUE when the filter set changed
+ */
+boolean_t sccp_debug_filter_set(sccp_debug_scope_t type, const char *key, int32_t categories)
+{
+	sccp_debug_filter_t *filter = NULL;
+	boolean_t changed = FALSE;
+
+	if (sccp_strlen_zero(key)) {
+		return FALSE;
+	}
+	pbx_mutex_lock(&sccp_debug_filter_lock);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_debug_filters, filter, list) {
+		if (filter->type == type && !strcasecmp(filter->key, key)) {
+			if (categories) {
+				changed = (filter->categories != categories);
+				filter->categories = categories;
+			} else {
+				SCCP_LIST_REMOVE_CURRENT(list);
+				sccp_free(filter);
+				changed = TRUE;
+			}
+			break;
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	if (!filter && categories) {
+		if ((filter = sccp_calloc(sizeof *filter, 1))) {
+			filter->type = type;
+			filter->categories = categories;
+			sccp_copy_string(filter->key, key, sizeof(filter->key));
+			SCCP_LIST_INSERT_TAIL(&sccp_debug_filters, filter, list);
+			changed = TRUE;
+		} else {
+			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		}
+	}
+	sccp_debug_scoped = SCCP_LIST_GETSIZE(&sccp_debug_filters);
+	pbx_mutex_unlock(&sccp_debug_filter_lock);
+	return changed;
+}
+
+/*!
+ * \brief Debug categories enabled for one device id, line name or ip-address
+ */
+int32_t sccp_debug_filter_get(sccp_debug_scope_t type, const char *key)
+{
+	sccp_debug_filter_t *filter = NULL;
+	int32_t categories = 0;
+
+	if (!sccp_debug_scoped || sccp_strlen_zero(key)) {
+		return 0;
+	}
+	pbx_mutex_lock(&sccp_debug_filter_lock);
+	SCCP_LIST_TRAVERSE(&sccp_debug_filters, filter, list) {
+		if (filter->type == type && !strcasecmp(filter->key, key)) {
+			categories = filter->categories;
+			break;
+		}
+	}
+	pbx_mutex_unlock(&sccp_debug_filter_lock);
+	return categories;
+}
+
+int sccp_debug_filter_print(int fd)
+{
+	sccp_debug_filter_t *filter = NULL;
+	char *categories = NULL;
+	int count = 0;
+
+	pbx_mutex_lock(&sccp_debug_filter_lock);
+	SCCP_LIST_TRAVERSE(&sccp_debug_filters, filter, list) {
+		categories = sccp_get_debugcategories(filter->categories);
+		pbx_cli(fd, "  %-6s %-40s (%d) %s\n", sccp_debug_scope2str(filter->type), filter->key, filter->categories, categories ? categories : "");
+		sccp_free(categories);
+		count++;
+	}
+	pbx_mutex_unlock(&sccp_debug_filter_lock);
+	return count;
+}
+
+/* ========================================================================================================= Async Debug Log == */
+/*!
+ * \brief Async Debug Logging
+ *
+ * sccp_log output can be handed to a background thread (debug_async=yes), so that session threads do not block on the asterisk
+ * logger lock. Every thread that logs gets its own single producer / single consumer ring of preformatted records (the arguments
+ * can not be captured as such, as most of them point to device/line/channel data that does not outlive the call). The producer
+ * only touches its own ring, the drainer thread empties all rings every SCCP_LOG_ASYNC_INTERVAL ms (or earlier when a ring is
+ * half full) and writes them to the asterisk logger.
+ *
+ * - rings are allocated within the debug_async_memory budget, threads that do not get one log synchronously
+ * - a full ring drops the record (counted), records longer than SCCP_LOG_ASYNC_RECORD_SIZE are truncated (counted)
+ * - a ring that stayed empty for SCCP_LOG_ASYNC_IDLE drains is reclaimed by the drainer (its owner may have exited, there is no module
+ *   code running at thread exit) and kept on a free list for the next thread, a reclaimed owner simply picks up a new ring
+ * - rings are only freed when async logging is switched off / the module stops, after they have been drained
+ * - order is kept per thread, records of different threads can interleave differently than they were produced
+ */
+#define SCCP_LOG_ASYNC_RECORD_SIZE 384										/* message bytes per record */
+#define SCCP_LOG_ASYNC_RING_SIZE 32										/* records per ring, power of two */
+#define SCCP_LOG_ASYNC_INTERVAL 50										/* drainer interval in ms */
+#define SCCP_LOG_ASYNC_IDLE 100											/* drains without a new record before a ring is reclaimed */
+
+typedef struct sccp_log_record {
+	int level;
+	int line;
+	const char *file;											/* __FILE__ / __PRETTY_FUNCTION__ literals */
+	const char *function;
+	char msg[SCCP_LOG_ASYNC_RECORD_SIZE];
+} sccp_log_record_t;
+
+typedef struct sccp_log_ring sccp_log_ring_t;
+struct sccp_log_ring {
+	volatile int head;											/*!< only advanced by the owning thread */
+	volatile int tail;											/*!< only advanced by the drainer */
+	volatile int serial;											/*!< bumped when reclaimed, the owner only writes while it matches */
+	volatile int busy;											/*!< owner is writing a record */
+	int lastHead;												/*!< drainer only */
+	int idle;												/*!< drainer only, drains without a new record */
+	boolean_t reclaimed;											/*!< drainer only */
+	SCCP_LIST_ENTRY (sccp_log_ring_t) list;
+	sccp_log_record_t records[SCCP_LOG_ASYNC_RING_SIZE];
+};
+
+typedef struct sccp_log_ring_holder {
+	sccp_log_ring_t *ring;
+	int serial;
+	int generation;
+} sccp_log_ring_holder_t;
+
+AST_THREADSTORAGE(sccp_log_ring_threadbuf);									/* freed by the core (ast_free_ptr), the ring itself belongs to the module */
+
+static struct {
+	SCCP_LIST_HEAD (, sccp_log_ring_t) rings;								/* drainer only, also guards wakeup */
+	SCCP_LIST_HEAD (, sccp_log_ring_t) pending;								/* handed out, not yet picked up by the drainer */
+	SCCP_LIST_HEAD (, sccp_log_ring_t) unused;								/* reclaimed, can be handed out again */
+	pthread_t thread;
+	pbx_cond_t wakeup;
+	boolean_t running;
+	volatile int inflight;											/* producers currently inside sccp_log_async */
+	volatile int generation;										/* bumped on stop, invalidates the ring pointers held by threads */
+	volatile int memory;
+	int budget;
+	void (*sink) (const sccp_log_record_t * record);
+	sccp_log_async_stats_t stats;
+} sccp_log_async_state;
+
+volatile int sccp_log_async_active = 0;
+AST_MUTEX_DEFINE_STATIC(sccp_log_async_control_lock);								/* start / stop */
+AST_MUTEX_DEFINE_STATIC(sccp_log_async_atomic_lock);								/* only used by platforms without atomic operations */
+
+static void sccp_log_async_write(const sccp_log_record_t * record)
+{
+	ast_log(record->level, record->file, record->line, record->function, "%s", record->msg);
+}
+
+/*
+ * hand out a reclaimed ring or allocate a new one within the budget, the rings lock is never taken here, the drainer holds it while
+ * writing to the logger
+ */
+static sccp_log_ring_t *sccp_log_async_newRing(void)
+{
+	sccp_log_ring_t *ring = NULL;
+
+	SCCP_LIST_LOCK(&sccp_log_async_state.pending);
+	ring = SCCP_LIST_REMOVE_HEAD(&sccp_log_async_state.unused, list);
+	SCCP_LIST_UNLOCK(&sccp_log_async_state.pending);
+	if (!ring) {
+		if (ATOMIC_INCR(&sccp_log_async_state.memory, (int) sizeof(sccp_log_ring_t), &sccp_log_async_atomic_lock) + (int) sizeof(sccp_log_ring_t) > sccp_log_async_state.budget) {
+			ATOMIC_DECR(&sccp_log_async_state.memory, (int) sizeof(sccp_log_ring_t), &sccp_log_async_atomic_lock);
+			return NULL;
+		}
+		if (!(ring = sccp_calloc(sizeof *ring, 1))) {
+			ATOMIC_DECR(&sccp_log_async_state.memory, (int) sizeof(sccp_log_ring_t), &sccp_log_async_atomic_lock);
+			return NULL;
+		}
+	}
+	ring->lastHead = ring->head;
+	ring->idle = 0;
+	ring->reclaimed = FALSE;
+	SCCP_LIST_LOCK(&sccp_log_async_state.pending);
+	SCCP_LIST_INSERT_TAIL(&sccp_log_async_state.pending, ring, list);
+	SCCP_LIST_UNLOCK(&sccp_log_async_state.pending);
+	return ring;
+}
+
+/* claim the ring held by the calling thread, fails once the drainer reclaimed it */
+static sccp_log_ring_t *sccp_log_async_claimRing(sccp_log_ring_holder_t * holder)
+{
+	sccp_log_ring_t *ring = holder->ring;
+
+	if (!ring || holder->generation != ATOMIC_FETCH(&sccp_log_async_state.generation, &sccp_log_async_atomic_lock)) {
+		return NULL;
+	}
+	ATOMIC_INCR(&ring->busy, 1, &sccp_log_async_atomic_lock);						/* full barrier, pairs with the serial bump in drain */
+	if (ATOMIC_FETCH(&ring->serial, &sccp_log_async_atomic_lock) != holder->serial) {
+		ATOMIC_DECR(&ring->busy, 1, &sccp_log_async_atomic_lock);
+		return NULL;
+	}
+	return ring;
+}
+
+/*!
+ * \brief Queue a log record on the ring of the calling thread (same arguments as pbx_log)
+ * \note called through the sccp_log macros when sccp_log_async_active is set
+ */
+void sccp_log_async(int level, const char *file, int line, const char *function, const char *fmt, ...)
+{
+	sccp_log_ring_holder_t *holder = NULL;
+	sccp_log_ring_t *ring = NULL;
+	va_list ap;
+
+	ATOMIC_INCR(&sccp_log_async_state.inflight, 1, &sccp_log_async_atomic_lock);
+	if (sccp_log_async_active && (holder = ast_threadstorage_get(&sccp_log_ring_threadbuf, sizeof *holder))) {
+		if (!(ring = sccp_log_async_claimRing(holder)) && (holder->ring = sccp_log_async_newRing())) {
+			holder->serial = ATOMIC_FETCH(&holder->ring->serial, &sccp_log_async_atomic_lock);
+			holder->generation = ATOMIC_FETCH(&sccp_log_async_state.generation, &sccp_log_async_atomic_lock);
+			ring = sccp_log_async_claimRing(holder);
+		}
+	}
+	if (ring) {
+		int head = ring->head;
+		int used = head - ATOMIC_FETCH(&ring->tail, &sccp_log_async_atomic_lock);
+
+		if (used >= SCCP_LOG_ASYNC_RING_SIZE) {
+			ATOMIC_INCR(&sccp_log_async_state.stats.dropped, 1, &sccp_log_async_atomic_lock);
+		} else {
+			sccp_log_record_t *record = &ring->records[head & (SCCP_LOG_ASYNC_RING_SIZE - 1)];
+
+			record->level = level;
+			record->file = file;
+			record->line = line;
+			record->function = function;
+			va_start(ap, fmt);
+			if (vsnprintf(record->msg, sizeof(record->msg), fmt, ap) >= (int) sizeof(record->msg)) {
+				ATOMIC_INCR(&sccp_log_async_state.stats.truncated, 1, &sccp_log_async_atomic_lock);
+			}
+			va_end(ap);
+			ATOMIC_INCR(&ring->head, 1, &sccp_log_async_atomic_lock);				/* publish (full barrier) */
+			if (used + 1 >= SCCP_LOG_ASYNC_RING_SIZE / 2) {
+				pbx_cond_signal(&sccp_log_async_state.wakeup);
+			}
+		}
+		ATOMIC_DECR(&ring->busy, 1, &sccp_log_async_atomic_lock);
+		ATOMIC_DECR(&sccp_log_async_state.inflight, 1, &sccp_log_async_atomic_lock);
+		return;
+	}
+	ATOMIC_DECR(&sccp_log_async_state.inflight, 1, &sccp_log_async_atomic_lock);
+
+	/* no ring (budget exhausted / stopping) */
+	char *msg = NULL;
+
+	ATOMIC_INCR(&sccp_log_async_state.stats.synchronous, 1, &sccp_log_async_atomic_lock);
+	va_start(ap, fmt);
+	if (ast_vasprintf(&msg, fmt, ap) >= 0) {
+		ast_log(level, file, line, function, "%s", msg);
+		ast_free(msg);
+	}
+	va_end(ap);
+}
+
+static void sccp_log_async_drainRing(sccp_log_ring_t * ring)
+{
+	int head = ATOMIC_FETCH(&ring->head, &sccp_log_async_atomic_lock);
+
+	while (ring->tail != head) {
+		sccp_log_async_state.sink(&ring->records[ring->tail & (SCCP_LOG_ASYNC_RING_SIZE - 1)]);
+		ATOMIC_INCR(&ring->tail, 1, &sccp_log_async_atomic_lock);					/* release the slot (full barrier) */
+		sccp_log_async_state.stats.written++;
+	}
+}
+
+/* write out everything that was queued, reclaim idle rings (or free all rings when final) */
+static void sccp_log_async_drain(boolean_t final)
+{
+	sccp_log_ring_t *ring = NULL;
+
+	SCCP_LIST_LOCK(&sccp_log_async_state.rings);
+	SCCP_LIST_LOCK(&sccp_log_async_state.pending);						/* lock order: rings, pending */
+	while ((ring = SCCP_LIST_REMOVE_HEAD(&sccp_log_async_state.pending, list))) {
+		SCCP_LIST_INSERT_TAIL(&sccp_log_async_state.rings, ring, list);
+	}
+	SCCP_LIST_UNLOCK(&sccp_log_async_state.pending);
+
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_log_async_state.rings, ring, list) {
+		sccp_log_async_drainRing(ring);
+		if (final) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			ATOMIC_DECR(&sccp_log_async_state.memory, (int) sizeof(sccp_log_ring_t), &sccp_log_async_atomic_lock);
+			sccp_free(ring);
+		} else {
+			if (ring->tail != ring->lastHead) {
+				ring->lastHead = ring->tail;
+				ring->idle = 0;
+			} else if (!ring->reclaimed && ++ring->idle >= SCCP_LOG_ASYNC_IDLE) {
+				ATOMIC_INCR(&ring->serial, 1, &sccp_log_async_atomic_lock);			/* full barrier, the owner can not claim it anymore */
+				ring->reclaimed = TRUE;
+			}
+			if (ring->reclaimed && ATOMIC_FETCH(&ring->busy, &sccp_log_async_atomic_lock) == 0) {
+				sccp_log_async_drainRing(ring);						/* written before the owner noticed */
+				SCCP_LIST_REMOVE_CURRENT(list);
+				SCCP_LIST_LOCK(&sccp_log_async_state.pending);
+				SCCP_LIST_INSERT_TAIL(&sccp_log_async_state.unused, ring, list);
+				SCCP_LIST_UNLOCK(&sccp_log_async_state.pending);
+			}
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	if (final) {
+		SCCP_LIST_LOCK(&sccp_log_async_state.pending);
+		while ((ring = SCCP_LIST_REMOVE_HEAD(&sccp_log_async_state.unused, list))) {
+			ATOMIC_DECR(&sccp_log_async_state.memory, (int) sizeof(sccp_log_ring_t), &sccp_log_async_atomic_lock);
+			sccp_free(ring);
+		}
+		SCCP_LIST_UNLOCK(&sccp_log_async_state.pending);
+	}
+	SCCP_LIST_UNLOCK(&sccp_log_async_state.rings);
+}
+
+static void *sccp_log_async_thread(void *data)
+{
+	struct timespec ts;
+	struct timeval tp;
+
+	while (sccp_log_async_state.running) {
+		sccp_log_async_drain(FALSE);
+
+		SCCP_LIST_LOCK(&sccp_log_async_state.rings);
+		if (sccp_log_async_state.running) {
+			gettimeofday(&tp, NULL);
+			ts.tv_sec = tp.tv_sec;
+			ts.tv_nsec = (tp.tv_usec + SCCP_LOG_ASYNC_INTERVAL * 1000) * 1000;
+			if (ts.tv_nsec >= 1000000000) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+			pbx_cond_timedwait(&sccp_log_async_state.wakeup, &sccp_log_async_state.rings.lock, &ts);
+		}
+		SCCP_LIST_UNLOCK(&sccp_log_async_state.rings);
+	}
+	return NULL;
+}
+
+static boolean_t sccp_log_async_start(void)
+{
+	SCCP_LIST_HEAD_INIT(&sccp_log_async_state.rings);
+	SCCP_LIST_HEAD_INIT(&sccp_log_async_state.pending);
+	SCCP_LIST_HEAD_INIT(&sccp_log_async_state.unused);
+	pbx_cond_init(&sccp_log_async_state.wakeup, NULL);
+	if (!sccp_log_async_state.sink) {
+		sccp_log_async_state.sink = sccp_log_async_write;
+	}
+	sccp_log_async_state.running = TRUE;
+	if (pbx_pthread_create(&sccp_log_async_state.thread, NULL, sccp_log_async_thread, NULL)) {
+		pbx_log(LOG_ERROR, "SCCP: Unable to start async debug log thread, debug output stays synchronous\n");
+		sccp_log_async_state.running = FALSE;
+		pbx_cond_destroy(&sccp_log_async_state.wakeup);
+		SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.unused);
+		SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.pending);
+		SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.rings);
+		return FALSE;
+	}
+	sccp_log_async_active = 1;
+	return TRUE;
+}
+
+static void sccp_log_async_stop(void)
+{
+	sccp_log_async_active = 0;
+	while (ATOMIC_FETCH(&sccp_log_async_state.inflight, &sccp_log_async_atomic_lock) > 0) {				/* wait for producers still writing into a ring */
+		sched_yield();
+	}
+	SCCP_LIST_LOCK(&sccp_log_async_state.rings);
+	sccp_log_async_state.running = FALSE;
+	pbx_cond_signal(&sccp_log_async_state.wakeup);
+	SCCP_LIST_UNLOCK(&sccp_log_async_state.rings);
+	pthread_join(sccp_log_async_state.thread, NULL);
+
+	sccp_log_async_drain(TRUE);
+	ATOMIC_INCR(&sccp_log_async_state.generation, 1, &sccp_log_async_atomic_lock);
+	pbx_cond_destroy(&sccp_log_async_state.wakeup);
+	SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.unused);
+	SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.pending);
+	SCCP_LIST_HEAD_DESTROY(&sccp_log_async_state.rings);
+}
+
+/*!
+ * \brief Enable / Disable async debug logging (debug_async / debug_async_memory), called after (re)loading [general]
+ */
+void sccp_log_async_configure(boolean_t enable, uint budget_kb)
+{
+	pbx_mutex_lock(&sccp_log_async_control_lock);
+	sccp_log_async_state.budget = (int) budget_kb * 1024;
+	if (enable && !sccp_log_async_state.running) {
+		sccp_log_async_start();
+	} else if (!enable && sccp_log_async_state.running) {
+		sccp_log_async_stop();
+	}
+	pbx_mutex_unlock(&sccp_log_async_control_lock);
+}
+
+void sccp_log_async_module_stop(void)
+{
+	sccp_log_async_configure(FALSE, 0);
+}
+
+void sccp_log_async_getStats(sccp_log_async_stats_t * stats)
+{
+	pbx_mutex_lock(&sccp_log_async_control_lock);
+	*stats = sccp_log_async_state.stats;
+	stats->rings = sccp_log_async_state.running ? (int) SCCP_LIST_GETSIZE(&sccp_log_async_state.rings) : 0;
+	stats->memory = sccp_log_async_state.memory;
+	pbx_mutex_unlock(&sccp_log_async_control_lock);
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define SCCP_LOG_ASYNC_TEST_THREADS 4
+#define SCCP_LOG_ASYNC_TEST_RECORDS 5000
+static struct {
+	int written;
+	int outoforder;
+	int last[SCCP_LOG_ASYNC_TEST_THREADS];
+} sccp_log_async_test;
+
+static void sccp_log_async_testSink(const sccp_log_record_t * record)
+{
+	int thread = 0, seq = 0;
+
+	if (sscanf(record->msg, "%d:%d", &thread, &seq) == 2 && thread >= 0 && thread < SCCP_LOG_ASYNC_TEST_THREADS) {
+		if (seq <= sccp_log_async_test.last[thread]) {
+			sccp_log_async_test.outoforder++;
+		}
+		sccp_log_async_test.last[thread] = seq;
+	}
+	sccp_log_async_test.written++;
+}
+
+static void *sccp_log_async_testThread(void *data)
+{
+	int thread = (int) (intptr_t) data;
+	int seq = 0;
+
+	for (seq = 1; seq <= SCCP_LOG_ASYNC_TEST_RECORDS; seq++) {
+		sccp_log_async(__LOG_VERBOSE, _B_, "%d:%d\n", thread, seq);
+		if (seq % (SCCP_LOG_ASYNC_RING_SIZE / 2) == 0) {
+			usleep(1000);
+		}
+	}
+	return NULL;
+}
+
+AST_TEST_DEFINE(sccp_log_async_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "async";
+			info->category = "/channels/chan_sccp/debug/";
+			info->summary = "chan-sccp-b async debug log test";
+			info->description = "per thread rings, drainer, drop counters and memory budget";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pthread_t threads[SCCP_LOG_ASYNC_TEST_THREADS];
+	sccp_log_async_stats_t before, after;
+	int thread = 0;
+	int res = AST_TEST_PASS;
+
+	sccp_log_async_configure(FALSE, 0);
+	memset(&sccp_log_async_test, 0, sizeof(sccp_log_async_test));
+	sccp_log_async_state.sink = sccp_log_async_testSink;
+	sccp_log_async_getStats(&before);
+
+	pbx_test_status_update(test, "%d threads logging %d records each...\n", SCCP_LOG_ASYNC_TEST_THREADS, SCCP_LOG_ASYNC_TEST_RECORDS);
+	sccp_log_async_configure(TRUE, 1024);
+	for (thread = 0; thread < SCCP_LOG_ASYNC_TEST_THREADS; thread++) {
+		pbx_pthread_create(&threads[thread], NULL, sccp_log_async_testThread, (void *) (intptr_t) thread);
+	}
+	for (thread = 0; thread < SCCP_LOG_ASYNC_TEST_THREADS; thread++) {
+		pthread_join(threads[thread], NULL);
+	}
+	sccp_log_async_configure(FALSE, 0);
+	sccp_log_async_getStats(&after);
+	pbx_test_status_update(test, "written:%d, dropped:%d, synchronous:%d\n", sccp_log_async_test.written, after.dropped - before.dropped, after.synchronous - before.synchronous);
+
+	if (sccp_log_async_test.written + (after.dropped - before.dropped) + (after.synchronous - before.synchronous) != SCCP_LOG_ASYNC_TEST_THREADS * SCCP_LOG_ASYNC_TEST_RECORDS) {
+		pbx_test_status_update(test, "records got lost\n");
+		res = AST_TEST_FAIL;
+	}
+	if (sccp_log_async_test.outoforder) {
+		pbx_test_status_update(test, "%d records out of order\n", sccp_log_async_test.outoforder);
+		res = AST_TEST_FAIL;
+	}
+	if (after.memory != 0) {
+		pbx_test_status_update(test, "%d bytes of rings left after stop\n", after.memory);
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "no budget -> synchronous...\n");
+	sccp_log_async_configure(TRUE, 0);
+	sccp_log_async_getStats(&before);
+	sccp_log_async(__LOG_VERBOSE, _B_, "SCCP: async debug log test, written synchronously\n");
+	sccp_log_async_getStats(&after);
+	sccp_log_async_configure(FALSE, 0);
+	if (after.synchronous - before.synchronous != 1 || after.rings != 0) {
+		res = AST_TEST_FAIL;
+	}
+
+	sccp_log_async_state.sink = sccp_log_async_write;
+	sccp_log_async_configure(GLOB(debug_async), GLOB(debug_async_memory));
+	return res;
+}
+
+AST_TEST_DEFINE(sccp_debug_filter_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "filter";
+			info->category = "/channels/chan_sccp/debug/";
+			info->summary = "chan-sccp-b scoped debug test";
+			info->description = "per device / line / ip debug filters and thread scopes";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	int32_t global_debug = GLOB(debug);
+	int32_t scope = 0;
+	int32_t *prev_scope = NULL;
+	int res = AST_TEST_PASS;
+
+	/* the filters and GLOB(debug) are live, failures are only recorded so that both are always restored */
+	GLOB(debug) = DEBUGCAT_CORE;
+	pbx_test_status_update(test, "filters...\n");
+	if (!sccp_debug_filter_set(SCCP_DEBUG_SCOPE_DEVICE, "SEPTEST00000001", DEBUGCAT_MESSAGE | DEBUGCAT_DEVICE)
+	    || sccp_debug_filter_set(SCCP_DEBUG_SCOPE_DEVICE, "SEPTEST00000001", DEBUGCAT_MESSAGE | DEBUGCAT_DEVICE)
+	    || !sccp_debug_filter_set(SCCP_DEBUG_SCOPE_LINE, "98099", DEBUGCAT_LINE)
+	    || sccp_debug_scoped < 2
+	    || sccp_debug_filter_get(SCCP_DEBUG_SCOPE_DEVICE, "septest00000001") != (DEBUGCAT_MESSAGE | DEBUGCAT_DEVICE)
+	    || sccp_debug_filter_get(SCCP_DEBUG_SCOPE_LINE, "SEPTEST00000001") != 0
+	    || sccp_debug_filter_get(SCCP_DEBUG_SCOPE_IP, "192.0.2.1") != 0) {
+		pbx_test_status_update(test, "filter set/get failed\n");
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "thread scope...\n");
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {
+		res = AST_TEST_FAIL;
+	}
+	scope = sccp_debug_filter_get(SCCP_DEBUG_SCOPE_DEVICE, "SEPTEST00000001") | sccp_debug_filter_get(SCCP_DEBUG_SCOPE_LINE, "98099");
+	prev_scope = sccp_debug_scope_set(&scope);
+	if (!sccp_debug_enabled(DEBUGCAT_MESSAGE) || !sccp_debug_enabled(DEBUGCAT_LINE) || !sccp_debug_enabled(DEBUGCAT_CORE) || sccp_debug_enabled(DEBUGCAT_RTP)) {
+		pbx_test_status_update(test, "thread scope not applied\n");
+		res = AST_TEST_FAIL;
+	}
+	sccp_debug_scope_set(prev_scope);
+	if (sccp_debug_enabled(DEBUGCAT_MESSAGE)) {
+		pbx_test_status_update(test, "thread scope not restored\n");
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "removal...\n");
+	if (!sccp_debug_filter_set(SCCP_DEBUG_SCOPE_DEVICE, "SEPTEST00000001", 0)) {
+		res = AST_TEST_FAIL;
+	}
+	if (!sccp_debug_filter_set(SCCP_DEBUG_SCOPE_LINE, "98099", 0)) {
+		res = AST_TEST_FAIL;
+	}
+	if (sccp_debug_filter_get(SCCP_DEBUG_SCOPE_DEVICE, "SEPTEST00000001") != 0) {
+		res = AST_TEST_FAIL;
+	}
+
+	GLOB(debug) = global_debug;
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_debug_filter_tests);
+	AST_TEST_REGISTER(sccp_log_async_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_debug_filter_tests);
+	AST_TEST_UNREGISTER(sccp_log_async_tests);
+}
+#endif
+
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -18,15 +18,23 @@
 #define __LOG_VERBOSE    2
 #define NO_FILE_LINE_FUNC_DEBUG      __LOG_VERBOSE, _B_
 
+#define __sccp_log_write(...) {									\
+	if (sccp_log_async_active) {								\
+		sccp_log_async(__VA_ARGS__);							\
+	} else {										\
+		pbx_log(__VA_ARGS__);								\
+	}											\
+}
 #define sccp_log1(...) {									\
 	if ((sccp_globals->debug & (DEBUGCAT_FILELINEFUNC)) == DEBUGCAT_FILELINEFUNC) {		\
-		pbx_log(AST_LOG_NOTICE, __VA_ARGS__);						\
+		__sccp_log_write(AST_LOG_NOTICE, __VA_ARGS__);					\
 	} else {										\
-		pbx_log(NO_FILE_LINE_FUNC_DEBUG, __VA_ARGS__);					\
+		__sccp_log_write(NO_FILE_LINE_FUNC_DEBUG, __VA_ARGS__);				\
 	}											\
 }
-#define sccp_log(_x) if ((sccp_globals->debug & (_x))) sccp_log1
-#define sccp_log_and(_x) if ((sccp_globals->debug & (_x)) == (_x)) sccp_log1
+#define sccp_debug_enabled(_x) ((sccp_globals->debug & (_x)) || (sccp_debug_scoped && (sccp_debug_scope_current() & (_x))))
+#define sccp_log(_x) if (sccp_debug_enabled(_x)) sccp_log1
+#define sccp_log_and(_x) if ((sccp_globals->debug & (_x)) == (_x) || (sccp_debug_scoped && (sccp_debug_scope_current() & (_x)) == (_x))) sccp_log1
 
 __BEGIN_C_EXTERN__
 extern const char *SS_Memory_Allocation_Error;
@@ -79,5 +87,41 @@ extern const struct sccp_debug_category sccp_debug_categories[32];
 
 SCCP_API int32_t SCCP_CALL sccp_parse_debugline(char *arguments[], int startat, int argc, int32_t new_debug_value);
 SCCP_API char * SCCP_CALL sccp_get_debugcategories(int32_t debugvalue);
+
+/*!
+ * \brief Async Debug Log Statistics
+ */
+typedef struct sccp_log_async_stats {
+	int rings;												/*!< threads owning a buffer */
+	int memory;												/*!< bytes in use by the buffers */
+	int written;												/*!< records handed to the asterisk logger */
+	int dropped;												/*!< records lost because a buffer was full */
+	int truncated;												/*!< records cut off at SCCP_LOG_ASYNC_RECORD_SIZE */
+	int synchronous;											/*!< records written from the calling thread (no buffer within budget) */
+} sccp_log_async_stats_t;
+
+/*!
+ * \brief Scoped Debug Filter Type
+ */
+typedef enum {
+	SCCP_DEBUG_SCOPE_DEVICE,
+	SCCP_DEBUG_SCOPE_LINE,
+	SCCP_DEBUG_SCOPE_IP,
+} sccp_debug_scope_t;
+
+extern volatile int sccp_debug_scoped;
+SCCP_API int32_t SCCP_CALL sccp_debug_scope_current(void);
+SCCP_API int32_t * SCCP_CALL sccp_debug_scope_set(int32_t * scope);
+SCCP_API boolean_t SCCP_CALL sccp_debug_filter_set(sccp_debug_scope_t type, const char *key, int32_t categories);
+SCCP_API int32_t SCCP_CALL sccp_debug_filter_get(sccp_debug_scope_t type, const char *key);
+SCCP_API int SCCP_CALL sccp_debug_filter_print(int fd);
+SCCP_API const char * SCCP_CALL sccp_debug_scope2str(sccp_debug_scope_t type);
+SCCP_API int SCCP_CALL sccp_debug_str2scope(const char *str);
+
+extern volatile int sccp_log_async_active;
+SCCP_API void SCCP_CALL sccp_log_async(int level, const char *file, int line, const char *function, const char *fmt, ...) __attribute__ ((format(printf, 5, 6)));
+SCCP_API void SCCP_CALL sccp_log_async_configure(boolean_t enable, uint budget_kb);
+SCCP_API void SCCP_CALL sccp_log_async_module_stop(void);
+SCCP_API void SCCP_CALL sccp_log_async_getStats(sccp_log_async_stats_t * stats);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -31,6 +31,9 @@
 #include "sccp_devstate.h"
 #include "sccp_featureParkingLot.h"
 #include "sccp_labels.h"
+#include "sccp_realtime.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_stats.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
@@ -1246,8 +1249,12 @@ int sccp_dev_send(constDevicePtr d, sccp_msg_t * msg)
 	int result = -1;
 
 	if (d && d->session && msg) {
-		sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Send message %s\n", d->id, msgtype2str(letohl(msg->header.lel_messageId)));
+		sccp_mid_t mid = letohl(msg->header.lel_messageId);
+		struct timeval start = pbx_tvnow();
+
+		sccp_log((DEBUGCAT_MESSAGE)) (VERBOSE_PREFIX_3 "%s: >> Send message %s\n", d->id, msgtype2str(mid));
 		result = sccp_session_send(d, msg);
+		sccp_stats_message(SCCP_STATS_OUTBOUND, mid, &start);
 	} else {
 		sccp_free(msg);
 	}
@@ -1833,6 +1840,136 @@ void sccp_dev_displayprinotify_debug(constDevicePtr d, const char *msg, const sc
 	sccp_log((DEBUGCAT_DEVICE)) (VERBOSE_PREFIX_3 "%s: Display notify with timeout %d and priority %d\n", d->id, timeout, priority);
 }
 
+/*!
+ * \brief (Re)Build the Button Instances Array of a Device
+ * \param d SCCP Device
+ *
+ * \note called when all button instances have been assigned (button template request), replaces the previous array under the buttonconfig lock
+ */
+void sccp_dev_createButtonInstancesArray(devicePtr d)
+{
+	sccp_buttonconfig_t *config = NULL;
+	sccp_buttoninstance_t *instances = NULL, *previous = NULL;
+	uint16_t size = 0;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+		if (config->instance >= size) {
+			size = config->instance + 1;
+		}
+	}
+	if (size && !(instances = sccp_calloc(size, sizeof(sccp_buttoninstance_t)))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, d->id);
+		size = 0;
+	}
+	if (instances) {
+		SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+			sccp_buttoninstance_t *slot = &instances[config->instance];
+
+			if (!config->instance) {
+				continue;
+			}
+			switch (config->type) {
+				case LINE:
+					if (!slot->line) {
+						slot->line = config;
+					}
+					break;
+				case SPEEDDIAL:
+					if (sccp_strlen_zero(config->button.speeddial.hint)) {				/* the last one wins, like the former list walk */
+						slot->speeddial = config;
+					} else {
+						slot->speeddialHint = config;
+					}
+					break;
+				case FEATURE:
+					if (!slot->feature) {
+						slot->feature = config;
+					}
+					break;
+				case SERVICE:
+					if (!slot->service) {
+						slot->service = config;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+	}
+	previous = d->buttonInstances.instance;
+	d->buttonInstances.instance = instances;
+	d->buttonInstances.size = size;
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+
+	if (previous) {
+		sccp_free(previous);
+	}
+	sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: Button instances array created (size:%d)\n", d->id, size);
+}
+
+/*!
+ * \brief Delete the Button Instances Array of a Device
+ * \param d SCCP Device
+ */
+void sccp_dev_deleteButtonInstancesArray(devicePtr d)
+{
+	sccp_buttoninstance_t *previous = NULL;
+
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	previous = d->buttonInstances.instance;
+	d->buttonInstances.instance = NULL;
+	d->buttonInstances.size = 0;
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+
+	if (previous) {
+		sccp_free(previous);
+	}
+}
+
+/*!
+ * \brief Find ButtonConfig by Instance and Type
+ * \param d SCCP Device
+ * \param type Button Type
+ * \param instance Instance as uint16_t
+ * \return SCCP ButtonConfig (can be null)
+ *
+ * \note d->buttonconfig should be locked by the caller, for as long as the result is used
+ */
+sccp_buttonconfig_t *sccp_dev_buttonconfig_find_byinstance(constDevicePtr d, const sccp_config_buttontype_t type, const uint16_t instance)
+{
+	const sccp_buttoninstance_t *slot = NULL;
+
+	if (!d || !instance || instance >= d->buttonInstances.size) {
+		return NULL;
+	}
+	slot = &d->buttonInstances.instance[instance];
+	switch (type) {
+		case LINE:
+			return slot->line;
+		case SPEEDDIAL:
+			return slot->speeddial ? slot->speeddial : slot->speeddialHint;
+		case FEATURE:
+			return slot->feature;
+		case SERVICE:
+			return slot->service;
+		default:
+			return NULL;
+	}
+}
+
+/* call with d->buttonconfig locked */
+static sccp_buttonconfig_t *sccp_dev_speeddial_find_byinstance(constDevicePtr d, const uint16_t instance, boolean_t withHint)
+{
+	const sccp_buttoninstance_t *slot = NULL;
+
+	if (!instance || instance >= d->buttonInstances.size) {
+		return NULL;
+	}
+	slot = &d->buttonInstances.instance[instance];
+	return withHint ? slot->speeddialHint : slot->speeddial;
+}
+
 /*!
  * \brief Find SpeedDial by Index
  * \param d SCCP Device
@@ -1853,24 +1990,14 @@ void sccp_dev_speed_find_byindex(constDevicePtr d, const uint16_t instance, bool
 	sccp_copy_string(k->name, "unknown speeddial", sizeof(k->name));
 
 	SCCP_LIST_LOCK(&(((devicePtr)d)->buttonconfig));
-	SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
-		if (config->type == SPEEDDIAL && config->instance == instance) {
-			/* we are searching for hinted speeddials */
-			if (TRUE == withHint && !sccp_strlen_zero(config->button.speeddial.hint)) {
-				k->valid = TRUE;
-				k->instance = instance;
-				k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
-				sccp_copy_string(k->name, config->label, sizeof(k->name));
-				sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
-				sccp_copy_string(k->hint, config->button.speeddial.hint, sizeof(k->hint));
-				
-			} else if(FALSE == withHint && sccp_strlen_zero(config->button.speeddial.hint)) {
-				k->valid = TRUE;
-				k->instance = instance;
-				k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
-				sccp_copy_string(k->name, config->label, sizeof(k->name));
-				sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
-			}
+	if ((config = sccp_dev_speeddial_find_byinstance(d, instance, withHint))) {
+		k->valid = TRUE;
+		k->instance = instance;
+		k->type = SCCP_BUTTONTYPE_SPEEDDIAL;
+		sccp_copy_string(k->name, config->label, sizeof(k->name));
+		sccp_copy_string(k->ext, config->button.speeddial.ext, sizeof(k->ext));
+		if (withHint) {
+			sccp_copy_string(k->hint, config->button.speeddial.hint, sizeof(k->hint));
 		}
 	}
 	SCCP_LIST_UNLOCK(&(((devicePtr)d)->buttonconfig));
@@ -2378,6 +2505,10 @@ void _sccp_dev_clean(devicePtr device, boolean_t remove_from_global, boolean_t r
 #endif
 			}
 		}
+		if (d->buttonInstances.instance) {							/* instances are reset below, the instance index goes with them */
+			sccp_free(d->buttonInstances.instance);
+			d->buttonInstances.size = 0;
+		}
 		SCCP_LIST_TRAVERSE_SAFE_BEGIN(&d->buttonconfig, config, list) {
 			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_2 "%s: checking buttonconfig for pendingDelete (index:%d, type:%s (%d), pendingDelete:%s, pendingUpdate:%s)\n",
 				d->id, config->index, sccp_config_buttontype2str(config->type), config->type, config->pendingDelete ? "True" : "False", config->pendingUpdate ? "True" : "False");
@@ -2436,6 +2567,7 @@ void _sccp_dev_clean(devicePtr device, boolean_t remove_from_global, boolean_t r
 			sccp_free(d->buttonTemplate);
 			d->buttonTemplate = NULL;
 		}
+		sccp_buttontemplate_setDeviceTemplate(d, NULL);
 
 		if (device->lineButtons.size) {
 			sccp_line_deleteLineButtonsArray(d);
@@ -2504,6 +2636,7 @@ int __sccp_device_destroy(const void *ptr)
 	// clean button config (only generated on read config, so do not remove during device clean)
 	{
 		sccp_buttonconfig_t *config = NULL;
+		sccp_dev_deleteButtonInstancesArray(d);
 		SCCP_LIST_LOCK(&d->buttonconfig);
 		while ((config = SCCP_LIST_REMOVE_HEAD(&d->buttonconfig, list))) {
 			sccp_buttonconfig_destroy(config);
@@ -2662,13 +2795,8 @@ sccp_buttonconfig_t *sccp_dev_serviceURL_find_byindex(devicePtr device, uint16_t
 	}
 	sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: searching for service with instance %d\n", device->id, instance);
 	SCCP_LIST_LOCK(&device->buttonconfig);
-	SCCP_LIST_TRAVERSE(&device->buttonconfig, config, list) {
-		sccp_log_and((DEBUGCAT_DEVICE + DEBUGCAT_HIGH)) (VERBOSE_PREFIX_3 "%s: instance: %d buttontype: %d\n", device->id, config->instance, config->type);
-
-		if (config->type == SERVICE && config->instance == instance) {
-			sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: found service: %s\n", device->id, config->label);
-			break;
-		}
+	if ((config = sccp_dev_buttonconfig_find_byinstance(device, SERVICE, instance))) {
+		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_BUTTONTEMPLATE)) (VERBOSE_PREFIX_3 "%s: found service: %s\n", device->id, config->label);
 	}
 	SCCP_LIST_UNLOCK(&device->buttonconfig);
 
@@ -3313,13 +3441,14 @@ sccp_device_t *sccp_device_find_realtime(const char *name)
 	if (sccp_strlen_zero(GLOB(realtimedevicetable)) || sccp_strlen_zero(name)) {
 		return NULL;
 	}
-	if ((variable = pbx_load_realtime(GLOB(realtimedevicetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(GLOB(realtimedevicetable), name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_DEVICE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Device '%s' found in realtime table '%s'\n", name, GLOB(realtimedevicetable));
 
 		d = sccp_device_create(name);		/** create new device */
 		if (!d) {
 			pbx_log(LOG_ERROR, "SCCP: Unable to build realtime device '%s'\n", name);
+			pbx_variables_destroy(v);
 			return NULL;
 		}
 		// sccp_copy_string(d->id, name, sizeof(d->id));
@@ -3355,4 +3484,83 @@ void sccp_device_setLamp(constDevicePtr device, skinny_stimulus_t stimulus, uint
 	}
 }
 
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+static sccp_buttonconfig_t *sccp_device_testSpeeddial(sccp_device_t * d, uint16_t instance, char *label, char *ext, char *hint)
+{
+	sccp_buttonconfig_t *config = sccp_calloc(sizeof *config, 1);
+
+	if (config) {
+		config->type = SPEEDDIAL;
+		config->instance = instance;
+		config->label = label;
+		config->button.speeddial.ext = ext;
+		config->button.speeddial.hint = hint;
+		SCCP_LIST_INSERT_TAIL(&d->buttonconfig, config, list);
+	}
+	return config;
+}
+
+AST_TEST_DEFINE(sccp_device_buttoninstance_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "buttoninstances";
+			info->category = "/channels/chan_sccp/device/";
+			info->summary = "chan-sccp-b button instance index";
+			info->description = "hinted and plain speeddials sharing an instance number are both found by the instance index";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	sccp_device_t device;
+	sccp_device_t *d = &device;
+	sccp_buttonconfig_t *config = NULL;
+	sccp_buttonconfig_t *hinted = NULL, *plain = NULL, *other = NULL;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	memset(d, 0, sizeof *d);
+	sccp_copy_string(d->id, "SEPTEST00001", sizeof(d->id));
+	SCCP_LIST_HEAD_INIT(&d->buttonconfig);
+	hinted = sccp_device_testSpeeddial(d, 2, "Reception", "100", "100@hints");				/* numbered like a line */
+	plain = sccp_device_testSpeeddial(d, 2, "Voicemail", "*97", "");					/* numbered like a speeddial */
+	other = sccp_device_testSpeeddial(d, 3, "Lobby", "101", "101@hints");
+	sccp_dev_createButtonInstancesArray(d);
+
+	pbx_test_status_update(test, "hinted and plain speeddial on instance 2...\n");
+	SCCP_LIST_LOCK(&d->buttonconfig);
+	if (!hinted || !plain || !other) {
+		res = AST_TEST_FAIL;
+	} else if (sccp_dev_speeddial_find_byinstance(d, 2, TRUE) != hinted || sccp_dev_speeddial_find_byinstance(d, 2, FALSE) != plain) {
+		pbx_test_status_update(test, "instance 2 lookup returned the wrong button\n");
+		res = AST_TEST_FAIL;
+	} else if (sccp_dev_speeddial_find_byinstance(d, 3, TRUE) != other || sccp_dev_speeddial_find_byinstance(d, 3, FALSE)) {
+		pbx_test_status_update(test, "instance 3 lookup returned the wrong button\n");
+		res = AST_TEST_FAIL;
+	} else if (sccp_dev_speeddial_find_byinstance(d, 1, TRUE) || sccp_dev_speeddial_find_byinstance(d, 4, FALSE)) {
+		pbx_test_status_update(test, "unused instances returned a button\n");
+		res = AST_TEST_FAIL;
+	}
+	SCCP_LIST_UNLOCK(&d->buttonconfig);
+
+	sccp_dev_deleteButtonInstancesArray(d);
+	while ((config = SCCP_LIST_REMOVE_HEAD(&d->buttonconfig, list))) {
+		sccp_free(config);
+	}
+	SCCP_LIST_HEAD_DESTROY(&d->buttonconfig);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_device_buttoninstance_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_device_buttoninstance_tests);
+}
+#endif
+
 // kate: indent-width 4; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets on;
@@ -73,6 +73,19 @@ struct sccp_buttonconfig {
 };														/*!< SCCP Button Configuration Structure */
 
 SCCP_LIST_HEAD (sccp_buttonconfig_list, sccp_buttonconfig_t);
+
+/*!
+ * \brief SCCP Button Instance Structure, the buttonconfig using an instance for each button type (instances are shared between types)
+ * \note hinted speeddials may be numbered like lines (protocol < 15 / no CS_DYNAMIC_SPEEDDIAL) and plain ones like speeddials, so both can use the same instance
+ */
+typedef struct sccp_buttoninstance {
+	sccp_buttonconfig_t *line;
+	sccp_buttonconfig_t *speeddial;										/*!< speeddial without hint */
+	sccp_buttonconfig_t *speeddialHint;									/*!< speeddial with hint */
+	sccp_buttonconfig_t *feature;
+	sccp_buttonconfig_t *service;
+} sccp_buttoninstance_t;
+
 /*!
  * \brief SCCP SpeedDial Button Structure
  * \todo replace ext/hint with charptr (save 80)
@@ -181,6 +194,11 @@ struct sccp_device {
 		uint8_t size;
 	} lineButtons;
 
+	struct {
+		sccp_buttoninstance_t *instance;								/*!< indexed by instance, only valid under the buttonconfig lock */
+		uint16_t size;
+	} buttonInstances;
+
 	//SCCP_LIST_HEAD (, sccp_buttonconfig_t) buttonconfig;							/*!< SCCP Button Config Attached to this Device */
 	sccp_buttonconfig_list_t buttonconfig;									/*!< SCCP Button Config Attached to this Device */
 	SCCP_LIST_HEAD (, sccp_selectedchannel_t) selectedChannels;						/*!< Selected Channel List */
@@ -282,6 +300,7 @@ struct sccp_device {
 	boolean_t isAnonymous;											/*!< Device is connected Anonymously (Guest) */
 
 	btnlist *buttonTemplate;
+	sccp_buttontemplate_t *buttonTemplateCache;								/*!< shared template this device registered with (retained) */
 
 	struct {
 		char *action;
@@ -342,6 +361,7 @@ struct sccp_device {
 #endif
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this will contain the updated line struct once reloaded from config to update the line when unused */
+	uint64_t configHash;											/*!< content hash of the device section in sccp.conf, used by incremental reload */
 };
 
 // Number of additional keys per addon -FS
@@ -433,6 +453,9 @@ SCCP_API void SCCP_CALL sccp_dev_displayprinotify_debug(constDevicePtr d, const
 SCCP_API void SCCP_CALL sccp_dev_cleardisplaynotify(constDevicePtr d);
 SCCP_API void SCCP_CALL sccp_dev_cleardisplayprinotify(constDevicePtr d, const uint8_t priority);
 SCCP_API void SCCP_CALL sccp_dev_speed_find_byindex(constDevicePtr d, const uint16_t instance, boolean_t withHint, sccp_speed_t * const k);
+SCCP_API void SCCP_CALL sccp_dev_createButtonInstancesArray(devicePtr d);
+SCCP_API void SCCP_CALL sccp_dev_deleteButtonInstancesArray(devicePtr d);
+SCCP_API sccp_buttonconfig_t * SCCP_CALL sccp_dev_buttonconfig_find_byinstance(constDevicePtr d, const sccp_config_buttontype_t type, const uint16_t instance);
 SCCP_API void SCCP_CALL sccp_dev_forward_status(constLinePtr l, uint8_t lineInstance, constDevicePtr device);
 SCCP_API void SCCP_CALL sccp_dev_postregistration(void *data);
 SCCP_API void SCCP_CALL _sccp_dev_clean(devicePtr device, boolean_t remove_from_global, boolean_t restart_device);
@@ -11,6 +11,8 @@
 #include "common.h"
 #include "sccp_device.h"
 #include "sccp_devstate.h"
+#include "sccp_atomic.h"
+#include "sccp_threadpool.h"
 #include "sccp_utils.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -29,6 +31,8 @@ struct sccp_devstate_SubscribingDevice
 	sccp_buttonconfig_t *buttonConfig;
 	char label[StationMaxNameSize];
 	uint8_t instance;											/*!< Instance */
+	uint32_t notifiedState;											/*!< featureState last sent to the device */
+	sccp_msg_t *payload[2];											/*!< precomputed FeatureStat(Dynamic)Message per featureState */
 };
 
 typedef struct sccp_devstate_deviceState sccp_devstate_deviceState_t;
@@ -36,12 +40,16 @@ struct sccp_devstate_deviceState
 {
 	SCCP_LIST_HEAD (, sccp_devstate_SubscribingDevice_t) subscribers;
 	SCCP_LIST_ENTRY (struct sccp_devstate_deviceState) list;
+	sccp_devstate_deviceState_t *hashnext;									/*!< next deviceState in deviceStateIndex bucket */
 	char devicestate[StationMaxNameSize];
 	PBX_EVENT_SUBSCRIPTION *sub;
 	uint32_t featureState;
+	boolean_t notifyScheduled;										/*!< notification batch pending, protected by subscribers lock */
 };
 
 static SCCP_LIST_HEAD (, struct sccp_devstate_deviceState) deviceStates;
+static sccp_devstate_deviceState_t *deviceStateIndex[SCCP_HASH_PRIME];					/* devstate name -> deviceState, protected by deviceStates lock */
+static volatile int sccp_devstate_pendingNotifications;							/* notification batches handed to the threadpool */
 
 void sccp_devstate_deviceRegisterListener(const sccp_event_t * event);
 sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *devstate);
@@ -54,13 +62,16 @@ void sccp_devstate_changed_cb(void *data, struct stasis_subscription *sub, struc
 void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data);
 #endif
 void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device);
-void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber);
+void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, sccp_devstate_SubscribingDevice_t * subscriber);
+static void sccp_devstate_destroySubscriber(sccp_devstate_SubscribingDevice_t * subscriber);
 void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig);
 
 void sccp_devstate_module_start(void)
 {
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting devstate system\n");
 	SCCP_LIST_HEAD_INIT(&deviceStates);
+	memset(deviceStateIndex, 0, sizeof(deviceStateIndex));
+	sccp_devstate_pendingNotifications = 0;
 	sccp_event_subscribe(SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED, sccp_devstate_deviceRegisterListener, TRUE);
 }
 
@@ -70,19 +81,33 @@ void sccp_devstate_module_stop(void)
 	{
 		sccp_devstate_deviceState_t *deviceState;
 		sccp_devstate_SubscribingDevice_t *subscriber;
+		int loopcount = 0;
 
 		SCCP_LIST_LOCK(&deviceStates);
-		while ((deviceState = SCCP_LIST_REMOVE_HEAD(&deviceStates, list))) {
+		SCCP_LIST_TRAVERSE(&deviceStates, deviceState, list) {
 			pbx_event_unsubscribe(deviceState->sub);
+		}
+		SCCP_LIST_UNLOCK(&deviceStates);
 
+		/* wait for notification batches which are still running on the threadpool, they use the states freed below */
+		while (ATOMIC_FETCH(&sccp_devstate_pendingNotifications, &deviceStates.lock) > 0) {
+			if (++loopcount % 500 == 0) {
+				pbx_log(LOG_NOTICE, "SCCP: Still waiting for %d devstate notification batches to finish\n", ATOMIC_FETCH(&sccp_devstate_pendingNotifications, &deviceStates.lock));
+			}
+			sccp_safe_sleep(10);
+		}
+
+		SCCP_LIST_LOCK(&deviceStates);
+		while ((deviceState = SCCP_LIST_REMOVE_HEAD(&deviceStates, list))) {
 			SCCP_LIST_LOCK(&deviceState->subscribers);
 			while ((subscriber = SCCP_LIST_REMOVE_HEAD(&deviceState->subscribers, list))) {
-				sccp_device_release(&subscriber->device);		/* explicit release */
+				sccp_devstate_destroySubscriber(subscriber);
 			}
 			SCCP_LIST_UNLOCK(&deviceState->subscribers);
 			SCCP_LIST_HEAD_DESTROY(&deviceState->subscribers);
 			sccp_free(deviceState);
 		}
+		memset(deviceStateIndex, 0, sizeof(deviceStateIndex));
 		SCCP_LIST_UNLOCK(&deviceStates);
 	}
 
@@ -128,7 +153,9 @@ static void sccp_devstate_deviceUnRegistered(const sccp_device_t * device)
 				SCCP_LIST_LOCK(&deviceStates);
 				deviceState = sccp_devstate_getDeviceStateHandler(config->button.feature.options);
 				if (deviceState) {
+					SCCP_LIST_LOCK(&deviceState->subscribers);
 					sccp_devstate_removeSubscriber(deviceState, device);
+					SCCP_LIST_UNLOCK(&deviceState->subscribers);
 				}
 				SCCP_LIST_UNLOCK(&deviceStates);
 			}
@@ -159,6 +186,10 @@ void sccp_devstate_deviceRegisterListener(const sccp_event_t * event)
 	}
 }
 
+/*!
+ * \brief Find deviceState by name using the deviceStateIndex
+ * \note deviceStates needs to be locked by the caller
+ */
 sccp_devstate_deviceState_t * __PURE__ sccp_devstate_getDeviceStateHandler(const char *devstate)
 {
 	if (!devstate) {
@@ -167,7 +198,7 @@ sccp_devstate_deviceState_t * __PURE__ sccp_devstate_getDeviceStateHandler(const
 
 	sccp_devstate_deviceState_t *deviceState = NULL;
 
-	SCCP_LIST_TRAVERSE(&deviceStates, deviceState, list) {
+	for (deviceState = deviceStateIndex[sccp_str_case_hash(devstate) % SCCP_HASH_PRIME]; deviceState; deviceState = deviceState->hashnext) {
 		if (!strncasecmp(devstate, deviceState->devicestate, sizeof(deviceState->devicestate))) {
 			break;
 		}
@@ -204,24 +235,82 @@ sccp_devstate_deviceState_t *sccp_devstate_createDeviceStateHandler(const char *
 	deviceState->featureState = (ast_device_state(buf) == AST_DEVICE_NOT_INUSE) ? 0 : 1;
 
 	SCCP_LIST_INSERT_HEAD(&deviceStates, deviceState, list);
+	{
+		unsigned int bucket = sccp_str_case_hash(deviceState->devicestate) % SCCP_HASH_PRIME;
+		deviceState->hashnext = deviceStateIndex[bucket];
+		deviceStateIndex[bucket] = deviceState;
+	}
 	return deviceState;
 }
 
+/*!
+ * \brief Build the FeatureStat(Dynamic)Message a subscriber should receive for featureState
+ */
+static sccp_msg_t *sccp_devstate_buildPayload(const sccp_devstate_SubscribingDevice_t * subscriber, uint32_t featureState)
+{
+	sccp_msg_t *msg = NULL;
+
+	if (subscriber->device->inuseprotocolversion >= 15) {
+		REQ(msg, FeatureStatDynamicMessage);
+		if (msg) {
+			msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
+			msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
+			msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(featureState);
+			sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
+		}
+	} else {
+		REQ(msg, FeatureStatMessage);
+		if (msg) {
+			msg->data.FeatureStatMessage.lel_featureIndex = htolel(subscriber->instance);
+			msg->data.FeatureStatMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
+			msg->data.FeatureStatMessage.lel_featureStatus = htolel(featureState);
+			sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
+		}
+	}
+	return msg;
+}
+
+static void sccp_devstate_destroySubscriber(sccp_devstate_SubscribingDevice_t * subscriber)
+{
+	uint8_t state = 0;
+
+	for (state = 0; state < ARRAY_LEN(subscriber->payload); state++) {
+		if (subscriber->payload[state]) {
+			sccp_free(subscriber->payload[state]);
+		}
+	}
+	sccp_device_release(&subscriber->device);							/* explicit release */
+	sccp_free(subscriber);
+}
+
 void sccp_devstate_addSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device, sccp_buttonconfig_t * buttonConfig)
 {
 	sccp_devstate_SubscribingDevice_t *subscriber;
+	uint8_t state = 0;
 
 	subscriber = sccp_calloc(sizeof *subscriber, 1);
+	if (!subscriber) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, DEV_ID_LOG(device));
+		return;
+	}
 	subscriber->device = sccp_device_retain((sccp_device_t *) device);
 	subscriber->instance = buttonConfig->instance;
 	subscriber->buttonConfig = buttonConfig;
-	subscriber->buttonConfig->button.feature.status = deviceState->featureState;
 	sccp_copy_string(subscriber->label, buttonConfig->label, sizeof(subscriber->label));
+	for (state = 0; state < ARRAY_LEN(subscriber->payload); state++) {
+		subscriber->payload[state] = sccp_devstate_buildPayload(subscriber, state);
+	}
 
+	SCCP_LIST_LOCK(&deviceState->subscribers);
+	subscriber->buttonConfig->button.feature.status = deviceState->featureState;
 	SCCP_LIST_INSERT_HEAD(&deviceState->subscribers, subscriber, list);
 	sccp_devstate_notifySubscriber(deviceState, subscriber);						/* set initial state */
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
 }
 
+/*!
+ * \note deviceState->subscribers needs to be locked by the caller
+ */
 void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_device_t * device)
 {
 	sccp_devstate_SubscribingDevice_t *subscriber = NULL;
@@ -229,35 +318,64 @@ void sccp_devstate_removeSubscriber(sccp_devstate_deviceState_t * deviceState, c
 	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&deviceState->subscribers, subscriber, list) {
 		if (subscriber->device == device) {
 			SCCP_LIST_REMOVE_CURRENT(list);
-			sccp_device_release(&subscriber->device);				/* explicit release */
+			sccp_devstate_destroySubscriber(subscriber);
 		}
 
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
 }
 
-void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, const sccp_devstate_SubscribingDevice_t * subscriber)
+/*!
+ * \brief Send the precomputed payload for the current featureState to the subscriber
+ * \note deviceState->subscribers needs to be locked by the caller
+ */
+void sccp_devstate_notifySubscriber(sccp_devstate_deviceState_t * deviceState, sccp_devstate_SubscribingDevice_t * subscriber)
 {
 	pbx_assert(subscriber->device != NULL);
+	const sccp_msg_t *payload = subscriber->payload[deviceState->featureState ? 1 : 0];
 	sccp_msg_t *msg = NULL;
 
-	if (subscriber->device->inuseprotocolversion >= 15) {
-		REQ(msg, FeatureStatDynamicMessage);
-		msg->data.FeatureStatDynamicMessage.lel_featureIndex = htolel(subscriber->instance);
-		msg->data.FeatureStatDynamicMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatDynamicMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatDynamicMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatDynamicMessage.featureTextLabel));
-	} else {
-		REQ(msg, FeatureStatMessage);
-		msg->data.FeatureStatMessage.lel_featureIndex = htolel(subscriber->instance);
-		msg->data.FeatureStatMessage.lel_featureID = htolel(SKINNY_BUTTONTYPE_FEATURE);
-		msg->data.FeatureStatMessage.lel_featureStatus = htolel(deviceState->featureState);
-		sccp_copy_string(msg->data.FeatureStatMessage.featureTextLabel, subscriber->label, sizeof(msg->data.FeatureStatMessage.featureTextLabel));
+	if (!payload) {
+		return;
 	}
-
+	/* sccp_dev_send takes ownership of the message, so send a copy of the payload */
+	size_t len = letohl(payload->header.length) + SCCP_PACKET_HEADER - sizeof(payload->header.lel_messageId);
+	if (!(msg = sccp_calloc(1, len))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, DEV_ID_LOG(subscriber->device));
+		return;
+	}
+	memcpy(msg, payload, len);
+	subscriber->notifiedState = deviceState->featureState;
 	sccp_dev_send(subscriber->device, msg);
 }
 
+/*!
+ * \brief Notify all subscribers of a deviceState about its current featureState (run via threadpool)
+ * \note state changes received while the batch is pending are merged into it, subscribers already showing the current state are skipped
+ */
+static void *sccp_devstate_notifySubscribers(void *data)
+{
+	sccp_devstate_deviceState_t *deviceState = (sccp_devstate_deviceState_t *) data;
+	sccp_devstate_SubscribingDevice_t *subscriber = NULL;
+	uint32_t notified = 0;
+
+	SCCP_LIST_LOCK(&deviceState->subscribers);
+	deviceState->notifyScheduled = FALSE;								/* changes from now on need a new batch */
+	SCCP_LIST_TRAVERSE(&deviceState->subscribers, subscriber, list) {
+		if (subscriber->notifiedState != deviceState->featureState) {
+			sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_notifySubscribers) notify subscriber for state %d\n", DEV_ID_LOG(subscriber->device), deviceState->featureState);
+			subscriber->buttonConfig->button.feature.status = deviceState->featureState;
+			sccp_devstate_notifySubscriber(deviceState, subscriber);
+			notified++;
+		}
+	}
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_notifySubscribers) %s: notified %d of %d subscribers\n", "SCCP", deviceState->devicestate, notified, deviceState->subscribers.size);
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
+
+	ATOMIC_DECR(&sccp_devstate_pendingNotifications, 1, &deviceStates.lock);
+	return NULL;
+}
+
 //void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
 #if ASTERISK_VERSION_GROUP >= 112
 void sccp_devstate_changed_cb(void *data, struct stasis_subscription *sub, struct stasis_message *msg)
@@ -266,8 +384,8 @@ void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
 #endif
 {
 	sccp_devstate_deviceState_t *deviceState = NULL;
-	sccp_devstate_SubscribingDevice_t *subscriber = NULL;
 	enum ast_device_state state;
+	boolean_t schedule = FALSE;
 
 #if ASTERISK_VERSION_GROUP >= 112
 	struct ast_device_state_message *dev_state = stasis_message_data(msg);
@@ -283,13 +401,21 @@ void sccp_devstate_changed_cb(const struct ast_event *ast_event, void *data)
 	state = pbx_event_get_ie_uint(ast_event, AST_EVENT_IE_STATE);
 #endif
 	deviceState = (sccp_devstate_deviceState_t *) data;
+
+	/* only record the new state here, the subscribers are notified in a batch by the threadpool */
+	SCCP_LIST_LOCK(&deviceState->subscribers);
 	deviceState->featureState = (state == AST_DEVICE_NOT_INUSE) ? 0 : 1;
+	if (!deviceState->notifyScheduled && SCCP_LIST_GETSIZE(&deviceState->subscribers) > 0) {
+		deviceState->notifyScheduled = schedule = TRUE;
+	}
+	SCCP_LIST_UNLOCK(&deviceState->subscribers);
 
-	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) got new device state for %s, state: %d, deviceState->subscribers.count %d\n", "SCCP", deviceState->devicestate, state, deviceState->subscribers.size);
-	SCCP_LIST_TRAVERSE(&deviceState->subscribers, subscriber, list) {
-		sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) notify subscriber for state %d\n", DEV_ID_LOG(subscriber->device), deviceState->featureState);
-		subscriber->buttonConfig->button.feature.status = deviceState->featureState;
-		sccp_devstate_notifySubscriber(deviceState, subscriber);
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "%s: (sccp_devstate_changed_cb) got new device state for %s, state: %d, deviceState->subscribers.count %d, schedule:%s\n", "SCCP", deviceState->devicestate, state, deviceState->subscribers.size, schedule ? "yes" : "no");
+	if (schedule) {
+		ATOMIC_INCR(&sccp_devstate_pendingNotifications, 1, &deviceStates.lock);
+		if (!GLOB(general_threadpool) || !sccp_threadpool_add_work(GLOB(general_threadpool), sccp_devstate_notifySubscribers, deviceState)) {
+			sccp_devstate_notifySubscribers(deviceState);
+		}
 	}
 }
 #endif
@@ -68,6 +68,9 @@ static struct sccp_event_subscriptions {
 							// but using predeclared type instead
 } event_subscriptions[NUMBER_OF_EVENT_TYPES] = {{{0}}};
 
+static volatile int event_fired[NUMBER_OF_EVENT_TYPES] = {0};						/*!< events fired per type (metrics) */
+AST_MUTEX_DEFINE_STATIC(event_firedLock);
+
 /*
  * \brief release held references when we are finished processing this event
  */
@@ -253,6 +256,21 @@ static gcc_inline uint8_t __search_for_position_in_event_array(sccp_event_type_t
 }
 /* end helpers */
 
+/*!
+ * \brief Number of events of eventType fired since module load
+ */
+uint32_t sccp_event_getFiredCount(sccp_event_type_t eventType)
+{
+	uint8_t _idx = 0;
+
+	for (_idx = 0; _idx < NUMBER_OF_EVENT_TYPES; _idx++) {
+		if (eventType & (1 << _idx)) {
+			return (uint32_t) ATOMIC_FETCH(&event_fired[_idx], &event_firedLock);
+		}
+	}
+	return 0;
+}
+
 /*!
  * async thread arguments
  */
@@ -293,6 +311,9 @@ boolean_t sccp_event_fire(sccp_event_t * event)
 		size_t subsize = 0, syncsize = 0, asyncsize = 0;
 		uint8_t _idx = __search_for_position_in_event_array(event->type);
 		
+		if (_idx < NUMBER_OF_EVENT_TYPES) {
+			(void) ATOMIC_INCR(&event_fired[_idx], 1, &event_firedLock);
+		}
 		/* copy both vectors to a local copy while holding the rwlock */
 		sccp_event_vector_t *subscribers = &event_subscriptions[_idx].subscribers;
 		SCCP_VECTOR_RW_RDLOCK(subscribers);
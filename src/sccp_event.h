@@ -49,6 +49,7 @@ SCCP_API void SCCP_CALL sccp_event_module_start(void);
 SCCP_API boolean_t SCCP_CALL sccp_event_subscribe(sccp_event_type_t eventType, sccp_event_callback_t cb, boolean_t allowAsyncExecution);
 SCCP_API boolean_t SCCP_CALL sccp_event_fire(sccp_event_t * event);
 SCCP_API boolean_t SCCP_CALL sccp_event_unsubscribe(sccp_event_type_t eventType, sccp_event_callback_t cb);
+SCCP_API uint32_t SCCP_CALL sccp_event_getFiredCount(sccp_event_type_t eventType);
 SCCP_API void SCCP_CALL sccp_event_module_stop(void);
 __END_C_EXTERN__
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
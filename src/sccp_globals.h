@@ -36,6 +36,17 @@ struct subscriptionId {
 struct sccp_global_vars {
 	int keepalive;												/*!< KeepAlive */
 	int32_t debug;												/*!< Debug */
+	boolean_t debug_async;										/*!< Write debug output from a background thread */
+	uint debug_async_memory;									/*!< Memory budget (KB) of the async debug buffers */
+	char *pcap_file;											/*!< Packet capture file (relative to the asterisk log directory) */
+	uint pcap_filesize;											/*!< Rotate the capture file after this many KB */
+	uint pcap_files;											/*!< Number of rotated capture files to keep */
+	boolean_t callspan_log;											/*!< Log the call setup milestones of every call on hangup */
+	char *metrics_file;											/*!< Prometheus textfile dump (relative to the asterisk log directory), empty = off */
+	uint metrics_interval;											/*!< Seconds between two metrics dumps */
+	boolean_t manager_event_batching;									/*!< Coalesce manager events per object within manager_event_window */
+	uint manager_event_window;										/*!< Milliseconds manager events are held back when batching */
+	uint manager_event_summary;										/*!< Send one summary event once a type/status occurs this often in a window (0 = never) */
 	int module_running;
 	pbx_rwlock_t lock;											/*!< Asterisk: Lock Me Up and Tie me Down */
 
@@ -142,6 +153,10 @@ struct sccp_global_vars {
 #ifdef CS_SCCP_REALTIME
 	char *realtimedevicetable;										/*!< Database Table Name for SCCP Devices */
 	char *realtimelinetable;											/*!< Database Table Name for SCCP Lines */
+	uint16_t realtime_cache_ttl;										/*!< Seconds to cache a realtime row that was found */
+	uint16_t realtime_cache_negative_ttl;									/*!< Seconds to cache a realtime lookup that found nothing */
+	uint16_t realtime_cache_size;										/*!< Maximum number of cached realtime lookups */
+	boolean_t realtime_cache_prefetch;									/*!< Load the complete realtime tables during (re)load */
 #endif
 	char used_context[SCCP_MAX_EXTENSION];									/*!< placeholder to check if context are already used in regcontext (DUNDI) */
 
@@ -149,11 +164,14 @@ struct sccp_global_vars {
 	struct ast_config *cfg;
 	sccp_hotline_t *hotline;										/*!< HotLine */
 
+	char *provision_dir;											/*!< TFTP root the cnf.xml files of all devices are rendered to */
 	char *token_fallback;											/*!< Fall back immediatly on TokenReq (true/false/odd/even) */
 	int token_backoff_time;											/*!< Backoff time on TokenReject */
 	int server_priority;											/*!< Server Priority to fallback to */
 
 	boolean_t reload_in_progress;										/*!< Reload in Progress */
+	boolean_t reload_incremental;										/*!< Skip devices and lines whose config section did not change during reload */
+	boolean_t config_snapshot;										/*!< Keep a compiled snapshot of the config to skip the text parser on the next start */
 	boolean_t pendingUpdate;
 };														/*!< SCCP Global Varable Structure */
 
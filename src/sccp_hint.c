@@ -34,6 +34,7 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_line.h"
 #include "sccp_utils.h"
 #include "sccp_labels.h"
+#include "sccp_vector.h"
 
 #if defined(CS_AST_HAS_EVENT) && defined(HAVE_PBX_EVENT_H) 	// ast_event_subscribe
 #  include <asterisk/event.h>
@@ -77,6 +78,15 @@ struct sccp_hint_lineState
 	SCCP_LIST_ENTRY (struct sccp_hint_lineState) list;							/*!< Hint Type Linked List Entry */
 };
 
+/*!
+ * \brief SCCP Compiled Hint Dialplan Structure
+ * \note hint_dialplan is parsed only once, when the hint is created
+ */
+struct sccp_hint_compiled {
+	struct sccp_vector_string lines;									/*!< SCCP line names (without the 'SCCP/' prefix) */
+	struct sccp_vector_string devices;									/*!< non-SCCP device references (i.e. SIP/123, Custom:DND112) */
+};
+
 /*!
  * \brief SCCP Hint List Structure
  */
@@ -86,6 +96,7 @@ struct sccp_hint_list {
 	char exten[SCCP_MAX_EXTENSION];										/*!< Extension for Hint */
 	char context[SCCP_MAX_CONTEXT];										/*!< Context for Hint */
 	char hint_dialplan[256];										/*!< e.g. IAX2/station123 */
+	struct sccp_hint_compiled compiled;									/*!< hint_dialplan split into line and device references */
 
 	sccp_channelstate_t currentState;									/*!< current State */
 	sccp_channelstate_t previousState;									/*!< current State */
@@ -110,11 +121,25 @@ struct sccp_hint_list {
 	SCCP_LIST_ENTRY (sccp_hint_list_t) list;								/*!< Hint Type Linked List Entry */
 };														/*!< SCCP Hint List Structure */
 
+/*!
+ * \brief SCCP Hint Line Dependency Structure
+ * \note maps a line name to all hints which reference it, so that a linestate change does not need to parse any hint_dialplan
+ */
+struct sccp_hint_lineDependency {
+	char lineName[StationMaxNameSize];									/*!< Line Name */
+	SCCP_VECTOR(, sccp_hint_list_t *) hints;								/*!< Hints containing SCCP/lineName */
+	struct sccp_hint_lineDependency *next;									/*!< Next Dependency in Hash Bucket */
+};
+
 /* ========================================================================================================================= Declarations */
 static void sccp_hint_updateLineState(struct sccp_hint_lineState *lineState);
 static void sccp_hint_updateLineStateForMultipleChannels(struct sccp_hint_lineState *lineState);
 static void sccp_hint_updateLineStateForSingleChannel(struct sccp_hint_lineState *lineState);
 static void sccp_hint_checkForDND(struct sccp_hint_lineState *lineState);
+static boolean_t sccp_hint_compileDialplan(const char *hint_dialplan, struct sccp_hint_compiled *compiled);
+static void sccp_hint_freeCompiled(struct sccp_hint_compiled *compiled);
+static void sccp_hint_addLineDependencies(sccp_hint_list_t * hint);
+static void sccp_hint_destroyLineDependencies(void);
 static sccp_hint_list_t *sccp_hint_create(char *hint_exten, char *hint_context);
 static void sccp_hint_notifySubscribers(sccp_hint_list_t * hint);			/* old */
 static void sccp_hint_notifyLineStateUpdate(struct sccp_hint_lineState *linestate); 	/* new */
@@ -192,6 +217,7 @@ static void sccp_hint_distributed_devstate_cb(const pbx_event_t * event, void *d
 /* ========================================================================================================================= List Declarations */
 static SCCP_LIST_HEAD (, struct sccp_hint_lineState) lineStates;
 static SCCP_LIST_HEAD (, sccp_hint_list_t) sccp_hint_subscriptions;
+static struct sccp_hint_lineDependency *lineDependencies[SCCP_HASH_PRIME];				/* protected by sccp_hint_subscriptions lock */
 
 /* ========================================================================================================================= Module Start/Stop */
 /*!
@@ -253,8 +279,10 @@ void sccp_hint_module_stop(void)
 			SCCP_LIST_UNLOCK(&hint->subscribers);
 			SCCP_LIST_HEAD_DESTROY(&hint->subscribers);
 			iCallInfo.Destructor(&hint->callInfo);
+			sccp_hint_freeCompiled(&hint->compiled);
 			sccp_free(hint);
 		}
+		sccp_hint_destroyLineDependencies();
 		SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
 	}
 
@@ -547,6 +575,7 @@ static void sccp_hint_addSubscription4Device(const sccp_device_t * device, const
 		}
 		SCCP_LIST_LOCK(&sccp_hint_subscriptions);
 		SCCP_LIST_INSERT_HEAD(&sccp_hint_subscriptions, hint, list);
+		sccp_hint_addLineDependencies(hint);
 		SCCP_LIST_UNLOCK(&sccp_hint_subscriptions);
 	}
 
@@ -617,6 +646,12 @@ static sccp_hint_list_t *sccp_hint_create(char *hint_exten, char *hint_context)
 		sccp_free(hint);
 		return NULL;
 	}
+	if (!sccp_hint_compileDialplan(hint_dialplan, &hint->compiled)) {
+		pbx_log(LOG_ERROR, "SCCP: (sccp_hint_create) Memory Allocation Error while compiling hint: %s@%s\n", hint_exten, hint_context);
+		iCallInfo.Destructor(&hint->callInfo);
+		sccp_free(hint);
+		return NULL;
+	}
 	hint->calltype = SKINNY_CALLTYPE_SENTINEL;
 
 	SCCP_LIST_HEAD_INIT(&hint->subscribers);
@@ -1343,35 +1378,138 @@ static void sccp_hint_notifySubscribersViaPbx(struct sccp_hint_lineState *lineSt
 #endif /* CS_USE_ASTERISK_DISTRIBUTED_DEVSTATE && ASTERISK_VERSION_GROUP < 112 */
 }
 
-/* ========================================================================================================================= PBX Notify */
+/* ========================================================================================================================= Hint Compilation */
 /*!
- * \brief helper function to parse aggegated hint_dialplan to search for a match with lineName
+ * \brief compile an aggegated hint_dialplan into separate line and device references
+ * \param hint_dialplan hint application string (CustomPresence part already removed)
+ * \param compiled Compiled Hint Structure to fill
+ * \return TRUE on success
  *
  * \note: We need to be able to parse a hint like this:
  * exten => 112,hint, SIP/123&Meetme:444&SCCP/98011&SCCP/98031&Custom:DND112,CustomPresence:112,Meetme:444
- * and match on the lineName we are looking for, i.e.: SCCP/98011 and SCCP/98031
+ * resulting in lines: 98011, 98031 and devices: SIP/123, Meetme:444, Custom:DND112
  */
-static boolean_t sccp_match_dialplan2lineName(char *hint_app, char *lineName)
+static boolean_t sccp_hint_compileDialplan(const char *hint_dialplan, struct sccp_hint_compiled *compiled)
 {
-	char *rest = pbx_strdupa(hint_app);
-        char *cur;
-        char *tmp;
-
-        // get the device portion of the hint string
-        if ((tmp = strrchr(rest, ','))) {
-                *tmp = '\0';
-        }
-        
-        // check for match for aggregated entry
-        while ((cur = strsep(&rest, "&"))) {
-        	if (sccp_strcaseequals(cur, lineName)) {
-			//sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_3 "SCCP: (parse_hint_device) cur:%s matches lineName:%s\n", cur, lineName);
-        		return TRUE;
-        	}
-        }
-        return FALSE;
+	char *rest = pbx_strdupa(hint_dialplan);
+	char *cur;
+	char *tmp;
+	char *ref = NULL;
+
+	if (SCCP_VECTOR_INIT(&compiled->lines, 1) != 0) {
+		return FALSE;
+	}
+	if (SCCP_VECTOR_INIT(&compiled->devices, 1) != 0) {
+		SCCP_VECTOR_FREE(&compiled->lines);
+		return FALSE;
+	}
+
+	// get the device portion of the hint string
+	if ((tmp = strrchr(rest, ','))) {
+		*tmp = '\0';
+	}
+
+	while ((cur = strsep(&rest, "&"))) {
+		cur = pbx_strip(cur);
+		if (sccp_strlen_zero(cur)) {
+			continue;
+		}
+		if (!strncasecmp(cur, "SCCP/", 5) && !sccp_strlen_zero(cur + 5)) {
+			if (!(ref = pbx_strdup(cur + 5)) || SCCP_VECTOR_APPEND(&compiled->lines, ref) != 0) {
+				goto FAIL;
+			}
+		} else {
+			if (!(ref = pbx_strdup(cur)) || SCCP_VECTOR_APPEND(&compiled->devices, ref) != 0) {
+				goto FAIL;
+			}
+		}
+	}
+	return TRUE;
+
+FAIL:
+	if (ref) {
+		sccp_free(ref);
+	}
+	sccp_hint_freeCompiled(compiled);
+	return FALSE;
 }
 
+static void sccp_hint_freeCompiled(struct sccp_hint_compiled *compiled)
+{
+	SCCP_VECTOR_RESET(&compiled->lines, ast_free);
+	SCCP_VECTOR_FREE(&compiled->lines);
+	SCCP_VECTOR_RESET(&compiled->devices, ast_free);
+	SCCP_VECTOR_FREE(&compiled->devices);
+}
+
+/*!
+ * \brief find the lineDependency for a line name
+ * \note sccp_hint_subscriptions needs to be locked by the caller
+ */
+static struct sccp_hint_lineDependency *sccp_hint_findLineDependency(const char *lineName)
+{
+	struct sccp_hint_lineDependency *dependency = NULL;
+
+	for (dependency = lineDependencies[sccp_str_case_hash(lineName) % SCCP_HASH_PRIME]; dependency; dependency = dependency->next) {
+		if (sccp_strcaseequals(dependency->lineName, lineName)) {
+			break;
+		}
+	}
+	return dependency;
+}
+
+/*!
+ * \brief register the lines referenced by a newly created hint in the line dependency graph
+ * \note sccp_hint_subscriptions needs to be locked by the caller
+ */
+static void sccp_hint_addLineDependencies(sccp_hint_list_t * hint)
+{
+	struct sccp_hint_lineDependency *dependency = NULL;
+	unsigned int bucket;
+	size_t idx;
+
+	for (idx = 0; idx < SCCP_VECTOR_SIZE(&hint->compiled.lines); idx++) {
+		const char *lineName = SCCP_VECTOR_GET(&hint->compiled.lines, idx);
+
+		if (!(dependency = sccp_hint_findLineDependency(lineName))) {
+			dependency = sccp_calloc(sizeof *dependency, 1);
+			if (!dependency) {
+				pbx_log(LOG_ERROR, "SCCP: (sccp_hint_addLineDependencies) Memory Allocation Error while creating dependency for line %s\n", lineName);
+				continue;
+			}
+			if (SCCP_VECTOR_INIT(&dependency->hints, 1) != 0) {
+				sccp_free(dependency);
+				continue;
+			}
+			sccp_copy_string(dependency->lineName, lineName, sizeof(dependency->lineName));
+			bucket = sccp_str_case_hash(lineName) % SCCP_HASH_PRIME;
+			dependency->next = lineDependencies[bucket];
+			lineDependencies[bucket] = dependency;
+		}
+		sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "SCCP: (sccp_hint_addLineDependencies) line:%s -> hint:%s@%s\n", lineName, hint->exten, hint->context);
+		SCCP_VECTOR_APPEND(&dependency->hints, hint);
+	}
+}
+
+/*!
+ * \brief destroy the complete line dependency graph
+ * \note sccp_hint_subscriptions needs to be locked by the caller
+ */
+static void sccp_hint_destroyLineDependencies(void)
+{
+	struct sccp_hint_lineDependency *dependency = NULL;
+	int bucket;
+
+	for (bucket = 0; bucket < SCCP_HASH_PRIME; bucket++) {
+		while ((dependency = lineDependencies[bucket])) {
+			lineDependencies[bucket] = dependency->next;
+			SCCP_VECTOR_FREE(&dependency->hints);
+			sccp_free(dependency);
+		}
+	}
+}
+
+/* ========================================================================================================================= PBX Notify */
 /*
  * \brief Notify Line Status Update either directly or via PBX(including distributed devstate)
  * \param lineState SCCP LineState
@@ -1383,7 +1521,9 @@ static boolean_t sccp_match_dialplan2lineName(char *hint_app, char *lineName)
 static void sccp_hint_notifyLineStateUpdate(struct sccp_hint_lineState *lineState)
 {
 	sccp_hint_list_t *hint = NULL;
+	struct sccp_hint_lineDependency *dependency = NULL;
 	char lineName[StationMaxNameSize + 5];
+	size_t idx;
 
 	{
 		AUTO_RELEASE(sccp_line_t, line , lineState->line ? sccp_line_retain(lineState->line) : NULL);
@@ -1398,8 +1538,9 @@ static void sccp_hint_notifyLineStateUpdate(struct sccp_hint_lineState *lineStat
 
 	/* Local Update */
  	SCCP_LIST_LOCK(&sccp_hint_subscriptions);
-	SCCP_LIST_TRAVERSE(&sccp_hint_subscriptions, hint, list) {
-		if (!sccp_strlen_zero(hint->hint_dialplan) && sccp_match_dialplan2lineName(hint->hint_dialplan, lineName)) {
+	if ((dependency = sccp_hint_findLineDependency(lineName + 5))) {
+		for (idx = 0; idx < SCCP_VECTOR_SIZE(&dependency->hints); idx++) {
+			hint = SCCP_VECTOR_GET(&dependency->hints, idx);
 			sccp_log((DEBUGCAT_HINT)) (VERBOSE_PREFIX_4 "SCCP: (sccp_hint_notifyLineStateUpdate) matched lineName:%s to dialplan:%s\n", lineName, hint->hint_dialplan);
 
 			hint->calltype = lineState->callInfo.calltype;
@@ -143,6 +143,7 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 			break;
 		case SCCP_CHANNELSTATE_RINGOUT:
 			{
+				sccp_channel_markCallSpan(c, SCCP_CALLSPAN_RING);
 				// we already send out the ringing state before */
 				if (d->earlyrtp == SCCP_EARLYRTP_IMMEDIATE) {
 					/* Pavel Troller / Immediate Mode
@@ -185,6 +186,7 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 			break;
 		case SCCP_CHANNELSTATE_RINGING:
 			{
+				sccp_channel_markCallSpan(c, SCCP_CALLSPAN_RING);
 				sccp_dev_cleardisplaynotify(d);
 				sccp_dev_clearprompt(d, lineInstance, 0);
 
@@ -301,6 +303,7 @@ void __sccp_indicate(const sccp_device_t * const maybe_device, sccp_channel_t *
 			break;
 		case SCCP_CHANNELSTATE_CONNECTED:
 			{
+				sccp_channel_markCallSpan(c, SCCP_CALLSPAN_ANSWER);
 				d->indicate->connected(d, lineInstance, c->callid, c->calltype, ci);
 				if (c->rtp.audio.receiveChannelState == SCCP_RTP_STATUS_INACTIVE) {
 					sccp_channel_openReceiveChannel(c);
@@ -19,10 +19,11 @@
 #include "sccp_features.h"
 #include "sccp_mwi.h"
 #include "sccp_utils.h"
+#include "sccp_realtime.h"
+#include "sccp_regcontext.h"
 
 SCCP_FILE_VERSION(__FILE__, "");
 
-static void regcontext_exten(sccp_line_t * l, struct subscriptionId *subscriptionId, int onoff);
 int __sccp_line_destroy(const void *ptr);
 int __sccp_lineDevice_destroy(const void *ptr);
 int sccp_line_destroy(const void *ptr);
@@ -558,7 +559,7 @@ void sccp_line_addDevice(sccp_line_t * line, sccp_device_t * d, uint8_t lineInst
 	event.event.deviceAttached.linedevice = sccp_linedevice_retain(linedevice);
 	sccp_event_fire(&event);
 
-	regcontext_exten(l, &(linedevice->subscriptionId), 1);
+	sccp_regcontext_requestSync();
 	sccp_log((DEBUGCAT_LINE)) (VERBOSE_PREFIX_3 "%s: added linedevice: %p with device: %s\n", l->name, linedevice, DEV_ID_LOG(device));
 }
 
@@ -588,7 +589,6 @@ void sccp_line_removeDevice(sccp_line_t * l, sccp_device_t * device)
 #if CS_REFCOUNT_DEBUG
 			sccp_refcount_removeWeakParent(l, device ? device : linedevice->device);
 #endif
-			regcontext_exten(l, &(linedevice->subscriptionId), 0);
 			SCCP_LIST_REMOVE_CURRENT(list);
 			l->statistic.numberOfActiveDevices--;
 
@@ -607,6 +607,7 @@ void sccp_line_removeDevice(sccp_line_t * l, sccp_device_t * device)
 	}
 	SCCP_LIST_TRAVERSE_SAFE_END;
 	SCCP_LIST_UNLOCK(&l->devices);
+	sccp_regcontext_requestSync();
 }
 
 /*!
@@ -680,83 +681,6 @@ void sccp_line_removeChannel(sccp_line_t * line, sccp_channel_t * channel)
 	}
 }
 
-/*!
- * \brief Register Extension to Asterisk regextension
- * \param l SCCP Line
- * \param subscriptionId subscriptionId
- * \param onoff On/Off as int
- * \note used for DUNDi Discovery
- */
-static void regcontext_exten(sccp_line_t * l, struct subscriptionId *subscriptionId, int onoff)
-{
-	char multi[256] = "";
-	char *stringp, *ext = "", *context = "";
-
-	// char extension[SCCP_MAX_CONTEXT]="";
-	// char name[SCCP_MAX_CONTEXT]="";
-
-	struct pbx_context *con;
-	struct pbx_find_info q = {.stacklen = 0 };
-
-	if (sccp_strlen_zero(GLOB(regcontext))) {
-		return;
-	}
-
-	sccp_copy_string(multi, S_OR(l->regexten, l->name), sizeof(multi));
-	stringp = multi;
-	while ((ext = strsep(&stringp, "&"))) {
-		if ((context = strchr(ext, '@'))) {
-			*context++ = '\0';									/* split ext@context */
-			if (!pbx_context_find(context)) {
-				pbx_log(LOG_WARNING, "Context specified in regcontext=%s (sccp.conf) must exist\n", context);
-				continue;
-			}
-		} else {
-			context = pbx_strdupa(GLOB(regcontext));
-		}
-		con = pbx_context_find_or_create(NULL, NULL, context, "SCCP");					/* make sure the context exists */
-		if (con) {
-			if (onoff) {
-				/* register */
-
-				if (!pbx_exists_extension(NULL, context, ext, 1, NULL) && pbx_add_extension(context, 0, ext, 1, NULL, NULL, "Noop", pbx_strdup(l->name), sccp_free_ptr, "SCCP")) {
-					sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Registered RegContext: %s, Extension: %s, Line: %s\n", context, ext, l->name);
-				}
-
-				/* register extension + subscriptionId */
-				/* if (subscriptionId && subscriptionId->number && !sccp_strlen_zero(subscriptionId->number) && !sccp_strlen_zero(subscriptionId->name)) {
-				   snprintf(extension, sizeof(extension), "%s@%s", ext, subscriptionId->number);
-				   snprintf(name, sizeof(name), "%s%s", l->name, subscriptionId->name);
-				   if (!pbx_exists_extension(NULL, context, extension, 2, NULL) && pbx_add_extension(context, 0, extension, 2, NULL, NULL, "Noop", pbx_strdup(name), sccp_free_ptr, "SCCP")) {
-				   sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Registered RegContext: %s, Extension: %s, Line: %s\n", context, extension, name);
-				   }
-				   } */
-			} else {
-				/* un-register */
-
-				if (SCCP_LIST_GETSIZE(&l->devices) == 1) {			// only remove entry if it is the last one (shared line)
-					if (pbx_find_extension(NULL, NULL, &q, context, ext, 1, NULL, "", E_MATCH)) {
-						ast_context_remove_extension(context, ext, 1, NULL);
-						sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Unregistered RegContext: %s, Extension: %s\n", context, ext);
-					}
-				}
-
-				/* unregister extension + subscriptionId */
-				/* if (subscriptionId && subscriptionId->number && !sccp_strlen_zero(subscriptionId->number) && !sccp_strlen_zero(subscriptionId->name)) {
-				   snprintf(extension, sizeof(extension), "%s@%s", ext, subscriptionId->number);
-				   // if (pbx_exists_extension(NULL, context, extension, 2, NULL)) {
-				   if (pbx_find_extension(NULL, NULL, &q, context, extension, 2, NULL, "", E_MATCH)) {
-				   ast_context_remove_extension(context, extension, 2, NULL);
-				   sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Unregistered RegContext: %s, Extension: %s\n", context, extension);
-				   }
-				   } */
-			}
-		} else {
-			pbx_log(LOG_ERROR, "SCCP: context '%s' does not exist and could not be created\n", context);
-		}
-	}
-}
-
 #if UNUSEDCODE // 2015-11-01
 /*!
  * \brief check the DND status for single/shared lines
@@ -871,7 +795,7 @@ sccp_line_t *sccp_line_find_realtime_byname(const char *name)
 		return NULL;
 	}
 
-	if ((variable = pbx_load_realtime(GLOB(realtimelinetable), "name", name, NULL))) {
+	if ((variable = sccp_realtime_load(GLOB(realtimelinetable), name))) {
 		v = variable;
 		sccp_log((DEBUGCAT_LINE + DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: Line '%s' found in realtime table '%s'\n", name, GLOB(realtimelinetable));
 
@@ -882,10 +806,10 @@ sccp_line_t *sccp_line_find_realtime_byname(const char *name)
 			sccp_config_applyLineConfiguration(l, variable);
 			l->realtime = TRUE;
 			sccp_line_addToGlobals(l);								// can return previous instance on doubles
-			pbx_variables_destroy(v);
 		} else {
 			pbx_log(LOG_ERROR, "SCCP: Unable to build realtime line '%s'\n", name);
 		}
+		pbx_variables_destroy(v);
 		// SCCP_RWLIST_UNLOCK(&GLOB(lines));
 		return l;
 	}
@@ -101,6 +101,7 @@ struct sccp_line {
 	/* this is for reload routines */
 	boolean_t pendingDelete;										/*!< this bit will tell the scheduler to delete this line when unused */
 	boolean_t pendingUpdate;										/*!< this bit will tell the scheduler to update this line when unused */
+	uint64_t configHash;											/*!< content hash of the line section in sccp.conf, used by incremental reload */
 };														/*!< SCCP Line Structure */
 
 /*!
@@ -0,0 +1,429 @@
+/*!
+ * \file        sccp_lockstats.c
+ * \brief       SCCP Lock Contention Profiler
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Only active when configured with --enable-lock-profile (CS_LOCK_PROFILE), the pbx_mutex_* / pbx_rwlock_* macros (and with them
+ * sccp_mutex_lock, SCCP_LIST_LOCK, SCCP_RWLIST_RDLOCK, sccp_session_lock, ...) then call the wrappers below:
+ * - every call site (file:line plus the stringified lock expression) is a lock class, kept in a fixed open addressing table
+ * - per class: acquisitions, contended acquisitions (trylock failed first), total and max wait time, max hold time
+ * - hold time is measured from acquisition to the matching unlock on the same thread (per thread stack of held locks),
+ *   it includes the time spent in pbx_cond_wait, which releases the mutex behind our back
+ * - counters are updated with plain gcc atomics, the sccp_atomic.h fallbacks are built on pbx_mutex_* themselves
+ * - 'sccp show lockstats [reset]' / AMI SCCPShowLockStats list the classes, worst total wait time first
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_lockstats.h"
+#include "sccp_utils.h"
+#include <asterisk/threadstorage.h>
+#include <asterisk/cli.h>
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#if CS_LOCK_PROFILE
+enum sccp_lockstats_state {
+	SCCP_LOCKSTATS_FREE,
+	SCCP_LOCKSTATS_CLAIMED,
+	SCCP_LOCKSTATS_INUSE,
+};
+
+typedef struct sccp_lockstats_site {
+	volatile int state;
+	int line;
+	const char *file;
+	const char *name;											/*!< lock expression as written at the call site */
+	const char *type;
+	volatile uint32_t acquired;
+	volatile uint32_t contended;
+	volatile uint32_t maxWaitUs;
+	volatile uint32_t maxHoldUs;
+	volatile uint64_t waitUs;
+} sccp_lockstats_site_t;
+
+typedef struct sccp_lockstats_held {
+	int depth;
+	struct {
+		const void *lock;
+		sccp_lockstats_site_t *site;
+		struct timespec since;
+	} locks[SCCP_LOCKSTATS_DEPTH];
+} sccp_lockstats_held_t;
+
+static const char sccp_lockstats_mutex[] = "mutex";
+static const char sccp_lockstats_rdlock[] = "rdlock";
+static const char sccp_lockstats_wrlock[] = "wrlock";
+
+static struct {
+	sccp_lockstats_site_t sites[SCCP_LOCKSTATS_SITES];
+	sccp_lockstats_site_t overflow;										/* table full */
+	struct timeval since;
+} sccp_lockstats = {
+	.overflow = {.state = SCCP_LOCKSTATS_INUSE, .file = "(other)", .name = "", .type = "any"},
+};
+
+AST_THREADSTORAGE(sccp_lockstats_heldbuf);
+
+static uint32_t sccp_lockstats_elapsed(const struct timespec *since)
+{
+	struct timespec now;
+	int64_t us = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	us = (int64_t) (now.tv_sec - since->tv_sec) * 1000000 + (now.tv_nsec - since->tv_nsec) / 1000;
+	return us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t) us);
+}
+
+static void sccp_lockstats_max(volatile uint32_t * max, uint32_t value)
+{
+	uint32_t current = *max;
+	uint32_t seen = 0;
+
+	while (value > current && (seen = __sync_val_compare_and_swap(max, current, value)) != current) {
+		current = seen;
+	}
+}
+
+/* find or claim the class of a call site, lock free so that it can be called from inside any lock */
+static sccp_lockstats_site_t *sccp_lockstats_site(const char *file, int line, const char *name, const char *type)
+{
+	uint32_t idx = (((uint32_t) line * 2654435761U) >> 16) & (SCCP_LOCKSTATS_SITES - 1);
+	uint32_t probe = 0;
+	sccp_lockstats_site_t *site = NULL;
+
+	for (probe = 0; probe < SCCP_LOCKSTATS_SITES; probe++, idx = (idx + 1) & (SCCP_LOCKSTATS_SITES - 1)) {
+		site = &sccp_lockstats.sites[idx];
+		if (site->state == SCCP_LOCKSTATS_FREE && __sync_bool_compare_and_swap(&site->state, SCCP_LOCKSTATS_FREE, SCCP_LOCKSTATS_CLAIMED)) {
+			site->file = file;
+			site->line = line;
+			site->name = name;
+			site->type = type;
+			__sync_synchronize();
+			site->state = SCCP_LOCKSTATS_INUSE;
+			return site;
+		}
+		while (site->state == SCCP_LOCKSTATS_CLAIMED) {
+			sched_yield();
+		}
+		/* the same header macro expands to a different __FILE__ pointer per translation unit */
+		if (site->line == line && site->type == type && (site->file == file || !strcmp(site->file, file))) {
+			return site;
+		}
+	}
+	return &sccp_lockstats.overflow;
+}
+
+static void sccp_lockstats_waited(sccp_lockstats_site_t * site, const struct timespec *start)
+{
+	uint32_t waited = sccp_lockstats_elapsed(start);
+
+	__sync_fetch_and_add(&site->contended, 1);
+	__sync_fetch_and_add(&site->waitUs, waited);
+	sccp_lockstats_max(&site->maxWaitUs, waited);
+}
+
+static void sccp_lockstats_acquired(sccp_lockstats_site_t * site, const void *lock)
+{
+	sccp_lockstats_held_t *held = NULL;
+
+	__sync_fetch_and_add(&site->acquired, 1);
+	if ((held = ast_threadstorage_get(&sccp_lockstats_heldbuf, sizeof *held)) && held->depth < SCCP_LOCKSTATS_DEPTH) {
+		held->locks[held->depth].lock = lock;
+		held->locks[held->depth].site = site;
+		clock_gettime(CLOCK_MONOTONIC, &held->locks[held->depth].since);
+		held->depth++;
+	}
+}
+
+static void sccp_lockstats_released(const void *lock)
+{
+	sccp_lockstats_held_t *held = NULL;
+	int idx = 0;
+
+	if (!(held = ast_threadstorage_get(&sccp_lockstats_heldbuf, sizeof *held))) {
+		return;
+	}
+	for (idx = held->depth - 1; idx >= 0; idx--) {
+		if (held->locks[idx].lock == lock) {
+			sccp_lockstats_max(&held->locks[idx].site->maxHoldUs, sccp_lockstats_elapsed(&held->locks[idx].since));
+			memmove(&held->locks[idx], &held->locks[idx + 1], (held->depth - idx - 1) * sizeof(held->locks[0]));
+			held->depth--;
+			return;
+		}
+	}
+	/* locked before the thread got its storage or deeper than SCCP_LOCKSTATS_DEPTH: not measured */
+}
+
+int sccp_lockstats_mutex_lock(ast_mutex_t * lock, int trylock, const char *name, const char *file, int line)
+{
+	sccp_lockstats_site_t *site = sccp_lockstats_site(file, line, name, sccp_lockstats_mutex);
+	struct timespec start;
+	int res = ast_mutex_trylock(lock);
+
+	if (res && !trylock) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		res = ast_mutex_lock(lock);
+		sccp_lockstats_waited(site, &start);
+	} else if (res) {
+		__sync_fetch_and_add(&site->contended, 1);
+	}
+	if (!res) {
+		sccp_lockstats_acquired(site, lock);
+	}
+	return res;
+}
+
+int sccp_lockstats_mutex_unlock(ast_mutex_t * lock)
+{
+	sccp_lockstats_released(lock);
+	return ast_mutex_unlock(lock);
+}
+
+int sccp_lockstats_rwlock_lock(ast_rwlock_t * lock, int write, int trylock, const char *name, const char *file, int line)
+{
+	sccp_lockstats_site_t *site = sccp_lockstats_site(file, line, name, write ? sccp_lockstats_wrlock : sccp_lockstats_rdlock);
+	struct timespec start;
+	int res = write ? ast_rwlock_trywrlock(lock) : ast_rwlock_tryrdlock(lock);
+
+	if (res && !trylock) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		res = write ? ast_rwlock_wrlock(lock) : ast_rwlock_rdlock(lock);
+		sccp_lockstats_waited(site, &start);
+	} else if (res) {
+		__sync_fetch_and_add(&site->contended, 1);
+	}
+	if (!res) {
+		sccp_lockstats_acquired(site, lock);
+	}
+	return res;
+}
+
+int sccp_lockstats_rwlock_unlock(ast_rwlock_t * lock)
+{
+	sccp_lockstats_released(lock);
+	return ast_rwlock_unlock(lock);
+}
+
+/*!
+ * \brief Zero all counters, the classes stay in place
+ * \note updates racing with the reset may survive it
+ */
+void sccp_lockstats_reset(void)
+{
+	sccp_lockstats_site_t *site = NULL;
+	int idx = 0;
+
+	for (idx = 0; idx <= SCCP_LOCKSTATS_SITES; idx++) {
+		site = idx < SCCP_LOCKSTATS_SITES ? &sccp_lockstats.sites[idx] : &sccp_lockstats.overflow;
+		if (site->state == SCCP_LOCKSTATS_INUSE) {
+			site->acquired = 0;
+			site->contended = 0;
+			site->maxWaitUs = 0;
+			site->maxHoldUs = 0;
+			site->waitUs = 0;
+		}
+	}
+	sccp_lockstats.since = pbx_tvnow();
+}
+
+typedef struct sccp_lockstats_row {
+	char site[48];
+	const char *name;
+	const char *type;
+	uint32_t acquired;
+	uint32_t contended;
+	uint32_t maxWaitUs;
+	uint32_t maxHoldUs;
+	uint64_t waitUs;
+} sccp_lockstats_row_t;
+
+static int sccp_lockstats_rowcmp(const void *a, const void *b)
+{
+	const sccp_lockstats_row_t *ra = a;
+	const sccp_lockstats_row_t *rb = b;
+
+	if (ra->waitUs != rb->waitUs) {
+		return (ra->waitUs < rb->waitUs) - (ra->waitUs > rb->waitUs);
+	}
+	return (ra->acquired < rb->acquired) - (ra->acquired > rb->acquired);
+}
+
+/* snapshot of all classes that saw any activity, sorted by total wait time, returns the number of rows */
+static int sccp_lockstats_collect(sccp_lockstats_row_t ** rows)
+{
+	sccp_lockstats_site_t *site = NULL;
+	const char *basename = NULL;
+	int nrows = 0;
+	int idx = 0;
+
+	if (!(*rows = sccp_calloc(SCCP_LOCKSTATS_SITES + 1, sizeof(sccp_lockstats_row_t)))) {
+		return 0;
+	}
+	for (idx = 0; idx <= SCCP_LOCKSTATS_SITES; idx++) {
+		site = idx < SCCP_LOCKSTATS_SITES ? &sccp_lockstats.sites[idx] : &sccp_lockstats.overflow;
+		if (site->state != SCCP_LOCKSTATS_INUSE || (!site->acquired && !site->contended)) {
+			continue;
+		}
+		basename = strrchr(site->file, '/') ? strrchr(site->file, '/') + 1 : site->file;
+		snprintf((*rows)[nrows].site, sizeof((*rows)[nrows].site), "%s:%d", basename, site->line);
+		(*rows)[nrows].name = site->name;
+		(*rows)[nrows].type = site->type;
+		(*rows)[nrows].acquired = site->acquired;
+		(*rows)[nrows].contended = site->contended;
+		(*rows)[nrows].maxWaitUs = site->maxWaitUs;
+		(*rows)[nrows].maxHoldUs = site->maxHoldUs;
+		(*rows)[nrows].waitUs = site->waitUs;
+		nrows++;
+	}
+	qsort(*rows, nrows, sizeof(sccp_lockstats_row_t), sccp_lockstats_rowcmp);
+	return nrows;
+}
+#endif
+
+/*!
+ * \brief Show (and optionally reset) the lock contention statistics (CLI/AMI)
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_lockstats_show(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+#if CS_LOCK_PROFILE
+	sccp_lockstats_row_t *rows = NULL;
+	sccp_lockstats_row_t *row = NULL;
+	boolean_t reset = FALSE;
+	int nrows = 0;
+	int idx = 0;
+
+	if (argc > 3 && !sccp_strlen_zero(argv[3])) {
+		if (sccp_strcaseequals(argv[3], "reset") || sccp_true(argv[3])) {
+			reset = TRUE;
+		} else if (!sccp_strcaseequals(argv[3], "no") && !sccp_strcaseequals(argv[3], "false")) {
+			return RESULT_SHOWUSAGE;
+		}
+	}
+	nrows = sccp_lockstats_collect(&rows);
+	if (!s && sccp_lockstats.since.tv_sec) {
+		pbx_cli(fd, "Lock statistics over the last %ld seconds (times in microseconds)\n", (long) (ast_tvdiff_ms(pbx_tvnow(), sccp_lockstats.since) / 1000));
+	} else if (!s) {
+		pbx_cli(fd, "Lock statistics since module load (times in microseconds)\n");
+	}
+#define CLI_AMI_TABLE_NAME LockStats
+#define CLI_AMI_TABLE_PER_ENTRY_NAME LockStat
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		row = &rows[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Lock,		"-40.40",	s,	40,	row->name)							\
+ 		CLI_AMI_TABLE_FIELD(Site,		"-30.30",	s,	30,	row->site)							\
+ 		CLI_AMI_TABLE_FIELD(Type,		"-6.6",		s,	6,	row->type)							\
+ 		CLI_AMI_TABLE_FIELD(Acquired,		"10",		u,	10,	row->acquired)							\
+ 		CLI_AMI_TABLE_FIELD(Contended,		"9",		u,	9,	row->contended)							\
+ 		CLI_AMI_TABLE_FIELD(WaitUs,		"12",		llu,	12,	(unsigned long long) row->waitUs)				\
+ 		CLI_AMI_TABLE_FIELD(MaxWaitUs,		"9",		u,	9,	row->maxWaitUs)							\
+ 		CLI_AMI_TABLE_FIELD(MaxHoldUs,		"9",		u,	9,	row->maxHoldUs)
+#include "sccp_cli_table.h"
+	if (rows) {
+		sccp_free(rows);
+	}
+	if (reset) {
+		sccp_lockstats_reset();
+	}
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+#else
+	CLI_AMI_RETURN_ERROR(fd, s, m, "lock profiling is not compiled in, configure with --enable-lock-profile %s\n", "");	/* explicit return */
+#endif
+}
+
+#if CS_TEST_FRAMEWORK && CS_LOCK_PROFILE
+#include <asterisk/test.h>
+static ast_mutex_t sccp_lockstats_testlock;
+
+static void *sccp_lockstats_testThread(void *data)
+{
+	ast_mutex_t *contendedlock = data;
+
+	pbx_mutex_lock(contendedlock);
+	pbx_mutex_unlock(contendedlock);
+	return NULL;
+}
+
+static sccp_lockstats_site_t *sccp_lockstats_testSite(void)
+{
+	int idx = 0;
+
+	for (idx = 0; idx < SCCP_LOCKSTATS_SITES; idx++) {
+		if (sccp_lockstats.sites[idx].state == SCCP_LOCKSTATS_INUSE && sccp_lockstats.sites[idx].file == __FILE__ && !strcmp(sccp_lockstats.sites[idx].name, "contendedlock")) {
+			return &sccp_lockstats.sites[idx];
+		}
+	}
+	return NULL;
+}
+
+AST_TEST_DEFINE(sccp_lockstats_contention_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "contention";
+			info->category = "/channels/chan_sccp/lockstats/";
+			info->summary = "chan-sccp-b lock contention profiler test";
+			info->description = "a mutex held while another thread locks it is counted as contended, with wait and hold times";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pthread_t thread;
+	sccp_lockstats_site_t *site = NULL;
+	uint32_t acquired = 0;
+	uint32_t contended = 0;
+
+	ast_mutex_init(&sccp_lockstats_testlock);
+	if ((site = sccp_lockstats_testSite())) {
+		acquired = site->acquired;
+		contended = site->contended;
+	}
+	pbx_mutex_lock(&sccp_lockstats_testlock);
+	pbx_pthread_create(&thread, NULL, sccp_lockstats_testThread, &sccp_lockstats_testlock);
+	usleep(20000);
+	pbx_mutex_unlock(&sccp_lockstats_testlock);
+	pthread_join(thread, NULL);
+	ast_mutex_destroy(&sccp_lockstats_testlock);
+
+	pbx_test_status_update(test, "call site registered...\n");
+	site = sccp_lockstats_testSite();
+	pbx_test_validate(test, site != NULL);
+	pbx_test_status_update(test, "contended acquisition, wait and hold time...\n");
+	pbx_test_validate(test, site->acquired == acquired + 1 && site->contended == contended + 1);
+	pbx_test_validate(test, site->maxWaitUs >= 10000 && site->waitUs >= 10000);
+	pbx_test_status_update(test, "reset...\n");
+	sccp_lockstats_reset();
+	pbx_test_validate(test, site->acquired == 0 && site->contended == 0 && site->waitUs == 0);
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_lockstats_contention_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_lockstats_contention_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
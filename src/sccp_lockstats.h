@@ -0,0 +1,21 @@
+/*!
+ * \file        sccp_lockstats.h
+ * \brief       SCCP Lock Contention Profiler Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+#include "sccp_cli.h"
+
+#define SCCP_LOCKSTATS_SITES 1024										/* power of two, distinct lock call sites */
+#define SCCP_LOCKSTATS_DEPTH 16											/* locks held at the same time by one thread */
+
+__BEGIN_C_EXTERN__
+/*
+ * the lock wrappers (sccp_lockstats_mutex_lock etc) are declared in pbx_impl/ast/define.h, next to the pbx_mutex_lock macros using them
+ */
+SCCP_API void SCCP_CALL sccp_lockstats_reset(void);
+SCCP_API int SCCP_CALL sccp_lockstats_show(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
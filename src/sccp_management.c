@@ -18,6 +18,7 @@
 #include "sccp_session.h"
 #include "sccp_utils.h"
 #include "sccp_featureParkingLot.h"
+#include "sccp_atomic.h"
 #include <asterisk/threadstorage.h>
 
 SCCP_FILE_VERSION(__FILE__, "");
@@ -32,7 +33,7 @@ static char management_show_device_add_line_desc[] = "Description: Lists SCCP de
 static char management_device_update_desc[] = "Description: restart a given device\n" "\n" "Variables:\n" "   Devicename: Name of device\n";
 static char management_device_set_dnd_desc[] = "Description: set dnd on device\n" "\n" "Variables:\n" "   Devicename: Name of device\n" "  DNDState: off / reject / silent";
 static char management_line_fwd_update_desc[] = "Description: update forward status for line\n" "\n" "Variables:\n" "  Devicename: Name of device\n" "  Linename: Name of line\n" "  Forwardtype: type of cfwd (all | busy | noAnswer)\n" "  Disable: yes Disable call forward (optional)\n" "  Number: number to forward calls (optional)";
-static char management_fetch_config_metadata_desc[] = "Description: fetch configuration metadata\n" "\n" "Variables:\n" "  segment: Config Segment Name (if empty returns all segments).\n";
+static char management_fetch_config_metadata_desc[] = "Description: fetch configuration metadata\n" "\n" "Variables:\n" "  Segment: Config Segment Name, or comma separated list of names (if empty returns all segments).\n" "  IfNoneMatch: MetaDataVersion already known to the client, returns 'Message: Unchanged' without data when still current (optional).\n" "  ResultFormat: list / command (optional).\n";
 
 #if ASTERISK_VERSION_GROUP >= 112
 static char management_startcall_desc[] = "Description: start a new call on a device/line\n" "\n" "Variables:\n" "  Devicename: Name of the Device\n" "  Linename: Name of the line\n" "  number: Number to call\n" "  ChannelId: Channel UniqueId to be set on the channel\n";
@@ -133,11 +134,293 @@ int sccp_unregister_management(void)
 	return result;
 }
 
+/* ================================================================================================== EVENT BATCHING == */
+/*!
+ * \brief Manager Event Batching
+ *
+ * With manager_event_batching enabled the events posted by sccp_manager_eventListener are queued for manager_event_window ms
+ * instead of being sent one by one. Within that window a newer event for the same object (device, device/line) replaces the
+ * queued one, so a device which unregisters and registers again only produces its last state. When one event type/status
+ * combination occurs at least manager_event_summary times inside a window (mass (un)registration during a reload or site
+ * reconnect), a single SCCPEventSummary event carrying the count and the list of objects is sent instead of the individual
+ * events.
+ * Received, emitted, coalesced and summarized events are counted per event type ('sccp show manager events').
+ */
+typedef enum {
+	SCCP_MANAGER_EVENT_DEVICESTATUS,
+	SCCP_MANAGER_EVENT_PEERSTATUS,
+	SCCP_MANAGER_EVENT_DND,
+	SCCP_MANAGER_EVENT_CALLFORWARD,
+	SCCP_MANAGER_EVENT_SENTINEL,
+} sccp_manager_event_type_t;
+
+static const char *const sccp_manager_event_names[SCCP_MANAGER_EVENT_SENTINEL] = {
+	"DeviceStatus",
+	"PeerStatus",
+	"DND",
+	"CallForward",
+};
+
+typedef struct sccp_manager_pending sccp_manager_pending_t;
+struct sccp_manager_pending {
+	sccp_manager_event_type_t type;
+	const char *status;											/*!< static status string, used to group summaries */
+	char key[StationMaxDeviceNameSize + StationMaxNameSize + 16];						/*!< object the event is about */
+	char *body;
+	sccp_manager_pending_t *bucketNext;
+	sccp_manager_pending_t *next;
+};
+
+static struct {
+	sccp_manager_pending_t *buckets[SCCP_MANAGER_BATCH_BUCKETS];						/*!< pending events by object key */
+	sccp_manager_pending_t *first;										/*!< pending events in arrival order */
+	sccp_manager_pending_t *last;
+	int schedId;
+	boolean_t running;
+	volatile int received[SCCP_MANAGER_EVENT_SENTINEL];
+	volatile int emitted[SCCP_MANAGER_EVENT_SENTINEL];
+	volatile int coalesced[SCCP_MANAGER_EVENT_SENTINEL];
+	volatile int summarized[SCCP_MANAGER_EVENT_SENTINEL];
+	volatile int summaries[SCCP_MANAGER_EVENT_SENTINEL];
+} sccp_manager_batch = {
+	.schedId = -1,
+};
+
+AST_MUTEX_DEFINE_STATIC(sccp_manager_batchLock);
+
+static uint32_t sccp_manager_hashKey(sccp_manager_event_type_t type, const char *key)
+{
+	uint32_t hash = 5381 + type;
+
+	for (; *key; key++) {
+		hash = ((hash << 5) + hash) + (unsigned char) *key;
+	}
+	return hash % SCCP_MANAGER_BATCH_BUCKETS;
+}
+
+/* emitter used by sccp_manager_emitBatch, summarized is the number of events a summary stands for (0 for a single event) */
+typedef void (*sccp_manager_emit_cb_t) (sccp_manager_event_type_t type, const char *event, const char *body, int summarized);
+
+/* send an event to the manager and count it */
+static void sccp_manager_sendEvent(sccp_manager_event_type_t type, const char *event, const char *body, int summarized)
+{
+	manager_event(EVENT_FLAG_CALL, event, "%s", body);
+	if (summarized) {
+		ATOMIC_INCR(&sccp_manager_batch.summaries[type], 1, &sccp_manager_batchLock);
+		ATOMIC_INCR(&sccp_manager_batch.summarized[type], summarized, &sccp_manager_batchLock);
+	} else {
+		ATOMIC_INCR(&sccp_manager_batch.emitted[type], 1, &sccp_manager_batchLock);
+	}
+}
+
+/* send the pending events, replacing groups of at least threshold events of the same type/status by a summary listing the objects of the group */
+static void sccp_manager_emitBatch(sccp_manager_pending_t * pending, uint window, int threshold, sccp_manager_emit_cb_t emit)
+{
+	struct {
+		sccp_manager_event_type_t type;
+		const char *status;
+		int count;
+		struct ast_str *objects;									/*!< comma separated keys, NULL if the group can not be summarized */
+	} groups[SCCP_MANAGER_BATCH_GROUPS];
+	sccp_manager_pending_t *event = NULL;
+	struct ast_str *summary = NULL;
+	int ngroups = 0;
+	int idx = 0;
+
+	memset(groups, 0, sizeof(groups));
+	for (event = pending; event && threshold; event = event->next) {
+		for (idx = 0; idx < ngroups && (groups[idx].type != event->type || !sccp_strequals(groups[idx].status, event->status)); idx++);
+		if (idx == ngroups) {
+			if (ngroups == SCCP_MANAGER_BATCH_GROUPS) {
+				continue;
+			}
+			groups[ngroups].type = event->type;
+			groups[ngroups].status = event->status;
+			groups[ngroups].objects = pbx_str_create(SCCP_MANAGER_EVENT_BODYSIZE);
+			ngroups++;
+		}
+		if (groups[idx].objects) {
+			pbx_str_append(&groups[idx].objects, 0, "%s%s", groups[idx].count ? "," : "", event->key);
+		}
+		groups[idx].count++;
+	}
+	for (idx = 0; idx < ngroups; idx++) {
+		if (groups[idx].objects && groups[idx].count >= threshold) {
+			if (!(summary = pbx_str_create(SCCP_MANAGER_EVENT_BODYSIZE))) {				/* the group is sent event by event instead */
+				sccp_free(groups[idx].objects);
+				groups[idx].objects = NULL;
+				continue;
+			}
+			pbx_str_append(&summary, 0, "ChannelType: SCCP\r\nSummaryOf: %s\r\nStatus: %s\r\nCount: %d\r\nWindow: %u\r\nObjects: %s\r\n",
+				sccp_manager_event_names[groups[idx].type], groups[idx].status, groups[idx].count, window, pbx_str_buffer(groups[idx].objects));
+			emit(groups[idx].type, "SCCPEventSummary", pbx_str_buffer(summary), groups[idx].count);
+			sccp_free(summary);
+		}
+	}
+
+	while ((event = pending)) {
+		pending = event->next;
+		for (idx = 0; idx < ngroups && (groups[idx].type != event->type || !sccp_strequals(groups[idx].status, event->status)); idx++);
+		if (idx == ngroups || !groups[idx].objects || groups[idx].count < threshold) {
+			emit(event->type, sccp_manager_event_names[event->type], event->body, 0);
+		}
+		sccp_free(event->body);
+		sccp_free(event);
+	}
+	for (idx = 0; idx < ngroups; idx++) {
+		if (groups[idx].objects) {
+			sccp_free(groups[idx].objects);
+		}
+	}
+}
+
+/* detach the pending events, has to be called with sccp_manager_batchLock held */
+static sccp_manager_pending_t *sccp_manager_takeBatch(void)
+{
+	sccp_manager_pending_t *pending = sccp_manager_batch.first;
+
+	memset(sccp_manager_batch.buckets, 0, sizeof(sccp_manager_batch.buckets));
+	sccp_manager_batch.first = sccp_manager_batch.last = NULL;
+	return pending;
+}
+
+static int sccp_manager_flushTask(const void *data)
+{
+	sccp_manager_pending_t *pending = NULL;
+
+	pbx_mutex_lock(&sccp_manager_batchLock);
+	sccp_manager_batch.schedId = -1;
+	pending = sccp_manager_takeBatch();
+	pbx_mutex_unlock(&sccp_manager_batchLock);
+
+	sccp_manager_emitBatch(pending, GLOB(manager_event_window), GLOB(manager_event_summary), sccp_manager_sendEvent);
+	return 0;
+}
+
+/* queue an event, replacing a pending one for the same object, returns FALSE if it has to be sent directly */
+static boolean_t sccp_manager_queueEvent(sccp_manager_event_type_t type, const char *key, const char *status, const char *body)
+{
+	sccp_manager_pending_t *event = NULL;
+	char *copy = NULL;
+	uint32_t hash = sccp_manager_hashKey(type, key);
+	uint window = GLOB(manager_event_window) ? GLOB(manager_event_window) : SCCP_MANAGER_EVENT_WINDOW;
+
+	if (!(copy = pbx_strdup(body))) {
+		return FALSE;
+	}
+	pbx_mutex_lock(&sccp_manager_batchLock);
+	if (!sccp_manager_batch.running) {
+		pbx_mutex_unlock(&sccp_manager_batchLock);
+		sccp_free(copy);
+		return FALSE;
+	}
+	for (event = sccp_manager_batch.buckets[hash]; event && (event->type != type || !sccp_strequals(event->key, key)); event = event->bucketNext);
+	if (event) {
+		sccp_free(event->body);
+		event->body = copy;
+		event->status = status;
+		pbx_mutex_unlock(&sccp_manager_batchLock);
+		ATOMIC_INCR(&sccp_manager_batch.coalesced[type], 1, &sccp_manager_batchLock);
+		return TRUE;
+	}
+	if (!(event = sccp_calloc(sizeof(sccp_manager_pending_t), 1))) {
+		pbx_mutex_unlock(&sccp_manager_batchLock);
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		sccp_free(copy);
+		return FALSE;
+	}
+	event->type = type;
+	event->status = status;
+	sccp_copy_string(event->key, key, sizeof(event->key));
+	event->body = copy;
+	event->bucketNext = sccp_manager_batch.buckets[hash];
+	sccp_manager_batch.buckets[hash] = event;
+	if (sccp_manager_batch.last) {
+		sccp_manager_batch.last->next = event;
+	} else {
+		sccp_manager_batch.first = event;
+	}
+	sccp_manager_batch.last = event;
+	if (sccp_manager_batch.schedId < 0 && (sccp_manager_batch.schedId = iPbx.sched_add(window, sccp_manager_flushTask, NULL)) < 0) {
+		pbx_log(LOG_ERROR, "SCCP: (manager) unable to schedule the event batch, sending it now\n");
+		event = sccp_manager_takeBatch();
+		pbx_mutex_unlock(&sccp_manager_batchLock);
+		sccp_manager_emitBatch(event, 0, GLOB(manager_event_summary), sccp_manager_sendEvent);
+		return TRUE;
+	}
+	pbx_mutex_unlock(&sccp_manager_batchLock);
+	return TRUE;
+}
+
+/* post a manager event about the object identified by key, either directly or through the batch */
+static void __attribute__ ((format(printf, 4, 5))) sccp_manager_postEvent(sccp_manager_event_type_t type, const char *key, const char *status, const char *fmt, ...)
+{
+	char *body = NULL;
+	va_list ap;
+	int len = 0;
+
+	ATOMIC_INCR(&sccp_manager_batch.received[type], 1, &sccp_manager_batchLock);
+	va_start(ap, fmt);
+	len = sccp_vasprintf(&body, fmt, ap);
+	va_end(ap);
+	if (len < 0 || !body) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
+
+	if (!GLOB(manager_event_batching) || !sccp_manager_queueEvent(type, key, status, body)) {
+		sccp_manager_sendEvent(type, sccp_manager_event_names[type], body, 0);
+	}
+	sccp_free(body);
+}
+
+/*!
+ * \brief Show the manager event counters per event type
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_manager_show_events(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int type = 0;
+
+	if (!s) {
+		pbx_cli(fd, "Batching: %s, Window: %u ms, Summary at: %u events\n", GLOB(manager_event_batching) ? "on" : "off", GLOB(manager_event_window), GLOB(manager_event_summary));
+	}
+#define CLI_AMI_TABLE_NAME ManagerEvents
+#define CLI_AMI_TABLE_PER_ENTRY_NAME ManagerEvent
+#define CLI_AMI_TABLE_ITERATOR for(type = 0; type < SCCP_MANAGER_EVENT_SENTINEL; type++)
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Event,		"-14.14",	s,	14,	sccp_manager_event_names[type])					\
+ 		CLI_AMI_TABLE_FIELD(Received,		"10",		d,	10,	ATOMIC_FETCH(&sccp_manager_batch.received[type], &sccp_manager_batchLock))	\
+ 		CLI_AMI_TABLE_FIELD(Emitted,		"10",		d,	10,	ATOMIC_FETCH(&sccp_manager_batch.emitted[type], &sccp_manager_batchLock))	\
+ 		CLI_AMI_TABLE_FIELD(Coalesced,		"10",		d,	10,	ATOMIC_FETCH(&sccp_manager_batch.coalesced[type], &sccp_manager_batchLock))	\
+ 		CLI_AMI_TABLE_FIELD(Summarized,		"10",		d,	10,	ATOMIC_FETCH(&sccp_manager_batch.summarized[type], &sccp_manager_batchLock))	\
+ 		CLI_AMI_TABLE_FIELD(Summaries,		"10",		d,	10,	ATOMIC_FETCH(&sccp_manager_batch.summaries[type], &sccp_manager_batchLock))
+#include "sccp_cli_table.h"
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
 /*!
  * \brief starting manager-module
  */
 void sccp_manager_module_start(void)
 {
+	pbx_mutex_lock(&sccp_manager_batchLock);
+	sccp_manager_batch.running = TRUE;
+	pbx_mutex_unlock(&sccp_manager_batchLock);
 	sccp_event_subscribe(SCCP_EVENT_DEVICE_ATTACHED | SCCP_EVENT_DEVICE_DETACHED | SCCP_EVENT_DEVICE_PREREGISTERED | SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED | SCCP_EVENT_FEATURE_CHANGED, sccp_manager_eventListener, TRUE);
 }
 
@@ -147,7 +430,22 @@ void sccp_manager_module_start(void)
  */
 void sccp_manager_module_stop(void)
 {
-	sccp_event_unsubscribe(SCCP_EVENT_DEVICE_ATTACHED | SCCP_EVENT_DEVICE_DETACHED | SCCP_EVENT_DEVICE_PREREGISTERED | SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED, sccp_manager_eventListener);
+	sccp_manager_pending_t *pending = NULL;
+	int schedId = -1;
+
+	sccp_event_unsubscribe(SCCP_EVENT_DEVICE_ATTACHED | SCCP_EVENT_DEVICE_DETACHED | SCCP_EVENT_DEVICE_PREREGISTERED | SCCP_EVENT_DEVICE_REGISTERED | SCCP_EVENT_DEVICE_UNREGISTERED | SCCP_EVENT_FEATURE_CHANGED, sccp_manager_eventListener);
+
+	/* send whatever is still waiting in the batch, the flush task takes the same lock, so it is unscheduled after unlocking */
+	pbx_mutex_lock(&sccp_manager_batchLock);
+	sccp_manager_batch.running = FALSE;
+	schedId = sccp_manager_batch.schedId;
+	sccp_manager_batch.schedId = -1;
+	pending = sccp_manager_takeBatch();
+	pbx_mutex_unlock(&sccp_manager_batchLock);
+	if (schedId > -1) {
+		SCCP_SCHED_DEL(schedId);
+	}
+	sccp_manager_emitBatch(pending, 0, GLOB(manager_event_summary), sccp_manager_sendEvent);
 }
 
 /*!
@@ -159,6 +457,7 @@ void sccp_manager_eventListener(const sccp_event_t * event)
 {
 	sccp_device_t *device = NULL;
 	sccp_linedevices_t *linedevice = NULL;
+	char key[StationMaxDeviceNameSize + StationMaxNameSize + 16];
 
 	if (!event) {
 		return;
@@ -166,24 +465,24 @@ void sccp_manager_eventListener(const sccp_event_t * event)
 	switch (event->type) {
 		case SCCP_EVENT_DEVICE_REGISTERED:
 			device = event->event.deviceRegistered.device;						// already retained in the event
-			manager_event(EVENT_FLAG_CALL, "DeviceStatus", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "REGISTERED", DEV_ID_LOG(device));
+			sccp_manager_postEvent(SCCP_MANAGER_EVENT_DEVICESTATUS, DEV_ID_LOG(device), "REGISTERED", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "REGISTERED", DEV_ID_LOG(device));
 			break;
 
 		case SCCP_EVENT_DEVICE_UNREGISTERED:
 			device = event->event.deviceRegistered.device;						// already retained in the event
-			manager_event(EVENT_FLAG_CALL, "DeviceStatus", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "UNREGISTERED", DEV_ID_LOG(device));
+			sccp_manager_postEvent(SCCP_MANAGER_EVENT_DEVICESTATUS, DEV_ID_LOG(device), "UNREGISTERED", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "UNREGISTERED", DEV_ID_LOG(device));
 			break;
 
 		case SCCP_EVENT_DEVICE_PREREGISTERED:
 			device = event->event.deviceRegistered.device;						// already retained in the event
-			manager_event(EVENT_FLAG_CALL, "DeviceStatus", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "PREREGISTERED", DEV_ID_LOG(device));
+			sccp_manager_postEvent(SCCP_MANAGER_EVENT_DEVICESTATUS, DEV_ID_LOG(device), "PREREGISTERED", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nDeviceStatus: %s\r\nSCCPDevice: %s\r\n", "PREREGISTERED", DEV_ID_LOG(device));
 			break;
 
 		case SCCP_EVENT_DEVICE_ATTACHED:
 			device = event->event.deviceAttached.linedevice->device;				// already retained in the event
 			linedevice = event->event.deviceAttached.linedevice;					// already retained in the event
-			manager_event(EVENT_FLAG_CALL,
-				      "PeerStatus",
+			snprintf(key, sizeof(key), "%s/%s", DEV_ID_LOG(device), linedevice && linedevice->line ? linedevice->line->name : "(null)");
+			sccp_manager_postEvent(SCCP_MANAGER_EVENT_PEERSTATUS, key, "ATTACHED",
 				      "ChannelType: SCCP\r\nChannelObjectType: DeviceLine\r\nPeerStatus: %s\r\nSCCPDevice: %s\r\nSCCPLine: %s\r\nSCCPLineName: %s\r\nSubscriptionId: %s\r\nSubscriptionName: %s\r\n",
 				      "ATTACHED", DEV_ID_LOG(device), linedevice && linedevice->line ? linedevice->line->name : "(null)", (linedevice && linedevice->line && linedevice->line->label) ? linedevice->line->label : "(null)", linedevice->subscriptionId.number, linedevice->subscriptionId.name);
 			break;
@@ -191,8 +490,8 @@ void sccp_manager_eventListener(const sccp_event_t * event)
 		case SCCP_EVENT_DEVICE_DETACHED:
 			device = event->event.deviceAttached.linedevice->device;				// already retained in the event
 			linedevice = event->event.deviceAttached.linedevice;					// already retained in the event
-			manager_event(EVENT_FLAG_CALL,
-				      "PeerStatus",
+			snprintf(key, sizeof(key), "%s/%s", DEV_ID_LOG(device), linedevice && linedevice->line ? linedevice->line->name : "(null)");
+			sccp_manager_postEvent(SCCP_MANAGER_EVENT_PEERSTATUS, key, "DETACHED",
 				      "ChannelType: SCCP\r\nChannelObjectType: DeviceLine\r\nPeerStatus: %s\r\nSCCPDevice: %s\r\nSCCPLine: %s\r\nSCCPLineName: %s\r\nSubscriptionId: %s\r\nSubscriptionName: %s\r\n",
 				      "DETACHED", DEV_ID_LOG(device), linedevice && linedevice->line ? linedevice->line->name : "(null)", (linedevice && linedevice->line && linedevice->line->label) ? linedevice->line->label : "(null)", linedevice->subscriptionId.number, linedevice->subscriptionId.name);
 			break;
@@ -204,20 +503,23 @@ void sccp_manager_eventListener(const sccp_event_t * event)
 
 			switch (featureType) {
 				case SCCP_FEATURE_DND:
-					manager_event(EVENT_FLAG_CALL, "DND", "ChannelType: SCCP\r\nChannelObjectType: Device\r\nFeature: %s\r\nStatus: %s\r\nSCCPDevice: %s\r\n", sccp_feature_type2str(SCCP_FEATURE_DND), sccp_dndmode2str(device->dndFeature.status), DEV_ID_LOG(device));
+					sccp_manager_postEvent(SCCP_MANAGER_EVENT_DND, DEV_ID_LOG(device), sccp_dndmode2str(device->dndFeature.status), "ChannelType: SCCP\r\nChannelObjectType: Device\r\nFeature: %s\r\nStatus: %s\r\nSCCPDevice: %s\r\n", sccp_feature_type2str(SCCP_FEATURE_DND), sccp_dndmode2str(device->dndFeature.status), DEV_ID_LOG(device));
 					break;
 				case SCCP_FEATURE_CFWDALL:
 				case SCCP_FEATURE_CFWDBUSY:
 					if (linedevice) {
-						manager_event(EVENT_FLAG_CALL,
-							      "CallForward",
+						const char *status = (SCCP_FEATURE_CFWDALL == featureType) ? ((linedevice->cfwdAll.enabled) ? "On" : "Off") : ((linedevice->cfwdBusy.enabled) ? "On" : "Off");
+
+						snprintf(key, sizeof(key), "%s/%s/%s", DEV_ID_LOG(device), (linedevice->line) ? linedevice->line->name : "(null)", sccp_feature_type2str(featureType));
+						sccp_manager_postEvent(SCCP_MANAGER_EVENT_CALLFORWARD, key, status,
 							      "ChannelType: SCCP\r\nChannelObjectType: DeviceLine\r\nFeature: %s\r\nStatus: %s\r\nExtension: %s\r\nSCCPLine: %s\r\nSCCPDevice: %s\r\n",
-							      sccp_feature_type2str(featureType), (SCCP_FEATURE_CFWDALL == featureType) ? ((linedevice->cfwdAll.enabled) ? "On" : "Off") : ((linedevice->cfwdBusy.enabled) ? "On" : "Off"), (SCCP_FEATURE_CFWDALL == featureType) ? linedevice->cfwdAll.number : linedevice->cfwdBusy.number, (linedevice->line) ? linedevice->line->name : "(null)", DEV_ID_LOG(device)
+							      sccp_feature_type2str(featureType), status, (SCCP_FEATURE_CFWDALL == featureType) ? linedevice->cfwdAll.number : linedevice->cfwdBusy.number, (linedevice->line) ? linedevice->line->name : "(null)", DEV_ID_LOG(device)
 						    );
 					}
 					break;
 				case SCCP_FEATURE_CFWDNONE:
-					manager_event(EVENT_FLAG_CALL, "CallForward", "ChannelType: SCCP\r\nChannelObjectType: DeviceLine\r\nFeature: %s\r\nStatus: Off\r\nSCCPLine: %s\r\nSCCPDevice: %s\r\n", sccp_feature_type2str(featureType), (linedevice && linedevice->line) ? linedevice->line->name : "(null)", DEV_ID_LOG(device));
+					snprintf(key, sizeof(key), "%s/%s/%s", DEV_ID_LOG(device), (linedevice && linedevice->line) ? linedevice->line->name : "(null)", sccp_feature_type2str(featureType));
+					sccp_manager_postEvent(SCCP_MANAGER_EVENT_CALLFORWARD, key, "Off", "ChannelType: SCCP\r\nChannelObjectType: DeviceLine\r\nFeature: %s\r\nStatus: Off\r\nSCCPLine: %s\r\nSCCPDevice: %s\r\n", sccp_feature_type2str(featureType), (linedevice && linedevice->line) ? linedevice->line->name : "(null)", DEV_ID_LOG(device));
 					break;
 				default:
 					break;
@@ -1067,5 +1369,117 @@ char * sccp_manager_retrieve_parkedcalls_cxml(char ** out)
 }
 #endif
 #endif														// HAVE_PBX_MANAGER_HOOK_H
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+static struct {
+	int emitted[SCCP_MANAGER_EVENT_SENTINEL];
+	int summarized[SCCP_MANAGER_EVENT_SENTINEL];
+	int summaries[SCCP_MANAGER_EVENT_SENTINEL];
+	char lastSummary[SCCP_MANAGER_EVENT_BODYSIZE];
+} sccp_manager_batch_test;
+
+/* stands in for sccp_manager_sendEvent, nothing reaches the manager listeners or the live counters */
+static void sccp_manager_testEmit(sccp_manager_event_type_t type, const char *event, const char *body, int summarized)
+{
+	if (summarized) {
+		sccp_manager_batch_test.summaries[type]++;
+		sccp_manager_batch_test.summarized[type] += summarized;
+		sccp_copy_string(sccp_manager_batch_test.lastSummary, body, sizeof(sccp_manager_batch_test.lastSummary));
+	} else {
+		sccp_manager_batch_test.emitted[type]++;
+	}
+}
+
+/* append an event to a pending list built by the test, the same way sccp_manager_queueEvent does for the live batch */
+static boolean_t sccp_manager_testAppend(sccp_manager_pending_t ** first, sccp_manager_pending_t ** last, sccp_manager_event_type_t type, const char *key, const char *status)
+{
+	sccp_manager_pending_t *event = NULL;
+
+	if (!(event = sccp_calloc(sizeof(sccp_manager_pending_t), 1)) || !(event->body = pbx_strdup(key))) {
+		if (event) {
+			sccp_free(event);
+		}
+		return FALSE;
+	}
+	event->type = type;
+	event->status = status;
+	sccp_copy_string(event->key, key, sizeof(event->key));
+	if (*last) {
+		(*last)->next = event;
+	} else {
+		*first = event;
+	}
+	*last = event;
+	return TRUE;
+}
+
+AST_TEST_DEFINE(sccp_manager_batch_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "batch";
+			info->category = "/channels/chan_sccp/manager/";
+			info->summary = "chan-sccp-b manager event batching";
+			info->description = "emit locally built batches and verify which events are sent one by one and which are summarized";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	sccp_manager_pending_t *first = NULL;
+	sccp_manager_pending_t *last = NULL;
+	enum ast_test_result_state res = AST_TEST_PASS;
+	char key[32];
+	int n = 0;
+
+	pbx_test_status_update(test, "Emit 20 dnd changes and 3 call forward changes with a summary threshold of 10...\n");
+	memset(&sccp_manager_batch_test, 0, sizeof(sccp_manager_batch_test));
+	for (n = 0; n < 20; n++) {
+		snprintf(key, sizeof(key), "TESTSEP%04d", n);
+		sccp_manager_testAppend(&first, &last, SCCP_MANAGER_EVENT_DND, key, "Silent");
+	}
+	for (n = 0; n < 3; n++) {
+		snprintf(key, sizeof(key), "TESTLINE%d@TESTSEP0000", n);
+		sccp_manager_testAppend(&first, &last, SCCP_MANAGER_EVENT_CALLFORWARD, key, "All");
+	}
+	sccp_manager_emitBatch(first, 500, 10, sccp_manager_testEmit);
+	if (sccp_manager_batch_test.summaries[SCCP_MANAGER_EVENT_DND] != 1 || sccp_manager_batch_test.summarized[SCCP_MANAGER_EVENT_DND] != 20 || sccp_manager_batch_test.emitted[SCCP_MANAGER_EVENT_DND] != 0) {
+		pbx_test_status_update(test, "dnd changes were not summarized\n");
+		res = AST_TEST_FAIL;
+	}
+	if (!strstr(sccp_manager_batch_test.lastSummary, "Count: 20\r\nWindow: 500\r\nObjects: TESTSEP0000,TESTSEP0001,")) {
+		pbx_test_status_update(test, "unexpected summary '%s'\n", sccp_manager_batch_test.lastSummary);
+		res = AST_TEST_FAIL;
+	}
+	if (sccp_manager_batch_test.emitted[SCCP_MANAGER_EVENT_CALLFORWARD] != 3 || sccp_manager_batch_test.summaries[SCCP_MANAGER_EVENT_CALLFORWARD] != 0) {
+		pbx_test_status_update(test, "call forward changes were not sent one by one\n");
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Emit the same batch with summaries disabled...\n");
+	memset(&sccp_manager_batch_test, 0, sizeof(sccp_manager_batch_test));
+	first = last = NULL;
+	for (n = 0; n < 20; n++) {
+		snprintf(key, sizeof(key), "TESTSEP%04d", n);
+		sccp_manager_testAppend(&first, &last, SCCP_MANAGER_EVENT_DND, key, "Silent");
+	}
+	sccp_manager_emitBatch(first, 500, 0, sccp_manager_testEmit);
+	if (sccp_manager_batch_test.emitted[SCCP_MANAGER_EVENT_DND] != 20 || sccp_manager_batch_test.summaries[SCCP_MANAGER_EVENT_DND] != 0) {
+		pbx_test_status_update(test, "dnd changes were summarized\n");
+		res = AST_TEST_FAIL;
+	}
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_manager_batch_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_manager_batch_tests);
+}
+#endif
 #endif														// CS_SCCP_MANAGER
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -6,6 +6,7 @@
  *              See the LICENSE file at the top of the source tree.
  */
 #pragma once
+#include "sccp_cli.h"
 
 #ifdef CS_SCCP_MANAGER
 __BEGIN_C_EXTERN__
@@ -15,10 +16,16 @@ __BEGIN_C_EXTERN__
  *  Created on: 22.11.2008
  *      Author: marcello
  */
+#define SCCP_MANAGER_EVENT_WINDOW 250										/* default manager_event_window in ms */
+#define SCCP_MANAGER_EVENT_BODYSIZE 512										/* initial size of a summary body (grows as needed) */
+#define SCCP_MANAGER_BATCH_BUCKETS 1024										/* hash buckets used to coalesce pending events per object */
+#define SCCP_MANAGER_BATCH_GROUPS 32										/* distinct event type/status combinations considered for summaries */
+
 SCCP_API int SCCP_CALL sccp_register_management(void);
 SCCP_API int SCCP_CALL sccp_unregister_management(void);
 SCCP_API void SCCP_CALL sccp_manager_module_start(void);
 SCCP_API void SCCP_CALL sccp_manager_module_stop(void);
+SCCP_API int SCCP_CALL sccp_manager_show_events(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 
 #if HAVE_PBX_MANAGER_HOOK_H
 SCCP_API boolean_t SCCP_CALL sccp_manager_action2str(const char *manager_command, char **outStr);
@@ -0,0 +1,540 @@
+/*!
+ * \file        sccp_metrics.c
+ * \brief       SCCP Metrics Export
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Machine readable counters, gauges and histograms in the prometheus text exposition format:
+ * - the registry below lists every metric family with a collector, which reads the current values from the owning module
+ *   (sessions, devices, messages, channels, threadpool, event bus, refcounted objects, send backlog) when the metrics are rendered
+ * - every metrics_interval seconds the rendered text is written to metrics_file (written to a temporary file and renamed, so that
+ *   the node_exporter textfile collector never reads a partial file), an empty metrics_file disables the dump
+ * - 'sccp show metrics' prints the same text, AMI SCCPShowMetrics returns the samples as a table
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_metrics.h"
+#include "sccp_buttontemplate.h"
+#include "sccp_channel.h"
+#include "sccp_device.h"
+#include "sccp_line.h"
+#include "sccp_session.h"
+#include "sccp_stats.h"
+#include "sccp_utils.h"
+#include <asterisk/paths.h>
+#include <fcntl.h>
+#include <asterisk/cli.h>
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_METRICS_LABELSIZE 128
+#define SCCP_METRICS_REFCOUNT_TYPES 16
+
+typedef enum {
+	SCCP_METRIC_COUNTER,
+	SCCP_METRIC_GAUGE,
+	SCCP_METRIC_HISTOGRAM,
+} sccp_metric_type_t;
+
+static const char *const sccp_metric_type2str[] = {
+	[SCCP_METRIC_COUNTER] = "counter",
+	[SCCP_METRIC_GAUGE] = "gauge",
+	[SCCP_METRIC_HISTOGRAM] = "histogram",
+};
+
+typedef struct sccp_metrics sccp_metrics_t;
+
+typedef struct sccp_metric {
+	const char *name;
+	sccp_metric_type_t type;
+	void (*const collect) (sccp_metrics_t * metrics);
+	const char *help;
+} sccp_metric_t;
+
+typedef struct sccp_metric_sample {
+	const sccp_metric_t *metric;
+	const char *suffix;											/* "", or _bucket/_sum/_count for histograms */
+	char labels[SCCP_METRICS_LABELSIZE];
+	double value;
+} sccp_metric_sample_t;
+
+struct sccp_metrics {
+	const sccp_metric_t *current;										/* family being collected */
+	sccp_metric_sample_t *samples;
+	int count;
+	int size;
+};
+
+/* histogram bucket bounds in microseconds, powers of two so that sccp_histogram_below is exact */
+static const uint32_t sccp_metrics_bounds[] = { 16, 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216 };
+
+static struct {
+	int schedId;
+	boolean_t running;
+	uint32_t written;
+	uint32_t failed;
+} sccp_metrics = {
+	.schedId = -1,
+};
+
+AST_MUTEX_DEFINE_STATIC(sccp_metrics_schedLock);
+
+/* =========================================================================================================== Samples == */
+static void __attribute__ ((format(printf, 4, 5))) sccp_metrics_add(sccp_metrics_t * metrics, const char *suffix, double value, const char *fmt, ...)
+{
+	sccp_metric_sample_t *sample = NULL;
+	va_list ap;
+
+	if (metrics->count == metrics->size) {
+		int size = metrics->size ? metrics->size * 2 : 128;
+
+		if (!(sample = sccp_realloc(metrics->samples, size * sizeof(sccp_metric_sample_t)))) {
+			return;
+		}
+		metrics->samples = sample;
+		metrics->size = size;
+	}
+	sample = &metrics->samples[metrics->count++];
+	sample->metric = metrics->current;
+	sample->suffix = suffix;
+	sample->value = value;
+	va_start(ap, fmt);
+	vsnprintf(sample->labels, sizeof(sample->labels), fmt, ap);
+	va_end(ap);
+}
+
+/* single sample without labels */
+static void sccp_metrics_addValue(sccp_metrics_t * metrics, double value)
+{
+	sccp_metrics_add(metrics, "", value, "%s", "");
+}
+
+/* cumulative buckets, sum and count of a microsecond histogram, exported in seconds */
+static void sccp_metrics_addHistogram(sccp_metrics_t * metrics, const char *labels, const sccp_histogram_t * histogram)
+{
+	const char *sep = sccp_strlen_zero(labels) ? "" : ",";
+	uint idx = 0;
+
+	for (idx = 0; idx < ARRAY_LEN(sccp_metrics_bounds); idx++) {
+		sccp_metrics_add(metrics, "_bucket", sccp_histogram_below(histogram, sccp_metrics_bounds[idx]), "%s%sle=\"%g\"", labels, sep, sccp_metrics_bounds[idx] / 1000000.0);
+	}
+	sccp_metrics_add(metrics, "_bucket", histogram->count, "%s%sle=\"+Inf\"", labels, sep);
+	sccp_metrics_add(metrics, "_sum", histogram->sum / 1000000.0, "%s", labels);
+	sccp_metrics_add(metrics, "_count", histogram->count, "%s", labels);
+}
+
+/* ======================================================================================================== Collectors == */
+static void sccp_metrics_sessions(sccp_metrics_t * metrics)
+{
+	sccp_metrics_addValue(metrics, sccp_session_getCount(NULL));
+}
+
+static void sccp_metrics_sendBacklog(sccp_metrics_t * metrics)
+{
+	uint32_t backlog = 0;
+
+	sccp_session_getCount(&backlog);
+	sccp_metrics_addValue(metrics, backlog);
+}
+
+static void sccp_metrics_devices(sccp_metrics_t * metrics)
+{
+	uint32_t states[SKINNY_REGISTRATIONSTATE_SENTINEL] = { 0 };
+	sccp_device_t *d = NULL;
+	skinny_registrationstate_t state = SKINNY_DEVICE_RS_FAILED;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(devices));
+	SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+		state = sccp_device_getRegistrationState(d);
+		if (state < SKINNY_REGISTRATIONSTATE_SENTINEL) {
+			states[state]++;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+	for (state = SKINNY_DEVICE_RS_FAILED; state < SKINNY_REGISTRATIONSTATE_SENTINEL; state++) {
+		sccp_metrics_add(metrics, "", states[state], "state=\"%s\"", skinny_registrationstate2str(state));
+	}
+}
+
+static void sccp_metrics_registrations(sccp_metrics_t * metrics)
+{
+	sccp_metrics_addValue(metrics, sccp_event_getFiredCount(SCCP_EVENT_DEVICE_REGISTERED));
+}
+
+static void sccp_metrics_messageCount(sccp_stats_direction_t direction, const char *message, const sccp_histogram_t * histogram, void *data)
+{
+	sccp_metrics_add((sccp_metrics_t *) data, "", histogram->count, "direction=\"%s\",message=\"%s\"", direction == SCCP_STATS_INBOUND ? "in" : "out", message);
+}
+
+static void sccp_metrics_messages(sccp_metrics_t * metrics)
+{
+	sccp_stats_visitMessages(sccp_metrics_messageCount, metrics);
+}
+
+static void sccp_metrics_messageMerge(sccp_stats_direction_t direction, const char *message, const sccp_histogram_t * histogram, void *data)
+{
+	sccp_histogram_merge(&((sccp_histogram_t *) data)[direction], histogram);
+}
+
+static void sccp_metrics_messageDuration(sccp_metrics_t * metrics)
+{
+	sccp_histogram_t merged[2] = { {0} };
+
+	sccp_stats_visitMessages(sccp_metrics_messageMerge, merged);
+	sccp_metrics_addHistogram(metrics, "direction=\"in\"", &merged[SCCP_STATS_INBOUND]);
+	sccp_metrics_addHistogram(metrics, "direction=\"out\"", &merged[SCCP_STATS_OUTBOUND]);
+}
+
+static void sccp_metrics_channels(sccp_metrics_t * metrics)
+{
+	sccp_line_t *l = NULL;
+	uint32_t channels = 0;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), l, list) {
+		channels += SCCP_LIST_GETSIZE(&l->channels);
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	sccp_metrics_addValue(metrics, channels);
+}
+
+static void sccp_metrics_channelsAllocated(sccp_metrics_t * metrics)
+{
+	sccp_metrics_addValue(metrics, sccp_channel_getAllocatedCount());
+}
+
+static void sccp_metrics_threadpoolThreads(sccp_metrics_t * metrics)
+{
+	sccp_metrics_addValue(metrics, GLOB(general_threadpool) ? sccp_threadpool_thread_count(GLOB(general_threadpool)) : 0);
+}
+
+static void sccp_metrics_threadpoolQueue(sccp_metrics_t * metrics)
+{
+	sccp_metrics_addValue(metrics, GLOB(general_threadpool) ? sccp_threadpool_jobqueue_count(GLOB(general_threadpool)) : 0);
+}
+
+static void sccp_metrics_events(sccp_metrics_t * metrics)
+{
+	sccp_event_type_t type = SCCP_EVENT_LINE_CREATED;
+
+	for (type = SCCP_EVENT_LINE_CREATED; type < SCCP_EVENT_TYPE_SENTINEL; type <<= 1) {
+		sccp_metrics_add(metrics, "", sccp_event_getFiredCount(type), "type=\"%s\"", sccp_event_type2str(type));
+	}
+}
+
+static void sccp_metrics_refcount(sccp_metrics_t * metrics)
+{
+	uint32_t counts[SCCP_METRICS_REFCOUNT_TYPES];
+	int types = sccp_refcount_countObjects(counts, SCCP_METRICS_REFCOUNT_TYPES);
+	int type = 0;
+
+	for (type = 1; type < types; type++) {
+		sccp_metrics_add(metrics, "", counts[type], "type=\"%s\"", sccp_refcount_type2str(type));
+	}
+}
+
+static void sccp_metrics_buttontemplates(sccp_metrics_t * metrics)
+{
+	sccp_buttontemplate_stats_t stats;
+
+	sccp_buttontemplate_getStats(&stats);
+	sccp_metrics_addValue(metrics, stats.entries);
+}
+
+static void sccp_metrics_buttontemplateLookups(sccp_metrics_t * metrics)
+{
+	sccp_buttontemplate_stats_t stats;
+
+	sccp_buttontemplate_getStats(&stats);
+	sccp_metrics_add(metrics, "", stats.hits, "result=\"%s\"", "hit");
+	sccp_metrics_add(metrics, "", stats.misses, "result=\"%s\"", "miss");
+	sccp_metrics_add(metrics, "", stats.uncacheable, "result=\"%s\"", "uncacheable");
+}
+
+static void sccp_metrics_buttontemplatesPurged(sccp_metrics_t * metrics)
+{
+	sccp_buttontemplate_stats_t stats;
+
+	sccp_buttontemplate_getStats(&stats);
+	sccp_metrics_addValue(metrics, stats.purged);
+}
+
+/*!
+ * \brief Metrics Registry, exported in this order
+ */
+static const sccp_metric_t sccp_metrics_registry[] = {
+	/* *INDENT-OFF* */
+	{"sccp_sessions",			SCCP_METRIC_GAUGE,	sccp_metrics_sessions,		"Open skinny sessions."},
+	{"sccp_session_send_backlog_bytes",	SCCP_METRIC_GAUGE,	sccp_metrics_sendBacklog,	"Bytes queued on the session sockets, not yet taken by the phones."},
+	{"sccp_devices",			SCCP_METRIC_GAUGE,	sccp_metrics_devices,		"Configured devices by registration state."},
+	{"sccp_registrations_total",		SCCP_METRIC_COUNTER,	sccp_metrics_registrations,	"Successful device registrations."},
+	{"sccp_messages_total",			SCCP_METRIC_COUNTER,	sccp_metrics_messages,		"Skinny messages handled (in) and sent (out) by message type."},
+	{"sccp_message_duration_seconds",	SCCP_METRIC_HISTOGRAM,	sccp_metrics_messageDuration,	"Time spent handling (in) and sending (out) skinny messages."},
+	{"sccp_channels",			SCCP_METRIC_GAUGE,	sccp_metrics_channels,		"Active channels."},
+	{"sccp_channels_allocated_total",	SCCP_METRIC_COUNTER,	sccp_metrics_channelsAllocated,	"Channels allocated."},
+	{"sccp_threadpool_threads",		SCCP_METRIC_GAUGE,	sccp_metrics_threadpoolThreads,	"Threads in the general threadpool."},
+	{"sccp_threadpool_queue_depth",		SCCP_METRIC_GAUGE,	sccp_metrics_threadpoolQueue,	"Jobs waiting in the general threadpool queue."},
+	{"sccp_events_total",			SCCP_METRIC_COUNTER,	sccp_metrics_events,		"Events fired on the event bus by type."},
+	{"sccp_refcount_objects",		SCCP_METRIC_GAUGE,	sccp_metrics_refcount,		"Refcounted objects by type."},
+	{"sccp_buttontemplates",		SCCP_METRIC_GAUGE,	sccp_metrics_buttontemplates,	"Resolved button templates in the cache."},
+	{"sccp_buttontemplate_lookups_total",	SCCP_METRIC_COUNTER,	sccp_metrics_buttontemplateLookups,	"Button template cache lookups by result."},
+	{"sccp_buttontemplates_purged_total",	SCCP_METRIC_COUNTER,	sccp_metrics_buttontemplatesPurged,	"Unused button templates dropped after reload."},
+	/* *INDENT-ON* */
+};
+
+static void sccp_metrics_collect(sccp_metrics_t * metrics)
+{
+	uint idx = 0;
+
+	for (idx = 0; idx < ARRAY_LEN(sccp_metrics_registry); idx++) {
+		metrics->current = &sccp_metrics_registry[idx];
+		sccp_metrics_registry[idx].collect(metrics);
+	}
+}
+
+/*!
+ * \brief Render all metrics in the prometheus text exposition format
+ * \return FALSE if the samples could not be collected
+ */
+boolean_t sccp_metrics_render(pbx_str_t ** buf)
+{
+	sccp_metrics_t metrics = { 0 };
+	const sccp_metric_t *metric = NULL;
+	sccp_metric_sample_t *sample = NULL;
+	int idx = 0;
+
+	sccp_metrics_collect(&metrics);
+	if (!metrics.samples) {
+		return FALSE;
+	}
+	for (idx = 0; idx < metrics.count; idx++) {
+		sample = &metrics.samples[idx];
+		if (sample->metric != metric) {
+			metric = sample->metric;
+			pbx_str_append(buf, 0, "# HELP %s %s\n# TYPE %s %s\n", metric->name, metric->help, metric->name, sccp_metric_type2str[metric->type]);
+		}
+		if (sccp_strlen_zero(sample->labels)) {
+			pbx_str_append(buf, 0, "%s%s %.15g\n", metric->name, sample->suffix, sample->value);
+		} else {
+			pbx_str_append(buf, 0, "%s%s{%s} %.15g\n", metric->name, sample->suffix, sample->labels, sample->value);
+		}
+	}
+	sccp_free(metrics.samples);
+	return TRUE;
+}
+
+/* ============================================================================================================== Dump == */
+static void sccp_metrics_write(void)
+{
+	char filename[PATH_MAX];
+	char tmpname[PATH_MAX + 16];
+	pbx_str_t *buf = NULL;
+	FILE *fp = NULL;
+	int fd = -1;
+	boolean_t ok = FALSE;
+
+	if (GLOB(metrics_file)[0] == '/') {
+		sccp_copy_string(filename, GLOB(metrics_file), sizeof(filename));
+	} else {
+		snprintf(filename, sizeof(filename), "%s/%s", ast_config_AST_LOG_DIR, GLOB(metrics_file));
+	}
+	snprintf(tmpname, sizeof(tmpname), "%s.%d", filename, (int) getpid());
+
+	if (!(buf = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE * 16))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
+	if (sccp_metrics_render(&buf)) {
+		unlink(tmpname);										/* left behind by a crash, never follow a link planted there */
+		if ((fd = open(tmpname, O_WRONLY | O_CREAT | O_EXCL, 0600)) >= 0 && !(fp = fdopen(fd, "w"))) {
+			close(fd);
+			unlink(tmpname);
+		}
+	}
+	if (fp) {
+		ok = fwrite(pbx_str_buffer(buf), 1, pbx_str_strlen(buf), fp) == pbx_str_strlen(buf);
+		ok = (fclose(fp) == 0) && ok;
+		if (ok && rename(tmpname, filename) != 0) {
+			ok = FALSE;
+		}
+		if (!ok) {
+			unlink(tmpname);
+		}
+	}
+	if (ok) {
+		sccp_metrics.written++;
+	} else if (!sccp_metrics.failed++) {									/* only report the first failure */
+		pbx_log(LOG_WARNING, "SCCP: (metrics) unable to write %s: %s\n", filename, strerror(errno));
+	}
+	sccp_free(buf);
+}
+
+static int sccp_metrics_dumpTask(const void *data)
+{
+	uint interval = GLOB(metrics_interval) ? GLOB(metrics_interval) : SCCP_METRICS_INTERVAL;
+
+	if (GLOB(module_running) && !sccp_strlen_zero(GLOB(metrics_file))) {
+		sccp_metrics_write();
+	}
+
+	/* reschedule my self, picking up a changed metrics_interval */
+	pbx_mutex_lock(&sccp_metrics_schedLock);
+	sccp_metrics.schedId = -1;
+	if (sccp_metrics.running && (sccp_metrics.schedId = iPbx.sched_add(interval * 1000, sccp_metrics_dumpTask, NULL)) < 0) {
+		pbx_log(LOG_ERROR, "SCCP: (metrics) unable to schedule the metrics dump\n");
+	}
+	pbx_mutex_unlock(&sccp_metrics_schedLock);
+	return 0;
+}
+
+void sccp_metrics_module_start(void)
+{
+	pbx_mutex_lock(&sccp_metrics_schedLock);
+	sccp_metrics.running = TRUE;
+	sccp_metrics.written = 0;
+	sccp_metrics.failed = 0;
+	if (sccp_metrics.schedId < 0 && (sccp_metrics.schedId = iPbx.sched_add(SCCP_METRICS_INTERVAL * 1000, sccp_metrics_dumpTask, NULL)) < 0) {
+		pbx_log(LOG_ERROR, "SCCP: (metrics) unable to schedule the metrics dump\n");
+	}
+	pbx_mutex_unlock(&sccp_metrics_schedLock);
+}
+
+void sccp_metrics_module_stop(void)
+{
+	int schedId = -1;
+
+	/* the dump task takes the same lock to reschedule itself, so it is unscheduled after unlocking */
+	pbx_mutex_lock(&sccp_metrics_schedLock);
+	sccp_metrics.running = FALSE;
+	schedId = sccp_metrics.schedId;
+	sccp_metrics.schedId = -1;
+	pbx_mutex_unlock(&sccp_metrics_schedLock);
+	if (schedId > -1) {
+		SCCP_SCHED_DEL(schedId);
+	}
+}
+
+/* =============================================================================================================== CLI == */
+/*!
+ * \brief Show the metrics, as exposition text (CLI) or as a table of samples (AMI)
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_metrics_show(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+
+	if (!s) {
+		pbx_str_t *buf = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE * 16);
+
+		if (!buf || !sccp_metrics_render(&buf)) {
+			if (buf) {
+				sccp_free(buf);
+			}
+			CLI_AMI_RETURN_ERROR(fd, s, m, "Unable to collect the metrics %s\n", "");			/* explicit return */
+		}
+		pbx_cli(fd, "%s", pbx_str_buffer(buf));
+		if (!sccp_strlen_zero(GLOB(metrics_file))) {
+			pbx_cli(fd, "# dumped to %s every %us, %u written, %u failed\n", GLOB(metrics_file), GLOB(metrics_interval) ? GLOB(metrics_interval) : SCCP_METRICS_INTERVAL, sccp_metrics.written, sccp_metrics.failed);
+		}
+		sccp_free(buf);
+		return RESULT_SUCCESS;
+	}
+
+	sccp_metrics_t metrics = { 0 };
+	sccp_metric_sample_t *sample = NULL;
+	int idx = 0;
+
+	sccp_metrics_collect(&metrics);
+#define CLI_AMI_TABLE_NAME Metrics
+#define CLI_AMI_TABLE_PER_ENTRY_NAME Metric
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < metrics.count; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		sample = &metrics.samples[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Name,		"-40.40",	s,	40,	sample->metric->name)						\
+ 		CLI_AMI_TABLE_FIELD(Type,		"-9.9",		s,	9,	sccp_metric_type2str[sample->metric->type])			\
+ 		CLI_AMI_TABLE_FIELD(Suffix,		"-7.7",		s,	7,	sample->suffix)							\
+ 		CLI_AMI_TABLE_FIELD(Labels,		"-60.60",	s,	60,	sample->labels)							\
+ 		CLI_AMI_TABLE_FIELD(Value,		"15.15",	g,	15,	sample->value)
+#include "sccp_cli_table.h"
+	if (metrics.samples) {
+		sccp_free(metrics.samples);
+	}
+	totals->lines = local_line_total;
+	totals->tables = 1;
+	return RESULT_SUCCESS;
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_metrics_exposition_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "exposition";
+			info->category = "/channels/chan_sccp/metrics/";
+			info->summary = "chan-sccp-b metrics exposition test";
+			info->description = "samples are grouped per family with HELP/TYPE lines, histogram buckets are cumulative";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	static const sccp_metric_t family = { "sccp_test_seconds", SCCP_METRIC_HISTOGRAM, NULL, "test" };
+	sccp_metrics_t metrics = { 0 };
+	sccp_histogram_t histogram = { 0 };
+	double previous = 0;
+	int idx = 0;
+	pbx_str_t *buf = NULL;
+
+	pbx_test_status_update(test, "histogram samples...\n");
+	sccp_histogram_add(&histogram, 10);
+	sccp_histogram_add(&histogram, 64);
+	sccp_histogram_add(&histogram, 100);
+	sccp_histogram_add(&histogram, 100000);
+	metrics.current = &family;
+	sccp_metrics_addHistogram(&metrics, "direction=\"in\"", &histogram);
+	pbx_test_validate(test, metrics.count == (int) ARRAY_LEN(sccp_metrics_bounds) + 3);
+	for (idx = 0; idx < metrics.count - 2; idx++) {
+		pbx_test_validate(test, metrics.samples[idx].value >= previous);
+		previous = metrics.samples[idx].value;
+	}
+	pbx_test_validate(test, metrics.samples[0].value == 1);						/* le=16us: 10 */
+	pbx_test_validate(test, metrics.samples[1].value == 2);						/* le=64us: 10 and 64, the bound itself is included */
+	pbx_test_validate(test, metrics.samples[2].value == 3);						/* le=256us: 10, 64 and 100 */
+	pbx_test_validate(test, metrics.samples[metrics.count - 3].value == 4);				/* le=+Inf: all samples */
+	pbx_test_validate(test, !strcmp(metrics.samples[metrics.count - 1].suffix, "_count") && metrics.samples[metrics.count - 1].value == 4);
+	pbx_test_validate(test, !strcmp(metrics.samples[1].labels, "direction=\"in\",le=\"6.4e-05\""));
+	sccp_free(metrics.samples);
+
+	pbx_test_status_update(test, "render...\n");
+	if ((buf = pbx_str_create(DEFAULT_PBX_STR_BUFFERSIZE))) {
+		pbx_test_validate(test, sccp_metrics_render(&buf));
+		pbx_test_validate(test, strstr(pbx_str_buffer(buf), "# TYPE sccp_sessions gauge\nsccp_sessions ") != NULL);
+		pbx_test_validate(test, strstr(pbx_str_buffer(buf), "sccp_message_duration_seconds_bucket{direction=\"out\",le=\"+Inf\"}") != NULL);
+		sccp_free(buf);
+	}
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_metrics_exposition_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_metrics_exposition_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,19 @@
+/*!
+ * \file        sccp_metrics.h
+ * \brief       SCCP Metrics Export Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+#include "sccp_cli.h"
+
+#define SCCP_METRICS_INTERVAL 15										/* default metrics_interval in seconds */
+
+__BEGIN_C_EXTERN__
+SCCP_API void SCCP_CALL sccp_metrics_module_start(void);
+SCCP_API void SCCP_CALL sccp_metrics_module_stop(void);
+SCCP_API boolean_t SCCP_CALL sccp_metrics_render(pbx_str_t ** buf);
+SCCP_API int SCCP_CALL sccp_metrics_show(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -91,8 +91,23 @@ struct sccp_mailbox_subscriber_list {
 #else
 	int schedUpdate;
 #endif
+	sccp_mailbox_subscriber_list_t *hashnext;							/*!< next subscription in sccp_mailbox_index bucket */
+	int refcount;												/*!< list reference plus callers working on it unlocked, protected by sccp_mailbox_subscriptions lock */
 };																/*!< SCCP Mailbox Subscriber List Structure */
 
+/*!
+ * \brief SCCP MWI Pending Device Structure
+ *
+ * Devices affected by one or more mailbox events, waiting to be updated by the mwi batch processor.
+ * A device is only queued once, however many lines/mailboxes changed in the mean time.
+ */
+typedef struct sccp_mwi_pendingDevice sccp_mwi_pendingDevice_t;
+struct sccp_mwi_pendingDevice {
+	sccp_device_t *device;											/*!< retained device */
+	sccp_mwi_pendingDevice_t *hashnext;									/*!< next pending device in hash bucket */
+	SCCP_LIST_ENTRY (sccp_mwi_pendingDevice_t) list;
+};
+
 void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice);
 void sccp_mwi_destroySubscription(sccp_mailbox_subscriber_list_t *subscription);
 void sccp_mwi_linecreatedEvent(const sccp_event_t * event);
@@ -101,6 +116,83 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 void sccp_mwi_lineStatusChangedEvent(const sccp_event_t * event);
 
 static SCCP_LIST_HEAD (, sccp_mailbox_subscriber_list_t) sccp_mailbox_subscriptions;
+static sccp_mailbox_subscriber_list_t *sccp_mailbox_index[SCCP_HASH_PRIME];				/* mailbox@context -> subscription, protected by sccp_mailbox_subscriptions lock */
+
+/*!
+ * \brief devices waiting for an mwi update (batched / asynchronous delivery)
+ */
+static struct {
+	SCCP_LIST_HEAD (, sccp_mwi_pendingDevice_t) devices;
+	sccp_mwi_pendingDevice_t *index[SCCP_HASH_PRIME];						/* protected by devices list lock */
+	boolean_t scheduled;										/* batch processor has been scheduled */
+} sccp_mwi_pending;
+
+/*!
+ * \brief mwi statistics
+ */
+static struct {
+	sccp_mutex_t lock;
+	volatile int mailboxEvents;									/* mailbox events received from the pbx */
+	volatile int devicesQueued;									/* devices queued for update */
+	volatile int devicesCoalesced;									/* device updates merged into an already pending update */
+	volatile int batches;										/* batch processor runs */
+	volatile int lampMessages;									/* SetLampMessages sent to devices */
+	volatile int cacheHits;										/* initial values served from the mwi cache */
+	volatile int cacheMisses;									/* initial values fetched from the pbx one by one */
+} sccp_mwi_stats;
+
+/*!
+ * \brief SCCP MWI Cache Entry Structure
+ *
+ * last known message counts for one mailbox@context
+ */
+typedef struct sccp_mwi_cacheEntry sccp_mwi_cacheEntry_t;
+struct sccp_mwi_cacheEntry {
+	char mailbox[60];
+	char context[60];
+	int newmsgs;												/*!< New Messages */
+	int oldmsgs;												/*!< Old Messages */
+	boolean_t valid;											/*!< counts have been fetched / received */
+	sccp_mwi_cacheEntry_t *hashnext;									/*!< next entry in cache bucket */
+};
+
+typedef struct sccp_mwi_cache sccp_mwi_cache_t;
+
+/*!
+ * \brief SCCP MWI Provider Structure
+ *
+ * Source of mailbox message counts used to fill the mwi cache. bulkFetch is optional and hands every
+ * mailbox state it knows about to sccp_mwi_cacheFill in one pass, fetch is used for whatever is left.
+ */
+typedef struct sccp_mwi_provider {
+	const char *const name;
+	int (*const bulkFetch)(sccp_mwi_cache_t *cache);
+	boolean_t (*const fetch)(const char *mailbox, const char *context, int *newmsgs, int *oldmsgs);
+} sccp_mwi_provider_t;
+
+/*!
+ * \brief SCCP MWI Cache Structure
+ */
+struct sccp_mwi_cache {
+	sccp_mutex_t lock;
+	const sccp_mwi_provider_t *provider;
+	sccp_mwi_cacheEntry_t *index[SCCP_HASH_PRIME];							/* protected by lock */
+	int entries;
+};
+
+static sccp_mwi_cache_t sccp_mwi_cache;									/* shared mwi cache, filled by sccp_mwi_primeCache */
+static boolean_t sccp_mwi_primed;									/* protected by sccp_mailbox_subscriptions lock */
+
+#define SCCP_MWI_STAT_INCR(_counter) (void) ATOMIC_INCR(&sccp_mwi_stats._counter, 1, &sccp_mwi_stats.lock)
+#define SCCP_MWI_DEVICE_HASH(_d) (((uintptr_t)(_d)) % SCCP_HASH_PRIME)
+
+static void sccp_mwi_queueDeviceUpdate(sccp_device_t * device);
+static void sccp_mwi_schedulePendingUpdates(void);
+static void sccp_mwi_cacheInit(sccp_mwi_cache_t *cache, const sccp_mwi_provider_t *provider);
+static void sccp_mwi_cacheDestroy(sccp_mwi_cache_t *cache);
+static void sccp_mwi_cacheUpdate(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int newmsgs, int oldmsgs);
+static void sccp_mwi_cacheRemove(sccp_mwi_cache_t *cache, const char *mailbox, const char *context);
+static boolean_t sccp_mwi_cacheGet(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int *newmsgs, int *oldmsgs);
 
 /*!
  * start mwi module.
@@ -108,6 +200,14 @@ static SCCP_LIST_HEAD (, sccp_mailbox_subscriber_list_t) sccp_mailbox_subscripti
 void sccp_mwi_module_start(void)
 {
 	SCCP_LIST_HEAD_INIT(&sccp_mailbox_subscriptions);
+	memset(sccp_mailbox_index, 0, sizeof(sccp_mailbox_index));
+	SCCP_LIST_HEAD_INIT(&sccp_mwi_pending.devices);
+	memset(sccp_mwi_pending.index, 0, sizeof(sccp_mwi_pending.index));
+	sccp_mwi_pending.scheduled = FALSE;
+	memset(&sccp_mwi_stats, 0, sizeof(sccp_mwi_stats));
+	pbx_mutex_init(&sccp_mwi_stats.lock);
+	sccp_mwi_cacheInit(&sccp_mwi_cache, NULL);
+	sccp_mwi_primed = FALSE;
 	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_2 "SCCP: Starting MWI system\n");
 
 	sccp_event_subscribe(SCCP_EVENT_LINE_CREATED, sccp_mwi_linecreatedEvent, TRUE);
@@ -129,10 +229,92 @@ void sccp_mwi_module_stop(void)
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
 	while ((subscription = SCCP_LIST_REMOVE_HEAD(&sccp_mailbox_subscriptions, list))) {
-		sccp_mwi_destroySubscription(subscription);
+		if (--subscription->refcount == 0) {
+			sccp_mwi_destroySubscription(subscription);
+		}
 	}
+	memset(sccp_mailbox_index, 0, sizeof(sccp_mailbox_index));
+	sccp_mwi_primed = FALSE;
 	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 	SCCP_LIST_HEAD_DESTROY(&sccp_mailbox_subscriptions);
+	sccp_mwi_cacheDestroy(&sccp_mwi_cache);
+
+	/* drop pending updates, a running batch processor will find the list empty */
+	sccp_mwi_pendingDevice_t *pending = NULL;
+	SCCP_LIST_LOCK(&sccp_mwi_pending.devices);
+	while ((pending = SCCP_LIST_REMOVE_HEAD(&sccp_mwi_pending.devices, list))) {
+		sccp_device_release(&pending->device);						/* explicit release */
+		sccp_free(pending);
+	}
+	memset(sccp_mwi_pending.index, 0, sizeof(sccp_mwi_pending.index));
+	SCCP_LIST_UNLOCK(&sccp_mwi_pending.devices);
+}
+
+/*!
+ * \brief Calculate the sccp_mailbox_index bucket for mailbox@context
+ */
+static gcc_inline unsigned int sccp_mwi_hashMailbox(const char *mailbox, const char *context)
+{
+	return (sccp_str_case_hash(mailbox) * 31 + sccp_str_case_hash(context)) % SCCP_HASH_PRIME;
+}
+
+/*!
+ * \brief Find Mailbox Subscription using the mailbox index
+ * \note sccp_mailbox_subscriptions needs to be locked by the caller
+ */
+static sccp_mailbox_subscriber_list_t *sccp_mwi_findSubscription(const char *mailbox, const char *context)
+{
+	sccp_mailbox_subscriber_list_t *subscription = NULL;
+
+	for (subscription = sccp_mailbox_index[sccp_mwi_hashMailbox(mailbox, context)]; subscription; subscription = subscription->hashnext) {
+		if (sccp_strequals(mailbox, subscription->mailbox) && sccp_strequals(context, subscription->context)) {
+			break;
+		}
+	}
+	return subscription;
+}
+
+/*!
+ * \brief Remove Mailbox Subscription from the mailbox index
+ * \note sccp_mailbox_subscriptions needs to be locked by the caller
+ */
+static void sccp_mwi_unindexSubscription(sccp_mailbox_subscriber_list_t * subscription)
+{
+	sccp_mailbox_subscriber_list_t **prev = &sccp_mailbox_index[sccp_mwi_hashMailbox(subscription->mailbox, subscription->context)];
+
+	for (; *prev; prev = &(*prev)->hashnext) {
+		if (*prev == subscription) {
+			*prev = subscription->hashnext;
+			subscription->hashnext = NULL;
+			break;
+		}
+	}
+}
+
+/*!
+ * \brief Retain Mailbox Subscription, so that it can be used after unlocking sccp_mailbox_subscriptions
+ * \note sccp_mailbox_subscriptions needs to be locked by the caller
+ */
+static sccp_mailbox_subscriber_list_t *sccp_mwi_retainSubscription(sccp_mailbox_subscriber_list_t * subscription)
+{
+	subscription->refcount++;
+	return subscription;
+}
+
+/*!
+ * \brief Release Mailbox Subscription, destroying it when it has been unsubscribed in the mean time
+ * \note sccp_mailbox_subscriptions should not be locked by the caller
+ */
+static void sccp_mwi_releaseSubscription(sccp_mailbox_subscriber_list_t * subscription)
+{
+	boolean_t destroy = FALSE;
+
+	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
+	destroy = (--subscription->refcount == 0);
+	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+	if (destroy) {
+		sccp_mwi_destroySubscription(subscription);
+	}
 }
 
 /*!
@@ -160,11 +342,11 @@ static void sccp_mwi_updatecount(sccp_mailbox_subscriber_list_t * subscription)
 			/* done */
 			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s:(sccp_mwi_updatecount) newmsgs:%d, oldmsgs:%d\n", line->name, line->voicemailStatistic.newmsgs, line->voicemailStatistic.oldmsgs);
 
-			/* notify each device on line */
+			/* queue each device on line, devices sharing multiple lines/mailboxes are only updated once */
 			SCCP_LIST_LOCK(&line->devices);
 			SCCP_LIST_TRAVERSE(&line->devices, lineDevice, list) {
 				if (lineDevice && lineDevice->device) {
-					sccp_mwi_setMWILineStatus(lineDevice);
+					sccp_mwi_queueDeviceUpdate(lineDevice->device);
 				} else {
 					pbx_log(LOG_ERROR, "error: null line device.\n");
 				}
@@ -173,6 +355,480 @@ static void sccp_mwi_updatecount(sccp_mailbox_subscriber_list_t * subscription)
 		}
 	}
 	SCCP_LIST_UNLOCK(&subscription->sccp_mailboxLine);
+
+	sccp_mwi_schedulePendingUpdates();
+}
+
+/*!
+ * \brief Queue a device for a batched mwi update
+ * \param device SCCP Device
+ */
+static void sccp_mwi_queueDeviceUpdate(sccp_device_t * device)
+{
+	sccp_mwi_pendingDevice_t *pending = NULL;
+	unsigned int bucket = SCCP_MWI_DEVICE_HASH(device);
+
+	SCCP_LIST_LOCK(&sccp_mwi_pending.devices);
+	for (pending = sccp_mwi_pending.index[bucket]; pending; pending = pending->hashnext) {
+		if (pending->device == device) {
+			break;
+		}
+	}
+	if (pending) {
+		SCCP_MWI_STAT_INCR(devicesCoalesced);
+	} else if ((pending = sccp_calloc(sizeof *pending, 1))) {
+		if ((pending->device = sccp_device_retain(device))) {
+			pending->hashnext = sccp_mwi_pending.index[bucket];
+			sccp_mwi_pending.index[bucket] = pending;
+			SCCP_LIST_INSERT_TAIL(&sccp_mwi_pending.devices, pending, list);
+			SCCP_MWI_STAT_INCR(devicesQueued);
+		} else {
+			sccp_free(pending);
+		}
+	} else {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, DEV_ID_LOG(device));
+	}
+	SCCP_LIST_UNLOCK(&sccp_mwi_pending.devices);
+}
+
+/*!
+ * \brief Take the next pending device from the queue
+ * \return retained device or NULL when the queue is empty (which also clears the scheduled flag)
+ */
+static sccp_device_t *sccp_mwi_dequeueDeviceUpdate(void)
+{
+	sccp_mwi_pendingDevice_t *pending = NULL;
+	sccp_mwi_pendingDevice_t **prev = NULL;
+	sccp_device_t *device = NULL;
+
+	SCCP_LIST_LOCK(&sccp_mwi_pending.devices);
+	if ((pending = SCCP_LIST_REMOVE_HEAD(&sccp_mwi_pending.devices, list))) {
+		for (prev = &sccp_mwi_pending.index[SCCP_MWI_DEVICE_HASH(pending->device)]; *prev; prev = &(*prev)->hashnext) {
+			if (*prev == pending) {
+				*prev = pending->hashnext;
+				break;
+			}
+		}
+	} else {
+		sccp_mwi_pending.scheduled = FALSE;
+	}
+	SCCP_LIST_UNLOCK(&sccp_mwi_pending.devices);
+
+	if (pending) {
+		device = pending->device;								/* hand over retained device */
+		sccp_free(pending);
+	}
+	return device;
+}
+
+static boolean_t __sccp_mwi_setLineLamp(sccp_linedevices_t * lineDevice);
+
+/*!
+ * \brief Process all queued mwi device updates (run via threadpool)
+ * \note every device gets its line lamps updated and its device lamp/display checked exactly once per batch
+ */
+static void *sccp_mwi_processPendingUpdates(void *data)
+{
+	sccp_device_t *device = NULL;
+	uint32_t instance = 0;
+
+	SCCP_MWI_STAT_INCR(batches);
+	while ((device = sccp_mwi_dequeueDeviceUpdate())) {
+		if (GLOB(module_running) && sccp_device_getRegistrationState(device) == SKINNY_DEVICE_RS_OK) {
+			for (instance = SCCP_FIRST_LINEINSTANCE; instance < device->lineButtons.size; instance++) {
+				AUTO_RELEASE(sccp_linedevices_t, lineDevice , sccp_linedevice_findByLineinstance(device, instance));
+
+				if (lineDevice && lineDevice->line) {
+					__sccp_mwi_setLineLamp(lineDevice);
+				}
+			}
+			sccp_mwi_check(device);
+		}
+		sccp_device_release(&device);								/* explicit release */
+	}
+	return NULL;
+}
+
+/*!
+ * \brief Schedule the batch processor, unless it is already pending
+ * \note falls back to synchronous processing if the threadpool is not available
+ */
+static void sccp_mwi_schedulePendingUpdates(void)
+{
+	boolean_t schedule = FALSE;
+
+	SCCP_LIST_LOCK(&sccp_mwi_pending.devices);
+	if (!sccp_mwi_pending.scheduled && SCCP_LIST_GETSIZE(&sccp_mwi_pending.devices) > 0) {
+		sccp_mwi_pending.scheduled = schedule = TRUE;
+	}
+	SCCP_LIST_UNLOCK(&sccp_mwi_pending.devices);
+
+	if (schedule) {
+		if (!GLOB(general_threadpool) || !sccp_threadpool_add_work(GLOB(general_threadpool), sccp_mwi_processPendingUpdates, NULL)) {
+			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_schedulePendingUpdates) threadpool not available, processing synchronously\n");
+			sccp_mwi_processPendingUpdates(NULL);
+		}
+	}
+}
+
+/*!
+ * \brief Fetch the message counts of a single mailbox from the pbx
+ */
+static boolean_t sccp_mwi_pbxFetch(const char *mailbox, const char *context, int *newmsgs, int *oldmsgs)
+{
+	char buffer[512];
+	int newcount = -1, oldcount = -1;
+
+	snprintf(buffer, sizeof(buffer), "%s@%s", mailbox, context);
+#if defined(CS_AST_HAS_EVENT)
+	struct ast_event *event = ast_event_get_cached(AST_EVENT_MWI,
+						       AST_EVENT_IE_MAILBOX, AST_EVENT_IE_PLTYPE_STR, mailbox,
+						       AST_EVENT_IE_CONTEXT, AST_EVENT_IE_PLTYPE_STR, context,
+						       AST_EVENT_IE_END);
+	if (event) {
+		newcount = pbx_event_get_ie_uint(event, AST_EVENT_IE_NEWMSGS);
+		oldcount = pbx_event_get_ie_uint(event, AST_EVENT_IE_OLDMSGS);
+		ast_event_destroy(event);
+	} else
+#elif defined(CS_AST_HAS_STASIS)
+	RAII(struct stasis_message *, mwi_message, stasis_cache_get(ast_mwi_state_cache(), ast_mwi_state_type(), buffer), ao2_cleanup);
+	if (mwi_message) {
+		struct ast_mwi_state *mwi_state = stasis_message_data(mwi_message);
+		newcount = mwi_state->new_msgs;
+		oldcount = mwi_state->old_msgs;
+	} else
+#endif
+	{
+		/* Fall back on checking the mailbox directly */
+		if (pbx_app_inboxcount(buffer, &newcount, &oldcount) != 0) {
+			return FALSE;
+		}
+	}
+	if (newcount == -1 || oldcount == -1) {
+		return FALSE;
+	}
+	*newmsgs = newcount;
+	*oldmsgs = oldcount;
+	return TRUE;
+}
+
+static boolean_t sccp_mwi_cacheFill(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int newmsgs, int oldmsgs);
+
+/*!
+ * \brief Hand all mailbox states known to the pbx to the cache in one pass
+ * \return number of cache entries filled
+ */
+static int sccp_mwi_pbxBulkFetch(sccp_mwi_cache_t *cache)
+{
+	int filled = 0;
+#if defined(CS_AST_HAS_STASIS)
+	struct ao2_container *dump = stasis_cache_dump(ast_mwi_state_cache(), ast_mwi_state_type());
+	if (dump) {
+		struct ao2_iterator iter = ao2_iterator_init(dump, 0);
+		struct stasis_message *msg = NULL;
+		while ((msg = ao2_iterator_next(&iter))) {
+			struct ast_mwi_state *mwi_state = stasis_message_data(msg);
+			if (mwi_state && !sccp_strlen_zero(mwi_state->uniqueid) && mwi_state->new_msgs != -1 && mwi_state->old_msgs != -1) {
+				char *mailbox = pbx_strdupa(mwi_state->uniqueid);
+				char *context = strchr(mailbox, '@');
+				if (context) {
+					*context++ = '\0';
+					if (sccp_mwi_cacheFill(cache, mailbox, context, mwi_state->new_msgs, mwi_state->old_msgs)) {
+						filled++;
+					}
+				}
+			}
+			ao2_ref(msg, -1);
+		}
+		ao2_iterator_destroy(&iter);
+		ao2_ref(dump, -1);
+	}
+#endif
+	return filled;
+}
+
+static const sccp_mwi_provider_t sccp_mwi_pbxProvider = {
+	.name = "pbx",
+	.bulkFetch = sccp_mwi_pbxBulkFetch,
+	.fetch = sccp_mwi_pbxFetch,
+};
+
+/*!
+ * \brief Initialize a mwi cache
+ * \param cache MWI Cache
+ * \param provider Mailbox Provider (NULL for the pbx)
+ */
+static void sccp_mwi_cacheInit(sccp_mwi_cache_t *cache, const sccp_mwi_provider_t *provider)
+{
+	memset(cache, 0, sizeof(*cache));
+	pbx_mutex_init(&cache->lock);
+	cache->provider = provider ? provider : &sccp_mwi_pbxProvider;
+}
+
+/*!
+ * \brief Free all cache entries and the cache lock
+ */
+static void sccp_mwi_cacheDestroy(sccp_mwi_cache_t *cache)
+{
+	sccp_mwi_cacheEntry_t *entry = NULL;
+	unsigned int bucket = 0;
+
+	pbx_mutex_lock(&cache->lock);
+	for (bucket = 0; bucket < SCCP_HASH_PRIME; bucket++) {
+		while ((entry = cache->index[bucket])) {
+			cache->index[bucket] = entry->hashnext;
+			sccp_free(entry);
+		}
+	}
+	cache->entries = 0;
+	pbx_mutex_unlock(&cache->lock);
+	pbx_mutex_destroy(&cache->lock);
+}
+
+/*!
+ * \brief Find (and optionally create) a cache entry
+ * \note cache->lock needs to be locked by the caller
+ */
+static sccp_mwi_cacheEntry_t *__sccp_mwi_cacheFind(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, boolean_t create)
+{
+	sccp_mwi_cacheEntry_t *entry = NULL;
+	unsigned int bucket = sccp_mwi_hashMailbox(mailbox, context);
+
+	for (entry = cache->index[bucket]; entry; entry = entry->hashnext) {
+		if (sccp_strequals(mailbox, entry->mailbox) && sccp_strequals(context, entry->context)) {
+			return entry;
+		}
+	}
+	if (create && (entry = sccp_calloc(sizeof *entry, 1))) {
+		sccp_copy_string(entry->mailbox, mailbox, sizeof(entry->mailbox));
+		sccp_copy_string(entry->context, context, sizeof(entry->context));
+		entry->hashnext = cache->index[bucket];
+		cache->index[bucket] = entry;
+		cache->entries++;
+	}
+	return entry;
+}
+
+/*!
+ * \brief Make sure mailbox@context will be fetched by the next sccp_mwi_cachePrime
+ */
+static void sccp_mwi_cacheAddKey(sccp_mwi_cache_t *cache, const char *mailbox, const char *context)
+{
+	pbx_mutex_lock(&cache->lock);
+	if (!__sccp_mwi_cacheFind(cache, mailbox, context, TRUE)) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+	}
+	pbx_mutex_unlock(&cache->lock);
+}
+
+/*!
+ * \brief Fill a requested cache entry, which has not been filled yet (priming)
+ * \return TRUE if the entry was filled
+ */
+static boolean_t sccp_mwi_cacheFill(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int newmsgs, int oldmsgs)
+{
+	sccp_mwi_cacheEntry_t *entry = NULL;
+	boolean_t res = FALSE;
+
+	pbx_mutex_lock(&cache->lock);
+	if ((entry = __sccp_mwi_cacheFind(cache, mailbox, context, FALSE)) && !entry->valid) {
+		entry->newmsgs = newmsgs;
+		entry->oldmsgs = oldmsgs;
+		entry->valid = TRUE;
+		res = TRUE;
+	}
+	pbx_mutex_unlock(&cache->lock);
+	return res;
+}
+
+/*!
+ * \brief Apply an incremental mailbox update (mwi event) to the cache
+ */
+static void sccp_mwi_cacheUpdate(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int newmsgs, int oldmsgs)
+{
+	sccp_mwi_cacheEntry_t *entry = NULL;
+
+	pbx_mutex_lock(&cache->lock);
+	if ((entry = __sccp_mwi_cacheFind(cache, mailbox, context, TRUE))) {
+		entry->newmsgs = newmsgs;
+		entry->oldmsgs = oldmsgs;
+		entry->valid = TRUE;
+	}
+	pbx_mutex_unlock(&cache->lock);
+}
+
+/*!
+ * \brief Remove mailbox@context from the cache (no longer subscribed, so no longer kept up to date)
+ */
+static void sccp_mwi_cacheRemove(sccp_mwi_cache_t *cache, const char *mailbox, const char *context)
+{
+	sccp_mwi_cacheEntry_t **prev = NULL;
+	sccp_mwi_cacheEntry_t *entry = NULL;
+
+	pbx_mutex_lock(&cache->lock);
+	for (prev = &cache->index[sccp_mwi_hashMailbox(mailbox, context)]; (entry = *prev); prev = &entry->hashnext) {
+		if (sccp_strequals(mailbox, entry->mailbox) && sccp_strequals(context, entry->context)) {
+			*prev = entry->hashnext;
+			sccp_free(entry);
+			cache->entries--;
+			break;
+		}
+	}
+	pbx_mutex_unlock(&cache->lock);
+}
+
+/*!
+ * \brief Get the message counts for mailbox@context, fetching them from the provider on a cache miss
+ * \return TRUE if the counts are known
+ */
+static boolean_t sccp_mwi_cacheGet(sccp_mwi_cache_t *cache, const char *mailbox, const char *context, int *newmsgs, int *oldmsgs)
+{
+	sccp_mwi_cacheEntry_t *entry = NULL;
+	int newcount = 0, oldcount = 0;
+
+	pbx_mutex_lock(&cache->lock);
+	if ((entry = __sccp_mwi_cacheFind(cache, mailbox, context, FALSE)) && entry->valid) {
+		*newmsgs = entry->newmsgs;
+		*oldmsgs = entry->oldmsgs;
+		pbx_mutex_unlock(&cache->lock);
+		SCCP_MWI_STAT_INCR(cacheHits);
+		return TRUE;
+	}
+	pbx_mutex_unlock(&cache->lock);
+
+	SCCP_MWI_STAT_INCR(cacheMisses);
+	if (!cache->provider->fetch(mailbox, context, &newcount, &oldcount)) {
+		return FALSE;
+	}
+
+	pbx_mutex_lock(&cache->lock);
+	if ((entry = __sccp_mwi_cacheFind(cache, mailbox, context, TRUE))) {
+		if (!entry->valid) {									/* an update might have overtaken our fetch */
+			entry->newmsgs = newcount;
+			entry->oldmsgs = oldcount;
+			entry->valid = TRUE;
+		}
+		newcount = entry->newmsgs;
+		oldcount = entry->oldmsgs;
+	}
+	pbx_mutex_unlock(&cache->lock);
+
+	*newmsgs = newcount;
+	*oldmsgs = oldcount;
+	return TRUE;
+}
+
+/*!
+ * \brief Prime all requested cache entries, using a single bulk fetch and falling back to fetching the remaining entries one by one
+ * \return number of entries with known message counts
+ */
+static int sccp_mwi_cachePrime(sccp_mwi_cache_t *cache)
+{
+	struct sccp_mwi_cacheKey {
+		char mailbox[60];
+		char context[60];
+	} *missing = NULL;
+	sccp_mwi_cacheEntry_t *entry = NULL;
+	unsigned int bucket = 0;
+	int bulk = 0, num_missing = 0, idx = 0, newmsgs = 0, oldmsgs = 0, valid = 0;
+
+	if (cache->provider->bulkFetch) {
+		bulk = cache->provider->bulkFetch(cache);
+	}
+
+	pbx_mutex_lock(&cache->lock);
+	if (cache->entries > bulk && (missing = sccp_calloc(sizeof *missing, cache->entries))) {
+		for (bucket = 0; bucket < SCCP_HASH_PRIME; bucket++) {
+			for (entry = cache->index[bucket]; entry; entry = entry->hashnext) {
+				if (!entry->valid) {
+					sccp_copy_string(missing[num_missing].mailbox, entry->mailbox, sizeof(missing[num_missing].mailbox));
+					sccp_copy_string(missing[num_missing].context, entry->context, sizeof(missing[num_missing].context));
+					num_missing++;
+				}
+			}
+		}
+	}
+	pbx_mutex_unlock(&cache->lock);
+
+	for (idx = 0; idx < num_missing; idx++) {
+		if (cache->provider->fetch(missing[idx].mailbox, missing[idx].context, &newmsgs, &oldmsgs)) {
+			sccp_mwi_cacheFill(cache, missing[idx].mailbox, missing[idx].context, newmsgs, oldmsgs);
+		}
+	}
+	if (missing) {
+		sccp_free(missing);
+	}
+
+	pbx_mutex_lock(&cache->lock);
+	for (bucket = 0; bucket < SCCP_HASH_PRIME; bucket++) {
+		for (entry = cache->index[bucket]; entry; entry = entry->hashnext) {
+			valid += entry->valid ? 1 : 0;
+		}
+	}
+	pbx_mutex_unlock(&cache->lock);
+
+	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_cachePrime) provider:%s, bulk:%d, single:%d, valid:%d\n", cache->provider->name, bulk, num_missing, valid);
+	return valid;
+}
+
+/*!
+ * \brief Prime the mwi cache for all configured mailboxes in one pass
+ *
+ * Subscriptions created before the cache was primed are started without initial value, they get their message counts here.
+ * Subscriptions created afterwards are served from the cache, which is kept up to date by the mwi events.
+ */
+void sccp_mwi_primeCache(void)
+{
+	sccp_line_t *line = NULL;
+	sccp_mailbox_t *mailbox = NULL;
+	sccp_mailbox_subscriber_list_t *subscription = NULL;
+	sccp_mailbox_subscriber_list_t **subscriptions = NULL;
+	int newmsgs = 0, oldmsgs = 0;
+	int count = 0, n = 0;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), line, list) {
+		SCCP_LIST_LOCK(&line->mailboxes);
+		SCCP_LIST_TRAVERSE(&line->mailboxes, mailbox, list) {
+			if (!sccp_strlen_zero(mailbox->mailbox) && !sccp_strlen_zero(mailbox->context)) {
+				sccp_mwi_cacheAddKey(&sccp_mwi_cache, mailbox->mailbox, mailbox->context);
+			}
+		}
+		SCCP_LIST_UNLOCK(&line->mailboxes);
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+
+	int primed = sccp_mwi_cachePrime(&sccp_mwi_cache);
+	sccp_log((DEBUGCAT_CORE + DEBUGCAT_MWI)) (VERBOSE_PREFIX_2 "SCCP: MWI cache primed with %d mailboxes\n", primed);
+
+	/* collect the subscriptions, a cache miss fetches from the pbx and updatecount locks lines and devices, neither under the list lock */
+	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
+	sccp_mwi_primed = TRUE;
+	if ((subscriptions = sccp_calloc(SCCP_LIST_GETSIZE(&sccp_mailbox_subscriptions) + 1, sizeof *subscriptions))) {
+		SCCP_LIST_TRAVERSE(&sccp_mailbox_subscriptions, subscription, list) {
+			subscriptions[count++] = sccp_mwi_retainSubscription(subscription);
+		}
+	}
+	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
+	if (!subscriptions) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
+
+	for (n = 0; n < count; n++) {
+		subscription = subscriptions[n];
+		if (sccp_mwi_cacheGet(&sccp_mwi_cache, subscription->mailbox, subscription->context, &newmsgs, &oldmsgs)) {
+			if (newmsgs != subscription->currentVoicemailStatistic.newmsgs || oldmsgs != subscription->currentVoicemailStatistic.oldmsgs) {
+				subscription->previousVoicemailStatistic.newmsgs = subscription->currentVoicemailStatistic.newmsgs;
+				subscription->previousVoicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
+				subscription->currentVoicemailStatistic.newmsgs = newmsgs;
+				subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
+				sccp_mwi_updatecount(subscription);
+			}
+		}
+		sccp_mwi_releaseSubscription(subscription);
+	}
+	sccp_free(subscriptions);
 }
 
 #if defined(CS_AST_HAS_EVENT)
@@ -191,6 +847,7 @@ void sccp_mwi_event(const struct ast_event *event, void *data)
 	}
 	int newmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_NEWMSGS);
 	int oldmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_OLDMSGS);
+	SCCP_MWI_STAT_INCR(mailboxEvents);
 	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: Received PBX mwi event (%s) for %s@%s, newmsgs:%d, oldmsgs:%d\n", ast_event_get_type_name(event), subscription->mailbox, subscription->context, newmsgs, oldmsgs);
 
 	/* for calculation store previous voicemail counts */
@@ -198,6 +855,7 @@ void sccp_mwi_event(const struct ast_event *event, void *data)
 	subscription->previousVoicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
 
 	if (newmsgs != -1 && oldmsgs != -1) {
+		sccp_mwi_cacheUpdate(&sccp_mwi_cache, subscription->mailbox, subscription->context, newmsgs, oldmsgs);
 		subscription->currentVoicemailStatistic.newmsgs = newmsgs;
 		subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
 		if (subscription->previousVoicemailStatistic.newmsgs != subscription->currentVoicemailStatistic.newmsgs && subscription->currentVoicemailStatistic.newmsgs != -1) {
@@ -227,12 +885,14 @@ void sccp_mwi_event(void *userdata, struct stasis_subscription *sub, struct stas
 			int newmsgs = mwi_state->new_msgs;
 			int oldmsgs = mwi_state->old_msgs;
 
+			SCCP_MWI_STAT_INCR(mailboxEvents);
 			sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: Received PBX mwi event for %s@%s, newmsgs:%d, oldmsgs:%d\n", subscription->mailbox, subscription->context, newmsgs, oldmsgs);
 
 			subscription->previousVoicemailStatistic.newmsgs = subscription->currentVoicemailStatistic.newmsgs;
 			subscription->previousVoicemailStatistic.oldmsgs = subscription->currentVoicemailStatistic.oldmsgs;
 
 			if (newmsgs != -1 && oldmsgs != -1) {
+				sccp_mwi_cacheUpdate(&sccp_mwi_cache, subscription->mailbox, subscription->context, newmsgs, oldmsgs);
 				subscription->currentVoicemailStatistic.newmsgs = newmsgs;
 				subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
 				if (subscription->previousVoicemailStatistic.newmsgs != subscription->currentVoicemailStatistic.newmsgs) {
@@ -276,7 +936,9 @@ int sccp_mwi_checksubscription(const void *ptr)
 	snprintf(buffer, 512, "%s@%s", subscription->mailbox, subscription->context);
 	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_4 "SCCP: checking mailbox: %s\n", buffer);
 	if (pbx_app_inboxcount(buffer, &newmsgs, &oldmsgs) == 0) {
+		SCCP_MWI_STAT_INCR(mailboxEvents);
 		if (newmsgs != -1 && oldmsgs != -1) {
+			sccp_mwi_cacheUpdate(&sccp_mwi_cache, subscription->mailbox, subscription->context, newmsgs, oldmsgs);
 			subscription->currentVoicemailStatistic.newmsgs = newmsgs;
 			subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
 
@@ -345,13 +1007,14 @@ void sccp_mwi_unsubscribeMailbox(sccp_mailbox_t * mailbox)
 	sccp_mailbox_subscriber_list_t *subscription = NULL;
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
-	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_mailbox_subscriptions, subscription, list) {
-		if (sccp_strequals(mailbox->mailbox, subscription->mailbox) && sccp_strequals(mailbox->context, subscription->context)) {
-			SCCP_LIST_REMOVE_CURRENT(list);
+	if ((subscription = sccp_mwi_findSubscription(mailbox->mailbox, mailbox->context))) {
+		sccp_mwi_unindexSubscription(subscription);
+		SCCP_LIST_REMOVE(&sccp_mailbox_subscriptions, subscription, list);
+		sccp_mwi_cacheRemove(&sccp_mwi_cache, subscription->mailbox, subscription->context);
+		if (--subscription->refcount == 0) {							/* otherwise destroyed by the last sccp_mwi_releaseSubscription */
 			sccp_mwi_destroySubscription(subscription);
 		}
 	}
-	SCCP_LIST_TRAVERSE_SAFE_END;
 	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 }
 
@@ -456,12 +1119,11 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 	}
 	sccp_mailbox_subscriber_list_t *subscription = NULL;
 	sccp_mailboxLine_t *mailboxLine = NULL;
+	boolean_t primed = FALSE;
 
 	SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
-	SCCP_LIST_TRAVERSE(&sccp_mailbox_subscriptions, subscription, list) {
-		if (sccp_strequals(mailbox, subscription->mailbox) && sccp_strequals(context, subscription->context)) {
-			break;
-		}
+	if ((subscription = sccp_mwi_findSubscription(mailbox, context))) {
+		sccp_mwi_retainSubscription(subscription);
 	}
 	SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 
@@ -472,60 +1134,33 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 			return;
 		}
 		SCCP_LIST_HEAD_INIT(&subscription->sccp_mailboxLine);
+		subscription->refcount = 1;									/* list reference */
 
 		sccp_copy_string(subscription->mailbox, mailbox, sizeof(subscription->mailbox));
 		sccp_copy_string(subscription->context, context, sizeof(subscription->context));
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "SCCP: (mwi_addMailboxSubscription) creating subscription for: %s@%s\n", subscription->mailbox, subscription->context);
 
+#if defined(CS_AST_HAS_STASIS)
+		snprintf(subscription->uniqueid, sizeof(subscription->uniqueid), "%s@%s", subscription->mailbox, subscription->context);
+#endif
 		SCCP_LIST_LOCK(&sccp_mailbox_subscriptions);
 		SCCP_LIST_INSERT_HEAD(&sccp_mailbox_subscriptions, subscription, list);
+		{
+			unsigned int bucket = sccp_mwi_hashMailbox(subscription->mailbox, subscription->context);
+			subscription->hashnext = sccp_mailbox_index[bucket];
+			sccp_mailbox_index[bucket] = subscription;
+		}
+		sccp_mwi_retainSubscription(subscription);
+		primed = sccp_mwi_primed;
 		SCCP_LIST_UNLOCK(&sccp_mailbox_subscriptions);
 
-		/* get initial value */
-
-#ifdef CS_AST_HAS_EVENT
-		struct ast_event *event = ast_event_get_cached(AST_EVENT_MWI,
-							       AST_EVENT_IE_MAILBOX, AST_EVENT_IE_PLTYPE_STR, subscription->mailbox,
-							       AST_EVENT_IE_CONTEXT, AST_EVENT_IE_PLTYPE_STR, subscription->context,
-							       AST_EVENT_IE_END);
-
-		if (event) {
-			int newmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_NEWMSGS);
-			int oldmsgs = pbx_event_get_ie_uint(event, AST_EVENT_IE_OLDMSGS);
-			if (newmsgs != -1 && oldmsgs != -1) {
-				subscription->currentVoicemailStatistic.newmsgs = newmsgs;
-				subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
-			}
-			ast_event_destroy(event);
-		} else
-#elif CS_AST_HAS_STASIS
-		RAII(struct stasis_message *, mwi_message, NULL, ao2_cleanup);
-		snprintf(subscription->uniqueid, sizeof(subscription->uniqueid), "%s@%s", subscription->mailbox, subscription->context);
-		sccp_log(DEBUGCAT_MWI)(VERBOSE_PREFIX_3 "SCCP: (mwi_addMailboxSubscription) mailbox_uniqueid:%s, mailbox:%s, context:%s\n", subscription->uniqueid, subscription->mailbox, subscription->context)
-
-		mwi_message = stasis_cache_get(ast_mwi_state_cache(), ast_mwi_state_type(), subscription->uniqueid);
-		if (mwi_message) {
-			struct ast_mwi_state *mwi_state = stasis_message_data(mwi_message);
-			int newmsgs = mwi_state->new_msgs;
-			int oldmsgs = mwi_state->old_msgs;
-			if (newmsgs != -1 && oldmsgs != -1) {
+		/* get initial value (a cache miss fetches from the pbx), until the cache has been primed sccp_mwi_primeCache hands it over in bulk */
+		if (primed) {
+			int newmsgs = 0, oldmsgs = 0;
+			if (sccp_mwi_cacheGet(&sccp_mwi_cache, subscription->mailbox, subscription->context, &newmsgs, &oldmsgs)) {
 				subscription->currentVoicemailStatistic.newmsgs = newmsgs;
 				subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
 			}
-		} else
-#endif
-		{
-			/* Fall back on checking the mailbox directly */
-			char buffer[512];
-			int newmsgs = 0, oldmsgs = 0;
-
-			snprintf(buffer, 512, "%s@%s", subscription->mailbox, subscription->context);
-			if (pbx_app_inboxcount(buffer, &newmsgs, &oldmsgs) == 0) {
-				if (newmsgs != -1 && oldmsgs != -1) {
-					subscription->currentVoicemailStatistic.newmsgs = newmsgs;
-					subscription->currentVoicemailStatistic.oldmsgs = oldmsgs;
-				}
-			}
 		}
 
 		/* register asterisk event */
@@ -568,6 +1203,7 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 		mailboxLine = sccp_calloc(sizeof *mailboxLine, 1);
 		if (!mailboxLine) {
 			pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, line->name);
+			sccp_mwi_releaseSubscription(subscription);
 			return;
 		}
 
@@ -580,13 +1216,15 @@ void sccp_mwi_addMailboxSubscription(char *mailbox, char *context, sccp_line_t *
 		SCCP_LIST_INSERT_HEAD(&subscription->sccp_mailboxLine, mailboxLine, list);
 		SCCP_LIST_UNLOCK(&subscription->sccp_mailboxLine);
 	}
+	sccp_mwi_releaseSubscription(subscription);
 }
 
 /*!
- * \brief Set MWI Line Status
+ * \brief Set MWI Line Lamp
  * \param lineDevice SCCP LineDevice
+ * \return TRUE if a SetLampMessage was sent
  */
-void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice)
+static boolean_t __sccp_mwi_setLineLamp(sccp_linedevices_t * lineDevice)
 {
 	pbx_assert(lineDevice != NULL && lineDevice->device != NULL);
 	
@@ -621,12 +1259,25 @@ void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice)
 		msg->data.SetLampMessage.lel_stimulusInstance = htolel(instance);
 		msg->data.SetLampMessage.lel_lampMode = state ? htolel(SKINNY_LAMP_ON) : htolel(SKINNY_LAMP_OFF);
 		sccp_dev_send(d, msg);
+		SCCP_MWI_STAT_INCR(lampMessages);
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) Turn %s the MWI on line %s (%d)\n", DEV_ID_LOG(d), state ? "ON" : "OFF", (l ? l->name : "unknown"), instance);
-	} else {
-		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) Device already knows this state %s on line %s (%d). skipping update\n", DEV_ID_LOG(d), status ? "ON" : "OFF", (l ? l->name : "unknown"), instance);
+		return TRUE;
 	}
-	if (sccp_device_getRegistrationState(d) == SKINNY_DEVICE_RS_OK) {
-		sccp_mwi_check(d); /* we need to check mwi status again, to enable/disable device mwi light */
+	sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_setMWILineStatus) Device already knows this state %s on line %s (%d). skipping update\n", DEV_ID_LOG(d), status ? "ON" : "OFF", (l ? l->name : "unknown"), instance);
+	return FALSE;
+}
+
+/*!
+ * \brief Set MWI Line Status
+ * \param lineDevice SCCP LineDevice
+ */
+void sccp_mwi_setMWILineStatus(sccp_linedevices_t * lineDevice)
+{
+	pbx_assert(lineDevice != NULL && lineDevice->device != NULL);
+
+	__sccp_mwi_setLineLamp(lineDevice);
+	if (sccp_device_getRegistrationState(lineDevice->device) == SKINNY_DEVICE_RS_OK) {
+		sccp_mwi_check(lineDevice->device); /* we need to check mwi status again, to enable/disable device mwi light */
 	}
 }
 
@@ -701,6 +1352,7 @@ void sccp_mwi_check(sccp_device_t * d)
 		msg->data.SetLampMessage.lel_lampMode = (device->mwilight & (1 << SCCP_DEVICE_MWILIGHT)) ? htolel(device->mwilamp) : htolel(SKINNY_LAMP_OFF);
 		//msg->data.SetLampMessage.lel_lampMode = devicelamp_active ? htolel(device->mwilamp) : htolel(SKINNY_LAMP_OFF);
 		sccp_dev_send(device, msg);
+		SCCP_MWI_STAT_INCR(lampMessages);
 		sccp_log((DEBUGCAT_MWI)) (VERBOSE_PREFIX_3 "%s: (mwi_check) Turn %s the MWI light (newmsgs: %d->%d)\n", DEV_ID_LOG(device), (device->mwilight & (1 << SCCP_DEVICE_MWILIGHT)) ? "ON" : "OFF", newmsgs,  device->voicemailStatistic.newmsgs);
 	}
 	/* we should check the display only once, maybe we need a priority stack -MC */
@@ -770,10 +1422,179 @@ int sccp_show_mwi_subscriptions(int fd, sccp_cli_totals_t *totals, struct manses
 #include "sccp_cli_table.h"
 #endif
 
+	int once;
+#define CLI_AMI_TABLE_NAME MWIStatistics
+#define CLI_AMI_TABLE_PER_ENTRY_NAME Statistic
+#define CLI_AMI_TABLE_ITERATOR for(once=0;once<1;once++)
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(MailboxEvents,	"-13.13",	d,	13,	sccp_mwi_stats.mailboxEvents)					\
+ 		CLI_AMI_TABLE_FIELD(DevicesQueued,	"-13.13",	d,	13,	sccp_mwi_stats.devicesQueued)					\
+ 		CLI_AMI_TABLE_FIELD(Coalesced,		"-9.9",		d,	9,	sccp_mwi_stats.devicesCoalesced)				\
+ 		CLI_AMI_TABLE_FIELD(Batches,		"-7.7",		d,	7,	sccp_mwi_stats.batches)						\
+ 		CLI_AMI_TABLE_FIELD(LampMessages,	"-12.12",	d,	12,	sccp_mwi_stats.lampMessages)					\
+ 		CLI_AMI_TABLE_FIELD(CacheHits,		"-9.9",		d,	9,	sccp_mwi_stats.cacheHits)					\
+ 		CLI_AMI_TABLE_FIELD(CacheMisses,	"-11.11",	d,	11,	sccp_mwi_stats.cacheMisses)					\
+ 		CLI_AMI_TABLE_FIELD(Pending,		"-7.7",		d,	7,	SCCP_LIST_GETSIZE(&sccp_mwi_pending.devices))
+#include "sccp_cli_table.h"
+
 	if (s) {
 		totals->lines = local_line_total;
-		totals->tables = 1;
+		totals->tables = 2;
 	}
 	return RESULT_SUCCESS;
 }
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+/*!
+ * \brief local stand-in mailbox provider, only part of the mailboxes is available in bulk
+ */
+static struct {
+	const char *mailbox;
+	const char *context;
+	int newmsgs;
+	int oldmsgs;
+	boolean_t bulk;
+} sccp_mwi_test_mailboxes[] = {
+	{"100", "default", 1, 2, TRUE},
+	{"101", "default", 0, 5, TRUE},
+	{"100", "other", 3, 0, FALSE},
+	{"200", "default", 7, 7, TRUE},								/* not requested, should be ignored */
+};
+static int sccp_mwi_test_bulkFetches;
+static int sccp_mwi_test_fetches;
+
+static int sccp_mwi_test_bulkFetch(sccp_mwi_cache_t *cache)
+{
+	uint32_t idx = 0;
+	int filled = 0;
+
+	sccp_mwi_test_bulkFetches++;
+	for (idx = 0; idx < ARRAY_LEN(sccp_mwi_test_mailboxes); idx++) {
+		if (sccp_mwi_test_mailboxes[idx].bulk && sccp_mwi_cacheFill(cache, sccp_mwi_test_mailboxes[idx].mailbox, sccp_mwi_test_mailboxes[idx].context, sccp_mwi_test_mailboxes[idx].newmsgs, sccp_mwi_test_mailboxes[idx].oldmsgs)) {
+			filled++;
+		}
+	}
+	return filled;
+}
+
+static boolean_t sccp_mwi_test_fetch(const char *mailbox, const char *context, int *newmsgs, int *oldmsgs)
+{
+	uint32_t idx = 0;
+
+	sccp_mwi_test_fetches++;
+	for (idx = 0; idx < ARRAY_LEN(sccp_mwi_test_mailboxes); idx++) {
+		if (sccp_strequals(mailbox, sccp_mwi_test_mailboxes[idx].mailbox) && sccp_strequals(context, sccp_mwi_test_mailboxes[idx].context)) {
+			*newmsgs = sccp_mwi_test_mailboxes[idx].newmsgs;
+			*oldmsgs = sccp_mwi_test_mailboxes[idx].oldmsgs;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static const sccp_mwi_provider_t sccp_mwi_test_provider = {
+	.name = "test",
+	.bulkFetch = sccp_mwi_test_bulkFetch,
+	.fetch = sccp_mwi_test_fetch,
+};
+
+AST_TEST_DEFINE(sccp_mwi_cache_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "cache";
+			info->category = "/channels/chan_sccp/mwi/";
+			info->summary = "chan-sccp-b mwi cache test";
+			info->description = "chan-sccp-b mwi cache priming and consistency tests";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	sccp_mwi_cache_t cache;
+	int newmsgs = 0, oldmsgs = 0;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	sccp_mwi_test_bulkFetches = sccp_mwi_test_fetches = 0;
+	sccp_mwi_cacheInit(&cache, &sccp_mwi_test_provider);
+
+	pbx_test_status_update(test, "Executing chan-sccp-b mwi cache tests...\n");
+	sccp_mwi_cacheAddKey(&cache, "100", "default");
+	sccp_mwi_cacheAddKey(&cache, "101", "default");
+	sccp_mwi_cacheAddKey(&cache, "100", "other");
+	sccp_mwi_cacheAddKey(&cache, "100", "default");							/* duplicate key */
+	if (cache.entries != 3) {
+		pbx_test_status_update(test, "Expected 3 cache entries, got %d\n", cache.entries);
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+
+	pbx_test_status_update(test, "Prime: one bulk fetch, single fetch for mailboxes missing from bulk...\n");
+	if (sccp_mwi_cachePrime(&cache) != 3 || sccp_mwi_test_bulkFetches != 1 || sccp_mwi_test_fetches != 1) {
+		pbx_test_status_update(test, "Priming failed, bulk:%d, single:%d\n", sccp_mwi_test_bulkFetches, sccp_mwi_test_fetches);
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+	if (cache.entries != 3) {
+		pbx_test_status_update(test, "Bulk fetch added unrequested mailboxes\n");
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+
+	pbx_test_status_update(test, "Primed values are served from the cache...\n");
+	if (!sccp_mwi_cacheGet(&cache, "100", "default", &newmsgs, &oldmsgs) || newmsgs != 1 || oldmsgs != 2 ||
+	    !sccp_mwi_cacheGet(&cache, "101", "default", &newmsgs, &oldmsgs) || newmsgs != 0 || oldmsgs != 5 ||
+	    !sccp_mwi_cacheGet(&cache, "100", "other", &newmsgs, &oldmsgs) || newmsgs != 3 || oldmsgs != 0 ||
+	    sccp_mwi_test_fetches != 1) {
+		pbx_test_status_update(test, "Cache returned inconsistent values\n");
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+
+	pbx_test_status_update(test, "Incremental updates replace primed values and are not overwritten by priming again...\n");
+	sccp_mwi_cacheUpdate(&cache, "100", "default", 4, 2);
+	sccp_mwi_cachePrime(&cache);
+	if (!sccp_mwi_cacheGet(&cache, "100", "default", &newmsgs, &oldmsgs) || newmsgs != 4 || oldmsgs != 2) {
+		pbx_test_status_update(test, "Incremental update lost, newmsgs:%d, oldmsgs:%d\n", newmsgs, oldmsgs);
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+
+	pbx_test_status_update(test, "Cache miss falls back to the provider once...\n");
+	sccp_mwi_test_fetches = 0;
+	if (!sccp_mwi_cacheGet(&cache, "200", "default", &newmsgs, &oldmsgs) || newmsgs != 7 || oldmsgs != 7 ||
+	    !sccp_mwi_cacheGet(&cache, "200", "default", &newmsgs, &oldmsgs) || sccp_mwi_test_fetches != 1) {
+		pbx_test_status_update(test, "Cache miss not handled, fetches:%d\n", sccp_mwi_test_fetches);
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+	if (sccp_mwi_cacheGet(&cache, "999", "default", &newmsgs, &oldmsgs)) {
+		pbx_test_status_update(test, "Unknown mailbox returned a value\n");
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+
+	pbx_test_status_update(test, "Removed mailboxes are fetched again...\n");
+	sccp_mwi_cacheRemove(&cache, "100", "default");
+	sccp_mwi_test_fetches = 0;
+	if (cache.entries != 3 || !sccp_mwi_cacheGet(&cache, "100", "default", &newmsgs, &oldmsgs) || newmsgs != 1 || sccp_mwi_test_fetches != 1) {
+		pbx_test_status_update(test, "Cache removal failed\n");
+		res = AST_TEST_FAIL;
+		goto EXIT;
+	}
+EXIT:
+	sccp_mwi_cacheDestroy(&cache);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_mwi_cache_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_mwi_cache_tests);
+}
+#endif
 // kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
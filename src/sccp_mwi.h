@@ -27,6 +27,7 @@ struct sccp_mailbox {
 SCCP_API void SCCP_CALL sccp_mwi_module_start(void);
 SCCP_API void SCCP_CALL sccp_mwi_module_stop(void);
 SCCP_API void SCCP_CALL sccp_mwi_check(sccp_device_t * d);
+SCCP_API void SCCP_CALL sccp_mwi_primeCache(void);
 
 SCCP_API void SCCP_CALL sccp_mwi_unsubscribeMailbox(sccp_mailbox_t *mailbox);
 
@@ -193,6 +193,7 @@ int sccp_pbx_call(sccp_channel_t * c, char *dest, int timeout)
 	}
 	int res = 0;
 
+	sccp_channel_markCallSpan(c, SCCP_CALLSPAN_CALL);
 	AUTO_RELEASE(sccp_line_t, l , sccp_line_retain(c->line));
 	if (!l) {
 		pbx_log(LOG_WARNING, "SCCP: The channel %08X has no line. giving up.\n", (c->callid));
@@ -998,6 +999,7 @@ void *sccp_pbx_softswitch(sccp_channel_t * channel)
 			pbx_log(LOG_ERROR, "SCCP: (sccp_pbx_softswitch) No <channel> available. Returning from dial thread.\n");
 			goto EXIT_FUNC;
 		}
+		sccp_channel_markCallSpan(c, SCCP_CALLSPAN_SOFTSWITCH);
 		sccp_channel_stop_schedule_digittimout(c);
 		
 		/* Reset Enbloc Dial Emulation */
@@ -0,0 +1,625 @@
+/*!
+ * \file        sccp_pcap.c
+ * \brief       SCCP Packet Capture
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Writes the skinny messages exchanged with selected devices to a rotating pcap file, so that wireshark can dissect them:
+ * - devices are selected by name ('sccp capture <device> on|off' / AMI SCCPCapture), the session caches the result in a flag
+ * - every message is copied into a slot of a bounded multi-producer ring by the session (inbound) or sending (outbound) thread
+ * - a writer thread adds synthetic IPv4/IPv6 and TCP headers (LINKTYPE_RAW, tcp sequence numbers per session) and writes the
+ *   records to pcap_file, which is rotated after pcap_filesize KB keeping pcap_files old files
+ * - when the ring is full (or a message does not fit a slot) packets are dropped and counted, capturing never blocks a session
+ * - an existing pcap_file is rotated away when capturing starts, it is never truncated
+ * - ring and writer thread only exist while at least one device is captured
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_pcap.h"
+#include "sccp_utils.h"
+#include <asterisk/paths.h>
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_PCAP_RING_SIZE 256											/* slots, power of two */
+#define SCCP_PCAP_INTERVAL 100											/* writer interval in ms */
+#define SCCP_PCAP_MAGIC 0xa1b2c3d4
+#define SCCP_PCAP_LINKTYPE_RAW 101
+#define SCCP_PCAP_SNAPLEN 65535
+
+typedef struct sccp_pcap_slot {
+	volatile int seq;											/* slot sequence, see sccp_pcap_capture */
+	struct timeval tv;
+	int family;
+	uint8_t src[16];
+	uint8_t dst[16];
+	uint16_t sport;
+	uint16_t dport;
+	uint32_t tcpseq;
+	uint32_t tcpack;
+	uint16_t len;
+	uint8_t data[SCCP_MAX_PACKET];
+} sccp_pcap_slot_t;
+
+typedef struct sccp_pcap_device sccp_pcap_device_t;
+struct sccp_pcap_device {
+	SCCP_LIST_ENTRY (sccp_pcap_device_t) list;
+	char name[StationMaxDeviceNameSize];
+};
+
+static struct {
+	SCCP_LIST_HEAD (, sccp_pcap_device_t) devices;
+	sccp_pcap_slot_t *ring;
+	volatile int enqueue_pos;
+	int dequeue_pos;
+	volatile int inflight;											/* producers currently inside sccp_pcap_capture */
+	volatile boolean_t running;										/* producers may queue */
+	boolean_t writing;											/* writer thread keeps draining, protected by lock */
+	pthread_t thread;
+	pbx_cond_t wakeup;
+	pbx_mutex_t lock;											/* writer state, wakeup */
+	FILE *file;
+	char filename[PATH_MAX];
+	long filesize;
+	uint16_t ipid;
+	sccp_pcap_stats_t stats;
+} sccp_pcap;
+
+AST_MUTEX_DEFINE_STATIC(sccp_pcap_control_lock);								/* devices, start / stop */
+AST_MUTEX_DEFINE_STATIC(sccp_pcap_atomic_lock);									/* only used by platforms without atomic operations */
+
+/* =========================================================================================================== Producer == */
+static int sccp_pcap_getAddr(const struct sockaddr_storage *addr, uint8_t out[16])
+{
+	memset(out, 0, 16);
+	if (addr && addr->ss_family == AF_INET6) {
+		const struct in6_addr *in6 = &((const struct sockaddr_in6 *) addr)->sin6_addr;
+
+		if (IN6_IS_ADDR_V4MAPPED(in6)) {
+			memcpy(out, &in6->s6_addr[12], 4);
+			return AF_INET;
+		}
+		memcpy(out, in6, 16);
+		return AF_INET6;
+	}
+	if (addr && addr->ss_family == AF_INET) {
+		memcpy(out, &((const struct sockaddr_in *) addr)->sin_addr, 4);
+	}
+	return AF_INET;
+}
+
+static void sccp_pcap_mapIPv4(uint8_t addr[16])
+{
+	memmove(addr + 12, addr, 4);
+	memset(addr, 0, 10);
+	addr[10] = addr[11] = 0xff;
+}
+
+/*!
+ * \brief Queue one skinny message for the pcap writer
+ * \note never blocks, when the ring is full the message is dropped
+ *
+ * Bounded multi-producer queue: a producer claims the slot at enqueue_pos by advancing enqueue_pos with a CAS, once the
+ * slot sequence says it has been released by the writer (seq == pos). After copying it publishes the slot (seq = pos + 1),
+ * the writer consumes slots in order and releases them for the next round (seq = pos + SCCP_PCAP_RING_SIZE).
+ */
+void sccp_pcap_capture(const sccp_pcap_endpoint_t * src, const sccp_pcap_endpoint_t * dst, const uint8_t * data, size_t len)
+{
+	sccp_pcap_slot_t *slot = NULL;
+	int pos = 0;
+
+	if (!sccp_pcap.running || !data || !len) {
+		return;
+	}
+	if (len > SCCP_MAX_PACKET) {										/* does not fit a slot */
+		ATOMIC_INCR(&sccp_pcap.stats.dropped, 1, &sccp_pcap_atomic_lock);
+		return;
+	}
+	ATOMIC_INCR(&sccp_pcap.inflight, 1, &sccp_pcap_atomic_lock);
+	if (!sccp_pcap.running) {
+		ATOMIC_DECR(&sccp_pcap.inflight, 1, &sccp_pcap_atomic_lock);
+		return;
+	}
+	pos = ATOMIC_FETCH(&sccp_pcap.enqueue_pos, &sccp_pcap_atomic_lock);
+	for (;;) {
+		slot = &sccp_pcap.ring[pos & (SCCP_PCAP_RING_SIZE - 1)];
+		int dif = (int) ((unsigned int) ATOMIC_FETCH(&slot->seq, &sccp_pcap_atomic_lock) - (unsigned int) pos);
+
+		if (dif == 0) {
+			if (CAS32(&sccp_pcap.enqueue_pos, pos, pos + 1, &sccp_pcap_atomic_lock) == pos) {
+				break;
+			}
+		} else if (dif < 0) {
+			ATOMIC_INCR(&sccp_pcap.stats.dropped, 1, &sccp_pcap_atomic_lock);
+			ATOMIC_DECR(&sccp_pcap.inflight, 1, &sccp_pcap_atomic_lock);
+			return;
+		}
+		pos = ATOMIC_FETCH(&sccp_pcap.enqueue_pos, &sccp_pcap_atomic_lock);
+	}
+
+	slot->tv = ast_tvnow();
+	slot->family = sccp_pcap_getAddr(src->addr, slot->src);
+	if (sccp_pcap_getAddr(dst->addr, slot->dst) != slot->family) {					/* mixed families, write both as IPv6 */
+		sccp_pcap_mapIPv4(slot->family == AF_INET ? slot->src : slot->dst);
+		slot->family = AF_INET6;
+	}
+	slot->sport = src->port;
+	slot->dport = dst->port;
+	slot->tcpseq = src->seq;
+	slot->tcpack = dst->seq;
+	slot->len = (uint16_t) len;
+	memcpy(slot->data, data, len);
+	ATOMIC_INCR(&slot->seq, 1, &sccp_pcap_atomic_lock);							/* publish (full barrier) */
+
+	ATOMIC_INCR(&sccp_pcap.stats.captured, 1, &sccp_pcap_atomic_lock);
+	ATOMIC_DECR(&sccp_pcap.inflight, 1, &sccp_pcap_atomic_lock);
+}
+
+/* ============================================================================================================= Writer == */
+static void sccp_pcap_put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+static void sccp_pcap_put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+static uint16_t sccp_pcap_ipChecksum(const uint8_t *hdr, size_t len)
+{
+	uint32_t sum = 0;
+	size_t i = 0;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		sum += (hdr[i] << 8) | hdr[i + 1];
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+	return (uint16_t) ~sum;
+}
+
+/* pcap_file -> pcap_file.1 -> ... -> pcap_file.<pcap_files> */
+static void sccp_pcap_rotate(void)
+{
+	char from[PATH_MAX + 8] = "";
+	char to[PATH_MAX + 8] = "";
+	int files = GLOB(pcap_files) > 0 ? GLOB(pcap_files) : 1;
+	int i = 0;
+
+	if (sccp_pcap.file) {
+		fclose(sccp_pcap.file);
+		sccp_pcap.file = NULL;
+	}
+	for (i = files - 1; i > 0; i--) {
+		snprintf(from, sizeof(from), "%s.%d", sccp_pcap.filename, i);
+		snprintf(to, sizeof(to), "%s.%d", sccp_pcap.filename, i + 1);
+		rename(from, to);
+	}
+	snprintf(to, sizeof(to), "%s.1", sccp_pcap.filename);
+	rename(sccp_pcap.filename, to);
+	sccp_pcap.stats.rotations++;
+}
+
+static boolean_t sccp_pcap_open(void)
+{
+	struct {
+		uint32_t magic;
+		uint16_t version_major;
+		uint16_t version_minor;
+		int32_t thiszone;
+		uint32_t sigfigs;
+		uint32_t snaplen;
+		uint32_t linktype;
+	} header = { SCCP_PCAP_MAGIC, 2, 4, 0, 0, SCCP_PCAP_SNAPLEN, SCCP_PCAP_LINKTYPE_RAW };
+
+	if (!access(sccp_pcap.filename, F_OK)) {								/* earlier capture, or the remains of a failed write */
+		sccp_pcap_rotate();
+	}
+	if (!(sccp_pcap.file = fopen(sccp_pcap.filename, "w"))) {
+		pbx_log(LOG_ERROR, "SCCP: (pcap) unable to open '%s': %s\n", sccp_pcap.filename, strerror(errno));
+		return FALSE;
+	}
+	if (fwrite(&header, sizeof(header), 1, sccp_pcap.file) != 1) {
+		pbx_log(LOG_ERROR, "SCCP: (pcap) unable to write '%s': %s\n", sccp_pcap.filename, strerror(errno));
+		fclose(sccp_pcap.file);
+		sccp_pcap.file = NULL;
+		return FALSE;
+	}
+	sccp_pcap.filesize = sizeof(header);
+	return TRUE;
+}
+
+static void sccp_pcap_write(const sccp_pcap_slot_t * slot)
+{
+	uint8_t hdr[16 + 40 + 20] = { 0 };									/* pcap record + ip + tcp */
+	uint8_t *ip = hdr + 16;
+	uint8_t *tcp = NULL;
+	size_t iplen = (slot->family == AF_INET6) ? 40 : 20;
+	size_t caplen = iplen + 20 + slot->len;
+	long maxsize = (long) GLOB(pcap_filesize) * 1024;
+
+	if (sccp_pcap.file && maxsize > 0 && sccp_pcap.filesize + 16 + (long) caplen > maxsize) {
+		sccp_pcap_rotate();
+	}
+	if (!sccp_pcap.file && !sccp_pcap_open()) {
+		return;
+	}
+
+	/* record header, in host byte order like the file header */
+	uint32_t rec[4] = { (uint32_t) slot->tv.tv_sec, (uint32_t) slot->tv.tv_usec, (uint32_t) caplen, (uint32_t) caplen };
+	memcpy(hdr, rec, sizeof(rec));
+
+	if (slot->family == AF_INET6) {
+		ip[0] = 0x60;
+		sccp_pcap_put16(ip + 4, (uint16_t) (20 + slot->len));
+		ip[6] = IPPROTO_TCP;
+		ip[7] = 64;
+		memcpy(ip + 8, slot->src, 16);
+		memcpy(ip + 24, slot->dst, 16);
+	} else {
+		ip[0] = 0x45;
+		sccp_pcap_put16(ip + 2, (uint16_t) caplen);
+		sccp_pcap_put16(ip + 4, sccp_pcap.ipid++);
+		sccp_pcap_put16(ip + 6, 0x4000);								/* don't fragment */
+		ip[8] = 64;
+		ip[9] = IPPROTO_TCP;
+		memcpy(ip + 12, slot->src, 4);
+		memcpy(ip + 16, slot->dst, 4);
+		sccp_pcap_put16(ip + 10, sccp_pcap_ipChecksum(ip, 20));
+	}
+	tcp = ip + iplen;
+	sccp_pcap_put16(tcp, slot->sport);
+	sccp_pcap_put16(tcp + 2, slot->dport);
+	sccp_pcap_put32(tcp + 4, slot->tcpseq);
+	sccp_pcap_put32(tcp + 8, slot->tcpack);
+	tcp[12] = 5 << 4;											/* data offset */
+	tcp[13] = 0x18;												/* PSH | ACK */
+	sccp_pcap_put16(tcp + 14, 65535);									/* window, checksum left 0 */
+
+	if (fwrite(hdr, 16 + iplen + 20, 1, sccp_pcap.file) != 1 || fwrite(slot->data, slot->len, 1, sccp_pcap.file) != 1) {
+		pbx_log(LOG_ERROR, "SCCP: (pcap) write to '%s' failed: %s\n", sccp_pcap.filename, strerror(errno));
+		fclose(sccp_pcap.file);
+		sccp_pcap.file = NULL;
+		return;
+	}
+	sccp_pcap.filesize += 16 + caplen;
+	sccp_pcap.stats.written++;
+}
+
+static void sccp_pcap_drain(void)
+{
+	sccp_pcap_slot_t *slot = NULL;
+	int written = 0;
+
+	for (;;) {
+		slot = &sccp_pcap.ring[sccp_pcap.dequeue_pos & (SCCP_PCAP_RING_SIZE - 1)];
+		if (ATOMIC_FETCH(&slot->seq, &sccp_pcap_atomic_lock) != sccp_pcap.dequeue_pos + 1) {
+			break;
+		}
+		sccp_pcap_write(slot);
+		ATOMIC_INCR(&slot->seq, SCCP_PCAP_RING_SIZE - 1, &sccp_pcap_atomic_lock);			/* release for the next round */
+		sccp_pcap.dequeue_pos++;
+		written++;
+	}
+	if (written && sccp_pcap.file) {
+		fflush(sccp_pcap.file);
+	}
+}
+
+static void *sccp_pcap_thread(void *data)
+{
+	struct timespec ts;
+	struct timeval tp;
+
+	pbx_mutex_lock(&sccp_pcap.lock);
+	while (sccp_pcap.writing) {
+		pbx_mutex_unlock(&sccp_pcap.lock);
+		sccp_pcap_drain();
+		pbx_mutex_lock(&sccp_pcap.lock);
+		if (sccp_pcap.writing) {
+			gettimeofday(&tp, NULL);
+			ts.tv_sec = tp.tv_sec;
+			ts.tv_nsec = (tp.tv_usec + SCCP_PCAP_INTERVAL * 1000) * 1000;
+			if (ts.tv_nsec >= 1000000000) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+			pbx_cond_timedwait(&sccp_pcap.wakeup, &sccp_pcap.lock, &ts);
+		}
+	}
+	pbx_mutex_unlock(&sccp_pcap.lock);
+	sccp_pcap_drain();
+	return NULL;
+}
+
+/* call with sccp_pcap_control_lock held */
+static boolean_t sccp_pcap_start(const char *filename)
+{
+	int i = 0;
+
+	if (sccp_pcap.running) {
+		return TRUE;
+	}
+	if (!(sccp_pcap.ring = sccp_calloc(SCCP_PCAP_RING_SIZE, sizeof(sccp_pcap_slot_t)))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return FALSE;
+	}
+	for (i = 0; i < SCCP_PCAP_RING_SIZE; i++) {
+		sccp_pcap.ring[i].seq = i;
+	}
+	sccp_pcap.enqueue_pos = 0;
+	sccp_pcap.dequeue_pos = 0;
+	sccp_copy_string(sccp_pcap.filename, filename, sizeof(sccp_pcap.filename));
+	pbx_mutex_init(&sccp_pcap.lock);
+	pbx_cond_init(&sccp_pcap.wakeup, NULL);
+	sccp_pcap.writing = TRUE;
+	sccp_pcap.running = TRUE;
+	if (pbx_pthread_create(&sccp_pcap.thread, NULL, sccp_pcap_thread, NULL)) {
+		pbx_log(LOG_ERROR, "SCCP: (pcap) unable to start the capture writer thread\n");
+		sccp_pcap.running = FALSE;
+		sccp_pcap.writing = FALSE;
+		pbx_cond_destroy(&sccp_pcap.wakeup);
+		pbx_mutex_destroy(&sccp_pcap.lock);
+		sccp_free(sccp_pcap.ring);
+		return FALSE;
+	}
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "SCCP: (pcap) capturing to '%s'\n", sccp_pcap.filename);
+	return TRUE;
+}
+
+/* call with sccp_pcap_control_lock held */
+static void sccp_pcap_stop(void)
+{
+	if (!sccp_pcap.running) {
+		return;
+	}
+	sccp_pcap.running = FALSE;
+	while (ATOMIC_FETCH(&sccp_pcap.inflight, &sccp_pcap_atomic_lock) > 0) {				/* producers still copying into a slot, the writer has to see it */
+		sched_yield();
+	}
+	pbx_mutex_lock(&sccp_pcap.lock);
+	sccp_pcap.writing = FALSE;
+	pbx_cond_signal(&sccp_pcap.wakeup);
+	pbx_mutex_unlock(&sccp_pcap.lock);
+	pthread_join(sccp_pcap.thread, NULL);
+
+	if (sccp_pcap.file) {
+		fclose(sccp_pcap.file);
+		sccp_pcap.file = NULL;
+	}
+	pbx_cond_destroy(&sccp_pcap.wakeup);
+	pbx_mutex_destroy(&sccp_pcap.lock);
+	sccp_free(sccp_pcap.ring);
+	sccp_log((DEBUGCAT_CORE)) (VERBOSE_PREFIX_3 "SCCP: (pcap) capture to '%s' stopped\n", sccp_pcap.filename);
+}
+
+/* ========================================================================================================= Public API == */
+/*!
+ * \brief Is this device being captured
+ */
+boolean_t sccp_pcap_match(const char *deviceName)
+{
+	sccp_pcap_device_t *device = NULL;
+	boolean_t res = FALSE;
+
+	if (!sccp_pcap.running || sccp_strlen_zero(deviceName)) {
+		return FALSE;
+	}
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	SCCP_LIST_TRAVERSE(&sccp_pcap.devices, device, list) {
+		if (sccp_strcaseequals(device->name, deviceName)) {
+			res = TRUE;
+			break;
+		}
+	}
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+	return res;
+}
+
+/*!
+ * \brief Start / Stop capturing a device
+ * \note the writer is started with the first and stopped with the last device, callers refresh the session flags afterwards
+ * \return TRUE when the set of captured devices changed
+ */
+boolean_t sccp_pcap_set(const char *deviceName, boolean_t enable)
+{
+	sccp_pcap_device_t *device = NULL;
+	boolean_t changed = FALSE;
+
+	if (sccp_strlen_zero(deviceName)) {
+		return FALSE;
+	}
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_pcap.devices, device, list) {
+		if (sccp_strcaseequals(device->name, deviceName)) {
+			if (!enable) {
+				SCCP_LIST_REMOVE_CURRENT(list);
+				sccp_free(device);
+				changed = TRUE;
+			}
+			break;
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	if (!device && enable) {
+		char filename[PATH_MAX] = "";
+		const char *pcap_file = !sccp_strlen_zero(GLOB(pcap_file)) ? GLOB(pcap_file) : "sccp.pcap";
+
+		if (pcap_file[0] == '/') {
+			sccp_copy_string(filename, pcap_file, sizeof(filename));
+		} else {
+			snprintf(filename, sizeof(filename), "%s/%s", ast_config_AST_LOG_DIR, pcap_file);
+		}
+		if (sccp_pcap_start(filename) && (device = sccp_calloc(sizeof *device, 1))) {
+			sccp_copy_string(device->name, deviceName, sizeof(device->name));
+			SCCP_LIST_INSERT_TAIL(&sccp_pcap.devices, device, list);
+			changed = TRUE;
+		}
+	}
+	if (!SCCP_LIST_GETSIZE(&sccp_pcap.devices)) {
+		sccp_pcap_stop();
+	}
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+	return changed;
+}
+
+void sccp_pcap_getStats(sccp_pcap_stats_t * stats, pbx_str_t ** devices)
+{
+	sccp_pcap_device_t *device = NULL;
+
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	*stats = sccp_pcap.stats;
+	stats->devices = SCCP_LIST_GETSIZE(&sccp_pcap.devices);
+	stats->filesize = sccp_pcap.running ? sccp_pcap.filesize : 0;
+	sccp_copy_string(stats->filename, sccp_pcap.running ? sccp_pcap.filename : "", sizeof(stats->filename));
+	if (devices) {
+		SCCP_LIST_TRAVERSE(&sccp_pcap.devices, device, list) {
+			pbx_str_append(devices, 0, "%s%s", pbx_str_strlen(*devices) ? "," : "", device->name);
+		}
+	}
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+}
+
+void sccp_pcap_module_start(void)
+{
+	memset(&sccp_pcap.stats, 0, sizeof(sccp_pcap.stats));
+}
+
+void sccp_pcap_module_stop(void)
+{
+	sccp_pcap_device_t *device = NULL;
+
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	sccp_pcap_stop();
+	while ((device = SCCP_LIST_REMOVE_HEAD(&sccp_pcap.devices, list))) {
+		sccp_free(device);
+	}
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define SCCP_PCAP_TEST_THREADS 4
+#define SCCP_PCAP_TEST_PACKETS 2000
+
+static void *sccp_pcap_testThread(void *data)
+{
+	struct sockaddr_storage device = { 0 };
+	struct sockaddr_storage server = { 0 };
+	sccp_pcap_endpoint_t src = { &device, 49152 + (int) (intptr_t) data, 0 };
+	sccp_pcap_endpoint_t dst = { &server, 2000, 0 };
+	uint8_t packet[12] = { 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };						/* KeepAliveMessage */
+	int i = 0;
+
+	device.ss_family = AF_INET;
+	((struct sockaddr_in *) &device)->sin_addr.s_addr = htonl(0xC0000201 + (int) (intptr_t) data);		/* 192.0.2.x */
+	server.ss_family = AF_INET;
+	((struct sockaddr_in *) &server)->sin_addr.s_addr = htonl(0xC00002FE);
+	for (i = 0; i < SCCP_PCAP_TEST_PACKETS; i++) {
+		sccp_pcap_capture(&src, &dst, packet, sizeof(packet));
+		src.seq += sizeof(packet);
+		if (i % (SCCP_PCAP_RING_SIZE / 4) == 0) {
+			usleep(1000);
+		}
+	}
+	return NULL;
+}
+
+AST_TEST_DEFINE(sccp_pcap_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "capture";
+			info->category = "/channels/chan_sccp/pcap/";
+			info->summary = "chan-sccp-b pcap capture test";
+			info->description = "concurrent capture through the ring, pcap file layout";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pthread_t threads[SCCP_PCAP_TEST_THREADS];
+	char filename[PATH_MAX] = "";
+	sccp_pcap_stats_t before = sccp_pcap.stats;
+	uint32_t header[6] = { 0 };
+	uint32_t rec[4] = { 0 };
+	uint8_t ip[20 + 20 + 12] = { 0 };
+	int records = 0;
+	int res = AST_TEST_PASS;
+	int thread = 0;
+	FILE *f = NULL;
+
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	if (sccp_pcap.running) {
+		pbx_mutex_unlock(&sccp_pcap_control_lock);
+		pbx_test_status_update(test, "capture already running, skipped\n");
+		return AST_TEST_PASS;
+	}
+	snprintf(filename, sizeof(filename), "/tmp/sccp_pcap_test.%d.pcap", (int) getpid());
+	if (!sccp_pcap_start(filename)) {
+		pbx_mutex_unlock(&sccp_pcap_control_lock);
+		return AST_TEST_FAIL;
+	}
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+
+	pbx_test_status_update(test, "%d threads capturing %d packets...\n", SCCP_PCAP_TEST_THREADS, SCCP_PCAP_TEST_PACKETS);
+	for (thread = 0; thread < SCCP_PCAP_TEST_THREADS; thread++) {
+		pbx_pthread_create(&threads[thread], NULL, sccp_pcap_testThread, (void *) (intptr_t) thread);
+	}
+	for (thread = 0; thread < SCCP_PCAP_TEST_THREADS; thread++) {
+		pthread_join(threads[thread], NULL);
+	}
+	pbx_mutex_lock(&sccp_pcap_control_lock);
+	sccp_pcap_stop();
+	pbx_mutex_unlock(&sccp_pcap_control_lock);
+	pbx_test_status_update(test, "captured:%d, written:%d, dropped:%d\n", sccp_pcap.stats.captured - before.captured, sccp_pcap.stats.written - before.written, sccp_pcap.stats.dropped - before.dropped);
+
+	if ((sccp_pcap.stats.captured - before.captured) + (sccp_pcap.stats.dropped - before.dropped) != SCCP_PCAP_TEST_THREADS * SCCP_PCAP_TEST_PACKETS) {
+		res = AST_TEST_FAIL;
+	}
+	if (sccp_pcap.stats.captured - before.captured != sccp_pcap.stats.written - before.written) {
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "reading back %s...\n", filename);
+	if (!(f = fopen(filename, "r")) || fread(header, sizeof(header), 1, f) != 1 || header[0] != SCCP_PCAP_MAGIC || header[5] != SCCP_PCAP_LINKTYPE_RAW) {
+		res = AST_TEST_FAIL;
+	} else {
+		while (fread(rec, sizeof(rec), 1, f) == 1 && rec[2] == sizeof(ip) && fread(ip, sizeof(ip), 1, f) == 1) {
+			if (ip[0] != 0x45 || ip[9] != IPPROTO_TCP || sccp_pcap_ipChecksum(ip, 20) != 0 || ip[20 + 13] != 0x18 || ip[40] != 4) {
+				res = AST_TEST_FAIL;
+				break;
+			}
+			records++;
+		}
+		if (records != sccp_pcap.stats.written - before.written) {
+			pbx_test_status_update(test, "file contains %d records\n", records);
+			res = AST_TEST_FAIL;
+		}
+	}
+	if (f) {
+		fclose(f);
+	}
+	unlink(filename);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_pcap_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_pcap_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
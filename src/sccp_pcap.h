@@ -0,0 +1,40 @@
+/*!
+ * \file        sccp_pcap.h
+ * \brief       SCCP Packet Capture Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief Packet Capture Statistics
+ */
+typedef struct sccp_pcap_stats {
+	int devices;												/*!< devices being captured */
+	int captured;												/*!< packets queued */
+	int written;												/*!< packets written to file */
+	int dropped;												/*!< packets lost because the ring was full */
+	int rotations;
+	long filesize;												/*!< bytes in the current file */
+	char filename[PATH_MAX];
+} sccp_pcap_stats_t;
+
+/*!
+ * \brief Capture endpoint (one direction of a session)
+ */
+typedef struct sccp_pcap_endpoint {
+	const struct sockaddr_storage *addr;
+	uint16_t port;
+	uint32_t seq;												/*!< synthetic tcp sequence number, advanced by the caller */
+} sccp_pcap_endpoint_t;
+
+SCCP_API void SCCP_CALL sccp_pcap_module_start(void);
+SCCP_API void SCCP_CALL sccp_pcap_module_stop(void);
+SCCP_API boolean_t SCCP_CALL sccp_pcap_set(const char *deviceName, boolean_t enable);
+SCCP_API boolean_t SCCP_CALL sccp_pcap_match(const char *deviceName);
+SCCP_API void SCCP_CALL sccp_pcap_capture(const sccp_pcap_endpoint_t * src, const sccp_pcap_endpoint_t * dst, const uint8_t * data, size_t len);
+SCCP_API void SCCP_CALL sccp_pcap_getStats(sccp_pcap_stats_t * stats, pbx_str_t ** devices);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -24,34 +24,31 @@ SCCP_FILE_VERSION(__FILE__, "");
 /* CallInfo Message */
 
 /* =================================================================================================================== Send Messages */
-static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_snapshot_t * const snapshot, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
 {
  	pbx_assert(device != NULL);
 	sccp_msg_t *msg;
 
 	REQ(msg, CallInfoMessage);
 
-	int originalCdpnRedirectReason = 0;
-	int lastRedirectingReason = 0;
-	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
-
-	iCallInfo.Getter(ci,
-		SCCP_CALLINFO_CALLEDPARTY_NAME, &msg->data.CallInfoMessage.calledPartyName,
-		SCCP_CALLINFO_CALLEDPARTY_NUMBER, &msg->data.CallInfoMessage.calledParty,
-		SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &msg->data.CallInfoMessage.cdpnVoiceMailbox,
-		SCCP_CALLINFO_CALLINGPARTY_NAME, &msg->data.CallInfoMessage.callingPartyName,
-		SCCP_CALLINFO_CALLINGPARTY_NUMBER, &msg->data.CallInfoMessage.callingParty,
-		SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &msg->data.CallInfoMessage.cgpnVoiceMailbox,
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &msg->data.CallInfoMessage.originalCalledPartyName,
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &msg->data.CallInfoMessage.originalCalledParty,
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &msg->data.CallInfoMessage.originalCdpnVoiceMailbox,
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &msg->data.CallInfoMessage.lastRedirectingPartyName,
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &msg->data.CallInfoMessage.lastRedirectingParty,
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &msg->data.CallInfoMessage.lastRedirectingVoiceMailbox,
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
-		SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
-		SCCP_CALLINFO_PRESENTATION, &presentation,
-		SCCP_CALLINFO_KEY_SENTINEL);
+	int originalCdpnRedirectReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON);
+	int lastRedirectingReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_LAST_REDIRECT_REASON);
+	sccp_callerid_presentation_t presentation = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_PRESENTATION);
+
+#define CALLINFO_COPY(_field, _key) sccp_copy_string(msg->data.CallInfoMessage._field, iCallInfo.SnapshotString(snapshot, _key), sizeof(msg->data.CallInfoMessage._field))
+	CALLINFO_COPY(calledPartyName, SCCP_CALLINFO_CALLEDPARTY_NAME);
+	CALLINFO_COPY(calledParty, SCCP_CALLINFO_CALLEDPARTY_NUMBER);
+	CALLINFO_COPY(cdpnVoiceMailbox, SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL);
+	CALLINFO_COPY(callingPartyName, SCCP_CALLINFO_CALLINGPARTY_NAME);
+	CALLINFO_COPY(callingParty, SCCP_CALLINFO_CALLINGPARTY_NUMBER);
+	CALLINFO_COPY(cgpnVoiceMailbox, SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL);
+	CALLINFO_COPY(originalCalledPartyName, SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME);
+	CALLINFO_COPY(originalCalledParty, SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER);
+	CALLINFO_COPY(originalCdpnVoiceMailbox, SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL);
+	CALLINFO_COPY(lastRedirectingPartyName, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME);
+	CALLINFO_COPY(lastRedirectingParty, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER);
+	CALLINFO_COPY(lastRedirectingVoiceMailbox, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL);
+#undef CALLINFO_COPY
 
 	// 7920's exception. They don't seem to reverse the interpretation of the presentation flag
 	if (device->skinny_type == SKINNY_DEVICETYPE_CISCO7920) {
@@ -74,40 +71,34 @@ static void sccp_protocol_sendCallInfoV3 (const sccp_callinfo_t * const ci, cons
 	sccp_dev_send(device, msg);
 }
 
-static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_snapshot_t * const snapshot, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
 {
  	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
 
-	unsigned int dataSize = 12;
-	char data[dataSize][StationMaxNameSize];
+	/* the snapshot is immutable while we hold it, so we can use its strings directly */
+	const char *data[] = {
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME),
+	};
+	unsigned int dataSize = ARRAY_LEN(data);
 	int data_len[dataSize];
 	unsigned int i = 0;
 	int dummy_len = 0;
 
-	memset(data, 0, dataSize * StationMaxNameSize);
-	
-	int originalCdpnRedirectReason = 0;
-	int lastRedirectingReason = 0;
-	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
-	iCallInfo.Getter(ci,
-		SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
-		SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[1],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[2],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[3],
-		SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[4],
-		SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[5],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[6],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[7],
-		SCCP_CALLINFO_CALLINGPARTY_NAME, &data[8],
-		SCCP_CALLINFO_CALLEDPARTY_NAME, &data[9],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[10],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[11],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
-		SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
-		SCCP_CALLINFO_PRESENTATION, &presentation,
-		SCCP_CALLINFO_KEY_SENTINEL);
-
+	int originalCdpnRedirectReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON);
+	int lastRedirectingReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_LAST_REDIRECT_REASON);
+	sccp_callerid_presentation_t presentation = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_PRESENTATION);
 
 	for (i = 0; i < dataSize; i++) {
 		data_len[i] = strlen(data[i]);
@@ -154,38 +145,34 @@ static void sccp_protocol_sendCallInfoV7 (const sccp_callinfo_t * const ci, cons
 	sccp_dev_send(device, msg);
 }
 
-static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_t * const ci, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
+static void sccp_protocol_sendCallInfoV16 (const sccp_callinfo_snapshot_t * const snapshot, const uint32_t callid, const skinny_calltype_t calltype, const uint8_t lineInstance, const uint8_t callInstance, const skinny_callsecuritystate_t callsecurityState, constDevicePtr device)
 {
  	pbx_assert(device != NULL);
 	sccp_msg_t *msg = NULL;
 
-	unsigned int dataSize = 15;
-	char data[dataSize][StationMaxNameSize];
-	memset(data, 0, dataSize * StationMaxNameSize);
-
-	int originalCdpnRedirectReason = 0;
-	int lastRedirectingReason = 0;
-	sccp_callerid_presentation_t presentation = CALLERID_PRESENTATION_ALLOWED;
-	iCallInfo.Getter(ci,
-		SCCP_CALLINFO_CALLINGPARTY_NUMBER, &data[0],
-		SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER, &data[1],
-		SCCP_CALLINFO_CALLEDPARTY_NUMBER, &data[2],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER, &data[3],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER, &data[4],
-		SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL, &data[5],
-		SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL, &data[6],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL, &data[7],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL, &data[8],
-		SCCP_CALLINFO_CALLINGPARTY_NAME, &data[9],
-		SCCP_CALLINFO_CALLEDPARTY_NAME, &data[10],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME, &data[11],
-		SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME, &data[12],
-		SCCP_CALLINFO_HUNT_PILOT_NUMBER, &data[13],
-		SCCP_CALLINFO_HUNT_PILOT_NAME, &data[14],
-		SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON, &originalCdpnRedirectReason,
-		SCCP_CALLINFO_LAST_REDIRECT_REASON, &lastRedirectingReason,
-		SCCP_CALLINFO_PRESENTATION, &presentation,
-		SCCP_CALLINFO_KEY_SENTINEL);
+	/* the snapshot is immutable while we hold it, so we can use its strings directly */
+	const char *data[] = {
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLINGPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_VOICEMAIL),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLINGPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_CALLEDPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_LAST_REDIRECTINGPARTY_NAME),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_HUNT_PILOT_NUMBER),
+		iCallInfo.SnapshotString(snapshot, SCCP_CALLINFO_HUNT_PILOT_NAME),
+	};
+	unsigned int dataSize = ARRAY_LEN(data);
+
+	int originalCdpnRedirectReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_ORIG_CALLEDPARTY_REDIRECT_REASON);
+	int lastRedirectingReason = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_LAST_REDIRECT_REASON);
+	sccp_callerid_presentation_t presentation = iCallInfo.SnapshotValue(snapshot, SCCP_CALLINFO_PRESENTATION);
 
 	unsigned int field = 0;
 	int data_len = 0;
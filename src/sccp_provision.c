@@ -0,0 +1,559 @@
+/*!
+ * \file        sccp_provision.c
+ * \brief       SCCP Phone Provisioning
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Renders the SEP<mac>.cnf.xml file of every configured device into provision_dir, so that the phone configuration
+ * follows sccp.conf without regenerating the files out of band:
+ * - runs after every (re)load, rendering from the live device objects
+ * - the inputs of each device are hashed, only devices whose hash changed are rendered and written again
+ * - files are written to a temporary file and renamed, a phone never fetches a partially written file
+ * - files of devices that disappeared from the configuration are removed
+ *
+ * The rendered files only carry the settings chan-sccp-b owns (protocol, date format, callmanager address and port,
+ * firmware), so provision_dir is meant to be a dedicated directory rather than a tftp root holding hand made files.
+ * Every rendered file carries SCCP_PROVISION_MARKER, existing files without it are never overwritten nor removed.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_provision.h"
+#include "sccp_device.h"
+#include "sccp_netsock.h"
+#include "sccp_utils.h"
+#include <fcntl.h>
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_PROVISION_BUCKETS 256
+#define SCCP_PROVISION_HASH_OFFSET 14695981039346656037ULL
+#define SCCP_PROVISION_HASH_PRIME 1099511628211ULL
+#define SCCP_PROVISION_MAX_HOST 256
+#define SCCP_PROVISION_MARKER "generated by chan-sccp-b"
+#define SCCP_PROVISION_MARKER_SCAN 256									/* the marker is on the second line */
+
+/*!
+ * \brief Everything that ends up in the cnf.xml of one device
+ */
+typedef struct sccp_provision_device {
+	char id[StationMaxDeviceNameSize];
+	char imageversion[StationMaxImageVersionSize];
+} sccp_provision_device_t;
+
+/*!
+ * \brief Settings shared by all devices
+ */
+typedef struct sccp_provision_global {
+	char host[SCCP_PROVISION_MAX_HOST];									/*!< processNodeName, empty to let the phone use its tftp server */
+	char dateformat[SCCP_MAX_DATE_FORMAT];
+	uint16_t port;
+} sccp_provision_global_t;
+
+typedef struct sccp_provision_entry sccp_provision_entry_t;
+SCCP_LIST_HEAD (sccp_provision_bucket, sccp_provision_entry_t);
+
+struct sccp_provision_entry {
+	SCCP_LIST_ENTRY (sccp_provision_entry_t) list;
+	char id[StationMaxDeviceNameSize];
+	uint64_t hash;
+	uint32_t generation;
+	size_t len;
+	char *xml;												/*!< rendered bytes, as written to disk */
+};
+
+static struct {
+	struct sccp_provision_bucket buckets[SCCP_PROVISION_BUCKETS];
+	char dir[PATH_MAX];											/*!< directory the cached entries were written to */
+	uint32_t generation;
+} sccp_provision;
+
+AST_MUTEX_DEFINE_STATIC(sccp_provision_lock);
+
+static uint64_t sccp_provision_hash(uint64_t hash, const char *str)
+{
+	for (; *str; str++) {
+		hash = (hash ^ (uint8_t) *str) * SCCP_PROVISION_HASH_PRIME;
+	}
+	return (hash ^ 0xff) * SCCP_PROVISION_HASH_PRIME;							/* terminator, "ab"+"c" != "a"+"bc" */
+}
+
+static uint64_t sccp_provision_hashDevice(const sccp_provision_global_t * global, const sccp_provision_device_t * device)
+{
+	uint64_t hash = SCCP_PROVISION_HASH_OFFSET;
+
+	hash = sccp_provision_hash(hash, global->host);
+	hash = sccp_provision_hash(hash, global->dateformat);
+	hash = (hash ^ global->port) * SCCP_PROVISION_HASH_PRIME;
+	hash = sccp_provision_hash(hash, device->id);
+	hash = sccp_provision_hash(hash, device->imageversion);
+	return hash;
+}
+
+static struct sccp_provision_bucket *sccp_provision_bucket(const char *id)
+{
+	uint32_t hash = 5381;
+
+	for (; *id; id++) {
+		hash = (hash * 33) ^ (uint8_t) toupper(*id);
+	}
+	return &sccp_provision.buckets[hash % SCCP_PROVISION_BUCKETS];
+}
+
+/* call with sccp_provision_lock held */
+static sccp_provision_entry_t *sccp_provision_find(const char *id)
+{
+	sccp_provision_entry_t *entry = NULL;
+
+	SCCP_LIST_TRAVERSE(sccp_provision_bucket(id), entry, list) {
+		if (sccp_strcaseequals(entry->id, id)) {
+			break;
+		}
+	}
+	return entry;
+}
+
+static void sccp_provision_escape(struct ast_str **buf, const char *str)
+{
+	for (; *str; str++) {
+		switch (*str) {
+			case '&':
+				pbx_str_append(buf, 0, "&amp;");
+				break;
+			case '<':
+				pbx_str_append(buf, 0, "&lt;");
+				break;
+			case '>':
+				pbx_str_append(buf, 0, "&gt;");
+				break;
+			case '"':
+				pbx_str_append(buf, 0, "&quot;");
+				break;
+			default:
+				pbx_str_append(buf, 0, "%c", *str);
+				break;
+		}
+	}
+}
+
+#define SCCP_PROVISION_ELEMENT(_buf, _indent, _name, _value) do {						\
+	if (!sccp_strlen_zero(_value)) {									\
+		pbx_str_append(_buf, 0, "%s<" _name ">", _indent);						\
+		sccp_provision_escape(_buf, _value);								\
+		pbx_str_append(_buf, 0, "</" _name ">\n");							\
+	}													\
+} while (0)
+
+static void sccp_provision_render(struct ast_str **buf, const sccp_provision_global_t * global, const sccp_provision_device_t * device)
+{
+	pbx_str_reset(*buf);
+	pbx_str_append(buf, 0, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	pbx_str_append(buf, 0, "<!-- %s, " SCCP_PROVISION_MARKER ", changes will be overwritten on reload -->\n", device->id);
+	pbx_str_append(buf, 0, "<device>\n");
+	pbx_str_append(buf, 0, "  <deviceProtocol>SCCP</deviceProtocol>\n");
+	pbx_str_append(buf, 0, "  <devicePool>\n");
+	pbx_str_append(buf, 0, "    <dateTimeSetting>\n");
+	SCCP_PROVISION_ELEMENT(buf, "      ", "dateTemplate", global->dateformat);
+	pbx_str_append(buf, 0, "    </dateTimeSetting>\n");
+	pbx_str_append(buf, 0, "    <callManagerGroup>\n");
+	pbx_str_append(buf, 0, "      <members>\n");
+	pbx_str_append(buf, 0, "        <member priority=\"0\">\n");
+	pbx_str_append(buf, 0, "          <callManager>\n");
+	pbx_str_append(buf, 0, "            <ports>\n");
+	pbx_str_append(buf, 0, "              <ethernetPhonePort>%d</ethernetPhonePort>\n", global->port);
+	pbx_str_append(buf, 0, "            </ports>\n");
+	SCCP_PROVISION_ELEMENT(buf, "            ", "processNodeName", global->host);
+	pbx_str_append(buf, 0, "          </callManager>\n");
+	pbx_str_append(buf, 0, "        </member>\n");
+	pbx_str_append(buf, 0, "      </members>\n");
+	pbx_str_append(buf, 0, "    </callManagerGroup>\n");
+	pbx_str_append(buf, 0, "  </devicePool>\n");
+	SCCP_PROVISION_ELEMENT(buf, "  ", "loadInformation", device->imageversion);
+	pbx_str_append(buf, 0, "</device>\n");
+}
+
+/*!
+ * \brief Check if a file may be overwritten or removed, which is only the case if it is missing or was written by us
+ */
+static boolean_t sccp_provision_ownsFile(const char *path)
+{
+	char head[SCCP_PROVISION_MARKER_SCAN + 1] = "";
+	FILE *fp = NULL;
+
+	if (!(fp = fopen(path, "r"))) {
+		return errno == ENOENT;
+	}
+	head[fread(head, 1, SCCP_PROVISION_MARKER_SCAN, fp)] = '\0';
+	fclose(fp);
+	return strstr(head, SCCP_PROVISION_MARKER) != NULL;
+}
+
+static boolean_t sccp_provision_writeFile(const char *dir, const char *id, const char *xml, size_t len)
+{
+	char path[PATH_MAX];
+	char tmppath[PATH_MAX];
+	FILE *fp = NULL;
+	int fd = -1;
+	boolean_t res = FALSE;
+
+	snprintf(path, sizeof(path), "%s/%s.cnf.xml", dir, id);
+	snprintf(tmppath, sizeof(tmppath), "%s.%d", path, (int) getpid());
+	unlink(tmppath);											/* left behind by a crash, never follow a link planted there */
+	if ((fd = open(tmppath, O_WRONLY | O_CREAT | O_EXCL, 0600)) < 0 || !(fp = fdopen(fd, "w"))) {
+		pbx_log(LOG_WARNING, "SCCP: Unable to write provisioning file '%s': %s\n", tmppath, strerror(errno));
+		if (fd >= 0) {
+			close(fd);
+			unlink(tmppath);
+		}
+		return FALSE;
+	}
+	/* the tftp server has to be able to read it, published only once it is complete */
+	if (fwrite(xml, 1, len, fp) == len && fchmod(fd, 0644) == 0) {
+		res = TRUE;
+	}
+	if (fclose(fp) != 0) {
+		res = FALSE;
+	}
+	if (!res || rename(tmppath, path) != 0) {
+		pbx_log(LOG_WARNING, "SCCP: Unable to write provisioning file '%s': %s\n", path, strerror(errno));
+		unlink(tmppath);
+		res = FALSE;
+	}
+	return res;
+}
+
+static void sccp_provision_removeFile(const char *dir, const char *id, sccp_provision_summary_t * summary)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/%s.cnf.xml", dir, id);
+	if (!sccp_provision_ownsFile(path)) {
+		pbx_log(LOG_NOTICE, "SCCP: Provisioning file '%s' was not written by chan-sccp-b, leaving it in place\n", path);
+		summary->skipped++;
+		return;
+	}
+	if (unlink(path) != 0 && errno != ENOENT) {
+		pbx_log(LOG_WARNING, "SCCP: Unable to remove provisioning file '%s': %s\n", path, strerror(errno));
+		summary->failed++;
+		return;
+	}
+	summary->removed++;
+}
+
+/* call with sccp_provision_lock held */
+static void sccp_provision_flush(boolean_t removeFiles, sccp_provision_summary_t * summary)
+{
+	sccp_provision_entry_t *entry = NULL;
+	int b = 0;
+
+	for (b = 0; b < SCCP_PROVISION_BUCKETS; b++) {
+		while ((entry = SCCP_LIST_REMOVE_HEAD(&sccp_provision.buckets[b], list))) {
+			if (removeFiles && entry->xml) {
+				sccp_provision_removeFile(sccp_provision.dir, entry->id, summary);
+			}
+			sccp_free(entry->xml);
+			sccp_free(entry);
+		}
+	}
+}
+
+/*!
+ * \brief Render and write the files of a set of devices, rewriting only the ones that changed since the previous call
+ * \note call with sccp_provision_lock held
+ */
+static void sccp_provision_apply(const char *dir, const sccp_provision_global_t * global, const sccp_provision_device_t * devices, size_t count, boolean_t force, sccp_provision_summary_t * summary)
+{
+	struct ast_str *buf = pbx_str_create(1024);
+	sccp_provision_entry_t *entry = NULL;
+	char path[PATH_MAX];
+	uint64_t hash = 0;
+	size_t n = 0;
+	int b = 0;
+
+	if (!buf) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
+	if (!sccp_strequals(sccp_provision.dir, dir)) {
+		sccp_provision_flush(FALSE, summary);								/* leave the files in the previous directory alone */
+		sccp_copy_string(sccp_provision.dir, dir, sizeof(sccp_provision.dir));
+	}
+	sccp_provision.generation++;
+
+	for (n = 0; n < count; n++) {
+		const sccp_provision_device_t *device = &devices[n];
+
+		hash = sccp_provision_hashDevice(global, device);
+		if (!(entry = sccp_provision_find(device->id))) {
+			if (!(entry = sccp_calloc(1, sizeof *entry))) {
+				pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+				summary->failed++;
+				continue;
+			}
+			sccp_copy_string(entry->id, device->id, sizeof(entry->id));
+			SCCP_LIST_INSERT_HEAD(sccp_provision_bucket(device->id), entry, list);
+		} else if (entry->xml && entry->hash == hash && !force) {
+			entry->generation = sccp_provision.generation;
+			summary->unchanged++;
+			continue;
+		}
+		entry->generation = sccp_provision.generation;
+		sccp_provision_render(&buf, global, device);
+		if (entry->xml && entry->len == pbx_str_strlen(buf) && !memcmp(entry->xml, pbx_str_buffer(buf), entry->len) && !force) {
+			entry->hash = hash;										/* input changed, output did not */
+			summary->unchanged++;
+			continue;
+		}
+		if (!entry->xml) {										/* not written by us yet, never replace a foreign file */
+			snprintf(path, sizeof(path), "%s/%s.cnf.xml", dir, device->id);
+			if (!sccp_provision_ownsFile(path)) {
+				pbx_log(LOG_NOTICE, "SCCP: Provisioning file '%s' was not written by chan-sccp-b, leaving it in place\n", path);
+				summary->skipped++;
+				continue;
+			}
+		}
+		if (!sccp_provision_writeFile(dir, device->id, pbx_str_buffer(buf), pbx_str_strlen(buf))) {
+			entry->hash = 0;										/* retry on the next sync */
+			summary->failed++;
+			continue;
+		}
+		if (entry->xml) {
+			sccp_free(entry->xml);
+		}
+		entry->len = pbx_str_strlen(buf);
+		if ((entry->xml = sccp_malloc(entry->len + 1))) {
+			memcpy(entry->xml, pbx_str_buffer(buf), entry->len + 1);
+			entry->hash = hash;
+		}
+		summary->rendered++;
+	}
+
+	for (b = 0; b < SCCP_PROVISION_BUCKETS; b++) {
+		SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_provision.buckets[b], entry, list) {
+			if (entry->generation != sccp_provision.generation) {
+				SCCP_LIST_REMOVE_CURRENT(list);
+				if (entry->xml) {								/* only files we wrote ourselves */
+					sccp_provision_removeFile(dir, entry->id, summary);
+					sccp_free(entry->xml);
+				}
+				sccp_free(entry);
+			}
+		}
+		SCCP_LIST_TRAVERSE_SAFE_END;
+	}
+	sccp_free(buf);
+}
+
+static void sccp_provision_getGlobal(sccp_provision_global_t * global)
+{
+	memset(global, 0, sizeof *global);
+	if (!sccp_strlen_zero(GLOB(externhost))) {
+		sccp_copy_string(global->host, GLOB(externhost), sizeof(global->host));
+	} else if (!sccp_netsock_is_any_addr(&GLOB(externip))) {
+		sccp_copy_string(global->host, sccp_netsock_stringify_addr(&GLOB(externip)), sizeof(global->host));
+	} else if (!sccp_netsock_is_any_addr(&GLOB(bindaddr))) {
+		sccp_copy_string(global->host, sccp_netsock_stringify_addr(&GLOB(bindaddr)), sizeof(global->host));
+	}
+	sccp_copy_string(global->dateformat, GLOB(dateformat), sizeof(global->dateformat));
+	global->port = sccp_netsock_getPort(&GLOB(bindaddr));
+}
+
+/*!
+ * \brief Write the cnf.xml files of all configured devices to provision_dir
+ * \param force rewrite all files, even if their configuration did not change
+ * \param summary Summary (can be NULL)
+ * \return FALSE if provisioning is not configured
+ */
+boolean_t sccp_provision_sync(const boolean_t force, sccp_provision_summary_t * summary)
+{
+	sccp_provision_summary_t local = { 0 };
+	sccp_provision_global_t global;
+	sccp_provision_device_t *devices = NULL;
+	sccp_device_t *d = NULL;
+	size_t count = 0, n = 0;
+	struct timeval start = ast_tvnow();
+
+	if (!summary) {
+		summary = &local;
+	}
+	if (sccp_strlen_zero(GLOB(provision_dir))) {
+		pbx_mutex_lock(&sccp_provision_lock);
+		sccp_provision_flush(FALSE, summary);
+		sccp_provision.dir[0] = '\0';
+		pbx_mutex_unlock(&sccp_provision_lock);
+		return FALSE;
+	}
+	sccp_provision_getGlobal(&global);
+
+	/* collect the inputs first, rendering and writing happens without holding the device list */
+	SCCP_RWLIST_RDLOCK(&GLOB(devices));
+	count = SCCP_RWLIST_GETSIZE(&GLOB(devices));
+	if (count && (devices = sccp_calloc(count, sizeof *devices))) {
+		SCCP_RWLIST_TRAVERSE(&GLOB(devices), d, list) {
+			if (n >= count) {
+				break;
+			}
+			if (d->pendingDelete) {
+				continue;
+			}
+			sccp_copy_string(devices[n].id, d->id, sizeof(devices[n].id));
+			sccp_copy_string(devices[n].imageversion, d->imageversion, sizeof(devices[n].imageversion));
+			n++;
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(devices));
+	if (count && !devices) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return TRUE;
+	}
+
+	pbx_mutex_lock(&sccp_provision_lock);
+	sccp_provision_apply(GLOB(provision_dir), &global, devices, n, force, summary);
+	pbx_mutex_unlock(&sccp_provision_lock);
+	if (devices) {
+		sccp_free(devices);
+	}
+	sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: Provisioning in %s took %" PRId64 "ms, %d written, %d unchanged, %d removed, %d skipped, %d failed\n",
+		GLOB(provision_dir), (int64_t) ast_tvdiff_ms(ast_tvnow(), start), summary->rendered, summary->unchanged, summary->removed, summary->skipped, summary->failed);
+	return TRUE;
+}
+
+void sccp_provision_module_start(void)
+{
+	int b = 0;
+
+	for (b = 0; b < SCCP_PROVISION_BUCKETS; b++) {
+		SCCP_LIST_HEAD_INIT(&sccp_provision.buckets[b]);
+	}
+	sccp_provision.dir[0] = '\0';
+}
+
+void sccp_provision_module_stop(void)
+{
+	sccp_provision_summary_t summary = { 0 };
+	int b = 0;
+
+	pbx_mutex_lock(&sccp_provision_lock);
+	sccp_provision_flush(FALSE, &summary);									/* the phones keep using the files */
+	pbx_mutex_unlock(&sccp_provision_lock);
+	for (b = 0; b < SCCP_PROVISION_BUCKETS; b++) {
+		SCCP_LIST_HEAD_DESTROY(&sccp_provision.buckets[b]);
+	}
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_provision_render_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "render";
+			info->category = "/channels/chan_sccp/provision/";
+			info->summary = "chan-sccp-b provisioning renderer test";
+			info->description = "benchmark full and incremental rendering of 10000 cnf.xml files and verify that only changed devices are rewritten and that foreign files are left alone";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const size_t count = 10000;
+	sccp_provision_global_t global = {.host = "10.0.0.1", .dateformat = "D/M/Y", .port = 2000 };
+	sccp_provision_summary_t summary = { 0 };
+	sccp_provision_device_t *devices = NULL;
+	char dir[] = "/tmp/sccp_provision_XXXXXX";
+	char path[PATH_MAX];
+	char foreign[PATH_MAX];
+	char content[2048] = "";
+	struct timeval start;
+	FILE *fp = NULL;
+	size_t n = 0;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	if (!mkdtemp(dir) || !(devices = sccp_calloc(count, sizeof *devices))) {
+		pbx_test_status_update(test, "Unable to set up the test directory\n");
+		return AST_TEST_FAIL;
+	}
+	for (n = 0; n < count; n++) {
+		snprintf(devices[n].id, sizeof(devices[n].id), "SEP%012zX", n);
+		sccp_copy_string(devices[n].imageversion, "SCCP42.9-4-2SR1-1S", sizeof(devices[n].imageversion));
+	}
+
+	snprintf(foreign, sizeof(foreign), "%s/%s.cnf.xml", dir, devices[1].id);				/* a hand made file, which must survive */
+	if ((fp = fopen(foreign, "w"))) {
+		fputs("<device>hand made</device>\n", fp);
+		fclose(fp);
+	}
+
+	pbx_mutex_lock(&sccp_provision_lock);
+	pbx_test_status_update(test, "Full render...\n");
+	start = ast_tvnow();
+	sccp_provision_apply(dir, &global, devices, count, FALSE, &summary);
+	pbx_test_status_update(test, "Full render of %zu devices took %" PRId64 "ms\n", count, (int64_t) ast_tvdiff_ms(ast_tvnow(), start));
+	if (summary.rendered != count - 1 || summary.skipped != 1 || summary.failed) {
+		res = AST_TEST_FAIL;
+	}
+
+	pbx_test_status_update(test, "Incremental render...\n");
+	for (n = 0; n < count; n += 100) {
+		sccp_copy_string(devices[n].imageversion, "SCCP42.9-4-2SR2-2S & <new>", sizeof(devices[n].imageversion));
+	}
+	memset(&summary, 0, sizeof(summary));
+	start = ast_tvnow();
+	sccp_provision_apply(dir, &global, devices, count, FALSE, &summary);
+	pbx_test_status_update(test, "Incremental render of %zu changed devices took %" PRId64 "ms\n", count / 100, (int64_t) ast_tvdiff_ms(ast_tvnow(), start));
+	if (summary.rendered != count / 100 || summary.unchanged != count - count / 100 - 1 || summary.skipped != 1) {
+		res = AST_TEST_FAIL;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s.cnf.xml", dir, devices[0].id);
+	if ((fp = fopen(path, "r"))) {
+		content[fread(content, 1, sizeof(content) - 1, fp)] = '\0';
+		fclose(fp);
+	}
+	if (!strstr(content, "<loadInformation>SCCP42.9-4-2SR2-2S &amp; &lt;new&gt;</loadInformation>") || !strstr(content, "<processNodeName>10.0.0.1</processNodeName>")) {
+		pbx_test_status_update(test, "Unexpected content in %s\n", path);
+		res = AST_TEST_FAIL;											/* keep going, the lock and the files have to be released */
+	}
+
+	pbx_test_status_update(test, "Removed devices...\n");
+	memset(&summary, 0, sizeof(summary));
+	sccp_provision_apply(dir, &global, devices, count / 2, FALSE, &summary);
+	if (summary.removed != count - count / 2 || access(path, F_OK) != 0) {
+		res = AST_TEST_FAIL;
+	}
+	memset(&summary, 0, sizeof(summary));
+	sccp_provision_apply(dir, &global, devices, 0, FALSE, &summary);					/* cleans up the remaining files */
+	if (summary.removed != count / 2 - 1 || access(path, F_OK) == 0) {
+		res = AST_TEST_FAIL;
+	}
+	sccp_provision.dir[0] = '\0';
+	pbx_mutex_unlock(&sccp_provision_lock);
+
+	content[0] = '\0';
+	if ((fp = fopen(foreign, "r"))) {
+		content[fread(content, 1, sizeof(content) - 1, fp)] = '\0';
+		fclose(fp);
+	}
+	if (!sccp_strequals(content, "<device>hand made</device>\n")) {
+		pbx_test_status_update(test, "The hand made file was modified\n");
+		res = AST_TEST_FAIL;
+	}
+	unlink(foreign);
+
+	rmdir(dir);
+	sccp_free(devices);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_provision_render_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_provision_render_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
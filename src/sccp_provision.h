@@ -0,0 +1,26 @@
+/*!
+ * \file        sccp_provision.h
+ * \brief       SCCP Phone Provisioning Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief Provisioning Summary of one sync
+ */
+typedef struct sccp_provision_summary {
+	uint32_t rendered;											/*!< files (re)written */
+	uint32_t unchanged;											/*!< devices whose config hash did not change */
+	uint32_t removed;											/*!< files of devices that are no longer configured */
+	uint32_t skipped;											/*!< existing files not written by chan-sccp-b, left alone */
+	uint32_t failed;
+} sccp_provision_summary_t;
+
+SCCP_API void SCCP_CALL sccp_provision_module_start(void);
+SCCP_API void SCCP_CALL sccp_provision_module_stop(void);
+SCCP_API boolean_t SCCP_CALL sccp_provision_sync(const boolean_t force, sccp_provision_summary_t * summary);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
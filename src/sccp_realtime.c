@@ -0,0 +1,598 @@
+/*!
+ * \file        sccp_realtime.c
+ * \brief       SCCP Realtime Lookup Cache
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Caches the result of realtime device / line lookups, so that a registering phone or a dialed realtime line does not
+ * need a blocking database round trip every time:
+ * - found rows are kept for realtime_cache_ttl seconds, rows that were not found for realtime_cache_negative_ttl seconds
+ * - concurrent lookups of the same name wait for the query already in flight instead of issuing their own
+ * - at most realtime_cache_size entries are kept, the least recently used one is evicted to make room for a new one
+ * - realtime_cache_prefetch=yes loads the complete device and line tables in one query during (re)load
+ * - 'sccp realtime invalidate' / SCCPRealtimeInvalidate drop entries explicitly, a reload drops all of them
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_realtime.h"
+#include "sccp_utils.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#ifdef CS_SCCP_REALTIME
+#define SCCP_REALTIME_BUCKETS 256
+
+typedef struct sccp_realtime_entry sccp_realtime_entry_t;
+SCCP_LIST_HEAD (sccp_realtime_bucket, sccp_realtime_entry_t);
+
+struct sccp_realtime_entry {
+	SCCP_LIST_ENTRY (sccp_realtime_entry_t) list;
+	sccp_realtime_entry_t *lru_prev;									/*!< more recently used entry */
+	sccp_realtime_entry_t *lru_next;									/*!< less recently used entry */
+	char table[SCCP_MAX_CONTEXT];
+	char name[StationMaxNameSize];
+	PBX_VARIABLE_TYPE *variables;										/*!< cached row, NULL for a negative entry */
+	time_t expires;
+	boolean_t loading;											/*!< query in flight, other lookups wait for it */
+	boolean_t stale;											/*!< invalidated while loading, do not store the result */
+};
+
+static PBX_VARIABLE_TYPE *sccp_realtime_pbx_load(const char *table, const char *name)
+{
+	return pbx_load_realtime(table, "name", name, NULL);
+}
+
+static struct ast_config *sccp_realtime_pbx_load_all(const char *table)
+{
+	return pbx_load_realtime_multientry(table, "name LIKE", "%", NULL);
+}
+
+static const sccp_realtime_driver_t sccp_realtime_pbx_driver = {
+	.load = sccp_realtime_pbx_load,
+	.load_all = sccp_realtime_pbx_load_all,
+};
+
+static struct {
+	const sccp_realtime_driver_t *driver;
+	struct sccp_realtime_bucket buckets[SCCP_REALTIME_BUCKETS];
+	sccp_realtime_entry_t *lru_head;									/*!< most recently used entry */
+	sccp_realtime_entry_t *lru_tail;									/*!< least recently used entry, evicted first */
+	pbx_cond_t loaded;
+	boolean_t running;
+	int users;												/*!< lookups / prefetches using the cache, module_stop waits for them */
+	sccp_realtime_stats_t stats;
+} sccp_realtime_cache = {
+	.driver = &sccp_realtime_pbx_driver,
+};
+
+AST_MUTEX_DEFINE_STATIC(sccp_realtime_lock);
+
+static struct sccp_realtime_bucket *sccp_realtime_bucket(const char *name)
+{
+	return &sccp_realtime_cache.buckets[sccp_str_case_hash(name) % SCCP_REALTIME_BUCKETS];
+}
+
+/* call with sccp_realtime_lock held */
+static void sccp_realtime_lru_unlink(sccp_realtime_entry_t * entry)
+{
+	if (entry->lru_prev) {
+		entry->lru_prev->lru_next = entry->lru_next;
+	} else {
+		sccp_realtime_cache.lru_head = entry->lru_next;
+	}
+	if (entry->lru_next) {
+		entry->lru_next->lru_prev = entry->lru_prev;
+	} else {
+		sccp_realtime_cache.lru_tail = entry->lru_prev;
+	}
+	entry->lru_prev = entry->lru_next = NULL;
+}
+
+/* call with sccp_realtime_lock held, the entry must not be linked */
+static void sccp_realtime_lru_push(sccp_realtime_entry_t * entry)
+{
+	entry->lru_next = sccp_realtime_cache.lru_head;
+	if (sccp_realtime_cache.lru_head) {
+		sccp_realtime_cache.lru_head->lru_prev = entry;
+	} else {
+		sccp_realtime_cache.lru_tail = entry;
+	}
+	sccp_realtime_cache.lru_head = entry;
+}
+
+/* call with sccp_realtime_lock held */
+static void sccp_realtime_touch(sccp_realtime_entry_t * entry)
+{
+	if (entry != sccp_realtime_cache.lru_head) {
+		sccp_realtime_lru_unlink(entry);
+		sccp_realtime_lru_push(entry);
+	}
+}
+
+/* call with sccp_realtime_lock held */
+static sccp_realtime_entry_t *sccp_realtime_find(const char *table, const char *name)
+{
+	sccp_realtime_entry_t *entry = NULL;
+
+	SCCP_LIST_TRAVERSE(sccp_realtime_bucket(name), entry, list) {
+		if (sccp_strcaseequals(entry->name, name) && sccp_strequals(entry->table, table)) {
+			break;
+		}
+	}
+	return entry;
+}
+
+/* call with sccp_realtime_lock held */
+static void sccp_realtime_remove(sccp_realtime_entry_t * entry)
+{
+	SCCP_LIST_REMOVE(sccp_realtime_bucket(entry->name), entry, list);
+	sccp_realtime_lru_unlink(entry);
+	sccp_realtime_cache.stats.entries--;
+	if (!entry->variables && entry->expires) {
+		sccp_realtime_cache.stats.negative--;
+	}
+	pbx_variables_destroy(entry->variables);
+	sccp_free(entry);
+}
+
+/* call with sccp_realtime_lock held, takes ownership of variables */
+static void sccp_realtime_store(sccp_realtime_entry_t * entry, PBX_VARIABLE_TYPE * variables, time_t now)
+{
+	if (entry->variables) {
+		pbx_variables_destroy(entry->variables);
+	} else if (entry->expires) {
+		sccp_realtime_cache.stats.negative--;
+	}
+	entry->variables = variables;
+	if (variables) {
+		entry->expires = now + GLOB(realtime_cache_ttl);
+	} else {
+		entry->expires = now + GLOB(realtime_cache_negative_ttl);
+		sccp_realtime_cache.stats.negative++;
+	}
+}
+
+/* call with sccp_realtime_lock held, makes room for one more entry by dropping the least recently used ones */
+static void sccp_realtime_evict(void)
+{
+	sccp_realtime_entry_t *entry = NULL;
+	sccp_realtime_entry_t *prev = NULL;
+
+	for (entry = sccp_realtime_cache.lru_tail; GLOB(realtime_cache_size) && entry && sccp_realtime_cache.stats.entries >= GLOB(realtime_cache_size); entry = prev) {
+		prev = entry->lru_prev;
+		if (!entry->loading) {										/* the query in flight still owns it */
+			sccp_realtime_remove(entry);
+			sccp_realtime_cache.stats.evicted++;
+		}
+	}
+}
+
+/* call with sccp_realtime_lock held */
+static sccp_realtime_entry_t *sccp_realtime_add(const char *table, const char *name)
+{
+	sccp_realtime_entry_t *entry = NULL;
+
+	sccp_realtime_evict();
+	if (!(entry = sccp_calloc(1, sizeof *entry))) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return NULL;
+	}
+	sccp_copy_string(entry->table, table, sizeof(entry->table));
+	sccp_copy_string(entry->name, name, sizeof(entry->name));
+	SCCP_LIST_INSERT_HEAD(sccp_realtime_bucket(name), entry, list);
+	sccp_realtime_lru_push(entry);
+	sccp_realtime_cache.stats.entries++;
+	return entry;
+}
+
+/* call with sccp_realtime_lock held, after a lookup / prefetch is done with the cache */
+static void sccp_realtime_release(void)
+{
+	if (--sccp_realtime_cache.users == 0 && !sccp_realtime_cache.running) {
+		pbx_cond_broadcast(&sccp_realtime_cache.loaded);
+	}
+}
+
+/*!
+ * \brief Load a realtime row by name, using the cache
+ * \param table Realtime Table (GLOB(realtimedevicetable) / GLOB(realtimelinetable))
+ * \param name Device or Line Name
+ * \return copy of the row, which the caller has to free using pbx_variables_destroy, NULL if there is no such row
+ */
+PBX_VARIABLE_TYPE *sccp_realtime_load(const char *table, const char *name)
+{
+	sccp_realtime_entry_t *entry = NULL;
+	PBX_VARIABLE_TYPE *variables = NULL;
+	boolean_t waited = FALSE;
+	time_t now;
+
+	if (sccp_strlen_zero(table) || sccp_strlen_zero(name)) {
+		return NULL;
+	}
+	pbx_mutex_lock(&sccp_realtime_lock);
+	if (!sccp_realtime_cache.running || (!GLOB(realtime_cache_ttl) && !GLOB(realtime_cache_negative_ttl))) {
+		sccp_realtime_cache.stats.queries++;
+		pbx_mutex_unlock(&sccp_realtime_lock);
+		return sccp_realtime_cache.driver->load(table, name);
+	}
+	sccp_realtime_cache.users++;
+	while ((entry = sccp_realtime_find(table, name)) && entry->loading) {
+		if (!waited) {
+			sccp_realtime_cache.stats.coalesced++;
+			waited = TRUE;
+		}
+		pbx_cond_wait(&sccp_realtime_cache.loaded, &sccp_realtime_lock);
+	}
+	now = time(NULL);
+	if (entry && entry->expires > now) {
+		if (entry->variables) {
+			sccp_realtime_cache.stats.hits++;
+			variables = pbx_variables_dup(entry->variables);
+		} else {
+			sccp_realtime_cache.stats.negative_hits++;
+		}
+		sccp_realtime_touch(entry);
+		sccp_realtime_release();
+		pbx_mutex_unlock(&sccp_realtime_lock);
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_4 "SCCP: (sccp_realtime_load) %s '%s' served from cache (%s)\n", table, name, variables ? "found" : "not found");
+		return variables;
+	}
+	sccp_realtime_cache.stats.misses++;
+	sccp_realtime_cache.stats.queries++;
+	if (!entry) {
+		entry = sccp_realtime_add(table, name);
+	}
+	if (entry) {
+		entry->loading = TRUE;
+		entry->stale = FALSE;
+		sccp_realtime_touch(entry);
+	}
+	pbx_mutex_unlock(&sccp_realtime_lock);
+
+	variables = sccp_realtime_cache.driver->load(table, name);
+
+	pbx_mutex_lock(&sccp_realtime_lock);
+	if (entry) {
+		entry->loading = FALSE;
+		if (entry->stale || !(variables ? GLOB(realtime_cache_ttl) : GLOB(realtime_cache_negative_ttl))) {
+			sccp_realtime_remove(entry);
+		} else {
+			sccp_realtime_store(entry, variables ? pbx_variables_dup(variables) : NULL, time(NULL));
+		}
+		pbx_cond_broadcast(&sccp_realtime_cache.loaded);
+	}
+	sccp_realtime_release();
+	pbx_mutex_unlock(&sccp_realtime_lock);
+	return variables;
+}
+
+/*!
+ * \brief Load all rows of a realtime table in one query and cache them
+ * \param table Realtime Table
+ * \return number of rows cached
+ */
+int sccp_realtime_prefetch(const char *table)
+{
+	struct ast_config *cfg = NULL;
+	char *cat = NULL;
+	const char *name = NULL;
+	sccp_realtime_entry_t *entry = NULL;
+	int count = 0;
+	time_t now = time(NULL);
+
+	if (sccp_strlen_zero(table) || !GLOB(realtime_cache_ttl)) {
+		return 0;
+	}
+	pbx_mutex_lock(&sccp_realtime_lock);
+	if (!sccp_realtime_cache.running) {
+		pbx_mutex_unlock(&sccp_realtime_lock);
+		return 0;
+	}
+	sccp_realtime_cache.users++;
+	sccp_realtime_cache.stats.queries++;
+	pbx_mutex_unlock(&sccp_realtime_lock);
+	cfg = sccp_realtime_cache.driver->load_all(table);
+	pbx_mutex_lock(&sccp_realtime_lock);
+	if (!cfg) {
+		sccp_realtime_release();
+		pbx_mutex_unlock(&sccp_realtime_lock);
+		sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (sccp_realtime_prefetch) nothing loaded from realtime table '%s'\n", table);
+		return 0;
+	}
+	while ((cat = pbx_category_browse(cfg, cat))) {
+		PBX_VARIABLE_TYPE *v = ast_variable_browse(cfg, cat);
+
+		for (name = NULL; v; v = v->next) {
+			if (!strcasecmp(v->name, "name")) {
+				name = v->value;
+				break;
+			}
+		}
+		if (sccp_strlen_zero(name)) {
+			continue;
+		}
+		if (!(entry = sccp_realtime_find(table, name)) && !(entry = sccp_realtime_add(table, name))) {
+			break;
+		}
+		if (!entry->loading) {										/* a query in flight delivers its own result */
+			sccp_realtime_store(entry, pbx_variables_dup(ast_variable_browse(cfg, cat)), now);
+			sccp_realtime_touch(entry);
+			count++;
+		}
+	}
+	sccp_realtime_cache.stats.prefetched += count;
+	sccp_realtime_release();
+	pbx_mutex_unlock(&sccp_realtime_lock);
+	pbx_config_destroy(cfg);
+
+	sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (sccp_realtime_prefetch) cached %d rows from realtime table '%s'\n", count, table);
+	return count;
+}
+
+/*!
+ * \brief Drop cached realtime rows
+ * \param table Realtime Table, NULL for all tables
+ * \param name Device or Line Name, NULL for all names
+ * \return number of entries dropped
+ */
+int sccp_realtime_invalidate(const char *table, const char *name)
+{
+	sccp_realtime_entry_t *entry = NULL;
+	int count = 0;
+	uint16_t bucket = 0;
+
+	pbx_mutex_lock(&sccp_realtime_lock);
+	for (bucket = 0; bucket < SCCP_REALTIME_BUCKETS; bucket++) {
+		SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_realtime_cache.buckets[bucket], entry, list) {
+			if ((!sccp_strlen_zero(table) && !sccp_strequals(entry->table, table)) || (!sccp_strlen_zero(name) && !sccp_strcaseequals(entry->name, name))) {
+				continue;
+			}
+			if (entry->loading) {
+				entry->stale = TRUE;
+			} else {
+				sccp_realtime_remove(entry);
+			}
+			count++;
+		}
+		SCCP_LIST_TRAVERSE_SAFE_END;
+	}
+	pbx_mutex_unlock(&sccp_realtime_lock);
+
+	sccp_log((DEBUGCAT_REALTIME)) (VERBOSE_PREFIX_3 "SCCP: (sccp_realtime_invalidate) dropped %d entries (table: %s, name: %s)\n", count, S_OR(table, "*"), S_OR(name, "*"));
+	return count;
+}
+
+void sccp_realtime_getStats(sccp_realtime_stats_t * stats)
+{
+	pbx_mutex_lock(&sccp_realtime_lock);
+	*stats = sccp_realtime_cache.stats;
+	pbx_mutex_unlock(&sccp_realtime_lock);
+}
+
+void sccp_realtime_module_start(void)
+{
+	uint16_t bucket = 0;
+
+	for (bucket = 0; bucket < SCCP_REALTIME_BUCKETS; bucket++) {
+		SCCP_LIST_HEAD_INIT(&sccp_realtime_cache.buckets[bucket]);
+	}
+	pbx_cond_init(&sccp_realtime_cache.loaded, NULL);
+	memset(&sccp_realtime_cache.stats, 0, sizeof(sccp_realtime_cache.stats));
+	sccp_realtime_cache.running = TRUE;
+}
+
+void sccp_realtime_module_stop(void)
+{
+	uint16_t bucket = 0;
+
+	pbx_mutex_lock(&sccp_realtime_lock);
+	sccp_realtime_cache.running = FALSE;
+	while (sccp_realtime_cache.users > 0) {									/* lookups in flight still use their entries, the buckets and the condition */
+		pbx_cond_wait(&sccp_realtime_cache.loaded, &sccp_realtime_lock);
+	}
+	pbx_mutex_unlock(&sccp_realtime_lock);
+	sccp_realtime_invalidate(NULL, NULL);
+	for (bucket = 0; bucket < SCCP_REALTIME_BUCKETS; bucket++) {
+		SCCP_LIST_HEAD_DESTROY(&sccp_realtime_cache.buckets[bucket]);
+	}
+	pbx_cond_destroy(&sccp_realtime_cache.loaded);
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+
+/* stand-in realtime driver: knows every name starting with "SEPKNOWN", counts queries and takes a while to answer */
+static int sccp_realtime_test_queries = 0;
+
+static void sccp_realtime_test_count(void)
+{
+	pbx_mutex_lock(&sccp_realtime_lock);
+	sccp_realtime_test_queries++;
+	pbx_mutex_unlock(&sccp_realtime_lock);
+}
+
+static PBX_VARIABLE_TYPE *sccp_realtime_test_load(const char *table, const char *name)
+{
+	PBX_VARIABLE_TYPE *v = NULL;
+
+	sccp_realtime_test_count();
+	usleep(20000);
+	if (!strncasecmp(name, "SEPKNOWN", 8)) {
+		v = pbx_variable_new("name", name, "");
+		v->next = pbx_variable_new("devicetype", "7960", "");
+	}
+	return v;
+}
+
+static struct ast_config *sccp_realtime_test_load_all(const char *table)
+{
+	struct ast_config *cfg = ast_config_new();
+	struct ast_category *cat = NULL;
+	char name[StationMaxNameSize];
+	int row = 0;
+
+	sccp_realtime_test_count();
+	for (row = 0; cfg && row < 10; row++) {
+		snprintf(name, sizeof(name), "SEPKNOWN%04d", row);
+		if ((cat = ast_category_new(name, "", -1))) {
+			ast_variable_append(cat, pbx_variable_new("name", name, ""));
+			ast_variable_append(cat, pbx_variable_new("devicetype", "7960", ""));
+			ast_category_append(cfg, cat);
+		}
+	}
+	return cfg;
+}
+
+static const sccp_realtime_driver_t sccp_realtime_test_driver = {
+	.load = sccp_realtime_test_load,
+	.load_all = sccp_realtime_test_load_all,
+};
+
+static void *sccp_realtime_test_lookup(void *data)
+{
+	pbx_variables_destroy(sccp_realtime_load("sccpdevice_test", (const char *) data));
+	return NULL;
+}
+
+AST_TEST_DEFINE(sccp_realtime_cache_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "cache";
+			info->category = "/channels/chan_sccp/realtime/";
+			info->summary = "chan-sccp-b realtime cache test";
+			info->description = "positive / negative entries, coalescing, prefetch, invalidation and the size limit against a stand-in realtime driver";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const char *table = "sccpdevice_test";
+	const sccp_realtime_driver_t *driver = sccp_realtime_cache.driver;
+	uint16_t ttl = GLOB(realtime_cache_ttl);
+	uint16_t negative_ttl = GLOB(realtime_cache_negative_ttl);
+	uint16_t size = GLOB(realtime_cache_size);
+	sccp_realtime_stats_t stats;
+	char name[StationMaxNameSize];
+	PBX_VARIABLE_TYPE *v = NULL;
+	pthread_t threads[8];
+	uint8_t thread = 0;
+	uint8_t row = 0;
+	enum ast_test_result_state res = AST_TEST_PASS;
+
+	if (!sccp_realtime_cache.running) {
+		return AST_TEST_NOT_RUN;
+	}
+	sccp_realtime_invalidate(table, NULL);
+	sccp_realtime_cache.driver = &sccp_realtime_test_driver;
+	GLOB(realtime_cache_ttl) = 60;
+	GLOB(realtime_cache_negative_ttl) = 60;
+	GLOB(realtime_cache_size) = 0;
+	sccp_realtime_test_queries = 0;
+
+	do {
+		pbx_test_status_update(test, "positive entry...\n");
+		v = sccp_realtime_load(table, "SEPKNOWN0001");
+		if (!v || !v->next || !sccp_strequals(v->next->value, "7960")) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+		pbx_variables_destroy(v);
+		pbx_variables_destroy(sccp_realtime_load(table, "sepknown0001"));
+		if (sccp_realtime_test_queries != 1) {
+			pbx_test_status_update(test, "expected 1 query, got %d\n", sccp_realtime_test_queries);
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		pbx_test_status_update(test, "negative entry...\n");
+		if (sccp_realtime_load(table, "SEPUNKNOWN") || sccp_realtime_load(table, "SEPUNKNOWN") || sccp_realtime_test_queries != 2) {
+			pbx_test_status_update(test, "expected 2 queries, got %d\n", sccp_realtime_test_queries);
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		pbx_test_status_update(test, "coalescing...\n");
+		for (thread = 0; thread < ARRAY_LEN(threads); thread++) {
+			pthread_create(&threads[thread], NULL, sccp_realtime_test_lookup, "SEPKNOWN0002");
+		}
+		for (thread = 0; thread < ARRAY_LEN(threads); thread++) {
+			pthread_join(threads[thread], NULL);
+		}
+		if (sccp_realtime_test_queries != 3) {
+			pbx_test_status_update(test, "expected 3 queries, got %d\n", sccp_realtime_test_queries);
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		pbx_test_status_update(test, "invalidation...\n");
+		if (sccp_realtime_invalidate(table, "SEPUNKNOWN") != 1 || sccp_realtime_load(table, "SEPUNKNOWN") || sccp_realtime_test_queries != 4) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+		sccp_realtime_invalidate(table, NULL);
+
+		pbx_test_status_update(test, "prefetch...\n");
+		if (sccp_realtime_prefetch(table) != 10 || sccp_realtime_test_queries != 5) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+		pbx_variables_destroy(sccp_realtime_load(table, "SEPKNOWN0009"));
+		if (sccp_realtime_test_queries != 5) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		pbx_test_status_update(test, "negative ttl disabled...\n");
+		GLOB(realtime_cache_negative_ttl) = 0;
+		sccp_realtime_load(table, "SEPOTHER");
+		sccp_realtime_load(table, "SEPOTHER");
+		if (sccp_realtime_test_queries != 7) {
+			res = AST_TEST_FAIL;
+			break;
+		}
+
+		pbx_test_status_update(test, "size limit...\n");
+		sccp_realtime_invalidate(table, NULL);
+		GLOB(realtime_cache_size) = 4;
+		for (row = 0; row < 6; row++) {
+			snprintf(name, sizeof(name), "SEPKNOWN%04d", row);
+			pbx_variables_destroy(sccp_realtime_load(table, name));
+		}
+		pbx_variables_destroy(sccp_realtime_load(table, "SEPKNOWN0005"));				/* most recent, still cached */
+		pbx_variables_destroy(sccp_realtime_load(table, "SEPKNOWN0000"));				/* least recent, evicted */
+		if (sccp_realtime_test_queries != 14) {
+			pbx_test_status_update(test, "expected 14 queries, got %d\n", sccp_realtime_test_queries);
+			res = AST_TEST_FAIL;
+			break;
+		}
+		sccp_realtime_getStats(&stats);
+		if (stats.entries > GLOB(realtime_cache_size)) {
+			pbx_test_status_update(test, "expected at most %d entries, got %d\n", GLOB(realtime_cache_size), stats.entries);
+			res = AST_TEST_FAIL;
+			break;
+		}
+	} while (0);
+
+	sccp_realtime_invalidate(table, NULL);
+	sccp_realtime_cache.driver = driver;
+	GLOB(realtime_cache_ttl) = ttl;
+	GLOB(realtime_cache_negative_ttl) = negative_ttl;
+	GLOB(realtime_cache_size) = size;
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_realtime_cache_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_realtime_cache_tests);
+}
+#endif
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
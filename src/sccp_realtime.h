@@ -0,0 +1,43 @@
+/*!
+ * \file        sccp_realtime.h
+ * \brief       SCCP Realtime Lookup Cache Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+#ifdef CS_SCCP_REALTIME
+/*!
+ * \brief Realtime Driver, the functions used to query the realtime backend (replaceable for testing)
+ */
+typedef struct sccp_realtime_driver {
+	PBX_VARIABLE_TYPE *(*const load) (const char *table, const char *name);					/*!< load a single row by name, returns NULL when not found */
+	struct ast_config *(*const load_all) (const char *table);						/*!< load all rows of a table */
+} sccp_realtime_driver_t;
+
+/*!
+ * \brief Realtime Cache Statistics
+ */
+typedef struct sccp_realtime_stats {
+	uint32_t entries;
+	uint32_t negative;
+	uint32_t hits;
+	uint32_t negative_hits;
+	uint32_t misses;
+	uint32_t coalesced;
+	uint32_t queries;
+	uint32_t prefetched;
+	uint32_t evicted;
+} sccp_realtime_stats_t;
+
+SCCP_API void SCCP_CALL sccp_realtime_module_start(void);
+SCCP_API void SCCP_CALL sccp_realtime_module_stop(void);
+SCCP_API PBX_VARIABLE_TYPE * SCCP_CALL sccp_realtime_load(const char *table, const char *name);
+SCCP_API int SCCP_CALL sccp_realtime_prefetch(const char *table);
+SCCP_API int SCCP_CALL sccp_realtime_invalidate(const char *table, const char *name);
+SCCP_API void SCCP_CALL sccp_realtime_getStats(sccp_realtime_stats_t * stats);
+#endif
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
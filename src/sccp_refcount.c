@@ -463,6 +463,40 @@ void sccp_refcount_gen_report(const void * const ptr, pbx_str_t **buf)
 }
 #endif
 
+/*!
+ * \brief Count the objects in the hash table per type (metrics)
+ * \param counts Array indexed by enum sccp_refcounted_types, zeroed first
+ * \param size Number of elements in counts
+ * \return number of types (valid indexes are 1 .. return - 1)
+ */
+int sccp_refcount_countObjects(uint32_t * counts, int size)
+{
+	RefCountedObject *obj = NULL;
+	int types = (int) ARRAY_LEN(obj_info) < size ? (int) ARRAY_LEN(obj_info) : size;
+	int bucket = 0;
+
+	memset(counts, 0, size * sizeof(uint32_t));
+	ast_rwlock_rdlock(&objectslock);
+	for (bucket = 0; bucket < SCCP_HASH_PRIME; bucket++) {
+		if (objects[bucket]) {
+			SCCP_RWLIST_RDLOCK(&(objects[bucket]->refCountedObjects));
+			SCCP_RWLIST_TRAVERSE(&(objects[bucket]->refCountedObjects), obj, list) {
+				if ((int) obj->type < types) {
+					counts[obj->type]++;
+				}
+			}
+			SCCP_RWLIST_UNLOCK(&(objects[bucket]->refCountedObjects));
+		}
+	}
+	ast_rwlock_unlock(&objectslock);
+	return types;
+}
+
+const char *sccp_refcount_type2str(enum sccp_refcounted_types type)
+{
+	return (int) type < (int) ARRAY_LEN(obj_info) ? obj_info[type].datatype : "";
+}
+
 int sccp_show_refcount(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[])
 {
 	int local_line_total = 0;
@@ -42,6 +42,8 @@ SCCP_API void SCCP_CALL sccp_refcount_updateIdentifier(const void * const ptr, c
 SCCP_API void * SCCP_CALL  const sccp_refcount_retain(const void * const ptr, const char *filename, int lineno, const char *func);
 SCCP_API void * SCCP_CALL  const sccp_refcount_release(const void * * const ptr, const char *filename, int lineno, const char *func);
 SCCP_API void SCCP_CALL sccp_refcount_replace(const void * * const replaceptr, const void *const newptr, const char *filename, int lineno, const char *func);
+SCCP_API int SCCP_CALL sccp_refcount_countObjects(uint32_t * counts, int size);
+SCCP_API const char * SCCP_CALL sccp_refcount_type2str(enum sccp_refcounted_types type);
 SCCP_API int SCCP_CALL sccp_show_refcount(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 SCCP_API void SCCP_CALL sccp_refcount_autorelease(void *ptr);
 #if CS_REFCOUNT_DEBUG
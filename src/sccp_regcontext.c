@@ -0,0 +1,422 @@
+/*!
+ * \file        sccp_regcontext.c
+ * \brief       SCCP Registration Context (regcontext) Manager
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Keeps the extensions of the registered lines in the regcontext (used for DUNDi lookups) in sync with the lines:
+ * - every line with at least one attached device registers regexten (or its name) in each regcontext, or in the context given as ext@context
+ * - attaching / detaching devices only requests a synchronization, requests are coalesced for SCCP_REGCONTEXT_SYNC_DELAY ms
+ * - a synchronization computes the desired set of extensions, diffs it against the registered set and applies the difference
+ *   in one pass, holding the contexts lock once and each context lock once
+ * - reload runs a synchronization directly and adds the result to the reload report ('sccp show reload')
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_regcontext.h"
+#include "sccp_line.h"
+#include "sccp_utils.h"
+#include "sccp_vector.h"
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_REGCONTEXT_SYNC_DELAY 250
+#define SCCP_REGCONTEXT_REGISTRAR "SCCP"
+
+typedef struct sccp_regcontext_entry {
+	char context[SCCP_MAX_CONTEXT];
+	char exten[SCCP_MAX_EXTENSION];
+	char line[StationMaxNameSize];
+	boolean_t create;											/*!< context comes from regcontext and may be created, ext@context has to exist */
+} sccp_regcontext_entry_t;
+
+SCCP_VECTOR(sccp_regcontext_entries, sccp_regcontext_entry_t);
+
+static struct {
+	sccp_mutex_t lock;											/* serializes synchronizations, protects registered */
+	struct sccp_regcontext_entries registered;								/* sorted on context, exten, line */
+	int schedId;
+	boolean_t running;
+} sccp_regcontext;
+AST_MUTEX_DEFINE_STATIC(sccp_regcontext_schedLock);
+
+static int sccp_regcontext_cmp(const void *a, const void *b)
+{
+	const sccp_regcontext_entry_t *entryA = (const sccp_regcontext_entry_t *) a;
+	const sccp_regcontext_entry_t *entryB = (const sccp_regcontext_entry_t *) b;
+	int res = 0;
+
+	if (!(res = strcmp(entryA->context, entryB->context)) && !(res = strcmp(entryA->exten, entryB->exten))) {
+		res = strcmp(entryA->line, entryB->line);
+	}
+	return res;
+}
+
+static void sccp_regcontext_addEntry(struct sccp_regcontext_entries *entries, const char *context, const char *exten, const char *line, boolean_t create)
+{
+	sccp_regcontext_entry_t entry = {.create = create };
+
+	if (sccp_strlen_zero(context) || sccp_strlen_zero(exten)) {
+		return;
+	}
+	sccp_copy_string(entry.context, context, sizeof(entry.context));
+	sccp_copy_string(entry.exten, exten, sizeof(entry.exten));
+	sccp_copy_string(entry.line, line, sizeof(entry.line));
+	if (SCCP_VECTOR_APPEND(entries, entry)) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+	}
+}
+
+/*!
+ * \brief Sort entries and drop duplicate context/exten pairs (the first line, in sort order, wins)
+ */
+static void sccp_regcontext_sortUnique(struct sccp_regcontext_entries *entries)
+{
+	size_t idx = 0, out = 0;
+
+	if (SCCP_VECTOR_SIZE(entries) < 2) {
+		return;
+	}
+	qsort(entries->elems, SCCP_VECTOR_SIZE(entries), sizeof(sccp_regcontext_entry_t), sccp_regcontext_cmp);
+	for (idx = 1; idx < SCCP_VECTOR_SIZE(entries); idx++) {
+		sccp_regcontext_entry_t *prev = SCCP_VECTOR_GET_ADDR(entries, out);
+		sccp_regcontext_entry_t *cur = SCCP_VECTOR_GET_ADDR(entries, idx);
+
+		if (strcmp(prev->context, cur->context) || strcmp(prev->exten, cur->exten)) {
+			*SCCP_VECTOR_GET_ADDR(entries, ++out) = *cur;
+		}
+	}
+	entries->current = out + 1;
+}
+
+/*!
+ * \brief Collect the extensions that should be registered, from all lines that have at least one device attached
+ */
+static void sccp_regcontext_collect(struct sccp_regcontext_entries *desired)
+{
+	sccp_line_t *line = NULL;
+	boolean_t attached = FALSE;
+	char regcontexts[SCCP_MAX_CONTEXT];
+	char multi[256];
+	char *stringp = NULL, *ext = NULL, *context = NULL, *contexts = NULL, *regcontext = NULL;
+
+	if (sccp_strlen_zero(GLOB(regcontext))) {
+		return;
+	}
+	SCCP_RWLIST_RDLOCK(&GLOB(lines));
+	SCCP_RWLIST_TRAVERSE(&GLOB(lines), line, list) {
+		AUTO_RELEASE(sccp_line_t, l , sccp_line_retain(line));
+
+		if (!l) {
+			continue;
+		}
+		SCCP_LIST_LOCK(&l->devices);
+		if ((attached = SCCP_LIST_GETSIZE(&l->devices) > 0)) {
+			sccp_copy_string(multi, S_OR(l->regexten, l->name), sizeof(multi));
+		}
+		SCCP_LIST_UNLOCK(&l->devices);
+		if (!attached) {
+			continue;
+		}
+		stringp = multi;
+		while ((ext = strsep(&stringp, "&"))) {
+			if ((context = strchr(ext, '@'))) {
+				*context++ = '\0';								/* split ext@context */
+				sccp_regcontext_addEntry(desired, context, ext, l->name, FALSE);
+				continue;
+			}
+			sccp_copy_string(regcontexts, GLOB(regcontext), sizeof(regcontexts));
+			contexts = regcontexts;
+			while ((regcontext = strsep(&contexts, "&"))) {
+				sccp_regcontext_addEntry(desired, regcontext, ext, l->name, TRUE);
+			}
+		}
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(lines));
+	sccp_regcontext_sortUnique(desired);
+}
+
+/*!
+ * \brief Diff two sorted entry sets
+ */
+static void sccp_regcontext_diff(struct sccp_regcontext_entries *registered, struct sccp_regcontext_entries *desired, struct sccp_regcontext_entries *adds, struct sccp_regcontext_entries *removes, struct sccp_regcontext_entries *kept)
+{
+	size_t r = 0, d = 0;
+	int cmp = 0;
+
+	while (r < SCCP_VECTOR_SIZE(registered) || d < SCCP_VECTOR_SIZE(desired)) {
+		if (r == SCCP_VECTOR_SIZE(registered)) {
+			cmp = 1;
+		} else if (d == SCCP_VECTOR_SIZE(desired)) {
+			cmp = -1;
+		} else {
+			cmp = sccp_regcontext_cmp(SCCP_VECTOR_GET_ADDR(registered, r), SCCP_VECTOR_GET_ADDR(desired, d));
+		}
+		if (cmp < 0) {
+			SCCP_VECTOR_APPEND(removes, *SCCP_VECTOR_GET_ADDR(registered, r));
+			r++;
+		} else if (cmp > 0) {
+			SCCP_VECTOR_APPEND(adds, *SCCP_VECTOR_GET_ADDR(desired, d));
+			d++;
+		} else {
+			SCCP_VECTOR_APPEND(kept, *SCCP_VECTOR_GET_ADDR(registered, r));
+			r++;
+			d++;
+		}
+	}
+}
+
+/*!
+ * \brief Apply removes and adds (both sorted on context), grouped per context
+ *
+ * The contexts lock is taken once, for resolving (looking up / creating) the contexts and applying the changes, so that a dialplan reload cannot
+ * free a resolved context in between. Every context is write locked once for all its changes (the contexts lock is recursive).
+ * Successfully added entries, and entries that already existed, are appended to kept.
+ */
+static void sccp_regcontext_apply(struct sccp_regcontext_entries *adds, struct sccp_regcontext_entries *removes, struct sccp_regcontext_entries *kept, sccp_regcontext_summary_t * summary)
+{
+	struct sccp_regcontext_context {
+		const char *name;
+		struct pbx_context *con;
+	};
+	SCCP_VECTOR(, struct sccp_regcontext_context) contexts;
+	size_t a = 0, r = 0, c = 0;
+
+	if (SCCP_VECTOR_INIT(&contexts, 8)) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		return;
+	}
+	pbx_wrlock_contexts();
+	/* resolve the contexts, in sorted order */
+	while (a < SCCP_VECTOR_SIZE(adds) || r < SCCP_VECTOR_SIZE(removes)) {
+		const sccp_regcontext_entry_t *add = a < SCCP_VECTOR_SIZE(adds) ? SCCP_VECTOR_GET_ADDR(adds, a) : NULL;
+		const sccp_regcontext_entry_t *remove = r < SCCP_VECTOR_SIZE(removes) ? SCCP_VECTOR_GET_ADDR(removes, r) : NULL;
+		struct sccp_regcontext_context context = { NULL, NULL };
+		boolean_t create = FALSE;
+
+		context.name = (add && (!remove || strcmp(add->context, remove->context) <= 0)) ? add->context : remove->context;
+		for (; a < SCCP_VECTOR_SIZE(adds) && sccp_strequals(SCCP_VECTOR_GET_ADDR(adds, a)->context, context.name); a++) {
+			create |= SCCP_VECTOR_GET_ADDR(adds, a)->create;
+		}
+		for (; r < SCCP_VECTOR_SIZE(removes) && sccp_strequals(SCCP_VECTOR_GET_ADDR(removes, r)->context, context.name); r++);
+		if (create) {
+			context.con = pbx_context_find_or_create(NULL, NULL, context.name, SCCP_REGCONTEXT_REGISTRAR);
+		} else {
+			context.con = pbx_context_find(context.name);
+		}
+		if (!context.con && add) {
+			pbx_log(LOG_WARNING, "Context specified in regcontext=%s (sccp.conf) must exist\n", context.name);
+		}
+		SCCP_VECTOR_APPEND(&contexts, context);
+	}
+
+	a = r = 0;
+	for (c = 0; c < SCCP_VECTOR_SIZE(&contexts); c++) {
+		struct sccp_regcontext_context *context = SCCP_VECTOR_GET_ADDR(&contexts, c);
+
+		if (context->con) {
+			pbx_wrlock_context(context->con);
+		}
+		for (; r < SCCP_VECTOR_SIZE(removes) && sccp_strequals(SCCP_VECTOR_GET_ADDR(removes, r)->context, context->name); r++) {
+			const sccp_regcontext_entry_t *entry = SCCP_VECTOR_GET_ADDR(removes, r);
+
+			/* only removes what we registered, the registrar has to match */
+			if (context->con && !pbx_context_remove_extension_callerid2(context->con, entry->exten, 1, NULL, 0, SCCP_REGCONTEXT_REGISTRAR, 1)) {
+				sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Unregistered RegContext: %s, Extension: %s\n", entry->context, entry->exten);
+				summary->removed++;
+			}
+		}
+		for (; a < SCCP_VECTOR_SIZE(adds) && sccp_strequals(SCCP_VECTOR_GET_ADDR(adds, a)->context, context->name); a++) {
+			const sccp_regcontext_entry_t *entry = SCCP_VECTOR_GET_ADDR(adds, a);
+
+			if (!context->con) {
+				summary->failed++;
+				continue;
+			}
+			if (!pbx_add_extension2_nolock(context->con, 0, entry->exten, 1, NULL, NULL, "Noop", pbx_strdup(entry->line), sccp_free_ptr, SCCP_REGCONTEXT_REGISTRAR)) {
+				sccp_log((DEBUGCAT_LINE + DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_1 "Registered RegContext: %s, Extension: %s, Line: %s\n", entry->context, entry->exten, entry->line);
+				summary->added++;
+			} else if (errno != EEXIST) {
+				summary->failed++;
+				continue;
+			}
+			/* an existing extension (from the dialplan or an earlier module instance) is tracked as well, remove only touches our own */
+			SCCP_VECTOR_APPEND(kept, *entry);
+		}
+		if (context->con) {
+			pbx_unlock_context(context->con);
+		}
+	}
+	pbx_unlock_contexts();
+	SCCP_VECTOR_FREE(&contexts);
+}
+
+/*!
+ * \brief Bring the registered regcontext extensions in line with the lines and their attached devices
+ * \param summary optional, receives what was changed
+ */
+void sccp_regcontext_sync(sccp_regcontext_summary_t * summary)
+{
+	sccp_regcontext_summary_t result = { 0 };
+	struct sccp_regcontext_entries desired, adds, removes, kept;
+	struct timeval start = pbx_tvnow();
+
+	if (SCCP_VECTOR_INIT(&desired, 64) || SCCP_VECTOR_INIT(&adds, 64) || SCCP_VECTOR_INIT(&removes, 64) || SCCP_VECTOR_INIT(&kept, 64)) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+		goto EXIT;
+	}
+	sccp_mutex_lock(&sccp_regcontext.lock);
+	if (sccp_regcontext.running) {
+		sccp_regcontext_collect(&desired);
+	}
+	sccp_regcontext_diff(&sccp_regcontext.registered, &desired, &adds, &removes, &kept);
+	if (SCCP_VECTOR_SIZE(&adds) || SCCP_VECTOR_SIZE(&removes)) {
+		sccp_regcontext_apply(&adds, &removes, &kept, &result);
+		sccp_regcontext_sortUnique(&kept);
+		SCCP_VECTOR_FREE(&sccp_regcontext.registered);
+		sccp_regcontext.registered = kept;							/* take over, kept is reinitialized below */
+		memset(&kept, 0, sizeof(kept));
+		sccp_log((DEBUGCAT_CONFIG)) (VERBOSE_PREFIX_2 "SCCP: regcontext synchronized in %d ms: %u added, %u removed, %u failed, %u registered\n", (int) ast_tvdiff_ms(pbx_tvnow(), start), result.added, result.removed, result.failed, (uint32_t) SCCP_VECTOR_SIZE(&sccp_regcontext.registered));
+	}
+	result.registered = SCCP_VECTOR_SIZE(&sccp_regcontext.registered);
+	sccp_mutex_unlock(&sccp_regcontext.lock);
+EXIT:
+	SCCP_VECTOR_FREE(&desired);
+	SCCP_VECTOR_FREE(&adds);
+	SCCP_VECTOR_FREE(&removes);
+	SCCP_VECTOR_FREE(&kept);
+	if (summary) {
+		*summary = result;
+	}
+}
+
+static int sccp_regcontext_syncTask(const void *data)
+{
+	pbx_mutex_lock(&sccp_regcontext_schedLock);
+	sccp_regcontext.schedId = -1;
+	pbx_mutex_unlock(&sccp_regcontext_schedLock);
+
+	if (GLOB(module_running)) {
+		sccp_regcontext_sync(NULL);
+	}
+	return 0;
+}
+
+/*!
+ * \brief Request a regcontext synchronization after a line gained or lost a device
+ * \note requests arriving within SCCP_REGCONTEXT_SYNC_DELAY ms (mass registration after a restart) are handled by a single synchronization
+ */
+void sccp_regcontext_requestSync(void)
+{
+	if (sccp_strlen_zero(GLOB(regcontext)) && SCCP_VECTOR_SIZE(&sccp_regcontext.registered) == 0) {
+		return;
+	}
+	pbx_mutex_lock(&sccp_regcontext_schedLock);
+	if (sccp_regcontext.running && sccp_regcontext.schedId < 0) {
+		if ((sccp_regcontext.schedId = iPbx.sched_add(SCCP_REGCONTEXT_SYNC_DELAY, sccp_regcontext_syncTask, NULL)) < 0) {
+			pbx_log(LOG_ERROR, "SCCP: Unable to schedule regcontext synchronization\n");
+		}
+	}
+	pbx_mutex_unlock(&sccp_regcontext_schedLock);
+}
+
+void sccp_regcontext_module_start(void)
+{
+	sccp_mutex_init(&sccp_regcontext.lock);
+	if (SCCP_VECTOR_INIT(&sccp_regcontext.registered, 64)) {
+		pbx_log(LOG_ERROR, SS_Memory_Allocation_Error, "SCCP");
+	}
+	sccp_regcontext.schedId = -1;
+	sccp_regcontext.running = TRUE;
+}
+
+/*!
+ * \brief Stop the manager and unregister all extensions it registered
+ */
+void sccp_regcontext_module_stop(void)
+{
+	pbx_mutex_lock(&sccp_regcontext_schedLock);
+	sccp_regcontext.running = FALSE;
+	if (sccp_regcontext.schedId > -1) {
+		sccp_regcontext.schedId = SCCP_SCHED_DEL(sccp_regcontext.schedId);
+	}
+	pbx_mutex_unlock(&sccp_regcontext_schedLock);
+
+	sccp_regcontext_sync(NULL);										/* not running: desired set is empty */
+	sccp_mutex_lock(&sccp_regcontext.lock);
+	SCCP_VECTOR_FREE(&sccp_regcontext.registered);
+	sccp_mutex_unlock(&sccp_regcontext.lock);
+	sccp_mutex_destroy(&sccp_regcontext.lock);
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+AST_TEST_DEFINE(sccp_regcontext_diff_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "diff";
+			info->category = "/channels/chan_sccp/regcontext/";
+			info->summary = "chan-sccp-b regcontext diff test";
+			info->description = "verify that the desired regcontext set is deduplicated and diffed correctly against the registered set";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	struct sccp_regcontext_entries registered, desired, adds, removes, kept;
+
+	SCCP_VECTOR_INIT(&registered, 8);
+	SCCP_VECTOR_INIT(&desired, 8);
+	SCCP_VECTOR_INIT(&adds, 8);
+	SCCP_VECTOR_INIT(&removes, 8);
+	SCCP_VECTOR_INIT(&kept, 8);
+
+	sccp_regcontext_addEntry(&registered, "sccp", "100", "100", TRUE);
+	sccp_regcontext_addEntry(&registered, "sccp", "101", "101", TRUE);
+	sccp_regcontext_addEntry(&registered, "sccp", "102", "102", TRUE);
+	sccp_regcontext_sortUnique(&registered);
+
+	sccp_regcontext_addEntry(&desired, "sccp", "103", "103", TRUE);					/* new */
+	sccp_regcontext_addEntry(&desired, "sccp", "100", "100", TRUE);					/* unchanged */
+	sccp_regcontext_addEntry(&desired, "sccp", "102", "98", TRUE);					/* moved to another line */
+	sccp_regcontext_addEntry(&desired, "sccp", "103", "99", TRUE);					/* duplicate exten, line 99 sorts last and loses */
+	sccp_regcontext_addEntry(&desired, "other", "100", "100", FALSE);				/* other context */
+	sccp_regcontext_addEntry(&desired, "", "104", "104", TRUE);					/* ignored */
+	sccp_regcontext_sortUnique(&desired);
+
+	pbx_test_status_update(test, "Deduplicate...\n");
+	pbx_test_validate(test, SCCP_VECTOR_SIZE(&desired) == 4);
+	pbx_test_validate(test, sccp_strequals(SCCP_VECTOR_GET_ADDR(&desired, 0)->context, "other"));
+	pbx_test_validate(test, sccp_strequals(SCCP_VECTOR_GET_ADDR(&desired, 3)->line, "103"));
+
+	pbx_test_status_update(test, "Diff...\n");
+	sccp_regcontext_diff(&registered, &desired, &adds, &removes, &kept);
+	pbx_test_validate(test, SCCP_VECTOR_SIZE(&kept) == 1 && sccp_strequals(SCCP_VECTOR_GET_ADDR(&kept, 0)->exten, "100"));
+	pbx_test_validate(test, SCCP_VECTOR_SIZE(&removes) == 2);
+	pbx_test_validate(test, sccp_strequals(SCCP_VECTOR_GET_ADDR(&removes, 0)->exten, "101") && sccp_strequals(SCCP_VECTOR_GET_ADDR(&removes, 1)->exten, "102"));
+	pbx_test_validate(test, SCCP_VECTOR_SIZE(&adds) == 3);
+	pbx_test_validate(test, sccp_strequals(SCCP_VECTOR_GET_ADDR(&adds, 0)->context, "other"));
+	pbx_test_validate(test, sccp_strequals(SCCP_VECTOR_GET_ADDR(&adds, 1)->line, "98") && sccp_strequals(SCCP_VECTOR_GET_ADDR(&adds, 2)->line, "103"));
+
+	SCCP_VECTOR_FREE(&registered);
+	SCCP_VECTOR_FREE(&desired);
+	SCCP_VECTOR_FREE(&adds);
+	SCCP_VECTOR_FREE(&removes);
+	SCCP_VECTOR_FREE(&kept);
+	return AST_TEST_PASS;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_regcontext_diff_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_regcontext_diff_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,26 @@
+/*!
+ * \file        sccp_regcontext.h
+ * \brief       SCCP Registration Context (regcontext) Manager Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief Result of a regcontext synchronization
+ */
+typedef struct sccp_regcontext_summary {
+	uint32_t added;
+	uint32_t removed;
+	uint32_t registered;											/*!< extensions registered after the synchronization */
+	uint32_t failed;											/*!< extensions that could not be added (context missing) */
+} sccp_regcontext_summary_t;
+
+SCCP_API void SCCP_CALL sccp_regcontext_module_start(void);
+SCCP_API void SCCP_CALL sccp_regcontext_module_stop(void);
+SCCP_API void SCCP_CALL sccp_regcontext_requestSync(void);
+SCCP_API void SCCP_CALL sccp_regcontext_sync(sccp_regcontext_summary_t * summary);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -18,8 +18,12 @@ SCCP_FILE_VERSION(__FILE__, "");
 #include "sccp_cli.h"
 #include "sccp_device.h"
 #include "sccp_netsock.h"
+#include "sccp_pcap.h"
 #include "sccp_utils.h"
 #include <netinet/in.h>
+#if HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
 
 #ifndef CS_USE_POLL_COMPAT
 #include <poll.h>
@@ -80,6 +84,9 @@ struct sccp_session {
 	struct sockaddr_storage ourip;										/*!< Our IP is for rtp use */
 	struct sockaddr_storage ourIPv4;
 	char designator[40];
+	int32_t debug;												/*!< Debug categories of the scoped debug filters matching this session */
+	volatile boolean_t capture;										/*!< Skinny messages of this session are captured (sccp capture) */
+	uint32_t captureSeq[2];											/*!< Synthetic tcp sequence numbers for the capture (device, server) */
 };														/*!< SCCP Session Structure */
 
 boolean_t sccp_session_getOurIP(constSessionPtr session, struct sockaddr_storage * const sockAddrStorage, int family)
@@ -259,6 +266,24 @@ static gcc_inline int session_buffer2msg(sccp_session_t * s, unsigned char *buff
 	return sccp_handle_message(msg, s);
 }
 
+/*!
+ * \brief Hand a skinny message to the packet capture (inbound: device -> server, outbound: server -> device)
+ * \note outbound messages are captured in the write_lock critical section of their first send(), so that the sequence numbers follow the socket order
+ */
+static void sccp_session_capture(sccp_session_t * s, boolean_t inbound, const uint8_t * data, size_t len)
+{
+	sccp_pcap_endpoint_t device = { &s->sin, sccp_netsock_getPort(&s->sin), s->captureSeq[0] };
+	sccp_pcap_endpoint_t server = { &s->ourip, sccp_netsock_getPort(&GLOB(bindaddr)), s->captureSeq[1] };
+
+	if (inbound) {
+		sccp_pcap_capture(&device, &server, data, len);
+		s->captureSeq[0] += len;
+	} else {
+		sccp_pcap_capture(&server, &device, data, len);
+		s->captureSeq[1] += len;
+	}
+}
+
 static gcc_inline int process_buffer(sccp_session_t * s, sccp_msg_t *msg, unsigned char *buffer, size_t *len)
 {
 	int res = 0;
@@ -274,6 +299,9 @@ static gcc_inline int process_buffer(sccp_session_t * s, sccp_msg_t *msg, unsign
 			res = -1;
 			break;
 		}
+		if (s->capture) {
+			sccp_session_capture(s, TRUE, buffer, payload_len);
+		}
 		if (dont_expect(session_buffer2msg(s, buffer, payload_len, msg) != 0)) {
 			res = -2;
 			break;
@@ -443,6 +471,7 @@ static int __sccp_session_addDevice(sessionPtr session, constDevicePtr device)
 			}
 		}
 		sccp_session_unlock(session);
+		sccp_session_updateScope(session);
 	}
 	return res;
 }
@@ -490,6 +519,12 @@ static void destroy_session(sccp_session_t * s, uint8_t cleanupTime)
 		return;
 	}
 
+	/* stop logging in the scope of this session before it is freed */
+	int32_t *scope = sccp_debug_scope_set(NULL);
+	if (scope != &s->debug) {
+		sccp_debug_scope_set(scope);
+	}
+
 	char addrStr[INET6_ADDRSTRLEN];
 	sccp_copy_string(addrStr, sccp_netsock_stringify_addr(&s->sin), sizeof(addrStr));
 	AUTO_RELEASE(sccp_device_t, d , s->device ? sccp_device_retain(s->device) : NULL);
@@ -548,6 +583,7 @@ void sccp_session_device_thread_exit(void *session)
 	}*/
 	sccp_session_unlock(s);
 	s->session_thread = AST_PTHREADT_NULL;
+	sccp_debug_scope_set(NULL);
 	destroy_session(s, SESSION_DEVICE_CLEANUP_TIME);
 }
 
@@ -607,6 +643,7 @@ void *sccp_session_device_thread(void *session)
 	sccp_msg_t msg = { {0,} };
 
 	pthread_cleanup_push(sccp_session_device_thread_exit, session);
+	sccp_debug_scope_set(&s->debug);
 	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
@@ -829,6 +866,7 @@ static void *accept_thread(void *ignore)
 		}
 		memcpy(&s->sin, &incoming, sizeof(s->sin));
 		sccp_session_set_ourip(s);
+		sccp_session_updateScope(s);
 		sccp_session_addToGlobals(s);
 		recalc_wait_time(s);
 		
@@ -1030,19 +1068,29 @@ int sccp_session_send2(constSessionPtr session, sccp_msg_t * msg)
 		msg->header.lel_protocolVer = 0;
 	}
 
-	if (msg && (GLOB(debug) & DEBUGCAT_MESSAGE) != 0) {
+	boolean_t scoped = sccp_debug_scoped ? TRUE : FALSE;
+	int32_t *prev_scope = scoped ? sccp_debug_scope_set(&s->debug) : NULL;				/* messages sent from other threads are logged in the scope of the receiving session */
+	if (msg && sccp_debug_enabled(DEBUGCAT_MESSAGE)) {
 		uint32_t mid = letohl(msg->header.lel_messageId);
 
 		pbx_log(LOG_NOTICE, "%s: Send Message: %s(0x%04X) %d bytes length\n", DEV_ID_LOG(s->device), msgtype2str(mid), mid, msg->header.length);
 		sccp_dump_msg(msg);
 	}
+	if (scoped) {
+		sccp_debug_scope_set(prev_scope);
+	}
 
 	uint backoff = WRITE_BACKOFF;
+	boolean_t captured = FALSE;
 	bytesSent = 0;
 	bufAddr = ((uint8_t *) msg);
 	bufLen = (ssize_t) (letohl(msg->header.length) + 8);
 	do {
 		pbx_mutex_lock(&s->write_lock);									/* prevent two threads writing at the same time. That should happen in a synchronized way */
+		if (s->capture && !captured) {
+			sccp_session_capture(s, FALSE, bufAddr, bufLen);
+			captured = TRUE;
+		}
 		res = send(mysocket, bufAddr + bytesSent, bufLen - bytesSent, 0);
 		pbx_mutex_unlock(&s->write_lock);
 		if (res <= 0) {
@@ -1233,6 +1281,88 @@ gcc_inline sccp_device_t * const sccp_session_getDevice(constSessionPtr session,
 	return device;
 }
 
+/*!
+ * \brief Recalculate the debug categories of the scoped debug filters (ip-address, device, lines) matching this session and
+ * whether its device is being captured
+ */
+void sccp_session_updateScope(constSessionPtr session)
+{
+	sessionPtr s = (sessionPtr)session;										/* discard const */
+	int32_t categories = 0;
+
+	if (!s) {
+		return;
+	}
+	sccp_session_lock(s);
+	AUTO_RELEASE(sccp_device_t, d , s->device ? sccp_device_retain(s->device) : NULL);
+	sccp_session_unlock(s);
+
+	if (sccp_debug_scoped) {
+		categories |= sccp_debug_filter_get(SCCP_DEBUG_SCOPE_IP, sccp_netsock_stringify_addr(&s->sin));
+		if (d) {
+			sccp_buttonconfig_t *config = NULL;
+
+			categories |= sccp_debug_filter_get(SCCP_DEBUG_SCOPE_DEVICE, d->id);
+			SCCP_LIST_LOCK(&d->buttonconfig);
+			SCCP_LIST_TRAVERSE(&d->buttonconfig, config, list) {
+				if (config->type == LINE) {
+					categories |= sccp_debug_filter_get(SCCP_DEBUG_SCOPE_LINE, config->button.line.name);
+				}
+			}
+			SCCP_LIST_UNLOCK(&d->buttonconfig);
+		}
+	}
+	s->debug = categories;
+	s->capture = d ? sccp_pcap_match(d->id) : FALSE;
+}
+
+/*!
+ * \brief Recalculate the scoped debug categories and capture flag of all sessions (after the debug filters / captured devices changed)
+ */
+void sccp_session_refreshScopes(void)
+{
+	sccp_session_t *s = NULL;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(sessions));
+	SCCP_RWLIST_TRAVERSE(&GLOB(sessions), s, list) {
+		sccp_session_updateScope(s);
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(sessions));
+}
+
+/*!
+ * \brief Number of sessions, optionally with the bytes they have queued in the kernel but the phones did not take yet (metrics)
+ */
+int sccp_session_getCount(uint32_t * sendBacklog)
+{
+	sccp_session_t *s = NULL;
+	int count = 0;
+	uint32_t backlog = 0;
+
+	SCCP_RWLIST_RDLOCK(&GLOB(sessions));
+	SCCP_RWLIST_TRAVERSE(&GLOB(sessions), s, list) {
+		count++;
+#if defined(TIOCOUTQ) || defined(FIONWRITE)
+		int queued = 0;
+
+		if (sendBacklog && s->fds[0].fd > 0) {
+#  if defined(TIOCOUTQ)
+			if (ioctl(s->fds[0].fd, TIOCOUTQ, &queued) == 0 && queued > 0) {
+#  else
+			if (ioctl(s->fds[0].fd, FIONWRITE, &queued) == 0 && queued > 0) {
+#  endif
+				backlog += queued;
+			}
+		}
+#endif
+	}
+	SCCP_RWLIST_UNLOCK(&GLOB(sessions));
+	if (sendBacklog) {
+		*sendBacklog = backlog;
+	}
+	return count;
+}
+
 boolean_t sccp_session_isValid(constSessionPtr session)
 {
 	if (session && session->fds[0].fd > 0 && !session->session_stop && !sccp_netsock_is_any_addr(&session->ourip)) {
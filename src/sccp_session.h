@@ -36,6 +36,9 @@ void sccp_session_crossdevice_cleanup(constSessionPtr current_session, sessionPt
 SCCP_API boolean_t SCCP_CALL sccp_session_check_crossdevice(constSessionPtr session, constDevicePtr device);
 SCCP_API sccp_device_t * const SCCP_CALL sccp_session_getDevice(constSessionPtr session, boolean_t required);
 SCCP_API boolean_t SCCP_CALL sccp_session_isValid(constSessionPtr session);
+SCCP_API void SCCP_CALL sccp_session_updateScope(constSessionPtr session);
+SCCP_API void SCCP_CALL sccp_session_refreshScopes(void);
+SCCP_API int SCCP_CALL sccp_session_getCount(uint32_t * sendBacklog);
 SCCP_API int SCCP_CALL sccp_cli_show_sessions(int fd, sccp_cli_totals_t *totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
 
 SCCP_API boolean_t SCCP_CALL sccp_session_bind_and_listen(struct sockaddr_storage *bindaddr);
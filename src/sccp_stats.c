@@ -0,0 +1,931 @@
+/*!
+ * \file        sccp_stats.c
+ * \brief       SCCP Statistics
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ *
+ * Per message type counters and latency histograms, for the inbound handlers (sccp_handle_message) and outbound sends (sccp_dev_send):
+ * - histograms are log-linear (4 linear sub-buckets per power of two microseconds), so percentiles stay within 25%
+ * - every thread records into its own table (found through thread storage), the hot path takes no lock, only uncontended atomic
+ *   counters that keep its table from being reclaimed or freed underneath it
+ * - each histogram has a single writer, readers merge all thread tables (and those of reclaimed ones) under the list lock
+ * - the tables belong to the module: a table that was not written to for SCCP_STATS_IDLE seconds (its thread may have exited) is
+ *   merged into the retired totals and handed to the next thread that needs one, all tables are freed on module stop
+ * - 'sccp show stats messages' / AMI SCCPShowStatsMessages list the merged result, worst total time first
+ *
+ * Call setup spans:
+ * - every channel carries a span, stamped (monotonic clock) at allocation and at the first occurrence of each milestone
+ *   (offhook, first digit, softswitch, call, ring, answer, openreceivechannel, startmediatransmission)
+ * - on hangup (sccp_channel_clean) the span is folded into histograms per device type and per line, and optionally logged
+ * - 'sccp show stats calls' / AMI SCCPShowStatsCalls list them
+ */
+
+#include "config.h"
+#include "common.h"
+#include "sccp_stats.h"
+#include "sccp_utils.h"
+#include <asterisk/threadstorage.h>
+#include <asterisk/cli.h>
+
+SCCP_FILE_VERSION(__FILE__, "");
+
+#define SCCP_STATS_MESSAGE_IDS (SCCP_MESSAGE_HIGH_BOUNDARY + 5)						/* skinny, 3 spcp, unknown */
+#define SCCP_STATS_DIRECTIONS 2
+
+/* ========================================================================================================== Histogram == */
+/* buckets hold (upper of the previous bucket, upper], a power of two is always the upper bound of a bucket */
+static int sccp_histogram_bucket(uint32_t value)
+{
+	int msb = 0;
+	int idx = 0;
+
+	if (value) {
+		value--;
+	}
+	if (value < SCCP_HISTOGRAM_SUBBUCKETS) {
+		return value;
+	}
+	msb = 31 - __builtin_clz(value);									/* >= 2 */
+	idx = (msb - 1) * SCCP_HISTOGRAM_SUBBUCKETS + ((value >> (msb - 2)) & (SCCP_HISTOGRAM_SUBBUCKETS - 1));
+	return idx < SCCP_HISTOGRAM_BUCKETS ? idx : SCCP_HISTOGRAM_BUCKETS - 1;
+}
+
+/* highest value that falls into bucket idx */
+static uint32_t sccp_histogram_upper(int idx)
+{
+	int msb = 0;
+
+	if (idx < SCCP_HISTOGRAM_SUBBUCKETS) {
+		return idx + 1;
+	}
+	msb = idx / SCCP_HISTOGRAM_SUBBUCKETS + 1;
+	return (uint32_t) (SCCP_HISTOGRAM_SUBBUCKETS + idx % SCCP_HISTOGRAM_SUBBUCKETS + 1) << (msb - 2);
+}
+
+void sccp_histogram_add(sccp_histogram_t * histogram, uint32_t value)
+{
+	histogram->buckets[sccp_histogram_bucket(value)]++;
+	histogram->sum += value;
+	if (value > histogram->max) {
+		histogram->max = value;
+	}
+	histogram->count++;
+}
+
+void sccp_histogram_merge(sccp_histogram_t * to, const sccp_histogram_t * from)
+{
+	int idx = 0;
+
+	for (idx = 0; idx < SCCP_HISTOGRAM_BUCKETS; idx++) {
+		to->buckets[idx] += from->buckets[idx];
+	}
+	to->sum += from->sum;
+	if (from->max > to->max) {
+		to->max = from->max;
+	}
+	to->count += from->count;
+}
+
+/*!
+ * \brief Value below which percentile% of the samples fall (upper bound of the bucket, capped at the maximum)
+ */
+uint32_t sccp_histogram_percentile(const sccp_histogram_t * histogram, uint percentile)
+{
+	uint64_t target = 0;
+	uint64_t seen = 0;
+	int idx = 0;
+
+	if (!histogram->count) {
+		return 0;
+	}
+	target = ((uint64_t) histogram->count * percentile + 99) / 100;
+	for (idx = 0; idx < SCCP_HISTOGRAM_BUCKETS; idx++) {
+		seen += histogram->buckets[idx];
+		if (seen >= target && seen) {
+			uint32_t upper = sccp_histogram_upper(idx);
+
+			return upper < histogram->max ? upper : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/*!
+ * \brief Number of samples less than or equal to bound (exact for powers of two, used for cumulative exposition buckets)
+ */
+uint32_t sccp_histogram_below(const sccp_histogram_t * histogram, uint32_t bound)
+{
+	uint32_t count = 0;
+	int idx = 0;
+
+	for (idx = 0; idx < SCCP_HISTOGRAM_BUCKETS && sccp_histogram_upper(idx) <= bound; idx++) {
+		count += histogram->buckets[idx];
+	}
+	return count;
+}
+
+/* ===================================================================================================== Thread Tables == */
+#define SCCP_STATS_IDLE 300											/* seconds without a record before a table is reclaimed */
+
+typedef struct sccp_stats_table sccp_stats_table_t;
+struct sccp_stats_table {
+	SCCP_LIST_ENTRY (sccp_stats_table_t) list;
+	volatile int serial;											/*!< bumped when reclaimed, the owner only writes while it matches */
+	volatile int busy;											/*!< owner is recording */
+	volatile time_t lastUse;										/*!< written by the owner */
+	boolean_t reclaimed;											/*!< protected by the list lock */
+	sccp_histogram_t *messages[SCCP_STATS_DIRECTIONS][SCCP_STATS_MESSAGE_IDS];				/*!< allocated on first use */
+};
+
+typedef struct sccp_stats_table_holder {
+	sccp_stats_table_t *table;
+	int serial;
+	int generation;
+} sccp_stats_table_holder_t;
+
+static struct {
+	SCCP_LIST_HEAD (, sccp_stats_table_t) tables;
+	sccp_stats_table_t retired;										/* merged tables that were reclaimed */
+	struct timeval started;
+	volatile boolean_t active;
+	volatile int inflight;											/* threads currently inside sccp_stats_message */
+	volatile int generation;										/* bumped on stop, invalidates the table pointers held by threads */
+} sccp_stats;
+
+AST_THREADSTORAGE(sccp_stats_threadbuf);									/* freed by the core (ast_free_ptr), the table itself belongs to the module */
+AST_MUTEX_DEFINE_STATIC(sccp_stats_atomic_lock);								/* only used by platforms without atomic operations */
+
+static int sccp_stats_mid2idx(sccp_mid_t mid)
+{
+	if (mid <= SCCP_MESSAGE_HIGH_BOUNDARY) {
+		return mid;
+	}
+	switch (mid) {
+		case SPCPRegisterTokenRequest:
+			return SCCP_MESSAGE_HIGH_BOUNDARY + 1;
+		case SPCPRegisterTokenAck:
+			return SCCP_MESSAGE_HIGH_BOUNDARY + 2;
+		case SPCPRegisterTokenReject:
+			return SCCP_MESSAGE_HIGH_BOUNDARY + 3;
+		default:
+			return SCCP_MESSAGE_HIGH_BOUNDARY + 4;
+	}
+}
+
+static const char *sccp_stats_idx2str(int idx)
+{
+	switch (idx - SCCP_MESSAGE_HIGH_BOUNDARY) {
+		case 1:
+			return msgtype2str(SPCPRegisterTokenRequest);
+		case 2:
+			return msgtype2str(SPCPRegisterTokenAck);
+		case 3:
+			return msgtype2str(SPCPRegisterTokenReject);
+		case 4:
+			return "Unknown";
+		default:
+			return msgtype2str((sccp_mid_t) idx);
+	}
+}
+
+/* call with the tables list lock held */
+static void sccp_stats_mergeTable(sccp_stats_table_t * to, const sccp_stats_table_t * from)
+{
+	int dir = 0;
+	int idx = 0;
+
+	for (dir = 0; dir < SCCP_STATS_DIRECTIONS; dir++) {
+		for (idx = 0; idx < SCCP_STATS_MESSAGE_IDS; idx++) {
+			if (from->messages[dir][idx] && (to->messages[dir][idx] || (to->messages[dir][idx] = sccp_calloc(sizeof(sccp_histogram_t), 1)))) {
+				sccp_histogram_merge(to->messages[dir][idx], from->messages[dir][idx]);
+			}
+		}
+	}
+}
+
+static void sccp_stats_clearTable(sccp_stats_table_t * table)
+{
+	int dir = 0;
+	int idx = 0;
+
+	for (dir = 0; dir < SCCP_STATS_DIRECTIONS; dir++) {
+		for (idx = 0; idx < SCCP_STATS_MESSAGE_IDS; idx++) {
+			if (table->messages[dir][idx]) {
+				sccp_free(table->messages[dir][idx]);
+			}
+		}
+	}
+}
+
+/* claim the table held by the calling thread, fails once it was reclaimed (or the statistics were restarted) */
+static sccp_stats_table_t *sccp_stats_claimTable(sccp_stats_table_holder_t * holder)
+{
+	sccp_stats_table_t *table = holder->table;
+
+	if (!table || holder->generation != ATOMIC_FETCH(&sccp_stats.generation, &sccp_stats_atomic_lock)) {
+		return NULL;
+	}
+	ATOMIC_INCR(&table->busy, 1, &sccp_stats_atomic_lock);						/* full barrier, pairs with the serial bump in newTable */
+	if (ATOMIC_FETCH(&table->serial, &sccp_stats_atomic_lock) != holder->serial) {
+		ATOMIC_DECR(&table->busy, 1, &sccp_stats_atomic_lock);
+		return NULL;
+	}
+	return table;
+}
+
+/* hand the calling thread a table, reusing one that went idle, and claim it */
+static sccp_stats_table_t *sccp_stats_newTable(sccp_stats_table_holder_t * holder)
+{
+	sccp_stats_table_t *table = NULL;
+	sccp_stats_table_t *candidate = NULL;
+	time_t now = time(NULL);
+
+	SCCP_LIST_LOCK(&sccp_stats.tables);
+	SCCP_LIST_TRAVERSE(&sccp_stats.tables, candidate, list) {
+		if (!candidate->reclaimed && candidate->lastUse + SCCP_STATS_IDLE < now) {
+			ATOMIC_INCR(&candidate->serial, 1, &sccp_stats_atomic_lock);				/* full barrier, the owner can not claim it anymore */
+			candidate->reclaimed = TRUE;
+		}
+		if (candidate->reclaimed && ATOMIC_FETCH(&candidate->busy, &sccp_stats_atomic_lock) == 0) {
+			table = candidate;
+			sccp_stats_mergeTable(&sccp_stats.retired, table);
+			sccp_stats_clearTable(table);
+			memset(table->messages, 0, sizeof(table->messages));
+			break;
+		}
+	}
+	if (!table && (table = sccp_calloc(sizeof *table, 1))) {
+		SCCP_LIST_INSERT_TAIL(&sccp_stats.tables, table, list);
+	}
+	if (table) {
+		table->reclaimed = FALSE;
+		table->lastUse = now;
+		holder->table = table;
+		holder->serial = ATOMIC_FETCH(&table->serial, &sccp_stats_atomic_lock);
+		holder->generation = ATOMIC_FETCH(&sccp_stats.generation, &sccp_stats_atomic_lock);
+		table = sccp_stats_claimTable(holder);
+	}
+	SCCP_LIST_UNLOCK(&sccp_stats.tables);
+	return table;
+}
+
+/*!
+ * \brief Record the handling (inbound) or sending (outbound) of a message, started at start
+ */
+void sccp_stats_message(sccp_stats_direction_t direction, sccp_mid_t mid, const struct timeval *start)
+{
+	sccp_stats_table_holder_t *holder = NULL;
+	sccp_stats_table_t *table = NULL;
+	sccp_histogram_t *histogram = NULL;
+	int idx = sccp_stats_mid2idx(mid);
+	struct timeval now;
+	int64_t elapsed = 0;
+
+	ATOMIC_INCR(&sccp_stats.inflight, 1, &sccp_stats_atomic_lock);
+	if (!sccp_stats.active || !(holder = ast_threadstorage_get(&sccp_stats_threadbuf, sizeof *holder))) {
+		ATOMIC_DECR(&sccp_stats.inflight, 1, &sccp_stats_atomic_lock);
+		return;
+	}
+	if (!(table = sccp_stats_claimTable(holder)) && !(table = sccp_stats_newTable(holder))) {		/* first use, reclaimed or stats restarted */
+		ATOMIC_DECR(&sccp_stats.inflight, 1, &sccp_stats_atomic_lock);
+		return;
+	}
+	if (!(histogram = table->messages[direction][idx])) {
+		SCCP_LIST_LOCK(&sccp_stats.tables);								/* readers walk the histogram pointers */
+		histogram = table->messages[direction][idx] = sccp_calloc(sizeof(sccp_histogram_t), 1);
+		SCCP_LIST_UNLOCK(&sccp_stats.tables);
+	}
+	if (histogram) {
+		now = pbx_tvnow();
+		elapsed = ast_tvdiff_us(now, *start);
+		sccp_histogram_add(histogram, elapsed > 0 ? (elapsed < UINT32_MAX ? (uint32_t) elapsed : UINT32_MAX) : 0);
+		table->lastUse = now.tv_sec;
+	}
+	ATOMIC_DECR(&table->busy, 1, &sccp_stats_atomic_lock);
+	ATOMIC_DECR(&sccp_stats.inflight, 1, &sccp_stats_atomic_lock);
+}
+
+/* ========================================================================================================= Call Spans == */
+static const char *const sccp_callspan_milestone2str[SCCP_CALLSPAN_SENTINEL] = {
+	[SCCP_CALLSPAN_OFFHOOK] = "OffHook",
+	[SCCP_CALLSPAN_FIRSTDIGIT] = "FirstDigit",
+	[SCCP_CALLSPAN_SOFTSWITCH] = "SoftSwitch",
+	[SCCP_CALLSPAN_CALL] = "Call",
+	[SCCP_CALLSPAN_RING] = "Ring",
+	[SCCP_CALLSPAN_ANSWER] = "Answer",
+	[SCCP_CALLSPAN_OPENRECEIVE] = "OpenReceive",
+	[SCCP_CALLSPAN_STARTMEDIA] = "StartMedia",
+};
+
+typedef struct sccp_callspan_aggregate sccp_callspan_aggregate_t;
+struct sccp_callspan_aggregate {
+	SCCP_LIST_ENTRY (sccp_callspan_aggregate_t) list;
+	uint32_t calls;
+	sccp_histogram_t milestones[SCCP_CALLSPAN_SENTINEL];							/*!< milliseconds after channel allocation */
+	char name[StationMaxNameSize];
+};
+SCCP_LIST_HEAD (sccp_callspan_aggregates, sccp_callspan_aggregate_t);
+
+static struct {
+	struct sccp_callspan_aggregates devicetypes;
+	struct sccp_callspan_aggregates lines;
+} sccp_callspans;
+
+static int32_t sccp_callspan_elapsed(const sccp_callspan_t * span)
+{
+	struct timespec now;
+	int64_t elapsed = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (int64_t) (now.tv_sec - span->origin.tv_sec) * 1000 + (now.tv_nsec - span->origin.tv_nsec) / 1000000;
+	return elapsed < 0 ? 0 : (elapsed > INT32_MAX ? INT32_MAX : (int32_t) elapsed);
+}
+
+/*!
+ * \brief Start a call setup span (at channel allocation)
+ */
+void sccp_callspan_start(sccp_callspan_t * span)
+{
+	int milestone = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &span->origin);
+	for (milestone = 0; milestone < SCCP_CALLSPAN_SENTINEL; milestone++) {
+		span->at[milestone] = -1;
+	}
+	span->finished = FALSE;
+}
+
+/*!
+ * \brief Stamp a milestone, only its first occurrence is kept
+ * \note milestones are stamped from different threads, each slot is written once
+ */
+void sccp_callspan_mark(sccp_callspan_t * span, sccp_callspan_milestone_t milestone)
+{
+	if (span && !span->finished && span->at[milestone] < 0) {
+		span->at[milestone] = sccp_callspan_elapsed(span);
+	}
+}
+
+/* call with the list lock held */
+static sccp_callspan_aggregate_t *sccp_callspan_getAggregate(struct sccp_callspan_aggregates *aggregates, const char *name)
+{
+	sccp_callspan_aggregate_t *aggregate = NULL;
+
+	SCCP_LIST_TRAVERSE(aggregates, aggregate, list) {
+		if (sccp_strequals(aggregate->name, name)) {
+			return aggregate;
+		}
+	}
+	if ((aggregate = sccp_calloc(sizeof *aggregate, 1))) {
+		sccp_copy_string(aggregate->name, name, sizeof(aggregate->name));
+		SCCP_LIST_INSERT_SORTALPHA(aggregates, aggregate, list, name);
+	}
+	return aggregate;
+}
+
+static void sccp_callspan_aggregate(struct sccp_callspan_aggregates *aggregates, const char *name, const sccp_callspan_t * span)
+{
+	sccp_callspan_aggregate_t *aggregate = NULL;
+	int milestone = 0;
+
+	SCCP_LIST_LOCK(aggregates);
+	if ((aggregate = sccp_callspan_getAggregate(aggregates, name))) {
+		aggregate->calls++;
+		for (milestone = 0; milestone < SCCP_CALLSPAN_SENTINEL; milestone++) {
+			if (span->at[milestone] >= 0) {
+				sccp_histogram_add(&aggregate->milestones[milestone], span->at[milestone]);
+			}
+		}
+	}
+	SCCP_LIST_UNLOCK(aggregates);
+}
+
+/*!
+ * \brief Fold a span into the per device type and per line histograms (at hangup), once
+ */
+void sccp_callspan_finish(sccp_callspan_t * span, const char *designator, const char *deviceType, const char *lineName)
+{
+	int milestone = 0;
+
+	if (!span || span->finished || !sccp_stats.active) {
+		return;
+	}
+	span->finished = TRUE;
+	sccp_callspan_aggregate(&sccp_callspans.devicetypes, !sccp_strlen_zero(deviceType) ? deviceType : "Unknown", span);
+	sccp_callspan_aggregate(&sccp_callspans.lines, !sccp_strlen_zero(lineName) ? lineName : "Unknown", span);
+
+	if (GLOB(callspan_log)) {
+		char buf[256] = "";
+		int pos = 0;
+
+		for (milestone = 0; milestone < SCCP_CALLSPAN_SENTINEL && pos < (int) sizeof(buf); milestone++) {
+			if (span->at[milestone] >= 0) {
+				pos += snprintf(buf + pos, sizeof(buf) - pos, " %s:+%dms", sccp_callspan_milestone2str[milestone], span->at[milestone]);
+			}
+		}
+		pbx_log(LOG_NOTICE, "%s: Call setup (%s, line %s):%s\n", designator, deviceType ? deviceType : "Unknown", lineName ? lineName : "Unknown", buf);
+	}
+}
+
+static void sccp_callspan_clear(struct sccp_callspan_aggregates *aggregates)
+{
+	sccp_callspan_aggregate_t *aggregate = NULL;
+
+	SCCP_LIST_LOCK(aggregates);
+	while ((aggregate = SCCP_LIST_REMOVE_HEAD(aggregates, list))) {
+		sccp_free(aggregate);
+	}
+	SCCP_LIST_UNLOCK(aggregates);
+}
+
+void sccp_stats_module_start(void)
+{
+	SCCP_LIST_HEAD_INIT(&sccp_stats.tables);
+	SCCP_LIST_HEAD_INIT(&sccp_callspans.devicetypes);
+	SCCP_LIST_HEAD_INIT(&sccp_callspans.lines);
+	sccp_stats.started = pbx_tvnow();
+	sccp_stats.active = TRUE;
+}
+
+/*!
+ * \note threads may still be running, their thread storage only points at the table, which is freed here once no thread is recording
+ */
+void sccp_stats_module_stop(void)
+{
+	sccp_stats_table_t *table = NULL;
+
+	sccp_stats.active = FALSE;
+	while (ATOMIC_FETCH(&sccp_stats.inflight, &sccp_stats_atomic_lock) > 0) {				/* wait for threads still recording */
+		sched_yield();
+	}
+	ATOMIC_INCR(&sccp_stats.generation, 1, &sccp_stats_atomic_lock);
+	SCCP_LIST_LOCK(&sccp_stats.tables);
+	while ((table = SCCP_LIST_REMOVE_HEAD(&sccp_stats.tables, list))) {
+		sccp_stats_clearTable(table);
+		sccp_free(table);
+	}
+	sccp_stats_clearTable(&sccp_stats.retired);
+	memset(sccp_stats.retired.messages, 0, sizeof(sccp_stats.retired.messages));
+	SCCP_LIST_UNLOCK(&sccp_stats.tables);
+
+	sccp_callspan_clear(&sccp_callspans.devicetypes);
+	sccp_callspan_clear(&sccp_callspans.lines);
+	SCCP_LIST_HEAD_DESTROY(&sccp_callspans.devicetypes);
+	SCCP_LIST_HEAD_DESTROY(&sccp_callspans.lines);
+}
+
+/* ================================================================================================================ CLI == */
+typedef struct sccp_stats_row {
+	int direction;
+	int idx;
+	sccp_histogram_t histogram;
+} sccp_stats_row_t;
+
+static int sccp_stats_rowcmp(const void *a, const void *b)
+{
+	const sccp_stats_row_t *ra = a;
+	const sccp_stats_row_t *rb = b;
+
+	return (ra->histogram.sum < rb->histogram.sum) - (ra->histogram.sum > rb->histogram.sum);
+}
+
+/* merge all thread tables into rows (one per direction and message type seen), sorted by total time, returns the number of rows */
+static int sccp_stats_collect(sccp_stats_row_t ** rows)
+{
+	sccp_stats_table_t merged = { {0} };
+	sccp_stats_table_t *table = NULL;
+	int dir = 0;
+	int idx = 0;
+	int nrows = 0;
+
+	SCCP_LIST_LOCK(&sccp_stats.tables);
+	sccp_stats_mergeTable(&merged, &sccp_stats.retired);
+	SCCP_LIST_TRAVERSE(&sccp_stats.tables, table, list) {
+		sccp_stats_mergeTable(&merged, table);
+	}
+	SCCP_LIST_UNLOCK(&sccp_stats.tables);
+
+	*rows = NULL;
+	for (dir = 0; dir < SCCP_STATS_DIRECTIONS; dir++) {
+		for (idx = 0; idx < SCCP_STATS_MESSAGE_IDS; idx++) {
+			nrows += (merged.messages[dir][idx] && merged.messages[dir][idx]->count) ? 1 : 0;
+		}
+	}
+	if (nrows && (*rows = sccp_calloc(nrows, sizeof(sccp_stats_row_t)))) {
+		nrows = 0;
+		for (dir = 0; dir < SCCP_STATS_DIRECTIONS; dir++) {
+			for (idx = 0; idx < SCCP_STATS_MESSAGE_IDS; idx++) {
+				if (merged.messages[dir][idx] && merged.messages[dir][idx]->count) {
+					(*rows)[nrows].direction = dir;
+					(*rows)[nrows].idx = idx;
+					(*rows)[nrows].histogram = *merged.messages[dir][idx];
+					nrows++;
+				}
+			}
+		}
+		qsort(*rows, nrows, sizeof(sccp_stats_row_t), sccp_stats_rowcmp);
+	} else {
+		nrows = 0;
+	}
+	sccp_stats_clearTable(&merged);
+	return nrows;
+}
+
+/*!
+ * \brief Hand the merged histogram of every message type seen to cb (metrics export)
+ */
+void sccp_stats_visitMessages(sccp_stats_message_cb_t cb, void *data)
+{
+	sccp_stats_row_t *rows = NULL;
+	int nrows = sccp_stats_collect(&rows);
+	int idx = 0;
+
+	for (idx = 0; idx < nrows; idx++) {
+		cb(rows[idx].direction, sccp_stats_idx2str(rows[idx].idx), &rows[idx].histogram, data);
+	}
+	if (rows) {
+		sccp_free(rows);
+	}
+}
+
+/*!
+ * \brief Show the per message type statistics (CLI/AMI)
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_stats_show_messages(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	sccp_stats_row_t *rows = NULL;
+	sccp_stats_row_t *row = NULL;
+	int nrows = 0;
+	int limit = 0;
+	int idx = 0;
+	double elapsed = ast_tvdiff_ms(pbx_tvnow(), sccp_stats.started) / 1000.0;
+
+	if (argc > 4 && !sccp_strlen_zero(argv[4])) {
+		if (sscanf(argv[4], "%d", &limit) != 1 || limit < 0) {
+			return RESULT_SHOWUSAGE;
+		}
+	}
+	nrows = sccp_stats_collect(&rows);
+	if (limit && limit < nrows) {
+		nrows = limit;
+	}
+	if (elapsed < 1) {
+		elapsed = 1;
+	}
+
+#define CLI_AMI_TABLE_NAME MessageStats
+#define CLI_AMI_TABLE_PER_ENTRY_NAME MessageStat
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		row = &rows[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Dir,		"-3.3",		s,	3,	row->direction == SCCP_STATS_INBOUND ? "In" : "Out")		\
+ 		CLI_AMI_TABLE_FIELD(Message,		"-40.40",	s,	40,	sccp_stats_idx2str(row->idx))					\
+ 		CLI_AMI_TABLE_FIELD(Count,		"10",		u,	10,	row->histogram.count)						\
+ 		CLI_AMI_TABLE_FIELD(PerSec,		"8.2",		f,	8,	row->histogram.count / elapsed)					\
+ 		CLI_AMI_TABLE_FIELD(AvgUs,		"8",		u,	8,	(uint32_t) (row->histogram.sum / row->histogram.count))		\
+ 		CLI_AMI_TABLE_FIELD(P50Us,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 50))			\
+ 		CLI_AMI_TABLE_FIELD(P99Us,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 99))			\
+ 		CLI_AMI_TABLE_FIELD(MaxUs,		"9",		u,	9,	row->histogram.max)						\
+ 		CLI_AMI_TABLE_FIELD(TotalMs,		"10",		u,	10,	(uint32_t) (row->histogram.sum / 1000))
+#include "sccp_cli_table.h"
+	if (rows) {
+		sccp_free(rows);
+	}
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = 1;
+	}
+	return RESULT_SUCCESS;
+}
+
+typedef struct sccp_callspan_row {
+	char name[StationMaxNameSize];
+	uint32_t calls;
+	int milestone;
+	sccp_histogram_t histogram;
+} sccp_callspan_row_t;
+
+/* copy the reached milestones of all aggregates (one row per aggregate and milestone), returns the number of rows */
+static int sccp_callspan_collect(struct sccp_callspan_aggregates *aggregates, sccp_callspan_row_t ** rows)
+{
+	sccp_callspan_aggregate_t *aggregate = NULL;
+	int milestone = 0;
+	int nrows = 0;
+
+	*rows = NULL;
+	SCCP_LIST_LOCK(aggregates);
+	if (SCCP_LIST_GETSIZE(aggregates) && (*rows = sccp_calloc(SCCP_LIST_GETSIZE(aggregates) * SCCP_CALLSPAN_SENTINEL, sizeof(sccp_callspan_row_t)))) {
+		SCCP_LIST_TRAVERSE(aggregates, aggregate, list) {
+			for (milestone = 0; milestone < SCCP_CALLSPAN_SENTINEL; milestone++) {
+				if (aggregate->milestones[milestone].count) {
+					sccp_copy_string((*rows)[nrows].name, aggregate->name, sizeof((*rows)[nrows].name));
+					(*rows)[nrows].calls = aggregate->calls;
+					(*rows)[nrows].milestone = milestone;
+					(*rows)[nrows].histogram = aggregate->milestones[milestone];
+					nrows++;
+				}
+			}
+		}
+	}
+	SCCP_LIST_UNLOCK(aggregates);
+	return nrows;
+}
+
+/*!
+ * \brief Show the call setup milestones per device type and per line (CLI/AMI)
+ * \param fd Fd as int
+ * \param totals Total number of lines as int
+ * \param s AMI Session
+ * \param m Message
+ * \param argc Argc as int
+ * \param argv[] Argv[] as char
+ * \return Result as int
+ *
+ * \called_from_asterisk
+ */
+int sccp_stats_show_callspans(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[])
+{
+	int local_line_total = 0;
+	int tables = 0;
+	boolean_t devicetypes = TRUE;
+	boolean_t lines = TRUE;
+	sccp_callspan_row_t *rows = NULL;
+	sccp_callspan_row_t *row = NULL;
+	int nrows = 0;
+	int idx = 0;
+
+	if (argc > 4 && !sccp_strlen_zero(argv[4])) {
+		if (sccp_strcaseequals(argv[4], "devicetype")) {
+			lines = FALSE;
+		} else if (sccp_strcaseequals(argv[4], "line")) {
+			devicetypes = FALSE;
+		} else {
+			return RESULT_SHOWUSAGE;
+		}
+	}
+
+	if (devicetypes) {
+		nrows = sccp_callspan_collect(&sccp_callspans.devicetypes, &rows);
+#define CLI_AMI_TABLE_NAME DeviceTypeCallSetup
+#define CLI_AMI_TABLE_PER_ENTRY_NAME DeviceTypeCallSetup
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		row = &rows[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(DeviceType,		"-20.20",	s,	20,	row->name)							\
+ 		CLI_AMI_TABLE_FIELD(Calls,		"7",		u,	7,	row->calls)							\
+ 		CLI_AMI_TABLE_FIELD(Milestone,		"-11.11",	s,	11,	sccp_callspan_milestone2str[row->milestone])			\
+ 		CLI_AMI_TABLE_FIELD(Count,		"7",		u,	7,	row->histogram.count)						\
+ 		CLI_AMI_TABLE_FIELD(AvgMs,		"8",		u,	8,	(uint32_t) (row->histogram.sum / row->histogram.count))		\
+ 		CLI_AMI_TABLE_FIELD(P50Ms,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 50))			\
+ 		CLI_AMI_TABLE_FIELD(P99Ms,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 99))			\
+ 		CLI_AMI_TABLE_FIELD(MaxMs,		"8",		u,	8,	row->histogram.max)
+#include "sccp_cli_table.h"
+		if (rows) {
+			sccp_free(rows);
+		}
+		tables++;
+	}
+
+	if (lines) {
+		nrows = sccp_callspan_collect(&sccp_callspans.lines, &rows);
+#define CLI_AMI_TABLE_NAME LineCallSetup
+#define CLI_AMI_TABLE_PER_ENTRY_NAME LineCallSetup
+#define CLI_AMI_TABLE_ITERATOR for(idx = 0; idx < nrows; idx++)
+#define CLI_AMI_TABLE_BEFORE_ITERATION 															\
+ 		row = &rows[idx];
+#define CLI_AMI_TABLE_FIELDS 																\
+ 		CLI_AMI_TABLE_FIELD(Line,		"-20.20",	s,	20,	row->name)							\
+ 		CLI_AMI_TABLE_FIELD(Calls,		"7",		u,	7,	row->calls)							\
+ 		CLI_AMI_TABLE_FIELD(Milestone,		"-11.11",	s,	11,	sccp_callspan_milestone2str[row->milestone])			\
+ 		CLI_AMI_TABLE_FIELD(Count,		"7",		u,	7,	row->histogram.count)						\
+ 		CLI_AMI_TABLE_FIELD(AvgMs,		"8",		u,	8,	(uint32_t) (row->histogram.sum / row->histogram.count))		\
+ 		CLI_AMI_TABLE_FIELD(P50Ms,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 50))			\
+ 		CLI_AMI_TABLE_FIELD(P99Ms,		"8",		u,	8,	sccp_histogram_percentile(&row->histogram, 99))			\
+ 		CLI_AMI_TABLE_FIELD(MaxMs,		"8",		u,	8,	row->histogram.max)
+#include "sccp_cli_table.h"
+		if (rows) {
+			sccp_free(rows);
+		}
+		tables++;
+	}
+
+	if (s) {
+		totals->lines = local_line_total;
+		totals->tables = tables;
+	}
+	return RESULT_SUCCESS;
+}
+
+#if CS_TEST_FRAMEWORK
+#include <asterisk/test.h>
+#define SCCP_STATS_TEST_THREADS 4
+#define SCCP_STATS_TEST_MESSAGES 1000
+
+static void *sccp_stats_testThread(void *data)
+{
+	struct timeval start = pbx_tvnow();
+	int i = 0;
+
+	for (i = 0; i < SCCP_STATS_TEST_MESSAGES; i++) {
+		sccp_stats_message(SCCP_STATS_OUTBOUND, RecordingStatusMessage, &start);
+	}
+	return NULL;
+}
+
+static uint32_t sccp_stats_testCount(void)
+{
+	sccp_stats_row_t *rows = NULL;
+	uint32_t count = 0;
+	int nrows = sccp_stats_collect(&rows);
+	int idx = 0;
+
+	for (idx = 0; idx < nrows; idx++) {
+		if (rows[idx].direction == SCCP_STATS_OUTBOUND && rows[idx].idx == RecordingStatusMessage) {
+			count = rows[idx].histogram.count;
+		}
+	}
+	if (rows) {
+		sccp_free(rows);
+	}
+	return count;
+}
+
+AST_TEST_DEFINE(sccp_stats_histogram_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "histogram";
+			info->category = "/channels/chan_sccp/stats/";
+			info->summary = "chan-sccp-b latency histogram test";
+			info->description = "bucket boundaries, percentiles and merging of the log-linear histogram";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	sccp_histogram_t a = { 0 };
+	sccp_histogram_t b = { 0 };
+	uint32_t value = 0;
+	int idx = 0;
+
+	pbx_test_status_update(test, "bucket boundaries...\n");
+	for (value = 0; value < (1 << 20); value += (value >> 6) + 1) {
+		idx = sccp_histogram_bucket(value);
+		pbx_test_validate(test, value <= sccp_histogram_upper(idx));
+		pbx_test_validate(test, idx == 0 || value > sccp_histogram_upper(idx - 1));
+	}
+	pbx_test_validate(test, sccp_histogram_bucket(UINT32_MAX) == SCCP_HISTOGRAM_BUCKETS - 1);
+
+	pbx_test_status_update(test, "percentiles...\n");
+	for (value = 1; value <= 100; value++) {
+		sccp_histogram_add(&a, value * 10);
+	}
+	pbx_test_validate(test, a.count == 100 && a.max == 1000 && a.sum == 50500);
+	value = sccp_histogram_percentile(&a, 50);
+	pbx_test_validate(test, value >= 500 && value <= 500 * 5 / 4);
+	value = sccp_histogram_percentile(&a, 99);
+	pbx_test_validate(test, value >= 990 && value <= 1000);
+	pbx_test_validate(test, sccp_histogram_percentile(&b, 50) == 0);
+
+	pbx_test_status_update(test, "merge...\n");
+	sccp_histogram_add(&b, 100000);
+	sccp_histogram_merge(&b, &a);
+	pbx_test_validate(test, b.count == 101 && b.max == 100000 && b.sum == 150500);
+	pbx_test_validate(test, sccp_histogram_percentile(&b, 100) == 100000);
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_stats_thread_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "threads";
+			info->category = "/channels/chan_sccp/stats/";
+			info->summary = "chan-sccp-b per thread statistics test";
+			info->description = "messages recorded by several threads are merged on read, also after the threads exited";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	pthread_t threads[SCCP_STATS_TEST_THREADS];
+	uint32_t before = 0;
+	uint32_t after = 0;
+	int thread = 0;
+
+	if (!sccp_stats.active) {
+		pbx_test_status_update(test, "statistics not active, skipped\n");
+		return AST_TEST_PASS;
+	}
+	before = sccp_stats_testCount();
+	for (thread = 0; thread < SCCP_STATS_TEST_THREADS; thread++) {
+		pbx_pthread_create(&threads[thread], NULL, sccp_stats_testThread, NULL);
+	}
+	for (thread = 0; thread < SCCP_STATS_TEST_THREADS; thread++) {
+		pthread_join(threads[thread], NULL);
+	}
+	after = sccp_stats_testCount();
+	pbx_test_status_update(test, "recorded %u messages\n", after - before);
+	pbx_test_validate(test, after - before == SCCP_STATS_TEST_THREADS * SCCP_STATS_TEST_MESSAGES);
+	return AST_TEST_PASS;
+}
+
+AST_TEST_DEFINE(sccp_stats_callspan_tests)
+{
+	switch(cmd) {
+		case TEST_INIT:
+			info->name = "callspan";
+			info->category = "/channels/chan_sccp/stats/";
+			info->summary = "chan-sccp-b call setup span test";
+			info->description = "milestones are stamped once, a finished span is aggregated once per device type and line";
+			return AST_TEST_NOT_RUN;
+		case TEST_EXECUTE:
+			break;
+	}
+
+	const char *name = "sccp_stats_test";
+	sccp_callspan_t span;
+	sccp_callspan_row_t *rows = NULL;
+	sccp_callspan_aggregate_t *aggregate = NULL;
+	int nrows = 0;
+	int idx = 0;
+	int res = AST_TEST_PASS;
+
+	if (!sccp_stats.active) {
+		pbx_test_status_update(test, "statistics not active, skipped\n");
+		return AST_TEST_PASS;
+	}
+	sccp_callspan_start(&span);
+	sccp_callspan_mark(&span, SCCP_CALLSPAN_OFFHOOK);
+	usleep(20000);
+	sccp_callspan_mark(&span, SCCP_CALLSPAN_RING);
+	sccp_callspan_mark(&span, SCCP_CALLSPAN_OFFHOOK);
+	pbx_test_validate(test, span.at[SCCP_CALLSPAN_OFFHOOK] < 20 && span.at[SCCP_CALLSPAN_RING] >= 20);
+	pbx_test_validate(test, span.at[SCCP_CALLSPAN_ANSWER] == -1);
+	sccp_callspan_finish(&span, name, name, name);
+	sccp_callspan_finish(&span, name, name, name);
+
+	nrows = sccp_callspan_collect(&sccp_callspans.devicetypes, &rows);
+	for (idx = 0; idx < nrows; idx++) {
+		if (sccp_strequals(rows[idx].name, name)) {
+			pbx_test_status_update(test, "%s: calls:%u, max:%ums\n", sccp_callspan_milestone2str[rows[idx].milestone], rows[idx].calls, rows[idx].histogram.max);
+			if (rows[idx].calls != 1 || rows[idx].histogram.count != 1 || (rows[idx].milestone != SCCP_CALLSPAN_OFFHOOK && rows[idx].milestone != SCCP_CALLSPAN_RING)) {
+				res = AST_TEST_FAIL;
+			}
+		}
+	}
+	if (rows) {
+		sccp_free(rows);
+	}
+
+	/* remove the test aggregates */
+	SCCP_LIST_LOCK(&sccp_callspans.devicetypes);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_callspans.devicetypes, aggregate, list) {
+		if (sccp_strequals(aggregate->name, name)) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			sccp_free(aggregate);
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&sccp_callspans.devicetypes);
+	SCCP_LIST_LOCK(&sccp_callspans.lines);
+	SCCP_LIST_TRAVERSE_SAFE_BEGIN(&sccp_callspans.lines, aggregate, list) {
+		if (sccp_strequals(aggregate->name, name)) {
+			SCCP_LIST_REMOVE_CURRENT(list);
+			sccp_free(aggregate);
+		}
+	}
+	SCCP_LIST_TRAVERSE_SAFE_END;
+	SCCP_LIST_UNLOCK(&sccp_callspans.lines);
+	return res;
+}
+
+static void __attribute__((constructor)) sccp_register_tests(void)
+{
+	AST_TEST_REGISTER(sccp_stats_histogram_tests);
+	AST_TEST_REGISTER(sccp_stats_thread_tests);
+	AST_TEST_REGISTER(sccp_stats_callspan_tests);
+}
+
+static void __attribute__((destructor)) sccp_unregister_tests(void)
+{
+	AST_TEST_UNREGISTER(sccp_stats_histogram_tests);
+	AST_TEST_UNREGISTER(sccp_stats_thread_tests);
+	AST_TEST_UNREGISTER(sccp_stats_callspan_tests);
+}
+#endif
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
@@ -0,0 +1,72 @@
+/*!
+ * \file        sccp_stats.h
+ * \brief       SCCP Statistics Header
+ * \note        This program is free software and may be modified and distributed under the terms of the GNU Public License.
+ *              See the LICENSE file at the top of the source tree.
+ * \since       2026-10-19
+ */
+#pragma once
+#include "sccp_cli.h"
+
+#define SCCP_HISTOGRAM_SUBBUCKETS 4										/* linear sub-buckets per power of two */
+#define SCCP_HISTOGRAM_BUCKETS 96										/* covers 0 - 33 seconds in microseconds */
+
+__BEGIN_C_EXTERN__
+/*!
+ * \brief Log-Linear Latency Histogram (microseconds for messages, milliseconds for call setup)
+ * \note not synchronized, each histogram has either a single writer or is protected by its owner's lock
+ */
+typedef struct sccp_histogram {
+	uint32_t count;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t buckets[SCCP_HISTOGRAM_BUCKETS];
+} sccp_histogram_t;
+
+typedef enum {
+	SCCP_STATS_INBOUND,
+	SCCP_STATS_OUTBOUND,
+} sccp_stats_direction_t;
+
+/*!
+ * \brief Call Setup Milestones
+ */
+typedef enum {
+	SCCP_CALLSPAN_OFFHOOK,
+	SCCP_CALLSPAN_FIRSTDIGIT,
+	SCCP_CALLSPAN_SOFTSWITCH,
+	SCCP_CALLSPAN_CALL,
+	SCCP_CALLSPAN_RING,
+	SCCP_CALLSPAN_ANSWER,
+	SCCP_CALLSPAN_OPENRECEIVE,
+	SCCP_CALLSPAN_STARTMEDIA,
+	SCCP_CALLSPAN_SENTINEL
+} sccp_callspan_milestone_t;
+
+/*!
+ * \brief Call Setup Span, milliseconds from channel allocation (monotonic clock) to each milestone
+ */
+typedef struct sccp_callspan {
+	struct timespec origin;
+	int32_t at[SCCP_CALLSPAN_SENTINEL];									/*!< -1 = not reached, only the first occurrence is kept */
+	boolean_t finished;
+} sccp_callspan_t;
+
+typedef void (*sccp_stats_message_cb_t) (sccp_stats_direction_t direction, const char *message, const sccp_histogram_t * histogram, void *data);
+
+SCCP_API void SCCP_CALL sccp_histogram_add(sccp_histogram_t * histogram, uint32_t value);
+SCCP_API void SCCP_CALL sccp_histogram_merge(sccp_histogram_t * to, const sccp_histogram_t * from);
+SCCP_API uint32_t SCCP_CALL sccp_histogram_percentile(const sccp_histogram_t * histogram, uint percentile);
+SCCP_API uint32_t SCCP_CALL sccp_histogram_below(const sccp_histogram_t * histogram, uint32_t bound);
+
+SCCP_API void SCCP_CALL sccp_stats_module_start(void);
+SCCP_API void SCCP_CALL sccp_stats_module_stop(void);
+SCCP_API void SCCP_CALL sccp_stats_message(sccp_stats_direction_t direction, sccp_mid_t mid, const struct timeval *start);
+SCCP_API void SCCP_CALL sccp_stats_visitMessages(sccp_stats_message_cb_t cb, void *data);
+SCCP_API void SCCP_CALL sccp_callspan_start(sccp_callspan_t * span);
+SCCP_API void SCCP_CALL sccp_callspan_mark(sccp_callspan_t * span, sccp_callspan_milestone_t milestone);
+SCCP_API void SCCP_CALL sccp_callspan_finish(sccp_callspan_t * span, const char *designator, const char *deviceType, const char *lineName);
+SCCP_API int SCCP_CALL sccp_stats_show_callspans(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+SCCP_API int SCCP_CALL sccp_stats_show_messages(int fd, sccp_cli_totals_t * totals, struct mansession *s, const struct message *m, int argc, char *argv[]);
+__END_C_EXTERN__
+// kate: indent-width 8; replace-tabs off; indent-mode cstyle; auto-insert-doxygen on; line-numbers on; tab-indents on; keep-extra-spaces off; auto-brackets off;
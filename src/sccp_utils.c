@@ -772,6 +772,25 @@ gcc_inline boolean_t sccp_strcaseequals(const char *data1, const char *data2)
 	return FALSE;
 }
 
+/*!
+ * \brief SCCP case insensitive string hash (djb2)
+ * \param str String to be hashed
+ * \return hash value as unsigned int
+ *
+ * \note Used to index objects by name, result should be reduced modulo the number of buckets by the caller
+ */
+gcc_inline unsigned int sccp_str_case_hash(const char *str)
+{
+	unsigned int hash = 5381;
+
+	if (str) {
+		while (*str) {
+			hash = ((hash << 5) + hash) + (unsigned int) tolower((unsigned char) *str++);
+		}
+	}
+	return hash;
+}
+
 int __PURE__ sccp_strIsNumeric(const char *s)
 {
 	if (*s) {